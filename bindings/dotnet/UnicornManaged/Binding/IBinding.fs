@@ -14,6 +14,8 @@ type IBinding =
         abstract RegWrite : UIntPtr * Int32 * Byte array -> Int32
         abstract MemRead : UIntPtr * UInt64 * Byte array * UIntPtr -> Int32
         abstract MemWrite : UIntPtr * UInt64 * Byte array * UIntPtr -> Int32
+        abstract MemReadPtr : UIntPtr * UInt64 * IntPtr * UIntPtr -> Int32
+        abstract MemWritePtr : UIntPtr * UInt64 * IntPtr * UIntPtr -> Int32
         abstract EmuStart : UIntPtr * UInt64 * UInt64 * UInt64 * UInt64 -> Int32
         abstract EmuStop : UIntPtr -> Int32        
         abstract HookDel : UIntPtr * UIntPtr -> Int32
@@ -24,5 +26,9 @@ type IBinding =
         abstract HookAddNoarg : UIntPtr * UIntPtr * Int32 * UIntPtr * IntPtr * UInt64 * UInt64 -> Int32
         abstract HookAddArg0 : UIntPtr * UIntPtr * Int32 * UIntPtr * IntPtr * UInt64 * UInt64 * Int32 -> Int32
         abstract HookAddArg0Arg1 : UIntPtr * UIntPtr * Int32 * UIntPtr * IntPtr * UInt64 * UInt64 * UInt64 * UInt64 -> Int32
+        abstract TraceAdd : UIntPtr * UIntPtr array * Int32 * UInt64 * UInt64 -> Int32
+        abstract TraceGet : UIntPtr * UIntPtr * IntPtr array * UIntPtr array -> Int32
+        abstract TraceReset : UIntPtr * UIntPtr -> Int32
+        abstract TraceDel : UIntPtr * UIntPtr -> Int32
     end
 
@@ -13,6 +13,8 @@ module internal MockBinding =
     let mutable mem_protect = fun(eng, address, size, perms) -> 0
     let mutable mem_write = fun(eng, adress, value, size) -> 0
     let mutable mem_read = fun(eng, adress, value, size) -> 0
+    let mutable mem_write_ptr = fun(eng, adress, value, size) -> 0
+    let mutable mem_read_ptr = fun(eng, adress, value, size) -> 0
     let mutable reg_write = fun(eng, regId, value) -> 0
     let mutable reg_read = fun(eng, regId, value) -> 0
     let mutable emu_start = fun(eng, beginAddr, untilAddr, timeout, count) -> 0
@@ -24,6 +26,10 @@ module internal MockBinding =
     let mutable hook_add_noarg = fun(eng, hh, callbackType, callback, userData, hookBegin, hookEnd) -> 0
     let mutable hook_add_arg0 = fun(eng, hh, callbackType, callback, userData, hookBegin, hookEnd, arg0) -> 0
     let mutable hook_add_arg0_arg1 = fun(eng, hh, callbackType, callback, userData, hookBegin, hookEnd, arg0, arg1) -> 0
+    let mutable trace_add = fun(eng, hh, traceType, hookBegin, hookEnd) -> 0
+    let mutable trace_get = fun(eng, hh, records, count) -> 0
+    let mutable trace_reset = fun(eng, hh) -> 0
+    let mutable trace_del = fun(eng, hh) -> 0
 
     let instance =
         {new IBinding with
@@ -33,6 +39,8 @@ module internal MockBinding =
             member thi.MemMap(eng, adress, size, perm) = mem_map(eng, adress, size, perm)
             member thi.MemWrite(eng, adress, value, size) = mem_write(eng, adress, value, size)
             member thi.MemRead(eng, adress, value, size) = mem_read(eng, adress, value, size)
+            member thi.MemWritePtr(eng, adress, value, size) = mem_write_ptr(eng, adress, value, size)
+            member thi.MemReadPtr(eng, adress, value, size) = mem_read_ptr(eng, adress, value, size)
             member thi.RegWrite(eng, regId, value) = reg_write(eng, regId, value)
             member thi.RegRead(eng, regId, value) = reg_read(eng, regId, value)
             member thi.EmuStart(eng, beginAddr, untilAddr, timeout, count) = emu_start(eng, beginAddr, untilAddr, timeout, count)
@@ -47,5 +55,9 @@ module internal MockBinding =
             member thi.HookAddNoarg(eng, hh, callbackType, callback, userData, hookBegin, hookEnd) = hook_add_noarg(eng, hh, callbackType, callback, userData, hookBegin, hookEnd)
             member thi.HookAddArg0(eng, hh, callbackType, callback, userData, hookBegin, hookEnd, arg0) = hook_add_arg0(eng, hh, callbackType, callback, userData, hookBegin, hookEnd, arg0)
             member thi.HookAddArg0Arg1(eng, hh, callbackType, callback, userData, hookBegin, hookEnd, arg0, arg1) = hook_add_arg0_arg1(eng, hh, callbackType, callback, userData, hookBegin, hookEnd, arg0, arg1)
+            member thi.TraceAdd(eng, hh, traceType, hookBegin, hookEnd) = trace_add(eng, hh, traceType, hookBegin, hookEnd)
+            member thi.TraceGet(eng, hh, records, count) = trace_get(eng, hh, records, count)
+            member thi.TraceReset(eng, hh) = trace_reset(eng, hh)
+            member thi.TraceDel(eng, hh) = trace_del(eng, hh)
         }
     
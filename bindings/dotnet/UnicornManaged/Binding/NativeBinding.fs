@@ -35,6 +35,12 @@ module NativeBinding =
         [<DllImport("unicorn", CallingConvention = CallingConvention.Cdecl)>]
         extern Int32 uc_mem_read(UIntPtr eng, UInt64 address, Byte[] value, UIntPtr size)
 
+        [<DllImport("unicorn", CallingConvention = CallingConvention.Cdecl, EntryPoint = "uc_mem_write")>]
+        extern Int32 uc_mem_write_ptr(UIntPtr eng, UInt64 address, IntPtr value, UIntPtr size)
+
+        [<DllImport("unicorn", CallingConvention = CallingConvention.Cdecl, EntryPoint = "uc_mem_read")>]
+        extern Int32 uc_mem_read_ptr(UIntPtr eng, UInt64 address, IntPtr value, UIntPtr size)
+
         [<DllImport("unicorn", CallingConvention = CallingConvention.Cdecl)>]
         extern Int32 uc_reg_write(UIntPtr eng, Int32 regId, Byte[] value)
 
@@ -67,6 +73,18 @@ module NativeBinding =
 
         [<DllImport("unicorn", CallingConvention = CallingConvention.Cdecl, EntryPoint = "uc_hook_add")>]
         extern Int32 uc_hook_add_arg0_arg1(UIntPtr eng, UIntPtr hh, Int32 callbackType, UIntPtr callback, IntPtr userData, UInt64 hookbegin, UInt64 hookend, UInt64 arg0, UInt64 arg1)
+
+        [<DllImport("unicorn", CallingConvention = CallingConvention.Cdecl)>]
+        extern Int32 uc_trace_add(UIntPtr eng, UIntPtr[] hh, Int32 traceType, UInt64 hookbegin, UInt64 hookend)
+
+        [<DllImport("unicorn", CallingConvention = CallingConvention.Cdecl)>]
+        extern Int32 uc_trace_get(UIntPtr eng, UIntPtr hh, IntPtr[] records, UIntPtr[] count)
+
+        [<DllImport("unicorn", CallingConvention = CallingConvention.Cdecl)>]
+        extern Int32 uc_trace_reset(UIntPtr eng, UIntPtr hh)
+
+        [<DllImport("unicorn", CallingConvention = CallingConvention.Cdecl)>]
+        extern Int32 uc_trace_del(UIntPtr eng, UIntPtr hh)
             
     let instance =
         {new IBinding with
@@ -76,6 +94,8 @@ module NativeBinding =
             member thi.MemMap(eng, adress, size, perm) = uc_mem_map(eng, adress, size, perm)
             member thi.MemWrite(eng, adress, value, size) = uc_mem_write(eng, adress, value, size)
             member thi.MemRead(eng, adress, value, size) = uc_mem_read(eng, adress, value, size)
+            member thi.MemWritePtr(eng, adress, value, size) = uc_mem_write_ptr(eng, adress, value, size)
+            member thi.MemReadPtr(eng, adress, value, size) = uc_mem_read_ptr(eng, adress, value, size)
             member thi.RegWrite(eng, regId, value) = uc_reg_write(eng, regId, value)
             member thi.RegRead(eng, regId, value) = uc_reg_read(eng, regId, value)
             member thi.EmuStart(eng, beginAddr, untilAddr, timeout, count) = uc_emu_start(eng, beginAddr, untilAddr, timeout, count)
@@ -90,4 +110,8 @@ module NativeBinding =
             member thi.HookAddNoarg(eng, hh, callbackType, callback, userData, hookBegin, hookEnd) = uc_hook_add_noarg(eng, hh, callbackType, callback, userData, hookBegin, hookEnd)
             member thi.HookAddArg0(eng, hh, callbackType, callback, userData, hookBegin, hookEnd, arg0) = uc_hook_add_arg0(eng, hh, callbackType, callback, userData, hookBegin, hookEnd, arg0)
             member thi.HookAddArg0Arg1(eng, hh, callbackType, callback, userData, hookBegin, hookEnd, arg0, arg1) = uc_hook_add_arg0_arg1(eng, hh, callbackType, callback, userData, hookBegin, hookEnd, arg0, arg1)
+            member thi.TraceAdd(eng, hh, traceType, hookBegin, hookEnd) = uc_trace_add(eng, hh, traceType, hookBegin, hookEnd)
+            member thi.TraceGet(eng, hh, records, count) = uc_trace_get(eng, hh, records, count)
+            member thi.TraceReset(eng, hh) = uc_trace_reset(eng, hh)
+            member thi.TraceDel(eng, hh) = uc_trace_del(eng, hh)
         }
\ No newline at end of file
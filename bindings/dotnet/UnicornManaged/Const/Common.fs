@@ -39,9 +39,11 @@ module Common =
     let UC_MODE_MIPS32R6 = 64
     let UC_MODE_MIPS32 = 4
     let UC_MODE_MIPS64 = 8
+    let UC_MODE_MIPS32R5 = 128
     let UC_MODE_16 = 2
     let UC_MODE_32 = 4
     let UC_MODE_64 = 8
+    let UC_MODE_X87_FAST = 128
     let UC_MODE_PPC32 = 4
     let UC_MODE_PPC64 = 8
     let UC_MODE_QPX = 16
@@ -72,6 +74,8 @@ module Common =
     let UC_ERR_RESOURCE = 20
     let UC_ERR_EXCEPTION = 21
     let UC_ERR_TIMEOUT = 22
+    let UC_ERR_BREAKPOINT = 23
+    let UC_ERR_CALL_STOPPED = 24
     let UC_MEM_READ = 16
     let UC_MEM_WRITE = 17
     let UC_MEM_FETCH = 18
@@ -107,6 +111,25 @@ module Common =
     let UC_QUERY_MODE = 1
     let UC_QUERY_PAGE_SIZE = 2
     let UC_QUERY_ARCH = 3
+    let UC_QUERY_EXIT = 4
+    let UC_QUERY_VCPU = 5
+    let UC_CTX_GPR = 1
+    let UC_CTX_FPU = 2
+    let UC_CTX_SYS = 4
+    let UC_CTX_ALL = 7
+
+    let UC_CALL_DEFAULT = 0
+    let UC_CALL_CDECL = 1
+    let UC_CALL_SYSV64 = 2
+    let UC_CALL_MS64 = 3
+    let UC_CALL_AAPCS = 4
+    let UC_CALL_AAPCS64 = 5
+    let UC_CALL_MIPS_O32 = 6
+    let UC_CALL_MIPS_N64 = 7
+    let UC_TRACE_CODE = 1
+    let UC_TRACE_BLOCK = 2
+    let UC_TRACE_MEM = 3
+    let UC_TRACE_COVERAGE = 4
 
     let UC_PROT_NONE = 0
     let UC_PROT_READ = 1
@@ -114,3 +137,6 @@ module Common =
     let UC_PROT_EXEC = 4
     let UC_PROT_ALL = 7
 
+    let UC_MAP_PRIVATE = 0
+    let UC_MAP_SHARED = 1
+
@@ -8,6 +8,15 @@ open System.Linq
 open UnicornManaged.Const
 open UnicornManaged.Binding
 
+// memory access recorded by a UC_TRACE_MEM collector
+[<Struct>]
+type TraceMemAccess =
+    val Address: Int64
+    val Value: Int64
+    val Type: Int32
+    val Size: Int32
+    new(address, value, accessType, size) = { Address = address; Value = value; Type = accessType; Size = size }
+
 // exported hooks
 type CodeHook = delegate of Unicorn * Int64 * Int32 * Object -> unit
 and BlockHook = delegate of Unicorn * Int64 * Int32 * Object -> unit
@@ -34,6 +43,9 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
     let _syscallHooks = new List<(SyscallHook * Object)>()
     let _disposablePointers = new List<nativeint>()
 
+    // the native library holds function pointers to these, so they must outlive the hooks
+    let _trampolines = new List<Delegate>()
+
     let _eventMemMap =
         [
             (UC_HOOK_MEM_READ_UNMAPPED, UC_MEM_READ_UNMAPPED)
@@ -60,6 +72,21 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
         _disposablePointers.Add(mem)
         mem.ToPointer()
 
+    let trampolinePointer(trampoline: Delegate) =
+        _trampolines.Add(trampoline)
+        let funcPointer = Marshal.GetFunctionPointerForDelegate(trampoline)
+        new UIntPtr(funcPointer.ToPointer())
+
+    let pinned(buffer: Byte array) (offset: Int32) (count: Int32) (action: IntPtr -> unit) =
+        if offset < 0 || count < 0 || offset > buffer.Length - count then
+            raise(ArgumentOutOfRangeException("count"))
+        if count > 0 then
+            let handle = GCHandle.Alloc(buffer, GCHandleType.Pinned)
+            try
+                action(Marshal.UnsafeAddrOfPinnedArrayElement(buffer, offset))
+            finally
+                handle.Free()
+
     do  
         // initialize event list
         _eventMemMap
@@ -110,6 +137,28 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
         match binding.MemRead(_eng.[0], uint64 address, memValue, new UIntPtr(uint32 memValue.Length)) |> this.CheckResult with 
         | Some e -> raise e | None -> ()
 
+    // read & write directly from unmanaged or pinned memory, e.g. a fixed Span<byte>
+    member this.MemWrite(address: Int64, buffer: IntPtr, size: Int64) =
+        match binding.MemWritePtr(_eng.[0], uint64 address, buffer, new UIntPtr(uint64 size)) |> this.CheckResult with 
+        | Some e -> raise e | None -> ()
+
+    member this.MemRead(address: Int64, buffer: IntPtr, size: Int64) =
+        match binding.MemReadPtr(_eng.[0], uint64 address, buffer, new UIntPtr(uint64 size)) |> this.CheckResult with 
+        | Some e -> raise e | None -> ()
+
+    // read & write a slice of a managed buffer, without an intermediate copy
+    member this.MemWrite(address: Int64, buffer: Byte array, offset: Int32, count: Int32) =
+        pinned buffer offset count (fun ptr -> this.MemWrite(address, ptr, int64 count))
+
+    member this.MemRead(address: Int64, buffer: Byte array, offset: Int32, count: Int32) =
+        pinned buffer offset count (fun ptr -> this.MemRead(address, ptr, int64 count))
+
+    member this.MemWrite(address: Int64, segment: ArraySegment<Byte>) =
+        this.MemWrite(address, segment.Array, segment.Offset, segment.Count)
+
+    member this.MemRead(address: Int64, segment: ArraySegment<Byte>) =
+        this.MemRead(address, segment.Array, segment.Offset, segment.Count)
+
     member this.RegWrite(regId: Int32, value: Byte array) =
         match binding.RegWrite(_eng.[0], regId, value) |> this.CheckResult with 
         | Some e -> raise e | None -> ()
@@ -150,13 +199,13 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
 
     member this.AddCodeHook(callback: CodeHook, userData: Object, beginAddr: Int64, endAddr: Int64) =   
         let trampoline(u: IntPtr) (addr: Int64) (size: Int32) (user: IntPtr) =
-            _codeHooks
-            |> Seq.iter(fun (callback, userData) -> callback.Invoke(this, addr, size, userData))
+            for (callback, userData) in _codeHooks do
+                callback.Invoke(this, addr, size, userData)
         
         if _codeHooks |> Seq.isEmpty then
-            let funcPointer = Marshal.GetFunctionPointerForDelegate(new CodeHookInternal(trampoline))        
+            let funcPointer = trampolinePointer(new CodeHookInternal(trampoline))        
             let hh = new UIntPtr(allocate(IntPtr.Size))
-            match binding.HookAddNoarg(_eng.[0], hh, Common.UC_HOOK_CODE, new UIntPtr(funcPointer.ToPointer()), IntPtr.Zero, uint64 beginAddr, uint64 endAddr) |> this.CheckResult with 
+            match binding.HookAddNoarg(_eng.[0], hh, Common.UC_HOOK_CODE, funcPointer, IntPtr.Zero, uint64 beginAddr, uint64 endAddr) |> this.CheckResult with 
             | Some e -> raise e | None -> ()
 
         _codeHooks.Add(callback, userData)
@@ -169,13 +218,13 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
 
     member this.AddBlockHook(callback: BlockHook, userData: Object, beginAddr: Int64, endAddr: Int64) =   
         let trampoline(u: IntPtr) (addr: Int64) (size: Int32) (user: IntPtr) =
-            _blockHooks
-            |> Seq.iter(fun (callback, userData) -> callback.Invoke(this, addr, size, userData))
+            for (callback, userData) in _blockHooks do
+                callback.Invoke(this, addr, size, userData)
 
         if _blockHooks |> Seq.isEmpty then
-            let funcPointer = Marshal.GetFunctionPointerForDelegate(new BlockHookInternal(trampoline))
+            let funcPointer = trampolinePointer(new BlockHookInternal(trampoline))
             let hh = new UIntPtr(allocate(IntPtr.Size))
-            match binding.HookAddNoarg(_eng.[0], hh, Common.UC_HOOK_BLOCK, new UIntPtr(funcPointer.ToPointer()), IntPtr.Zero, uint64 beginAddr, uint64 endAddr) |> this.CheckResult with 
+            match binding.HookAddNoarg(_eng.[0], hh, Common.UC_HOOK_BLOCK, funcPointer, IntPtr.Zero, uint64 beginAddr, uint64 endAddr) |> this.CheckResult with 
             | Some e -> raise e | None -> ()
 
         _blockHooks.Add(callback, userData)
@@ -189,9 +238,9 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
             |> Seq.iter(fun (callback, userData) -> callback.Invoke(this, intNumber, userData))
         
         if _interruptHooks |> Seq.isEmpty then
-            let funcPointer = Marshal.GetFunctionPointerForDelegate(new InterruptHookInternal(trampoline))
+            let funcPointer = trampolinePointer(new InterruptHookInternal(trampoline))
             let hh = new UIntPtr(allocate(IntPtr.Size))
-            match binding.HookAddNoarg(_eng.[0], hh, Common.UC_HOOK_INTR, new UIntPtr(funcPointer.ToPointer()), IntPtr.Zero, hookBegin, hookEnd) |> this.CheckResult with 
+            match binding.HookAddNoarg(_eng.[0], hh, Common.UC_HOOK_INTR, funcPointer, IntPtr.Zero, hookBegin, hookEnd) |> this.CheckResult with 
             | Some e -> raise e | None -> ()
 
         _interruptHooks.Add(callback, userData)
@@ -204,13 +253,13 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
 
     member this.AddMemReadHook(callback: MemReadHook, userData: Object, beginAddr: Int64, endAddr: Int64) =   
         let trampoline(u: IntPtr) (addr: Int64) (size: Int32) (user: IntPtr) =
-            _memReadHooks
-            |> Seq.iter(fun (callback, userData) -> callback.Invoke(this, addr, size, userData))
+            for (callback, userData) in _memReadHooks do
+                callback.Invoke(this, addr, size, userData)
 
         if _memReadHooks |> Seq.isEmpty then
-            let funcPointer = Marshal.GetFunctionPointerForDelegate(new MemReadHookInternal(trampoline))
+            let funcPointer = trampolinePointer(new MemReadHookInternal(trampoline))
             let hh = new UIntPtr(allocate(IntPtr.Size))
-            match binding.HookAddNoarg(_eng.[0], hh, Common.UC_HOOK_MEM_READ, new UIntPtr(funcPointer.ToPointer()), IntPtr.Zero, uint64 beginAddr, uint64 endAddr) |> this.CheckResult with 
+            match binding.HookAddNoarg(_eng.[0], hh, Common.UC_HOOK_MEM_READ, funcPointer, IntPtr.Zero, uint64 beginAddr, uint64 endAddr) |> this.CheckResult with 
             | Some e -> raise e | None -> ()
 
         _memReadHooks.Add(callback, userData)
@@ -220,13 +269,13 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
 
     member this.AddMemWriteHook(callback: MemWriteHook, userData: Object, beginAddr: Int64, endAddr: Int64) =   
         let trampoline(u: IntPtr) (addr: Int64) (size: Int32) (value: Int64) (user: IntPtr) =
-            _memWriteHooks
-            |> Seq.iter(fun (callback, userData) -> callback.Invoke(this, addr, size, value, userData))
+            for (callback, userData) in _memWriteHooks do
+                callback.Invoke(this, addr, size, value, userData)
         
         if _memWriteHooks |> Seq.isEmpty then
-            let funcPointer = Marshal.GetFunctionPointerForDelegate(new MemWriteHookInternal(trampoline))
+            let funcPointer = trampolinePointer(new MemWriteHookInternal(trampoline))
             let hh = new UIntPtr(allocate(IntPtr.Size))
-            match binding.HookAddNoarg(_eng.[0], hh, Common.UC_HOOK_MEM_WRITE, new UIntPtr(funcPointer.ToPointer()), IntPtr.Zero, uint64 beginAddr, uint64 endAddr) |> this.CheckResult with 
+            match binding.HookAddNoarg(_eng.[0], hh, Common.UC_HOOK_MEM_WRITE, funcPointer, IntPtr.Zero, uint64 beginAddr, uint64 endAddr) |> this.CheckResult with 
             | Some e -> raise e | None -> ()
 
         _memWriteHooks.Add(callback, userData)
@@ -248,9 +297,9 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
         |> Seq.filter(fun eventFlag -> (eventType &&& eventFlag) <> 0)
         |> Seq.filter(fun eventFlag -> _memEventHooks.[eventFlag] |> Seq.isEmpty)
         |> Seq.iter(fun eventFlag ->
-            let funcPointer = Marshal.GetFunctionPointerForDelegate(new EventMemHookInternal(trampoline))
+            let funcPointer = trampolinePointer(new EventMemHookInternal(trampoline))
             let hh = new UIntPtr(allocate(IntPtr.Size))      
-            match binding.HookAddNoarg(_eng.[0], hh, eventFlag, new UIntPtr(funcPointer.ToPointer()), IntPtr.Zero, uint64 0, uint64 0) |> this.CheckResult with 
+            match binding.HookAddNoarg(_eng.[0], hh, eventFlag, funcPointer, IntPtr.Zero, uint64 0, uint64 0) |> this.CheckResult with 
             | Some e -> raise e | None -> ()
         )
 
@@ -273,9 +322,9 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
             |> Seq.last
         
         if _inHooks |> Seq.isEmpty then
-            let funcPointer = Marshal.GetFunctionPointerForDelegate(new InHookInternal(trampoline))
+            let funcPointer = trampolinePointer(new InHookInternal(trampoline))
             let hh = new UIntPtr(allocate(IntPtr.Size))
-            match binding.HookAddArg0(_eng.[0], hh, Common.UC_HOOK_INSN, new UIntPtr(funcPointer.ToPointer()), IntPtr.Zero, uint64 0, uint64 0, X86.UC_X86_INS_IN) |> this.CheckResult with 
+            match binding.HookAddArg0(_eng.[0], hh, Common.UC_HOOK_INSN, funcPointer, IntPtr.Zero, uint64 0, uint64 0, X86.UC_X86_INS_IN) |> this.CheckResult with 
             | Some e -> raise e | None -> ()
 
         _inHooks.Add(callback, userData)
@@ -289,9 +338,9 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
             |> Seq.iter(fun (callback, userData) -> callback.Invoke(this, port, size, value, userData))
             
         if _outHooks |> Seq.isEmpty then
-            let funcPointer = Marshal.GetFunctionPointerForDelegate(new OutHookInternal(trampoline))
+            let funcPointer = trampolinePointer(new OutHookInternal(trampoline))
             let hh = new UIntPtr(allocate(IntPtr.Size))
-            match binding.HookAddArg0(_eng.[0], hh, Common.UC_HOOK_INSN, new UIntPtr(funcPointer.ToPointer()), IntPtr.Zero, uint64 0, uint64 0, X86.UC_X86_INS_OUT) |> this.CheckResult with 
+            match binding.HookAddArg0(_eng.[0], hh, Common.UC_HOOK_INSN, funcPointer, IntPtr.Zero, uint64 0, uint64 0, X86.UC_X86_INS_OUT) |> this.CheckResult with 
             | Some e -> raise e | None -> ()
 
         _outHooks.Add(callback, userData)
@@ -305,9 +354,9 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
             |> Seq.iter(fun (callback, userData) -> callback.Invoke(this, userData))
                     
         if _syscallHooks |> Seq.isEmpty then
-            let funcPointer = Marshal.GetFunctionPointerForDelegate(new SyscallHookInternal(trampoline))
+            let funcPointer = trampolinePointer(new SyscallHookInternal(trampoline))
             let hh = new UIntPtr(allocate(IntPtr.Size))
-            match binding.HookAddArg0(_eng.[0], hh, Common.UC_HOOK_INSN, new UIntPtr(funcPointer.ToPointer()), IntPtr.Zero, uint64 0, uint64 0, X86.UC_X86_INS_SYSCALL) |> this.CheckResult with 
+            match binding.HookAddArg0(_eng.[0], hh, Common.UC_HOOK_INSN, funcPointer, IntPtr.Zero, uint64 0, uint64 0, X86.UC_X86_INS_SYSCALL) |> this.CheckResult with 
             | Some e -> raise e | None -> ()
 
         _syscallHooks.Add(callback, userData)
@@ -315,6 +364,44 @@ and Unicorn(arch: Int32, mode: Int32, binding: IBinding) =
     member this.AddSyscallHook(callback: SyscallHook) =
         this.AddSyscallHook(callback, null)
     
+    member this.TraceAdd(traceType: Int32, beginAddr: Int64, endAddr: Int64) =
+        let hh = [|UIntPtr.Zero|]
+        match binding.TraceAdd(_eng.[0], hh, traceType, uint64 beginAddr, uint64 endAddr) |> this.CheckResult with 
+        | Some e -> raise e | None -> hh.[0]
+
+    member this.TraceAdd(traceType: Int32) =
+        this.TraceAdd(traceType, 1L, 0L)
+
+    member private this.TraceGet(trace: UIntPtr) =
+        let (records, count) = ([|IntPtr.Zero|], [|UIntPtr.Zero|])
+        match binding.TraceGet(_eng.[0], trace, records, count) |> this.CheckResult with 
+        | Some e -> raise e | None -> (records.[0], int count.[0])
+
+    // addresses recorded by a UC_TRACE_CODE, UC_TRACE_BLOCK or UC_TRACE_COVERAGE collector
+    member this.TraceGetAddresses(trace: UIntPtr) =
+        let (records, count) = this.TraceGet(trace)
+        let addresses = Array.zeroCreate<Int64> count
+        if count > 0 then Marshal.Copy(records, addresses, 0, count)
+        addresses
+
+    // accesses recorded by a UC_TRACE_MEM collector
+    member this.TraceGetMemAccesses(trace: UIntPtr) =
+        let (records, count) = this.TraceGet(trace)
+        // each record is an address, a value, then the type & size packed in 64 bits
+        let raw = Array.zeroCreate<Int64> (count * 3)
+        if count > 0 then Marshal.Copy(records, raw, 0, count * 3)
+        Array.init count (fun i ->
+            let typeSize = raw.[i * 3 + 2]
+            new TraceMemAccess(raw.[i * 3], raw.[i * 3 + 1], int32 typeSize, int32 (typeSize >>> 32)))
+
+    member this.TraceReset(trace: UIntPtr) =
+        match binding.TraceReset(_eng.[0], trace) |> this.CheckResult with 
+        | Some e -> raise e | None -> ()
+
+    member this.TraceDel(trace: UIntPtr) =
+        match binding.TraceDel(_eng.[0], trace) |> this.CheckResult with 
+        | Some e -> raise e | None -> ()
+
     member this.Version() =
         let (major, minor) = (new UIntPtr(), new UIntPtr())
         let combined = binding.Version(major, minor)
@@ -3,6 +3,7 @@ package unicorn
 import (
 	"errors"
 	"sync"
+	"sync/atomic"
 	"unsafe"
 )
 
@@ -15,42 +16,62 @@ import "C"
 type HookData struct {
 	Uc       Unicorn
 	Callback interface{}
+
+	// Callback resolved to its concrete type by HookAdd, so the exported
+	// trampolines below don't pay for a type assertion on every call.
+	code       func(Unicorn, uint64, uint32)
+	memInvalid func(Unicorn, int, uint64, int, int64) bool
+	memAccess  func(Unicorn, int, uint64, int, int64)
+	intr       func(Unicorn, uint32)
+	x86In      func(Unicorn, uint32, uint32) uint32
+	x86Out     func(Unicorn, uint32, uint32, uint32)
+	x86Syscall func(Unicorn)
 }
 
 type Hook uint64
 
+// fastHookMap is read from every hook callback, possibly by many engines
+// running at once, so lookups are lock-free: writers serialize on the mutex
+// and publish a fresh copy of the table, readers load whatever copy is current.
 type fastHookMap struct {
-	vals []*HookData
-	sync.RWMutex
+	vals atomic.Value // []*HookData
+	sync.Mutex
 }
 
 func (m *fastHookMap) insert(h *HookData) uintptr {
 	// don't change this to defer
 	m.Lock()
-	for i, v := range m.vals {
+	old, _ := m.vals.Load().([]*HookData)
+	i := len(old)
+	for j, v := range old {
 		if v == nil {
-			m.vals[i] = h
-			m.Unlock()
-			return uintptr(i)
+			i = j
+			break
 		}
 	}
-	i := len(m.vals)
-	m.vals = append(m.vals, h)
+	vals := make([]*HookData, len(old), len(old)+1)
+	copy(vals, old)
+	if i == len(vals) {
+		vals = append(vals, h)
+	} else {
+		vals[i] = h
+	}
+	m.vals.Store(vals)
 	m.Unlock()
 	return uintptr(i)
 }
 
 func (m *fastHookMap) get(i unsafe.Pointer) *HookData {
-	m.RLock()
-	// TODO: nil check?
-	v := m.vals[uintptr(i)]
-	m.RUnlock()
-	return v
+	return m.vals.Load().([]*HookData)[uintptr(i)]
 }
 
 func (m *fastHookMap) remove(i uintptr) {
 	m.Lock()
-	m.vals[i] = nil
+	old := m.vals.Load().([]*HookData)
+	vals := make([]*HookData, len(old))
+	copy(vals, old)
+	vals[i] = nil
+	m.vals.Store(vals)
 	m.Unlock()
 }
 
@@ -59,66 +80,74 @@ var hookMap fastHookMap
 //export hookCode
 func hookCode(handle unsafe.Pointer, addr uint64, size uint32, user unsafe.Pointer) {
 	hook := hookMap.get(user)
-	hook.Callback.(func(Unicorn, uint64, uint32))(hook.Uc, uint64(addr), uint32(size))
+	hook.code(hook.Uc, uint64(addr), uint32(size))
 }
 
 //export hookMemInvalid
 func hookMemInvalid(handle unsafe.Pointer, typ C.uc_mem_type, addr uint64, size int, value int64, user unsafe.Pointer) bool {
 	hook := hookMap.get(user)
-	return hook.Callback.(func(Unicorn, int, uint64, int, int64) bool)(hook.Uc, int(typ), addr, size, value)
+	return hook.memInvalid(hook.Uc, int(typ), addr, size, value)
 }
 
 //export hookMemAccess
 func hookMemAccess(handle unsafe.Pointer, typ C.uc_mem_type, addr uint64, size int, value int64, user unsafe.Pointer) {
 	hook := hookMap.get(user)
-	hook.Callback.(func(Unicorn, int, uint64, int, int64))(hook.Uc, int(typ), addr, size, value)
+	hook.memAccess(hook.Uc, int(typ), addr, size, value)
 }
 
 //export hookInterrupt
 func hookInterrupt(handle unsafe.Pointer, intno uint32, user unsafe.Pointer) {
 	hook := hookMap.get(user)
-	hook.Callback.(func(Unicorn, uint32))(hook.Uc, intno)
+	hook.intr(hook.Uc, intno)
 }
 
 //export hookX86In
 func hookX86In(handle unsafe.Pointer, port, size uint32, user unsafe.Pointer) uint32 {
 	hook := hookMap.get(user)
-	return hook.Callback.(func(Unicorn, uint32, uint32) uint32)(hook.Uc, port, size)
+	return hook.x86In(hook.Uc, port, size)
 }
 
 //export hookX86Out
 func hookX86Out(handle unsafe.Pointer, port, size, value uint32, user unsafe.Pointer) {
 	hook := hookMap.get(user)
-	hook.Callback.(func(Unicorn, uint32, uint32, uint32))(hook.Uc, port, size, value)
+	hook.x86Out(hook.Uc, port, size, value)
 }
 
 //export hookX86Syscall
 func hookX86Syscall(handle unsafe.Pointer, user unsafe.Pointer) {
 	hook := hookMap.get(user)
-	hook.Callback.(func(Unicorn))(hook.Uc)
+	hook.x86Syscall(hook.Uc)
 }
 
 func (u *uc) HookAdd(htype int, cb interface{}, begin, end uint64, extra ...int) (Hook, error) {
 	var callback unsafe.Pointer
 	var insn C.int
 	var insnMode bool
+	var ok bool
+	data := &HookData{Uc: u, Callback: cb}
 	switch htype {
 	case HOOK_BLOCK, HOOK_CODE:
 		callback = C.hookCode_cgo
+		data.code, ok = cb.(func(Unicorn, uint64, uint32))
 	case HOOK_MEM_READ, HOOK_MEM_WRITE, HOOK_MEM_READ | HOOK_MEM_WRITE:
 		callback = C.hookMemAccess_cgo
+		data.memAccess, ok = cb.(func(Unicorn, int, uint64, int, int64))
 	case HOOK_INTR:
 		callback = C.hookInterrupt_cgo
+		data.intr, ok = cb.(func(Unicorn, uint32))
 	case HOOK_INSN:
 		insn = C.int(extra[0])
 		insnMode = true
 		switch insn {
 		case X86_INS_IN:
 			callback = C.hookX86In_cgo
+			data.x86In, ok = cb.(func(Unicorn, uint32, uint32) uint32)
 		case X86_INS_OUT:
 			callback = C.hookX86Out_cgo
+			data.x86Out, ok = cb.(func(Unicorn, uint32, uint32, uint32))
 		case X86_INS_SYSCALL, X86_INS_SYSENTER:
 			callback = C.hookX86Syscall_cgo
+			data.x86Syscall, ok = cb.(func(Unicorn))
 		default:
 			return 0, errors.New("Unknown instruction type.")
 		}
@@ -127,12 +156,15 @@ func (u *uc) HookAdd(htype int, cb interface{}, begin, end uint64, extra ...int)
 		if htype&(HOOK_MEM_READ_UNMAPPED|HOOK_MEM_WRITE_UNMAPPED|HOOK_MEM_FETCH_UNMAPPED|
 			HOOK_MEM_READ_PROT|HOOK_MEM_WRITE_PROT|HOOK_MEM_FETCH_PROT) != 0 {
 			callback = C.hookMemInvalid_cgo
+			data.memInvalid, ok = cb.(func(Unicorn, int, uint64, int, int64) bool)
 		} else {
 			return 0, errors.New("Unknown hook type.")
 		}
 	}
+	if !ok {
+		return 0, errors.New("Callback type does not match hook type.")
+	}
 	var h2 C.uc_hook
-	data := &HookData{u, cb}
 	uptr := hookMap.insert(data)
 	if insnMode {
 		C.uc_hook_add_insn(u.handle, &h2, C.uc_hook_type(htype), callback, C.uintptr_t(uptr), C.uint64_t(begin), C.uint64_t(end), insn)
@@ -0,0 +1,73 @@
+package unicorn
+
+import (
+	"fmt"
+	"sync"
+	"sync/atomic"
+	"testing"
+)
+
+func TestHookCallbackType(t *testing.T) {
+	mu, err := MakeUc(MODE_32, "\x41\x4a")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer mu.Close()
+	if _, err := mu.HookAdd(HOOK_CODE, func(mu Unicorn) {}, 1, 0); err == nil {
+		t.Fatal("HookAdd accepted a callback of the wrong type")
+	}
+	if _, err := mu.HookAdd(HOOK_MEM_READ_UNMAPPED, func(mu Unicorn, access int, addr uint64, size int, value int64) {}, 1, 0); err == nil {
+		t.Fatal("HookAdd accepted a callback of the wrong type")
+	}
+}
+
+// loop: dec ecx; jnz loop
+const hookLoop = "\x49\x75\xfd"
+
+func benchHookCode(b *testing.B, engines int) {
+	var count uint64
+	// every engine runs its share of b.N hooked instructions
+	insns := uint64(b.N/engines) &^ 1
+	if insns < 2 {
+		insns = 2
+	}
+	mus := make([]Unicorn, engines)
+	for i := range mus {
+		mu, err := MakeUc(MODE_32, hookLoop)
+		if err != nil {
+			b.Fatal(err)
+		}
+		defer mu.Close()
+		if _, err := mu.HookAdd(HOOK_CODE, func(mu Unicorn, addr uint64, size uint32) {
+			atomic.AddUint64(&count, 1)
+		}, 1, 0); err != nil {
+			b.Fatal(err)
+		}
+		mu.RegWrite(X86_REG_ECX, insns/2)
+		mus[i] = mu
+	}
+	var wg sync.WaitGroup
+	b.ResetTimer()
+	for _, mu := range mus {
+		wg.Add(1)
+		go func(mu Unicorn) {
+			defer wg.Done()
+			if err := mu.Start(ADDRESS, ADDRESS+uint64(len(hookLoop))); err != nil {
+				b.Error(err)
+			}
+		}(mu)
+	}
+	wg.Wait()
+	b.StopTimer()
+	if count != insns*uint64(engines) {
+		b.Fatalf("hook ran %d times, expected %d", count, insns*uint64(engines))
+	}
+}
+
+func BenchmarkHookCode(b *testing.B) {
+	for _, engines := range []int{1, 4} {
+		b.Run(fmt.Sprintf("engines=%d", engines), func(b *testing.B) {
+			benchHookCode(b, engines)
+		})
+	}
+}
@@ -34,9 +34,11 @@ const (
 	MODE_MIPS32R6 = 64
 	MODE_MIPS32 = 4
 	MODE_MIPS64 = 8
+	MODE_MIPS32R5 = 128
 	MODE_16 = 2
 	MODE_32 = 4
 	MODE_64 = 8
+	MODE_X87_FAST = 128
 	MODE_PPC32 = 4
 	MODE_PPC64 = 8
 	MODE_QPX = 16
@@ -67,6 +69,8 @@ const (
 	ERR_RESOURCE = 20
 	ERR_EXCEPTION = 21
 	ERR_TIMEOUT = 22
+	ERR_BREAKPOINT = 23
+	ERR_CALL_STOPPED = 24
 	MEM_READ = 16
 	MEM_WRITE = 17
 	MEM_FETCH = 18
@@ -102,10 +106,32 @@ const (
 	QUERY_MODE = 1
 	QUERY_PAGE_SIZE = 2
 	QUERY_ARCH = 3
+	QUERY_EXIT = 4
+	QUERY_VCPU = 5
+	CTX_GPR = 1
+	CTX_FPU = 2
+	CTX_SYS = 4
+	CTX_ALL = 7
+
+	CALL_DEFAULT = 0
+	CALL_CDECL = 1
+	CALL_SYSV64 = 2
+	CALL_MS64 = 3
+	CALL_AAPCS = 4
+	CALL_AAPCS64 = 5
+	CALL_MIPS_O32 = 6
+	CALL_MIPS_N64 = 7
+	TRACE_CODE = 1
+	TRACE_BLOCK = 2
+	TRACE_MEM = 3
+	TRACE_COVERAGE = 4
 
 	PROT_NONE = 0
 	PROT_READ = 1
 	PROT_WRITE = 2
 	PROT_EXEC = 4
 	PROT_ALL = 7
+
+	MAP_PRIVATE = 0
+	MAP_SHARED = 1
 )
\ No newline at end of file
@@ -22,6 +22,8 @@ Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 package unicorn;
 
 import java.io.IOException;
+import java.nio.Buffer;
+import java.nio.ByteBuffer;
 import java.util.*;
 
 public class Unicorn implements UnicornConst, ArmConst, Arm64Const, M68kConst, SparcConst, MipsConst, X86Const {
@@ -603,6 +605,34 @@ public class Unicorn implements UnicornConst, ArmConst, Arm64Const, M68kConst, S
  */
    public native byte[] mem_read(long address, long size) throws UnicornException;
 
+/**
+ * Write to memory from a direct buffer, without copying it to an array first.
+ *
+ * @param  address  Start addres of the memory region to be written.
+ * @param  buffer   Direct buffer holding the values to be written into memory,
+ *                  from its position to its limit. Its position is moved to its limit.
+ */
+   public void mem_write(long address, ByteBuffer buffer) throws UnicornException {
+      mem_write_direct(address, buffer, buffer.position(), buffer.remaining());
+      ((Buffer)buffer).position(buffer.limit());
+   }
+
+/**
+ * Read memory contents into a direct buffer, without allocating an array.
+ *
+ * @param address  Start addres of the memory region to be read.
+ * @param buffer   Direct buffer receiving the contents of memory, from its position
+ *                 to its limit. Its position is moved to its limit.
+ */
+   public void mem_read(long address, ByteBuffer buffer) throws UnicornException {
+      mem_read_direct(address, buffer, buffer.position(), buffer.remaining());
+      ((Buffer)buffer).position(buffer.limit());
+   }
+
+   private native void mem_write_direct(long address, ByteBuffer buffer, int offset, int size) throws UnicornException;
+
+   private native void mem_read_direct(long address, ByteBuffer buffer, int offset, int size) throws UnicornException;
+
 /**
  * Emulate machine code in a specific duration of time.
  *
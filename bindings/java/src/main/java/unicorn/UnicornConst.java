@@ -36,9 +36,11 @@ public interface UnicornConst {
    public static final int UC_MODE_MIPS32R6 = 64;
    public static final int UC_MODE_MIPS32 = 4;
    public static final int UC_MODE_MIPS64 = 8;
+   public static final int UC_MODE_MIPS32R5 = 128;
    public static final int UC_MODE_16 = 2;
    public static final int UC_MODE_32 = 4;
    public static final int UC_MODE_64 = 8;
+   public static final int UC_MODE_X87_FAST = 128;
    public static final int UC_MODE_PPC32 = 4;
    public static final int UC_MODE_PPC64 = 8;
    public static final int UC_MODE_QPX = 16;
@@ -69,6 +71,8 @@ public interface UnicornConst {
    public static final int UC_ERR_RESOURCE = 20;
    public static final int UC_ERR_EXCEPTION = 21;
    public static final int UC_ERR_TIMEOUT = 22;
+   public static final int UC_ERR_BREAKPOINT = 23;
+   public static final int UC_ERR_CALL_STOPPED = 24;
    public static final int UC_MEM_READ = 16;
    public static final int UC_MEM_WRITE = 17;
    public static final int UC_MEM_FETCH = 18;
@@ -104,6 +108,25 @@ public interface UnicornConst {
    public static final int UC_QUERY_MODE = 1;
    public static final int UC_QUERY_PAGE_SIZE = 2;
    public static final int UC_QUERY_ARCH = 3;
+   public static final int UC_QUERY_EXIT = 4;
+   public static final int UC_QUERY_VCPU = 5;
+   public static final int UC_CTX_GPR = 1;
+   public static final int UC_CTX_FPU = 2;
+   public static final int UC_CTX_SYS = 4;
+   public static final int UC_CTX_ALL = 7;
+
+   public static final int UC_CALL_DEFAULT = 0;
+   public static final int UC_CALL_CDECL = 1;
+   public static final int UC_CALL_SYSV64 = 2;
+   public static final int UC_CALL_MS64 = 3;
+   public static final int UC_CALL_AAPCS = 4;
+   public static final int UC_CALL_AAPCS64 = 5;
+   public static final int UC_CALL_MIPS_O32 = 6;
+   public static final int UC_CALL_MIPS_N64 = 7;
+   public static final int UC_TRACE_CODE = 1;
+   public static final int UC_TRACE_BLOCK = 2;
+   public static final int UC_TRACE_MEM = 3;
+   public static final int UC_TRACE_COVERAGE = 4;
 
    public static final int UC_PROT_NONE = 0;
    public static final int UC_PROT_READ = 1;
@@ -111,4 +134,7 @@ public interface UnicornConst {
    public static final int UC_PROT_EXEC = 4;
    public static final int UC_PROT_ALL = 7;
 
+   public static final int UC_MAP_PRIVATE = 0;
+   public static final int UC_MAP_SHARED = 1;
+
 }
@@ -51,6 +51,30 @@ static jmethodID onMemEvent = 0;
 static JavaVM* cachedJVM;
 static jclass jclassUnicorn;
 
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+// JNIEnv of the thread in emu_start(), which runs the callbacks:
+// they use it as is, instead of attaching & detaching the thread every time
+static THREAD_LOCAL JNIEnv *emuEnv;
+
+static JNIEnv *attachEnv(void) {
+    JNIEnv *env = emuEnv;
+    if (env == NULL) {
+        (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+    }
+    return env;
+}
+
+static void detachEnv(JNIEnv *env) {
+    if (env != emuEnv) {
+        (*cachedJVM)->DetachCurrentThread(cachedJVM);
+    }
+}
+
 static jboolean fastDebug = JNI_TRUE;
 static jint singleStep = 0;
 
@@ -151,34 +175,34 @@ static void cb_debugger(uc_engine *eng, uint64_t address, uint32_t size, void *u
     }
     
     if(singleStep == 0 || hitBreakPoint(address)) {
-        (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+        env = attachEnv();
         (*env)->CallVoidMethod(env, user_data, onBreak, (jlong)address, (int)size);
-        (*cachedJVM)->DetachCurrentThread(cachedJVM);
+        detachEnv(env);
     } else if(fastDebug != JNI_TRUE) {
-        (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+        env = attachEnv();
         (*env)->CallVoidMethod(env, user_data, onCode, (jlong)address, (int)size);
-        (*cachedJVM)->DetachCurrentThread(cachedJVM);
+        detachEnv(env);
     }
 }
 
 static void cb_hookcode_new(uc_engine *eng, uint64_t address, uint32_t size, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    (*env)->CallVoidMethod(env, user_data, onCode, (jlong)address, (int)size);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
 }
 
 static void cb_hookblock_new(uc_engine *eng, uint64_t address, uint32_t size, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    (*env)->CallVoidMethod(env, user_data, onBlock, (jlong)address, (int)size);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
 }
 
 static void cb_hookmem_new(uc_engine *eng, uc_mem_type type,
         uint64_t address, int size, int64_t value, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    switch (type) {
       case UC_MEM_READ:
          (*env)->CallVoidMethod(env, user_data, onRead, (jlong)address, (int)size);
@@ -189,22 +213,22 @@ static void cb_hookmem_new(uc_engine *eng, uc_mem_type type,
       default:
          break;
    }
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
 }
 
 static void cb_hookintr_new(uc_engine *eng, uint32_t intno, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    (*env)->CallVoidMethod(env, user_data, onInterrupt, (int)intno);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
 }
 
 static bool cb_eventmem_new(uc_engine *eng, uc_mem_type type,
                         uint64_t address, int size, int64_t value, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    jboolean res = (*env)->CallBooleanMethod(env, user_data, onMemEvent, (int)type, (jlong)address, (int)size, (jlong)value);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
    return res;
 }
 
@@ -214,9 +238,9 @@ static bool cb_eventmem_new(uc_engine *eng, uc_mem_type type,
 // @user_data: user data passed to tracing APIs.
 static void cb_hookcode(uc_engine *eng, uint64_t address, uint32_t size, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    (*env)->CallStaticVoidMethod(env, jclassUnicorn, invokeCodeCallbacks, (jlong)eng, (jlong)address, (int)size);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
 }
 
 // Callback function for tracing code (UC_HOOK_CODE & UC_HOOK_BLOCK)
@@ -225,9 +249,9 @@ static void cb_hookcode(uc_engine *eng, uint64_t address, uint32_t size, void *u
 // @user_data: user data passed to tracing APIs.
 static void cb_hookblock(uc_engine *eng, uint64_t address, uint32_t size, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    (*env)->CallStaticVoidMethod(env, jclassUnicorn, invokeBlockCallbacks, (jlong)eng, (jlong)address, (int)size);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
 }
 
 // Callback function for tracing interrupts (for uc_hook_intr())
@@ -235,9 +259,9 @@ static void cb_hookblock(uc_engine *eng, uint64_t address, uint32_t size, void *
 // @user_data: user data passed to tracing APIs.
 static void cb_hookintr(uc_engine *eng, uint32_t intno, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    (*env)->CallStaticVoidMethod(env, jclassUnicorn, invokeInterruptCallbacks, (jlong)eng, (int)intno);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
 }
 
 // Callback function for tracing IN instruction of X86
@@ -247,9 +271,9 @@ static void cb_hookintr(uc_engine *eng, uint32_t intno, void *user_data) {
 static uint32_t cb_insn_in(uc_engine *eng, uint32_t port, int size, void *user_data) {
    JNIEnv *env;
    uint32_t res = 0;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    res = (uint32_t)(*env)->CallStaticIntMethod(env, jclassUnicorn, invokeInCallbacks, (jlong)eng, (jint)port, (jint)size);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
    return res;
 }
 
@@ -259,17 +283,17 @@ static uint32_t cb_insn_in(uc_engine *eng, uint32_t port, int size, void *user_d
 // @value: data value to be written to this port
 static void cb_insn_out(uc_engine *eng, uint32_t port, int size, uint32_t value, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    (*env)->CallStaticVoidMethod(env, jclassUnicorn, invokeOutCallbacks, (jlong)eng, (jint)port, (jint)size, (jint)value);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
 }
 
 // x86's handler for SYSCALL/SYSENTER
 static void cb_insn_syscall(uc_engine *eng, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    (*env)->CallStaticVoidMethod(env, jclassUnicorn, invokeSyscallCallbacks, (jlong)eng);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
 }
 
 // Callback function for hooking memory (UC_HOOK_MEM_*)
@@ -281,7 +305,7 @@ static void cb_insn_syscall(uc_engine *eng, void *user_data) {
 static void cb_hookmem(uc_engine *eng, uc_mem_type type,
         uint64_t address, int size, int64_t value, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    switch (type) {
       case UC_MEM_READ:
          (*env)->CallStaticVoidMethod(env, jclassUnicorn, invokeReadCallbacks, (jlong)eng, (jlong)address, (int)size);
@@ -292,7 +316,7 @@ static void cb_hookmem(uc_engine *eng, uc_mem_type type,
       default:
          break;
    }
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
 }
 
 // Callback function for handling memory events (for UC_HOOK_MEM_UNMAPPED)
@@ -305,9 +329,9 @@ static void cb_hookmem(uc_engine *eng, uc_mem_type type,
 static bool cb_eventmem(uc_engine *eng, uc_mem_type type,
                         uint64_t address, int size, int64_t value, void *user_data) {
    JNIEnv *env;
-   (*cachedJVM)->AttachCurrentThread(cachedJVM, (void **)&env, NULL);
+   env = attachEnv();
    jboolean res = (*env)->CallStaticBooleanMethod(env, jclassUnicorn, invokeEventMemCallbacks, (jlong)eng, (int)type, (jlong)address, (int)size, (jlong)value);
-   (*cachedJVM)->DetachCurrentThread(cachedJVM);
+   detachEnv(env);
    return res;
 }
 
@@ -617,6 +641,54 @@ JNIEXPORT jbyteArray JNICALL Java_unicorn_Unicorn_mem_1read
    return bytes;
 }
 
+static void *getDirectBuffer(JNIEnv *env, jobject buffer, jint offset, jint size) {
+   jbyte *ptr = (*env)->GetDirectBufferAddress(env, buffer);
+   if (ptr == NULL || offset < 0 || size < 0 || (jlong)offset + size > (*env)->GetDirectBufferCapacity(env, buffer)) {
+      jclass clazz = (*env)->FindClass(env, "java/lang/IllegalArgumentException");
+      (*env)->ThrowNew(env, clazz, "not a direct buffer, or out of its bounds");
+      return NULL;
+   }
+   return ptr + offset;
+}
+
+/*
+ * Class:     unicorn_Unicorn
+ * Method:    mem_write_direct
+ * Signature: (JLjava/nio/ByteBuffer;II)V
+ */
+JNIEXPORT void JNICALL Java_unicorn_Unicorn_mem_1write_1direct
+  (JNIEnv *env, jobject self, jlong address, jobject buffer, jint offset, jint size) {
+   uc_engine *eng = getEngine(env, self);
+   void *ptr = getDirectBuffer(env, buffer, offset, size);
+   if (ptr == NULL) {
+      return;
+   }
+
+   uc_err err = uc_mem_write(eng, (uint64_t)address, ptr, (size_t)size);
+   if (err != UC_ERR_OK) {
+      throwException(env, err);
+   }
+}
+
+/*
+ * Class:     unicorn_Unicorn
+ * Method:    mem_read_direct
+ * Signature: (JLjava/nio/ByteBuffer;II)V
+ */
+JNIEXPORT void JNICALL Java_unicorn_Unicorn_mem_1read_1direct
+  (JNIEnv *env, jobject self, jlong address, jobject buffer, jint offset, jint size) {
+   uc_engine *eng = getEngine(env, self);
+   void *ptr = getDirectBuffer(env, buffer, offset, size);
+   if (ptr == NULL) {
+      return;
+   }
+
+   uc_err err = uc_mem_read(eng, (uint64_t)address, ptr, (size_t)size);
+   if (err != UC_ERR_OK) {
+      throwException(env, err);
+   }
+}
+
 /*
  * Class:     unicorn_Unicorn
  * Method:    emu_start
@@ -625,8 +697,12 @@ JNIEXPORT jbyteArray JNICALL Java_unicorn_Unicorn_mem_1read
 JNIEXPORT void JNICALL Java_unicorn_Unicorn_emu_1start
   (JNIEnv *env, jobject self, jlong begin, jlong until, jlong timeout, jlong count) {
    uc_engine *eng = getEngine(env, self);
+   JNIEnv *prevEnv = emuEnv;
 
+   // callbacks may start emulation again
+   emuEnv = env;
    uc_err err = uc_emu_start(eng, (uint64_t)begin, (uint64_t)until, (uint64_t)timeout, (size_t)count);
+   emuEnv = prevEnv;
    if (err != UC_ERR_OK) {
       throwException(env, err);
    }
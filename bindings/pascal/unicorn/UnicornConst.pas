@@ -37,9 +37,11 @@ const  UC_API_MAJOR = 1;
   UC_MODE_MIPS32R6 = 64;
   UC_MODE_MIPS32 = 4;
   UC_MODE_MIPS64 = 8;
+  UC_MODE_MIPS32R5 = 128;
   UC_MODE_16 = 2;
   UC_MODE_32 = 4;
   UC_MODE_64 = 8;
+  UC_MODE_X87_FAST = 128;
   UC_MODE_PPC32 = 4;
   UC_MODE_PPC64 = 8;
   UC_MODE_QPX = 16;
@@ -70,6 +72,8 @@ const  UC_API_MAJOR = 1;
   UC_ERR_RESOURCE = 20;
   UC_ERR_EXCEPTION = 21;
   UC_ERR_TIMEOUT = 22;
+  UC_ERR_BREAKPOINT = 23;
+  UC_ERR_CALL_STOPPED = 24;
   UC_MEM_READ = 16;
   UC_MEM_WRITE = 17;
   UC_MEM_FETCH = 18;
@@ -105,6 +109,25 @@ const  UC_API_MAJOR = 1;
   UC_QUERY_MODE = 1;
   UC_QUERY_PAGE_SIZE = 2;
   UC_QUERY_ARCH = 3;
+  UC_QUERY_EXIT = 4;
+  UC_QUERY_VCPU = 5;
+  UC_CTX_GPR = 1;
+  UC_CTX_FPU = 2;
+  UC_CTX_SYS = 4;
+  UC_CTX_ALL = 7;
+
+  UC_CALL_DEFAULT = 0;
+  UC_CALL_CDECL = 1;
+  UC_CALL_SYSV64 = 2;
+  UC_CALL_MS64 = 3;
+  UC_CALL_AAPCS = 4;
+  UC_CALL_AAPCS64 = 5;
+  UC_CALL_MIPS_O32 = 6;
+  UC_CALL_MIPS_N64 = 7;
+  UC_TRACE_CODE = 1;
+  UC_TRACE_BLOCK = 2;
+  UC_TRACE_MEM = 3;
+  UC_TRACE_COVERAGE = 4;
 
   UC_PROT_NONE = 0;
   UC_PROT_READ = 1;
@@ -112,5 +135,8 @@ const  UC_API_MAJOR = 1;
   UC_PROT_EXEC = 4;
   UC_PROT_ALL = 7;
 
+  UC_MAP_PRIVATE = 0;
+  UC_MAP_SHARED = 1;
+
 implementation
 end.
\ No newline at end of file
@@ -0,0 +1,75 @@
+#!/usr/bin/env python
+# Time the per-call cost of the Python binding: reading 16 registers one by
+# one and with reg_read_batch(), and reading 64 bytes of memory with
+# mem_read(), mem_read_into() and a mem_view(), in microseconds per call.
+# Then the cost of tracing instructions with a UC_HOOK_CODE callback and with
+# a UC_TRACE_CODE collector, in microseconds per instruction.
+
+from __future__ import print_function
+import sys
+import timeit
+from unicorn import *
+from unicorn.x86_const import *
+
+ADDRESS = 0x1000000
+CALLS = 100000
+LOOPS = 100000
+
+# dec rcx; jnz -5
+LOOP_CODE = b"\x48\xff\xc9\x75\xfb"
+
+REGS = [UC_X86_REG_RAX, UC_X86_REG_RBX, UC_X86_REG_RCX, UC_X86_REG_RDX,
+        UC_X86_REG_RSI, UC_X86_REG_RDI, UC_X86_REG_RBP, UC_X86_REG_RSP,
+        UC_X86_REG_R8, UC_X86_REG_R9, UC_X86_REG_R10, UC_X86_REG_R11,
+        UC_X86_REG_R12, UC_X86_REG_R13, UC_X86_REG_R14, UC_X86_REG_RIP]
+
+
+def main():
+    mu = Uc(UC_ARCH_X86, UC_MODE_64)
+    mu.mem_map(ADDRESS, 0x10000)
+    buf = bytearray(64)
+    view = mu.mem_view(ADDRESS, 0x10000)
+
+    benches = [
+        ("reg_read x16", lambda: [mu.reg_read(r) for r in REGS]),
+        ("reg_read_batch", lambda: mu.reg_read_batch(REGS)),
+        ("mem_read", lambda: mu.mem_read(ADDRESS + 0x100, 64)),
+        ("mem_read_into", lambda: mu.mem_read_into(ADDRESS + 0x100, buf)),
+        ("mem_view", lambda: view[0x100:0x140]),
+    ]
+
+    for name, fn in benches:
+        if len(sys.argv) > 1 and sys.argv[1] != name.split()[0]:
+            continue
+        t = timeit.timeit(fn, number=CALLS)
+        print("%-16s %8.3f us" % (name, t * 1e6 / CALLS))
+
+    traces = [("hook_code", trace_hook), ("trace_code", trace_collector)]
+
+    for name, fn in traces:
+        if len(sys.argv) > 1 and sys.argv[1] != name:
+            continue
+        mu = Uc(UC_ARCH_X86, UC_MODE_64)
+        mu.mem_map(ADDRESS, 0x1000)
+        mu.mem_write(ADDRESS, LOOP_CODE)
+        mu.reg_write(UC_X86_REG_RCX, LOOPS)
+        t = timeit.timeit(lambda: fn(mu), number=1)
+        print("%-16s %8.3f us" % (name, t * 1e6 / (2 * LOOPS)))
+
+
+def trace_hook(mu):
+    pcs = []
+    mu.hook_add(UC_HOOK_CODE, lambda uc, address, size, user_data: pcs.append(address))
+    mu.emu_start(ADDRESS, ADDRESS + len(LOOP_CODE))
+    assert len(pcs) == 2 * LOOPS
+
+
+def trace_collector(mu):
+    h = mu.trace_add(UC_TRACE_CODE)
+    mu.emu_start(ADDRESS, ADDRESS + len(LOOP_CODE))
+    pcs = mu.trace_get(h)
+    assert len(pcs) == 2 * LOOPS
+
+
+if __name__ == '__main__':
+    main()
@@ -116,6 +116,41 @@ class _uc_mem_region(ctypes.Structure):
     ]
 
 
+class _uc_mem_page(ctypes.Structure):
+    _fields_ = [
+        ("begin", ctypes.c_uint64),
+        ("size",  ctypes.c_size_t),
+        ("perms", ctypes.c_uint32),
+        ("ptr",   ctypes.c_void_p),
+        ("data",  ctypes.c_void_p),
+    ]
+
+
+class _uc_batch_patch(ctypes.Structure):
+    _fields_ = [
+        ("address", ctypes.c_uint64),
+        ("data",    ctypes.c_void_p),
+        ("size",    ctypes.c_size_t),
+    ]
+
+
+class _uc_batch_job(ctypes.Structure):
+    _fields_ = [
+        ("context",  uc_context),
+        ("patches",  ctypes.POINTER(_uc_batch_patch)),
+        ("npatches", ctypes.c_size_t),
+        ("results",  ctypes.POINTER(ctypes.c_uint64)),
+        ("err",      ucerr),
+    ]
+
+
+class _uc_cache_info(ctypes.Structure):
+    _fields_ = [
+        ("blocks",    ctypes.c_size_t),
+        ("code_size", ctypes.c_size_t),
+    ]
+
+
 _setup_prototype(_uc, "uc_version", ctypes.c_uint, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int))
 _setup_prototype(_uc, "uc_arch_supported", ctypes.c_bool, ctypes.c_int)
 _setup_prototype(_uc, "uc_open", ucerr, ctypes.c_uint, ctypes.c_uint, ctypes.POINTER(uc_engine))
@@ -124,15 +159,36 @@ _setup_prototype(_uc, "uc_strerror", ctypes.c_char_p, ucerr)
 _setup_prototype(_uc, "uc_errno", ucerr, uc_engine)
 _setup_prototype(_uc, "uc_reg_read", ucerr, uc_engine, ctypes.c_int, ctypes.c_void_p)
 _setup_prototype(_uc, "uc_reg_write", ucerr, uc_engine, ctypes.c_int, ctypes.c_void_p)
+_setup_prototype(_uc, "uc_reg_read_batch", ucerr, uc_engine, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_void_p), ctypes.c_int)
+_setup_prototype(_uc, "uc_reg_write_batch", ucerr, uc_engine, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_void_p), ctypes.c_int)
 _setup_prototype(_uc, "uc_mem_read", ucerr, uc_engine, ctypes.c_uint64, ctypes.POINTER(ctypes.c_char), ctypes.c_size_t)
 _setup_prototype(_uc, "uc_mem_write", ucerr, uc_engine, ctypes.c_uint64, ctypes.POINTER(ctypes.c_char), ctypes.c_size_t)
 _setup_prototype(_uc, "uc_emu_start", ucerr, uc_engine, ctypes.c_uint64, ctypes.c_uint64, ctypes.c_uint64, ctypes.c_size_t)
 _setup_prototype(_uc, "uc_emu_stop", ucerr, uc_engine)
+_setup_prototype(_uc, "uc_call", ucerr, uc_engine, ctypes.c_uint64, ctypes.c_int, ctypes.POINTER(ctypes.c_uint64), ctypes.c_size_t, ctypes.POINTER(ctypes.c_uint64), ctypes.c_uint64, ctypes.c_size_t)
+_setup_prototype(_uc, "uc_emu_batch", ucerr, uc_engine, ctypes.c_uint64, ctypes.c_uint64, ctypes.c_uint64, ctypes.c_size_t, ctypes.POINTER(ctypes.c_int), ctypes.c_size_t, ctypes.POINTER(_uc_batch_job), ctypes.c_size_t)
+_setup_prototype(_uc, "uc_breakpoint_add", ucerr, uc_engine, ctypes.c_uint64)
+_setup_prototype(_uc, "uc_breakpoint_del", ucerr, uc_engine, ctypes.c_uint64)
+_setup_prototype(_uc, "uc_emu_set_exits", ucerr, uc_engine, ctypes.POINTER(ctypes.c_uint64), ctypes.c_size_t)
+_setup_prototype(_uc, "uc_vcpu_add", ucerr, uc_engine, ctypes.POINTER(ctypes.c_int))
+_setup_prototype(_uc, "uc_vcpu_select", ucerr, uc_engine, ctypes.c_int)
+_setup_prototype(_uc, "uc_vcpu_set_quantum", ucerr, uc_engine, ctypes.c_uint32)
+_setup_prototype(_uc, "uc_cache_translate", ucerr, uc_engine, ctypes.c_uint64, ctypes.c_uint64, ctypes.c_uint64, ctypes.POINTER(_uc_cache_info))
+_setup_prototype(_uc, "uc_cache_flush", ucerr, uc_engine)
+_setup_prototype(_uc, "uc_cache_save_list", ucerr, uc_engine, ctypes.c_char_p)
+_setup_prototype(_uc, "uc_cache_translate_list", ucerr, uc_engine, ctypes.c_char_p, ctypes.c_uint64, ctypes.POINTER(_uc_cache_info))
 _setup_prototype(_uc, "uc_hook_del", ucerr, uc_engine, uc_hook_h)
+_setup_prototype(_uc, "uc_trace_add", ucerr, uc_engine, ctypes.POINTER(uc_hook_h), ctypes.c_int, ctypes.c_uint64, ctypes.c_uint64)
+_setup_prototype(_uc, "uc_trace_get", ucerr, uc_engine, uc_hook_h, ctypes.POINTER(ctypes.c_void_p), ctypes.POINTER(ctypes.c_size_t))
+_setup_prototype(_uc, "uc_trace_reset", ucerr, uc_engine, uc_hook_h)
+_setup_prototype(_uc, "uc_trace_del", ucerr, uc_engine, uc_hook_h)
 _setup_prototype(_uc, "uc_mem_map", ucerr, uc_engine, ctypes.c_uint64, ctypes.c_size_t, ctypes.c_uint32)
 _setup_prototype(_uc, "uc_mem_map_ptr", ucerr, uc_engine, ctypes.c_uint64, ctypes.c_size_t, ctypes.c_uint32, ctypes.c_void_p)
+_setup_prototype(_uc, "uc_mem_map_file", ucerr, uc_engine, ctypes.c_uint64, ctypes.c_size_t, ctypes.c_uint32, ctypes.c_int, ctypes.c_uint64, ctypes.c_uint32)
 _setup_prototype(_uc, "uc_mem_unmap", ucerr, uc_engine, ctypes.c_uint64, ctypes.c_size_t)
 _setup_prototype(_uc, "uc_mem_protect", ucerr, uc_engine, ctypes.c_uint64, ctypes.c_size_t, ctypes.c_uint32)
+_setup_prototype(_uc, "uc_mem_flat_enable", ucerr, uc_engine)
+_setup_prototype(_uc, "uc_mem_set_pager", ucerr, uc_engine, ctypes.c_void_p, ctypes.c_void_p)
 _setup_prototype(_uc, "uc_query", ucerr, uc_engine, ctypes.c_uint32, ctypes.POINTER(ctypes.c_size_t))
 _setup_prototype(_uc, "uc_context_alloc", ucerr, uc_engine, ctypes.POINTER(uc_context))
 _setup_prototype(_uc, "uc_free", ucerr, ctypes.c_void_p)
@@ -140,6 +196,7 @@ _setup_prototype(_uc, "uc_context_save", ucerr, uc_engine, uc_context)
 _setup_prototype(_uc, "uc_context_restore", ucerr, uc_engine, uc_context)
 _setup_prototype(_uc, "uc_context_size", ctypes.c_size_t, uc_engine)
 _setup_prototype(_uc, "uc_mem_regions", ucerr, uc_engine, ctypes.POINTER(ctypes.POINTER(_uc_mem_region)), ctypes.POINTER(ctypes.c_uint32))
+_setup_prototype(_uc, "uc_mem_host_ptr", ucerr, uc_engine, ctypes.c_uint64, ctypes.POINTER(ctypes.c_void_p), ctypes.POINTER(ctypes.c_size_t))
 
 # uc_hook_add is special due to variable number of arguments
 _uc.uc_hook_add = _uc.uc_hook_add
@@ -166,6 +223,10 @@ UC_HOOK_INSN_OUT_CB = ctypes.CFUNCTYPE(
     ctypes.c_int, ctypes.c_uint32, ctypes.c_void_p
 )
 UC_HOOK_INSN_SYSCALL_CB = ctypes.CFUNCTYPE(None, uc_engine, ctypes.c_void_p)
+UC_MEM_PAGER_CB = ctypes.CFUNCTYPE(
+    ctypes.c_bool, uc_engine, ctypes.c_int,
+    ctypes.c_uint64, ctypes.c_int, ctypes.POINTER(_uc_mem_page), ctypes.c_void_p
+)
 
 
 # access to error code via @errno of UcError
@@ -237,6 +298,15 @@ class uc_x86_ymm(ctypes.Structure):
         ("fourth_qword", ctypes.c_uint64),
     ]
 
+class uc_trace_mem_access(ctypes.Structure):
+    """memory access recorded by a UC_TRACE_MEM collector"""
+    _fields_ = [
+        ("address", ctypes.c_uint64),
+        ("value", ctypes.c_int64),
+        ("type", ctypes.c_uint32),
+        ("size", ctypes.c_uint32),
+    ]
+
 class uc_arm64_neon128(ctypes.Structure):
     """128-bit neon register"""
     _fields_ = [
@@ -244,6 +314,19 @@ class uc_arm64_neon128(ctypes.Structure):
         ("high_qword", ctypes.c_uint64),
     ]
 
+# registers read & written through a structure rather than a 64-bit number
+def _wide_regs(arch):
+    if arch == uc.UC_ARCH_X86:
+        return frozenset([x86_const.UC_X86_REG_IDTR, x86_const.UC_X86_REG_GDTR, x86_const.UC_X86_REG_LDTR, x86_const.UC_X86_REG_TR, x86_const.UC_X86_REG_MSR] +
+                         list(range(x86_const.UC_X86_REG_FP0, x86_const.UC_X86_REG_FP0+8)) +
+                         list(range(x86_const.UC_X86_REG_XMM0, x86_const.UC_X86_REG_XMM0+8)) +
+                         list(range(x86_const.UC_X86_REG_YMM0, x86_const.UC_X86_REG_YMM0+16)))
+    if arch == uc.UC_ARCH_ARM64:
+        return frozenset(list(range(arm64_const.UC_ARM64_REG_Q0, arm64_const.UC_ARM64_REG_Q31+1)) +
+                         list(range(arm64_const.UC_ARM64_REG_V0, arm64_const.UC_ARM64_REG_V31+1)))
+    return frozenset()
+
+
 # Subclassing ref to allow property assignment.
 class UcRef(weakref.ref):
     pass
@@ -298,6 +381,12 @@ class Uc(object):
         self._callbacks = {}
         self._ctype_cbs = {}
         self._callback_count = 0
+        # scratch register for reg_read() & reg_write(), and arrays for the batches
+        self._wide_regs = _wide_regs(arch)
+        self._reg = ctypes.c_uint64(0)
+        self._reg_ref = ctypes.byref(self._reg)
+        self._batches = {}
+        self._traces = {}
         self._cleanup.register(self)
 
     @staticmethod
@@ -322,8 +411,124 @@ class Uc(object):
         if status != uc.UC_ERR_OK:
             raise UcError(status)
 
+    # call a guest function with integer arguments, and return its result
+    # (raises UcError(UC_ERR_CALL_STOPPED) if emulation stopped before the
+    # function returned)
+    def call(self, address, args=(), conv=uc.UC_CALL_DEFAULT, timeout=0, count=0):
+        _args = (ctypes.c_uint64 * len(args))(*[a & 0xffffffffffffffff for a in args])
+        result = ctypes.c_uint64(0)
+        status = _uc.uc_call(self._uch, address, conv, _args, len(args), ctypes.byref(result), timeout, count)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+        return result.value
+
+    # run from @begin to @until once per input, each input being a list of
+    # (address, bytes) written to memory before its run. Memory and registers
+    # are put back after each run. This returns a list of (error, values of
+    # @regs) per input, where error is UC_ERR_OK or the error of the run.
+    def emu_batch(self, begin, until, inputs, regs=(), timeout=0, count=0):
+        inputs = list(inputs)
+        _regs = (ctypes.c_int * len(regs))(*regs)
+        results = (ctypes.c_uint64 * (len(regs) * len(inputs)))()
+        jobs = (_uc_batch_job * len(inputs))()
+        keep = []
+        for i, patches in enumerate(inputs):
+            _patches = (_uc_batch_patch * len(patches))()
+            for j, (address, data) in enumerate(patches):
+                data = ctypes.create_string_buffer(bytes(data), len(data))
+                keep.append(data)
+                _patches[j].address = address
+                _patches[j].data = ctypes.addressof(data)
+                _patches[j].size = len(data)
+            keep.append(_patches)
+            jobs[i].patches = _patches
+            jobs[i].npatches = len(patches)
+            jobs[i].results = ctypes.cast(ctypes.byref(results, i * len(regs) * 8), ctypes.POINTER(ctypes.c_uint64))
+        status = _uc.uc_emu_batch(self._uch, begin, until, timeout, count, _regs, len(regs), jobs, len(inputs))
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+        n = len(regs)
+        return [(jobs[i].err, list(results[i * n:(i + 1) * n])) for i in range(len(inputs))]
+
+    # stop emulation right before the instruction at this address,
+    # emu_start() then raises UcError(UC_ERR_BREAKPOINT)
+    def breakpoint_add(self, address):
+        status = _uc.uc_breakpoint_add(self._uch, address)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
+    def breakpoint_del(self, address):
+        status = _uc.uc_breakpoint_del(self._uch, address)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
+    # stop emulation right before any of these addresses,
+    # query(UC_QUERY_EXIT) then returns the index of the exit reached
+    def emu_set_exits(self, exits):
+        exits = list(exits)
+        arr = (ctypes.c_uint64 * len(exits))(*exits)
+        status = _uc.uc_emu_set_exits(self._uch, arr, len(exits))
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
+    # add a vCPU sharing memory, hooks & translated code, return its index
+    def vcpu_add(self):
+        index = ctypes.c_int()
+        status = _uc.uc_vcpu_add(self._uch, ctypes.byref(index))
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+        return index.value
+
+    # make reg_*(), context_*() & the @begin of emu_start() apply to this vCPU
+    def vcpu_select(self, index):
+        status = _uc.uc_vcpu_select(self._uch, index)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
+    # instructions each vCPU runs before emu_start() switches to the next one
+    def vcpu_set_quantum(self, quantum):
+        status = _uc.uc_vcpu_set_quantum(self._uch, quantum)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
+    # translate code in [@begin, @end) ahead of emulation stopping at @until,
+    # return the number of blocks translated & the size of their host code
+    def cache_translate(self, begin, end, until):
+        info = _uc_cache_info()
+        status = _uc.uc_cache_translate(self._uch, begin, end, until, ctypes.byref(info))
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+        return (info.blocks, info.code_size)
+
+    # drop all translated code
+    def cache_flush(self):
+        status = _uc.uc_cache_flush(self._uch)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
+    # save the list of translated blocks to a file, to pre-translate them later
+    def cache_save_list(self, path):
+        status = _uc.uc_cache_save_list(self._uch, path.encode())
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
+    # translate the blocks listed by cache_save_list(), ahead of emulation stopping at @until
+    def cache_translate_list(self, path, until):
+        info = _uc_cache_info()
+        status = _uc.uc_cache_translate_list(self._uch, path.encode(), until, ctypes.byref(info))
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+        return (info.blocks, info.code_size)
+
     # return the value of a register
     def reg_read(self, reg_id, opt=None):
+        if reg_id not in self._wide_regs:
+            # read to 64bit number to be safe
+            status = _uc.uc_reg_read(self._uch, reg_id, self._reg_ref)
+            if status != uc.UC_ERR_OK:
+                raise UcError(status)
+            return self._reg.value
+
         if self._arch == uc.UC_ARCH_X86:
             if reg_id in [x86_const.UC_X86_REG_IDTR, x86_const.UC_X86_REG_GDTR, x86_const.UC_X86_REG_LDTR, x86_const.UC_X86_REG_TR]:
                 reg = uc_x86_mmr()
@@ -360,7 +565,7 @@ class Uc(object):
                 return reg.value
 
         if self._arch == uc.UC_ARCH_ARM64:
-            if reg_id in range(arm64_const.UC_ARM64_REG_Q0, arm64_const.UC_ARM64_REG_Q31+1) or range(arm64_const.UC_ARM64_REG_V0, arm64_const.UC_ARM64_REG_V31+1):
+            if reg_id in range(arm64_const.UC_ARM64_REG_Q0, arm64_const.UC_ARM64_REG_Q31+1) or reg_id in range(arm64_const.UC_ARM64_REG_V0, arm64_const.UC_ARM64_REG_V31+1):
                 reg = uc_arm64_neon128()
                 status = _uc.uc_reg_read(self._uch, reg_id, ctypes.byref(reg))
                 if status != uc.UC_ERR_OK:
@@ -378,6 +583,14 @@ class Uc(object):
     def reg_write(self, reg_id, value):
         reg = None
 
+        if reg_id not in self._wide_regs:
+            # convert to 64bit number to be safe
+            self._reg.value = value
+            status = _uc.uc_reg_write(self._uch, reg_id, self._reg_ref)
+            if status != uc.UC_ERR_OK:
+                raise UcError(status)
+            return
+
         if self._arch == uc.UC_ARCH_X86:
             if reg_id in [x86_const.UC_X86_REG_IDTR, x86_const.UC_X86_REG_GDTR, x86_const.UC_X86_REG_LDTR, x86_const.UC_X86_REG_TR]:
                 assert isinstance(value, tuple) and len(value) == 4
@@ -406,7 +619,7 @@ class Uc(object):
                 reg.value = value[1]
 
         if self._arch == uc.UC_ARCH_ARM64:
-            if reg_id in range(arm64_const.UC_ARM64_REG_Q0, arm64_const.UC_ARM64_REG_Q31+1) or range(arm64_const.UC_ARM64_REG_V0, arm64_const.UC_ARM64_REG_V31+1):
+            if reg_id in range(arm64_const.UC_ARM64_REG_Q0, arm64_const.UC_ARM64_REG_Q31+1) or reg_id in range(arm64_const.UC_ARM64_REG_V0, arm64_const.UC_ARM64_REG_V31+1):
                 reg = uc_arm64_neon128()
                 reg.low_qword = value & 0xffffffffffffffff
                 reg.high_qword = value >> 64
@@ -419,6 +632,34 @@ class Uc(object):
         if status != uc.UC_ERR_OK:
             raise UcError(status)
 
+    # arrays of register IDs & 64-bit values for a batch of registers, kept for the next time
+    def _batch(self, reg_ids):
+        reg_ids = tuple(reg_ids)
+        batch = self._batches.get(reg_ids)
+        if batch is None:
+            count = len(reg_ids)
+            vals = (ctypes.c_uint64 * count)()
+            ptrs = (ctypes.c_void_p * count)(*[ctypes.addressof(vals) + 8 * i for i in range(count)])
+            batch = ((ctypes.c_int * count)(*reg_ids), vals, ptrs, count)
+            self._batches[reg_ids] = batch
+        return batch
+
+    # return the values of several registers of up to 64 bits, in one call
+    def reg_read_batch(self, reg_ids):
+        ids, vals, ptrs, count = self._batch(reg_ids)
+        status = _uc.uc_reg_read_batch(self._uch, ids, ptrs, count)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+        return vals[:]
+
+    # write to several registers of up to 64 bits, in one call
+    def reg_write_batch(self, reg_ids, values):
+        ids, vals, ptrs, count = self._batch(reg_ids)
+        vals[:] = values
+        status = _uc.uc_reg_write_batch(self._uch, ids, ptrs, count)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
     # read from MSR - X86 only
     def msr_read(self, msr_id):
         return self.reg_read(x86_const.UC_X86_REG_MSR, msr_id)
@@ -435,6 +676,29 @@ class Uc(object):
             raise UcError(status)
         return bytearray(data)
 
+    # read data from memory into a writable buffer (bytearray, memoryview, array...),
+    # as many bytes as it holds
+    def mem_read_into(self, address, buf):
+        view = memoryview(buf)
+        size = view.nbytes
+        status = _uc.uc_mem_read(self._uch, address, (ctypes.c_char * size).from_buffer(view), size)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
+    # return a memoryview of mapped memory, which accesses it without copies.
+    # it must not be used after this memory is unmapped or protected again, nor after close.
+    # call cache_flush() after modifying code through it, or the old code keeps running
+    def mem_view(self, address, size):
+        ptr = ctypes.c_void_p()
+        avail = ctypes.c_size_t()
+        status = _uc.uc_mem_host_ptr(self._uch, address, ctypes.byref(ptr), ctypes.byref(avail))
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+        if size > avail.value:
+            # not contiguous in host memory
+            raise UcError(uc.UC_ERR_ARG)
+        return memoryview((ctypes.c_ubyte * size).from_address(ptr.value)).cast('B')
+
     # write to memory
     def mem_write(self, address, data):
         status = _uc.uc_mem_write(self._uch, address, data, len(data))
@@ -453,6 +717,14 @@ class Uc(object):
         if status != uc.UC_ERR_OK:
             raise UcError(status)
 
+    # map a range of memory from a file, given as a descriptor or a file object
+    def mem_map_file(self, address, size, fd, offset=0, perms=uc.UC_PROT_ALL, flags=uc.UC_MAP_PRIVATE):
+        if hasattr(fd, "fileno"):
+            fd = fd.fileno()
+        status = _uc.uc_mem_map_file(self._uch, address, size, perms, fd, offset, flags)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
     # unmap a range of memory
     def mem_unmap(self, address, size):
         status = _uc.uc_mem_unmap(self._uch, address, size)
@@ -465,6 +737,38 @@ class Uc(object):
         if status != uc.UC_ERR_OK:
             raise UcError(status)
 
+    # back guest memory with flat host memory, before mapping any
+    def mem_flat_enable(self):
+        status = _uc.uc_mem_flat_enable(self._uch)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
+    def _mem_pager_cb(self, handle, access, address, size, page, user_data):
+        (cb, data) = self._pager
+        res = cb(self, access, address, size, page.contents, data)
+        if isinstance(res, (bytes, bytearray)):
+            # content of the page, copied when it is mapped
+            if len(res) != page.contents.size:
+                return False
+            self._pager_data = ctypes.create_string_buffer(bytes(res), len(res))
+            page.contents.data = ctypes.cast(self._pager_data, ctypes.c_void_p)
+            return True
+        return bool(res)
+
+    # set a demand-paging callback, called as callback(uc, access, address, size, page, user_data)
+    # it returns False to leave the access unmapped, True to map @page, or the page content as bytes
+    def mem_set_pager(self, callback, user_data=None):
+        if callback is None:
+            cb = None
+        else:
+            self._pager = (callback, user_data)
+            cb = ctypes.cast(UC_MEM_PAGER_CB(self._mem_pager_cb), UC_MEM_PAGER_CB)
+        status = _uc.uc_mem_set_pager(self._uch, cb, None)
+        # save the ctype function so gc will leave it alone.
+        self._pager_cb = cb
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
     # return CPU mode at runtime
     def query(self, query_mode):
         result = ctypes.c_size_t(0)
@@ -595,6 +899,42 @@ class Uc(object):
             raise UcError(status)
         h = 0
 
+    # add a collector, which records events of this type in native memory
+    # during emulation, instead of calling back Python for each of them
+    def trace_add(self, trace_type, begin=1, end=0):
+        _h = uc_hook_h()
+        status = _uc.uc_trace_add(self._uch, ctypes.byref(_h), trace_type, begin, end)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+        self._traces[_h.value] = uc_trace_mem_access if trace_type == uc.UC_TRACE_MEM else ctypes.c_uint64
+        return _h.value
+
+    # return a copy of the records of a collector, as a ctypes array of addresses,
+    # or of uc_trace_mem_access for UC_TRACE_MEM: numpy.frombuffer() takes both
+    def trace_get(self, h):
+        records = ctypes.c_void_p()
+        count = ctypes.c_size_t()
+        status = _uc.uc_trace_get(self._uch, h, ctypes.byref(records), ctypes.byref(count))
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+        data = (self._traces[h] * count.value)()
+        if count.value:
+            ctypes.memmove(data, records, ctypes.sizeof(data))
+        return data
+
+    # drop the records of a collector
+    def trace_reset(self, h):
+        status = _uc.uc_trace_reset(self._uch, h)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+
+    # delete a collector
+    def trace_del(self, h):
+        status = _uc.uc_trace_del(self._uch, h)
+        if status != uc.UC_ERR_OK:
+            raise UcError(status)
+        del self._traces[h]
+
     def context_save(self):
         size = _uc.uc_context_size(self._uch)
 
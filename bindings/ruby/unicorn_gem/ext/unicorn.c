@@ -30,6 +30,8 @@ VALUE UcError = Qnil;
 VALUE SavedContext = Qnil;
 VALUE Hook = Qnil;
 
+static ID id_call;
+
 
 void Init_unicorn_engine() {
     rb_require("unicorn_engine/unicorn_const");
@@ -45,16 +47,23 @@ void Init_unicorn_engine() {
     rb_define_method(UcClass, "reg_read", m_uc_reg_read, 1);
     rb_define_method(UcClass, "reg_write", m_uc_reg_write, 2);
     rb_define_method(UcClass, "mem_read", m_uc_mem_read, 2);
+    rb_define_method(UcClass, "mem_read_into", m_uc_mem_read_into, -1);
     rb_define_method(UcClass, "mem_write", m_uc_mem_write, 2);
     rb_define_method(UcClass, "mem_map", m_uc_mem_map, -1);
     rb_define_method(UcClass, "mem_unmap", m_uc_mem_unmap, 2);
     rb_define_method(UcClass, "mem_protect", m_uc_mem_protect, 3);
     rb_define_method(UcClass, "hook_add", m_uc_hook_add, -1);
     rb_define_method(UcClass, "hook_del", m_uc_hook_del, 1);
+    rb_define_method(UcClass, "trace_add", m_uc_trace_add, -1);
+    rb_define_method(UcClass, "trace_get", m_uc_trace_get, 1);
+    rb_define_method(UcClass, "trace_reset", m_uc_trace_reset, 1);
+    rb_define_method(UcClass, "trace_del", m_uc_trace_del, 1);
     rb_define_method(UcClass, "query", m_uc_query, 1);
     rb_define_method(UcClass, "context_save", m_uc_context_save, 0);
     rb_define_method(UcClass, "context_update", m_uc_context_update, 1);
     rb_define_method(UcClass, "context_restore", m_uc_context_restore, 1);
+
+    id_call = rb_intern("call");
 }
 
 VALUE m_uc_initialize(VALUE self, VALUE arch, VALUE mode) {
@@ -68,6 +77,7 @@ VALUE m_uc_initialize(VALUE self, VALUE arch, VALUE mode) {
     VALUE uc = Data_Wrap_Struct(UcClass, 0, uc_close, _uc);
     rb_iv_set(self, "@uch", uc);
     rb_iv_set(self, "@hooks", rb_ary_new());
+    rb_iv_set(self, "@traces", rb_hash_new());
     
     return self;
 }
@@ -274,16 +284,44 @@ VALUE m_uc_reg_write(VALUE self, VALUE reg_id, VALUE reg_value){
 
 VALUE m_uc_mem_read(VALUE self, VALUE address, VALUE size){
     size_t isize = NUM2UINT(size);
-    uint8_t bytes[isize];
+    VALUE bytes = rb_str_new(NULL, isize);
+    uc_err err;
+    uc_engine *_uc;
+    Data_Get_Struct(rb_iv_get(self,"@uch"), uc_engine, _uc);
+
+    err = uc_mem_read(_uc, NUM2ULL(address), RSTRING_PTR(bytes), isize);
+    if (err != UC_ERR_OK) {
+      rb_raise(UcError, "%s", uc_strerror(err));
+    }
+    return bytes;
+}
+
+// read into an existing string, by default filling it, and return it
+VALUE m_uc_mem_read_into(int argc, VALUE* argv, VALUE self){
+    VALUE address;
+    VALUE bytes;
+    VALUE size;
+    size_t isize;
     uc_err err;
     uc_engine *_uc;
     Data_Get_Struct(rb_iv_get(self,"@uch"), uc_engine, _uc);
 
-    err = uc_mem_read(_uc, NUM2ULL(address), &bytes, isize);
+    rb_scan_args(argc, argv, "21", &address, &bytes, &size);
+    StringValue(bytes);
+    rb_str_modify(bytes);
+    if (NIL_P(size)) {
+        isize = RSTRING_LEN(bytes);
+    } else {
+        isize = NUM2UINT(size);
+        if (isize > (size_t)RSTRING_LEN(bytes))
+            rb_str_resize(bytes, isize);
+    }
+
+    err = uc_mem_read(_uc, NUM2ULL(address), RSTRING_PTR(bytes), isize);
     if (err != UC_ERR_OK) {
       rb_raise(UcError, "%s", uc_strerror(err));
     }
-    return rb_str_new(bytes, isize);
+    return bytes;
 }
 
 VALUE m_uc_mem_write(VALUE self, VALUE address, VALUE bytes){
@@ -346,7 +384,7 @@ static void cb_hook_code(uc_engine *uc, uint64_t address, uint32_t size, void *u
     cb = hook->cb;
     ud = hook->ud;
     rUc = hook->rUc;
-    rb_funcall(cb, rb_intern("call"), 4, rUc, ULL2NUM(address), UINT2NUM(size), ud);
+    rb_funcall(cb, id_call, 4, rUc, ULL2NUM(address), UINT2NUM(size), ud);
 }
 
 static void cb_hook_mem_access(uc_engine *uc, uint32_t access, uint64_t address, uint32_t size, int64_t value, void *user_data){
@@ -358,7 +396,7 @@ static void cb_hook_mem_access(uc_engine *uc, uint32_t access, uint64_t address,
     cb = hook->cb;
     ud = hook->ud;
     rUc = hook->rUc;
-    rb_funcall(cb, rb_intern("call"), 6, rUc, UINT2NUM(access), ULL2NUM(address), UINT2NUM(size), LL2NUM(value), ud);
+    rb_funcall(cb, id_call, 6, rUc, UINT2NUM(access), ULL2NUM(address), UINT2NUM(size), LL2NUM(value), ud);
 }
 
 static bool cb_hook_mem_invalid(uc_engine *uc, uint32_t access, uint64_t address, uint32_t size, int64_t value, void *user_data){
@@ -371,7 +409,7 @@ static bool cb_hook_mem_invalid(uc_engine *uc, uint32_t access, uint64_t address
     ud = hook->ud;
     rUc = hook->rUc;
     
-    return RTEST(rb_funcall(cb, rb_intern("call"), 6, rUc, UINT2NUM(access), ULL2NUM(address), UINT2NUM(size), LL2NUM(value), ud));
+    return RTEST(rb_funcall(cb, id_call, 6, rUc, UINT2NUM(access), ULL2NUM(address), UINT2NUM(size), LL2NUM(value), ud));
 }
 
 static uint32_t cb_hook_insn_in(uc_engine *uc, uint32_t port, int size, void *user_data){
@@ -383,7 +421,7 @@ static uint32_t cb_hook_insn_in(uc_engine *uc, uint32_t port, int size, void *us
     cb = hook->cb;
     ud = hook->ud;
     rUc = hook->rUc;
-    return NUM2UINT(rb_funcall(cb, rb_intern("call"), 4, rUc, UINT2NUM(port), INT2NUM(size), ud));
+    return NUM2UINT(rb_funcall(cb, id_call, 4, rUc, UINT2NUM(port), INT2NUM(size), ud));
 }
 
 static void cb_hook_insn_out(uc_engine *uc, uint32_t port, int size, uint32_t value, void *user_data){
@@ -395,7 +433,7 @@ static void cb_hook_insn_out(uc_engine *uc, uint32_t port, int size, uint32_t va
     cb = hook->cb;
     ud = hook->ud;
     rUc = hook->rUc;
-    rb_funcall(cb, rb_intern("call"), 5, rUc, UINT2NUM(port), INT2NUM(size), UINT2NUM(value), ud);
+    rb_funcall(cb, id_call, 5, rUc, UINT2NUM(port), INT2NUM(size), UINT2NUM(value), ud);
 }
 
 static void cb_hook_insn_syscall(uc_engine *uc, void *user_data){
@@ -407,7 +445,7 @@ static void cb_hook_insn_syscall(uc_engine *uc, void *user_data){
     cb = hook->cb;
     ud = hook->ud;
     rUc = hook->rUc;
-    rb_funcall(cb, rb_intern("call"), 2, rUc, ud);
+    rb_funcall(cb, id_call, 2, rUc, ud);
 }
 
 static void cb_hook_intr(uc_engine *uc, uint32_t intno, void *user_data){
@@ -419,7 +457,7 @@ static void cb_hook_intr(uc_engine *uc, uint32_t intno, void *user_data){
     cb = hook->cb;
     ud = hook->ud;
     rUc = hook->rUc;
-    rb_funcall(cb, rb_intern("call"), 3, rUc, ULL2NUM(intno), ud);
+    rb_funcall(cb, id_call, 3, rUc, ULL2NUM(intno), ud);
 }
 
 static void mark_hook(void *p){
@@ -525,6 +563,76 @@ VALUE m_uc_hook_del(VALUE self, VALUE hook){
     return Qnil;
 }
 
+VALUE m_uc_trace_add(int argc, VALUE* argv, VALUE self){
+    VALUE trace_type;
+    VALUE begin;
+    VALUE end;
+    uc_hook trace;
+    size_t record_size;
+    uc_err err;
+    uc_engine *_uc;
+    Data_Get_Struct(rb_iv_get(self, "@uch"), uc_engine, _uc);
+
+    rb_scan_args(argc, argv, "12", &trace_type, &begin, &end);
+    if (NIL_P(begin))
+        begin = ULL2NUM(1);
+
+    if (NIL_P(end))
+        end = ULL2NUM(0);
+
+    err = uc_trace_add(_uc, &trace, NUM2INT(trace_type), NUM2ULL(begin), NUM2ULL(end));
+    if (err != UC_ERR_OK) {
+      rb_raise(UcError, "%s", uc_strerror(err));
+    }
+    // remember the size of the records, for trace_get
+    record_size = NUM2INT(trace_type) == UC_TRACE_MEM ? sizeof(uc_trace_mem_access) : sizeof(uint64_t);
+    rb_hash_aset(rb_iv_get(self, "@traces"), ULL2NUM(trace), INT2NUM(record_size));
+    return ULL2NUM(trace);
+}
+
+// the records of a collector, packed: unpack("Q*") gives the addresses, and
+// unpack("QqLL" * n) the fields of UC_TRACE_MEM records
+VALUE m_uc_trace_get(VALUE self, VALUE trace){
+    const void *records;
+    size_t count;
+    size_t record_size;
+    uc_err err;
+    uc_engine *_uc;
+    Data_Get_Struct(rb_iv_get(self, "@uch"), uc_engine, _uc);
+
+    err = uc_trace_get(_uc, NUM2ULL(trace), &records, &count);
+    if (err != UC_ERR_OK) {
+      rb_raise(UcError, "%s", uc_strerror(err));
+    }
+    record_size = NUM2INT(rb_hash_aref(rb_iv_get(self, "@traces"), trace));
+    return rb_str_new(records, count * record_size);
+}
+
+VALUE m_uc_trace_reset(VALUE self, VALUE trace){
+    uc_err err;
+    uc_engine *_uc;
+    Data_Get_Struct(rb_iv_get(self, "@uch"), uc_engine, _uc);
+
+    err = uc_trace_reset(_uc, NUM2ULL(trace));
+    if (err != UC_ERR_OK) {
+      rb_raise(UcError, "%s", uc_strerror(err));
+    }
+    return Qnil;
+}
+
+VALUE m_uc_trace_del(VALUE self, VALUE trace){
+    uc_err err;
+    uc_engine *_uc;
+    Data_Get_Struct(rb_iv_get(self, "@uch"), uc_engine, _uc);
+
+    err = uc_trace_del(_uc, NUM2ULL(trace));
+    if (err != UC_ERR_OK) {
+      rb_raise(UcError, "%s", uc_strerror(err));
+    }
+    rb_hash_delete(rb_iv_get(self, "@traces"), trace);
+    return Qnil;
+}
+
 VALUE m_uc_query(VALUE self, VALUE query_mode){
     int qm = NUM2INT(query_mode);
     size_t result;
@@ -24,12 +24,17 @@ VALUE m_uc_emu_stop(VALUE self);
 VALUE m_uc_reg_read(VALUE self, VALUE reg_id);
 VALUE m_uc_reg_write(VALUE self, VALUE reg_id, VALUE reg_value);
 VALUE m_uc_mem_read(VALUE self, VALUE address, VALUE size);
+VALUE m_uc_mem_read_into(int argc, VALUE* argv, VALUE self);
 VALUE m_uc_mem_write(VALUE self, VALUE address, VALUE bytes);
 VALUE m_uc_mem_map(int argc, VALUE* argv, VALUE self);
 VALUE m_uc_mem_unmap(VALUE self, VALUE address, VALUE size);
 VALUE m_uc_mem_protect(VALUE self, VALUE address, VALUE size, VALUE perms);
 VALUE m_uc_hook_add(int argc, VALUE* argv, VALUE self);
 VALUE m_uc_hook_del(VALUE self, VALUE hook);
+VALUE m_uc_trace_add(int argc, VALUE* argv, VALUE self);
+VALUE m_uc_trace_get(VALUE self, VALUE trace);
+VALUE m_uc_trace_reset(VALUE self, VALUE trace);
+VALUE m_uc_trace_del(VALUE self, VALUE trace);
 VALUE m_uc_query(VALUE self, VALUE query_mode);
 VALUE m_uc_context_save(VALUE self);
 VALUE m_uc_context_update(VALUE self, VALUE context);
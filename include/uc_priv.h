@@ -13,10 +13,11 @@
 
 // These are masks of supported modes for each cpu/arch.
 // They should be updated when changes are made to the uc_mode enum typedef.
-#define UC_MODE_ARM_MASK    (UC_MODE_ARM|UC_MODE_THUMB|UC_MODE_LITTLE_ENDIAN|UC_MODE_MCLASS \
+#define UC_MODE_ARM_MASK    (UC_MODE_ARM|UC_MODE_THUMB|UC_MODE_LITTLE_ENDIAN|UC_MODE_MCLASS|UC_MODE_V8 \
 				|UC_MODE_ARM926|UC_MODE_ARM946|UC_MODE_ARM1176|UC_MODE_BIG_ENDIAN)
-#define UC_MODE_MIPS_MASK   (UC_MODE_MIPS32|UC_MODE_MIPS64|UC_MODE_LITTLE_ENDIAN|UC_MODE_BIG_ENDIAN)
-#define UC_MODE_X86_MASK    (UC_MODE_16|UC_MODE_32|UC_MODE_64|UC_MODE_LITTLE_ENDIAN)
+#define UC_MODE_MIPS_MASK   (UC_MODE_MIPS32|UC_MODE_MIPS64|UC_MODE_MIPS32R5|UC_MODE_LITTLE_ENDIAN \
+				|UC_MODE_BIG_ENDIAN)
+#define UC_MODE_X86_MASK    (UC_MODE_16|UC_MODE_32|UC_MODE_64|UC_MODE_X87_FAST|UC_MODE_LITTLE_ENDIAN)
 #define UC_MODE_PPC_MASK    (UC_MODE_PPC64|UC_MODE_BIG_ENDIAN)
 #define UC_MODE_SPARC_MASK  (UC_MODE_SPARC32|UC_MODE_SPARC64|UC_MODE_BIG_ENDIAN)
 #define UC_MODE_M68K_MASK   (UC_MODE_BIG_ENDIAN)
@@ -82,6 +83,40 @@ typedef uint64_t (*uc_mem_redirect_t)(uint64_t address);
 // validate if Unicorn supports hooking a given instruction
 typedef bool(*uc_insn_hook_validate)(uint32_t insn_enum);
 
+// translate code ahead of emulation
+typedef uc_err (*uc_tb_translate_range_t)(struct uc_struct *uc, uint64_t begin, uint64_t end, uc_cache_info *info);
+
+typedef uc_err (*uc_tb_translate_block_t)(struct uc_struct *uc, uint64_t pc, uint64_t cs_base, uint32_t flags, uc_cache_info *info);
+
+// enumerate translated blocks
+typedef void (*uc_tb_foreach_cb_t)(void *opaque, uint64_t pc, uint64_t cs_base, uint32_t flags, uint32_t size);
+typedef void (*uc_tb_foreach_t)(struct uc_struct *uc, uc_tb_foreach_cb_t fn, void *opaque);
+
+// recover from a fault of translated code on flat memory, return false if not ours
+typedef bool (*uc_flat_fault_t)(struct uc_struct *uc, uintptr_t host_pc);
+
+// register groups (uc_context_group) changed by writing a register
+typedef int (*uc_reg_group_t)(unsigned int regid);
+
+// number of register groups in uc_context_group
+#define UC_CTX_GROUPS 3
+
+// a range of CPUArchState saved by uc_context_save(), in tables ended by a 0 group
+typedef struct uc_context_range {
+    int group;              // uc_context_group
+    size_t begin, end;      // offsets in CPUArchState
+} uc_context_range;
+
+// flat memory (uc_mem_flat_enable()) needs a x86_64 Linux host
+#if defined(__x86_64__) && defined(__linux__)
+#define UC_FLAT_MEMORY
+#endif
+
+// flat memory covers the 32-bit guest address space, protected per host page
+#define UC_FLAT_SIZE        (1ULL << 32)
+#define UC_FLAT_PAGE_BITS   12
+#define UC_FLAT_PAGE_SIZE   (1 << UC_FLAT_PAGE_BITS)
+
 struct hook {
     int type;            // UC_HOOK_*
     int insn;            // instruction for HOOK_INSN
@@ -146,6 +181,9 @@ static inline bool _hook_exists_bounded(struct list_item *cur, uint64_t addr)
 //relloc increment, KEEP THIS A POWER OF 2!
 #define MEM_BLOCK_INCR 32
 
+// instructions each vCPU runs before the next one, unless uc_vcpu_set_quantum() says otherwise
+#define UC_VCPU_QUANTUM 10000
+
 struct uc_struct {
     uc_arch arch;
     uc_mode mode;
@@ -164,6 +202,12 @@ struct uc_struct {
 
     uc_args_uc_t init_arch, cpu_exec_init_all;
     uc_args_int_uc_t vm_start;
+    uc_tb_translate_range_t tb_translate_range;
+    uc_tb_translate_block_t tb_translate_block;
+    uc_tb_foreach_t tb_foreach;
+    uc_flat_fault_t flat_fault;
+    uc_args_uc_t ram_log_start, ram_log_rewind, ram_log_stop;
+    uc_args_uc_t tlb_flush;
     uc_args_tcg_enable_t tcg_enabled;
     uc_args_uc_long_t tcg_exec_init;
     uc_args_uc_ram_size_t memory_map;
@@ -226,6 +270,7 @@ struct uc_struct {
     bool init_tcg;      // already initialized local TCGv variables?
     bool stop_request;  // request to immediately stop emulation - for uc_emu_stop()
     bool quit_request;  // request to quit the current TB, but continue to emulate - for uc_mem_protect()
+    bool tb_flush_request;  // translated code is stale, flush it before running again
     bool emulation_done;  // emulation is done by uc_emu_start()
     bool timed_out;     // emulation timed out, uc_emu_start() will result in EC_ERR_TIMEOUT
     QemuThread timer;   // timer for emulation timeout
@@ -236,6 +281,15 @@ struct uc_struct {
 
     uint64_t addr_end;  // address where emulation stops (@end param of uc_emu_start())
 
+    GHashTable *breakpoints;    // addresses set by uc_breakpoint_add(), or NULL
+    bool breakpoint_hit;    // emulation stopped at a breakpoint, uc_emu_start() will result in UC_ERR_BREAKPOINT
+    bool breakpoint_skip;   // do not stop at breakpoint_skip_addr, where uc_emu_start() resumes from
+    uint64_t breakpoint_skip_addr;
+
+    GHashTable *exits;  // addresses set by uc_emu_set_exits(), or NULL
+    uint64_t *exit_list;    // keys of exits, in the order given to uc_emu_set_exits()
+    size_t exit_index;  // index in exit_list of the exit we stopped at, or (size_t)-1
+
     int thumb;  // thumb mode for ARM
     // full TCG cache leads to middle-block break in the last translation?
     bool block_full;
@@ -248,16 +302,86 @@ struct uc_struct {
     uint32_t target_page_align;
     uint64_t next_pc;   // save next PC for some special cases
     bool hook_insert;	// insert new hook at begin of the hook list (append by default)
+    uc_cb_mem_pager_t pager;    // demand-paging callback set by uc_mem_set_pager(), or NULL
+    void *pager_data;
+    struct list file_maps;  // host mappings of files made by uc_mem_map_file()
+    struct list traces;     // collectors added by uc_trace_add()
+
+    // flat memory, see uc_mem_flat_enable()
+    uint8_t *flat_base;     // guest address space accessed by translated code, or NULL
+    uint8_t *flat_ram;      // the same memory, always writable, backing the RAM blocks
+    int flat_fd;            // memory file shared by flat_base & flat_ram
+    unsigned long *flat_code;   // host pages kept read-only in flat_base, as they hold translated code
+    GHashTable *flat_slow;  // PCs of blocks that faulted on flat_base, translated with TLB lookups
+    bool flat_replay;       // the instruction at flat_replay_pc runs again after a fault: do not hook it twice
+    uint64_t flat_replay_pc;
+
+    // RAM write log of uc_emu_batch(), see ram_log_start() in qemu/exec.c
+    bool ram_log;           // save RAM pages before their first write
+    GHashTable *ram_log_copies; // page number -> content of the page when the log started
+    ram_addr_t *ram_log_pages;  // pages written since the last rewind
+    size_t ram_log_count, ram_log_size;
+    uint64_t ram_log_vaddrs[16];    // virtual pages made writable in the TLB since the last rewind
+    size_t ram_log_nvaddrs;
+
+    // register groups of CPUArchState, see uc_context_alloc_groups()
+    const uc_context_range *context_ranges; // layout of the groups, or NULL if they are not distinguished
+    const uc_context_range *context_mmu;    // system registers translating addresses: changing them flushes the TLB
+    uc_reg_group_t reg_group;   // groups changed by writing a register, or NULL for all of them
+
+    // vCPUs added by uc_vcpu_add(), sharing memory & translated code
+    QTAILQ_HEAD(, CPUState) cpus;   // all vCPUs, in the order of their index
+    int cpu_count;
+    uint32_t quantum;   // instructions each vCPU runs before the next one, see uc_vcpu_set_quantum()
+    int cpu_last;       // index of the vCPU which ran last, for UC_QUERY_VCPU
 };
 
+// iterate over the vCPUs of an engine
+#define CPU_FOREACH(uc, cpu) QTAILQ_FOREACH(cpu, &(uc)->cpus, node)
+
 // Metadata stub for the variable-size cpu context used with uc_context_*()
 struct uc_context {
-   size_t size;
+   size_t size;     // size of data, with UC_CONTEXT_TRACKED set when a uc_context_info follows it
    char data[0];
 };
 
+// contexts allocated by uc_context_alloc*() on architectures with register groups
+#define UC_CONTEXT_TRACKED ((size_t)1 << (sizeof(size_t) * 8 - 1))
+
+// register groups held by a context, stored after its data
+struct uc_context_info {
+    int groups;     // uc_context_group saved & restored
+    uint64_t version[UC_CTX_GROUPS];    // content of each group in data, or 0 if never saved
+};
+
 // check if this address is mapped in (via uc_mem_map())
 MemoryRegion *memory_mapping(struct uc_struct* uc, uint64_t address);
 
+// map the memory given by the pager (via uc_mem_set_pager()) for an access to unmapped @address
+MemoryRegion *memory_page_in(struct uc_struct *uc, uc_mem_type type, uint64_t address, int size);
+
+// write-protect (or not) the host page of flat memory backing this RAM pointer
+void uc_flat_protect_code(struct uc_struct *uc, void *host, bool protect);
+
+// check if there is a breakpoint at this address (via uc_breakpoint_add())
+static inline bool uc_breakpoint_exists(struct uc_struct *uc, uint64_t address)
+{
+    return uc->breakpoints != NULL &&
+        g_hash_table_lookup(uc->breakpoints, &address) != NULL;
+}
+
+// check if this address is an exit of emulation (via uc_emu_set_exits())
+static inline bool uc_exit_exists(struct uc_struct *uc, uint64_t address)
+{
+    return uc->exits != NULL &&
+        g_hash_table_lookup(uc->exits, &address) != NULL;
+}
+
+// check if emulation must stop right before this address
+static inline bool uc_stop_addr_exists(struct uc_struct *uc, uint64_t address)
+{
+    return uc_breakpoint_exists(uc, address) || uc_exit_exists(uc, address);
+}
+
 #endif
 /* vim: set ts=4 noet:  */
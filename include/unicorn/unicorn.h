@@ -107,7 +107,7 @@ typedef enum uc_mode {
     UC_MODE_ARM = 0,              // ARM mode
     UC_MODE_THUMB = 1 << 4,       // THUMB mode (including Thumb-2)
     UC_MODE_MCLASS = 1 << 5,      // ARM's Cortex-M series (currently unsupported)
-    UC_MODE_V8 = 1 << 6,          // ARMv8 A32 encodings for ARM (currently unsupported)
+    UC_MODE_V8 = 1 << 6,          // ARMv8 A32 encodings for ARM
 
     // arm (32bit) cpu types
     UC_MODE_ARM926 = 1 << 7,	  // ARM926 CPU type
@@ -121,10 +121,14 @@ typedef enum uc_mode {
     UC_MODE_MIPS32 = 1 << 2,      // Mips32 ISA
     UC_MODE_MIPS64 = 1 << 3,      // Mips64 ISA
 
+    // mips (32bit) cpu types
+    UC_MODE_MIPS32R5 = 1 << 7,    // Mips32r5 CPU with MSA (with UC_MODE_MIPS32)
+
     // x86 / x64
     UC_MODE_16 = 1 << 1,          // 16-bit mode
     UC_MODE_32 = 1 << 2,          // 32-bit mode
     UC_MODE_64 = 1 << 3,          // 64-bit mode
+    UC_MODE_X87_FAST = 1 << 7,    // x87 FPU computes in double precision: faster, not 80-bit exact
 
     // ppc 
     UC_MODE_PPC32 = 1 << 2,       // 32-bit mode (currently unsupported)
@@ -164,7 +168,9 @@ typedef enum uc_err {
     UC_ERR_HOOK_EXIST,  // hook for this event already existed
     UC_ERR_RESOURCE,    // Insufficient resource: uc_emu_start()
     UC_ERR_EXCEPTION, // Unhandled CPU exception
-    UC_ERR_TIMEOUT // Emulation timed out
+    UC_ERR_TIMEOUT, // Emulation timed out
+    UC_ERR_BREAKPOINT, // Emulation stopped at a breakpoint: uc_emu_start()
+    UC_ERR_CALL_STOPPED, // Emulation stopped before the function returned: uc_call()
 } uc_err;
 
 
@@ -326,18 +332,70 @@ typedef struct uc_mem_region {
     uint32_t perms; // memory permissions of the region
 } uc_mem_region;
 
+/*
+  Memory to map for an unmapped access, given by a uc_cb_mem_pager_t callback.
+  The fields are initialized to the target page holding the faulting address,
+  readable, writable & executable, and allocated by Unicorn with zeroes.
+  Every mapping adds to the cost of the next ones, so map more than one page
+  at a time where the access pattern allows.
+*/
+typedef struct uc_mem_page {
+    uint64_t begin; // begin address of the region to map, which must contain the faulting address
+    size_t size;    // size of the region to map
+    uint32_t perms; // memory permissions of the region
+    void *ptr;      // host memory backing the region, like with uc_mem_map_ptr(), or NULL
+    const void *data;   // if @ptr is NULL: @size bytes copied into the region, or NULL
+} uc_mem_page;
+
+/*
+  Callback function for demand paging, set with uc_mem_set_pager()
+
+  @type: UC_MEM_READ_UNMAPPED, UC_MEM_WRITE_UNMAPPED or UC_MEM_FETCH_UNMAPPED
+  @address: address where the code is accessing memory
+  @size: size of data being read or written
+  @page: memory to map for this access, to be filled in by the callback
+  @user_data: user data passed to uc_mem_set_pager()
+
+  @return true to map @page and continue the access, or false to raise the
+    access to UC_HOOK_MEM_*_UNMAPPED hooks as usual.
+*/
+typedef bool (*uc_cb_mem_pager_t)(uc_engine *uc, uc_mem_type type,
+        uint64_t address, int size, uc_mem_page *page, void *user_data);
+
 // All type of queries for uc_query() API.
 typedef enum uc_query_type {
     // Dynamically query current hardware mode.
     UC_QUERY_MODE = 1,
     UC_QUERY_PAGE_SIZE,
     UC_QUERY_ARCH,
+    // Index of the exit (given to uc_emu_set_exits()) where the last
+    // uc_emu_start() stopped, or (size_t)-1 if it did not stop at an exit.
+    UC_QUERY_EXIT,
+    // Index of the vCPU running the current hook, or outside of hooks, of
+    // the vCPU which ran last in uc_emu_start(). See uc_vcpu_add().
+    UC_QUERY_VCPU,
 } uc_query_type;
 
 // Opaque storage for CPU context, used with uc_context_*()
 struct uc_context;
 typedef struct uc_context uc_context;
 
+// Register groups of a CPU context, see uc_context_alloc_groups()
+typedef enum uc_context_group {
+    UC_CTX_GPR = 1 << 0,    // general purpose registers, program counter & flags
+    UC_CTX_FPU = 1 << 1,    // floating point & SIMD registers
+    UC_CTX_SYS = 1 << 2,    // system, segment & control registers
+    UC_CTX_ALL = UC_CTX_GPR | UC_CTX_FPU | UC_CTX_SYS,
+} uc_context_group;
+
+/*
+  Translated code generated by uc_cache_translate() and uc_cache_translate_list()
+*/
+typedef struct uc_cache_info {
+    size_t blocks;      // number of blocks translated
+    size_t code_size;   // size in bytes of the host code generated for them
+} uc_cache_info;
+
 /*
  Return combined API version & major and minor version numbers.
 
@@ -549,6 +607,295 @@ uc_err uc_emu_start(uc_engine *uc, uint64_t begin, uint64_t until, uint64_t time
 UNICORN_EXPORT
 uc_err uc_emu_stop(uc_engine *uc);
 
+// Calling conventions for uc_call()
+typedef enum uc_call_conv {
+    UC_CALL_DEFAULT = 0,    // the usual C convention of the arch & mode, as below
+    UC_CALL_CDECL = 1,      // x86-32: arguments on the stack, result in EAX
+    UC_CALL_SYSV64 = 2,     // x86-64 System V: RDI, RSI, RDX, RCX, R8, R9, then the stack; result in RAX
+    UC_CALL_MS64 = 3,       // x86-64 Microsoft: RCX, RDX, R8, R9 and 32 bytes of shadow space, then the stack; result in RAX
+    UC_CALL_AAPCS = 4,      // ARM: R0-R3, then the stack; result in R0
+    UC_CALL_AAPCS64 = 5,    // ARM64: X0-X7, then the stack; result in X0
+    UC_CALL_MIPS_O32 = 6,   // MIPS32: A0-A3 and 16 bytes reserved on the stack, then the stack; result in V0
+    UC_CALL_MIPS_N64 = 7,   // MIPS64: $4-$11, then the stack; result in V0
+} uc_call_conv;
+
+/*
+ Call a guest function, as compiled code calling it with the given calling
+ convention would: the arguments are passed in registers and on the stack
+ below the current stack pointer, and the function returns to an address
+ where emulation stops, without code needing to be mapped there. This is
+ the top page of the address space, 0xfffff000 on 32-bit CPUs and
+ 0xfffffffffffff000 on 64-bit CPUs.
+ The same return address is used by every call, so translated code is
+ kept from one call to the next, as with uc_emu_start() calls with the
+ same @until address.
+
+ NOTE: each argument takes one register or stack slot of the natural size
+ of the CPU, so 64-bit arguments on 32-bit CPUs, floating point and
+ aggregate arguments are not supported. The stack pointer, and the other
+ registers the function clobbers, are left as the function leaves them.
+
+ @uc: handle returned by uc_open()
+ @address: address of the function. On ARM, the lowest bit selects Thumb mode.
+ @conv: calling convention, one of uc_call_conv
+ @args: array of @nargs arguments, truncated to the size of a register
+ @nargs: number of arguments
+ @result: if not NULL, this receives the value returned by the function,
+   or 0 when this does not return UC_ERR_OK
+ @timeout, @count: as with uc_emu_start()
+
+ @return UC_ERR_OK when the function returned, or other value on failure
+   (refer to uc_err enum for detailed error). This fails with UC_ERR_ARG if
+   @conv is not valid for the arch & mode of @uc, and with UC_ERR_TIMEOUT
+   on @timeout. Unlike uc_emu_start(), this fails with UC_ERR_CALL_STOPPED
+   when emulation stopped on @count, or on uc_emu_stop(), before the
+   function returned; the registers are then left as the function had them.
+*/
+UNICORN_EXPORT
+uc_err uc_call(uc_engine *uc, uint64_t address, uc_call_conv conv,
+        const uint64_t *args, size_t nargs, uint64_t *result,
+        uint64_t timeout, size_t count);
+
+// Memory written before a run of uc_emu_batch()
+typedef struct uc_batch_patch {
+    uint64_t address;   // guest address to write @data to
+    const void *data;
+    size_t size;
+} uc_batch_patch;
+
+// One run of uc_emu_batch(), and its results
+typedef struct uc_batch_job {
+    uc_context *context;    // CPU state to start from, or NULL for the state of the engine
+    const uc_batch_patch *patches;  // memory written before the run
+    size_t npatches;
+    uint64_t *results;      // if not NULL, this receives the registers given to uc_emu_batch(), or zeros if the job did not run
+    uc_err err;             // set to the result of the run, as returned by uc_emu_start(), or to the error of the context or a patch
+} uc_batch_job;
+
+/*
+ Run the same code for many independent inputs, back to back.
+ Each job starts from its own CPU context and memory patches, on top of the
+ memory of the engine as it is when uc_emu_batch() is called, and emulates
+ from @begin to @until like uc_emu_start(). After each run, only the memory
+ pages written by the run (or by its patches) and the CPU registers are put
+ back, and translated code is kept for all jobs, so a batch runs close to the
+ speed of emulation itself.
+ The engine is left with the memory and CPU state it had before the call.
+
+ NOTE: the memory mapping must not change during the batch: regions mapped by
+ hooks or the pager stay mapped, and regions unmapped by hooks are not
+ restored. This is not available with flat memory (uc_mem_flat_enable()).
+
+ @uc: handle returned by uc_open()
+ @begin, @until, @timeout, @count: as with uc_emu_start(), for each job
+ @regs: array of @nregs register IDs, of at most 64 bits, to read after each
+   run into the @results of the job
+ @jobs: array of @njobs jobs. The @err of each job receives the result of
+   its run, which does not stop the batch.
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error). Errors of the runs are only reported in the jobs.
+*/
+UNICORN_EXPORT
+uc_err uc_emu_batch(uc_engine *uc, uint64_t begin, uint64_t until,
+        uint64_t timeout, size_t count, const int *regs, size_t nregs,
+        uc_batch_job *jobs, size_t njobs);
+
+/*
+ Set a breakpoint: emulation started by uc_emu_start() stops right before
+ the instruction at @address is executed, and uc_emu_start() then returns the
+ error UC_ERR_BREAKPOINT. The program counter is left at @address.
+ Breakpoints are compiled into the translated code, so unlike a UC_HOOK_CODE
+ callback calling uc_emu_stop(), they cost nothing on code that does not
+ reach them.
+
+ NOTE: a breakpoint at the @begin address of uc_emu_start() does not stop
+ the emulation before its first instruction. This allows to resume the
+ emulation from the breakpoint that was just hit.
+
+ NOTE: on MIPS, a breakpoint in the delay slot of a branch is not hit when
+ the branch runs before it, as both are translated together. It is only hit
+ when emulation jumps or starts right at the delay slot.
+
+ @uc: handle returned by uc_open()
+ @address: address of the instruction to stop at. On ARM, the lowest bit,
+   which selects Thumb mode, is ignored.
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_breakpoint_add(uc_engine *uc, uint64_t address);
+
+/*
+ Remove a breakpoint set by uc_breakpoint_add().
+
+ @uc: handle returned by uc_open()
+ @address: address of the breakpoint to be removed
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error). This fails with UC_ERR_ARG if there is no breakpoint
+   at @address.
+*/
+UNICORN_EXPORT
+uc_err uc_breakpoint_del(uc_engine *uc, uint64_t address);
+
+/*
+ Set the addresses where emulation stops, in addition to the @until address
+ of uc_emu_start(). Like @until, emulation stops right before the
+ instruction at any of these addresses is executed, and uc_emu_start()
+ returns UC_ERR_OK. Exits are checked when code is translated, so unlike
+ a UC_HOOK_CODE callback they cost nothing on code that does not reach them.
+ The exit that was hit can be retrieved with uc_query(UC_QUERY_EXIT).
+
+ NOTE: on MIPS, an exit in the delay slot of a branch is not honoured when
+ the branch runs before it, as both are translated together: emulation
+ goes on past it. Put the exit at the branch, or after the delay slot.
+
+ @uc: handle returned by uc_open()
+ @exits: array of exit addresses. This replaces the exits set previously.
+   On ARM, the lowest bit of each, which selects Thumb mode, is ignored.
+ @count: number of addresses in @exits, or 0 to remove all exits.
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_emu_set_exits(uc_engine *uc, const uint64_t *exits, size_t count);
+
+/*
+ Add a vCPU to the engine. uc_open() creates vCPU 0, and each new vCPU gets
+ the next index. All vCPUs share the memory, hooks and translated code of
+ the engine, but each has its own registers and contexts.
+
+ uc_emu_start() runs all vCPUs in turn, each for a quantum of instructions
+ (see uc_vcpu_set_quantum()), on the calling thread. The selected vCPU starts
+ at @begin, the others resume from their own program counter. A vCPU which
+ reaches @until stops, and uc_emu_start() returns once all of them have.
+ An error, uc_emu_stop(), an exit or a breakpoint stops all vCPUs, and the
+ @count of uc_emu_start() counts the instructions of all of them. Hooks can
+ tell which vCPU they run for with uc_query(UC_QUERY_VCPU).
+
+ This must not be called while emulation is running.
+
+ @uc: handle returned by uc_open()
+ @index: if not NULL, this receives the index of the new vCPU.
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_vcpu_add(uc_engine *uc, int *index);
+
+/*
+ Select the vCPU which uc_reg_*(), uc_context_*() and the @begin address of
+ uc_emu_start() apply to. vCPU 0 is selected after uc_open().
+
+ This must not be called while emulation is running.
+
+ @uc: handle returned by uc_open()
+ @index: index of the vCPU, as returned by uc_vcpu_add().
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_vcpu_select(uc_engine *uc, int index);
+
+/*
+ Set how many instructions each vCPU runs before uc_emu_start() switches to
+ the next one. A vCPU can run a little longer, to finish its current block.
+ The default is 10000 instructions. This has no effect with a single vCPU.
+
+ @uc: handle returned by uc_open()
+ @quantum: number of instructions, must not be 0.
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_vcpu_set_quantum(uc_engine *uc, uint32_t quantum);
+
+/*
+ Translate code ahead of emulation, so that the first execution of these
+ instructions does not pay for their translation.
+ Translated code is kept across uc_emu_start() calls, until hooks, breakpoints,
+ exits, the @until address or the memory mapping change. Blocks are translated
+ for the current CPU mode, starting at @begin and following each block with
+ the next one, until @end or @until is reached.
+
+ This must not be called while emulation is running. It can be called from
+ another thread while the engine is idle, as long as no other API is called
+ on @uc at the same time.
+
+ @uc: handle returned by uc_open()
+ @begin: address of the first instruction to translate
+ @end: address where translation stops (exclusive)
+ @until: the @until address of the next uc_emu_start() calls
+ @info: if not NULL, this receives the number of blocks translated and the
+   size of the host code generated for them.
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error). Blocks translated before a failure stay translated.
+*/
+UNICORN_EXPORT
+uc_err uc_cache_translate(uc_engine *uc, uint64_t begin, uint64_t end, uint64_t until, uc_cache_info *info);
+
+/*
+ Drop all translated code, so that instructions are translated again before
+ they run.
+
+ @uc: handle returned by uc_open()
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_cache_flush(uc_engine *uc);
+
+/*
+ Save the list of translated blocks to a file: the address, CPU state and a
+ checksum of the guest code of each block. uc_cache_translate_list() then
+ translates these blocks again ahead of emulation, in another engine or
+ process.
+
+ This is a list of addresses to pre-translate, not a cache of host code:
+ translation is not skipped, only moved before uc_emu_start(). Hooks, exits
+ and breakpoints are not recorded, blocks are translated for those installed
+ when the list is loaded. The file is the same on all hosts.
+
+ This must not be called while emulation is running.
+
+ @uc: handle returned by uc_open()
+ @path: file to write
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_cache_save_list(uc_engine *uc, const char *path);
+
+/*
+ Translate the blocks listed by uc_cache_save_list(), like uc_cache_translate()
+ does, skipping those whose guest code changed since then, or is not mapped.
+ The code of each block is checked at the physical address its address maps
+ to for the current CPU state. The file must have been saved by an engine of
+ the same architecture & mode.
+
+ This must not be called while emulation is running.
+
+ @uc: handle returned by uc_open()
+ @path: file to read
+ @until: the @until address of the next uc_emu_start() calls
+ @info: if not NULL, this receives the number of blocks translated and the
+   size of the host code generated for them.
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_cache_translate_list(uc_engine *uc, const char *path, uint64_t until, uc_cache_info *info);
+
 /*
  Register callback for a hook event.
  The callback will be run when the hook event is hit.
@@ -588,6 +935,80 @@ uc_err uc_hook_add(uc_engine *uc, uc_hook *hh, int type, void *callback,
 UNICORN_EXPORT
 uc_err uc_hook_del(uc_engine *uc, uc_hook hh);
 
+// Events recorded by a trace collector, see uc_trace_add()
+typedef enum uc_trace_type {
+    UC_TRACE_CODE = 1,      // address of each instruction executed, as uint64_t
+    UC_TRACE_BLOCK = 2,     // address of each basic block executed, as uint64_t
+    UC_TRACE_MEM = 3,       // each memory read & write, as uc_trace_mem_access
+    UC_TRACE_COVERAGE = 4,  // address of basic blocks executed, each once, as uint64_t
+} uc_trace_type;
+
+// Memory access recorded by a UC_TRACE_MEM collector
+typedef struct uc_trace_mem_access {
+    uint64_t address;
+    int64_t value;      // value written, or 0 for a read
+    uint32_t type;      // UC_MEM_READ or UC_MEM_WRITE
+    uint32_t size;
+} uc_trace_mem_access;
+
+/*
+ Add a trace collector, a hook that records events in an array in memory.
+ This is a lot cheaper than calling a callback per event, especially for
+ bindings, which read the whole array once emulation stopped.
+
+ @uc: handle returned by uc_open()
+ @hh: handle of the collector, to be used with uc_trace_get(), uc_trace_reset()
+   and uc_trace_del()
+ @type: type of events to record, one of uc_trace_type
+ @begin: start address of the area where events are recorded (inclusive)
+ @end: end address of the area where events are recorded (inclusive)
+   NOTE: as with uc_hook_add(), if @begin > @end, events are recorded everywhere
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_trace_add(uc_engine *uc, uc_hook *hh, uc_trace_type type, uint64_t begin, uint64_t end);
+
+/*
+ Get the events recorded by a trace collector, oldest first.
+
+ @uc: handle returned by uc_open()
+ @hh: handle returned by uc_trace_add()
+ @records: pointer to a variable receiving the array of records, which stays
+   valid until the next uc_emu_start(), uc_trace_reset() or uc_trace_del()
+ @count: pointer to a variable receiving the number of records
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_trace_get(uc_engine *uc, uc_hook hh, const void **records, size_t *count);
+
+/*
+ Drop the events recorded by a trace collector, which goes on recording.
+
+ @uc: handle returned by uc_open()
+ @hh: handle returned by uc_trace_add()
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_trace_reset(uc_engine *uc, uc_hook hh);
+
+/*
+ Remove a trace collector, and free its records.
+
+ @uc: handle returned by uc_open()
+ @hh: handle returned by uc_trace_add()
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_trace_del(uc_engine *uc, uc_hook hh);
+
 typedef enum uc_prot {
    UC_PROT_NONE = 0,
    UC_PROT_READ = 1,
@@ -630,6 +1051,8 @@ uc_err uc_mem_map(uc_engine *uc, uint64_t address, size_t size, uint32_t perms);
  @ptr: pointer to host memory backing the newly mapped memory. This host memory is
     expected to be an equal or larger size than provided, and be mapped with at
     least PROT_READ | PROT_WRITE. If it is not, the resulting behavior is undefined.
+    Code translated from this memory is kept across uc_emu_start() calls, so
+    call uc_cache_flush() after modifying instructions directly through @ptr.
 
  @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
    for detailed error).
@@ -637,6 +1060,43 @@ uc_err uc_mem_map(uc_engine *uc, uint64_t address, size_t size, uint32_t perms);
 UNICORN_EXPORT
 uc_err uc_mem_map_ptr(uc_engine *uc, uint64_t address, size_t size, uint32_t perms, void *ptr);
 
+// Sharing of memory mapped by uc_mem_map_file()
+typedef enum uc_map_flags {
+   UC_MAP_PRIVATE = 0,  // copy-on-write: guest writes are not seen in the file
+   UC_MAP_SHARED = 1,   // guest writes go to the file
+} uc_map_flags;
+
+/*
+ Map a file in for emulation.
+ This API adds a memory region backed by the content of a file, which the host
+ kernel reads in on the first access to each page: nothing is copied upfront.
+ The region can be split by uc_mem_protect() & uc_mem_unmap() like any other,
+ and the file stays mapped until its last page is unmapped, or uc_close().
+
+ NOTE: this is not available on Windows hosts, nor with flat memory
+ (uc_mem_flat_enable()).
+
+ @uc: handle returned by uc_open()
+ @address: starting address of the new memory region to be mapped in.
+    This address must be aligned to 4KB, or this will return with UC_ERR_ARG error.
+ @size: size of the new memory region to be mapped in.
+    This size must be multiple of 4KB, or this will return with UC_ERR_ARG error.
+ @perms: Permissions for the newly mapped region.
+    This must be some combination of UC_PROT_READ | UC_PROT_WRITE | UC_PROT_EXEC,
+    or this will return with UC_ERR_ARG error.
+ @fd: file descriptor of the file, which can be closed after this call.
+    The file must be opened for writing with UC_MAP_SHARED.
+ @offset: offset of the region in the file. This must be aligned to the host
+    page size, and a regular file must cover the whole region.
+ @flags: UC_MAP_PRIVATE or UC_MAP_SHARED.
+
+ @return UC_ERR_OK on success, UC_ERR_MODE if the host does not support this,
+   or other value on failure (refer to uc_err enum for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_mem_map_file(uc_engine *uc, uint64_t address, size_t size, uint32_t perms,
+        int fd, uint64_t offset, uint32_t flags);
+
 /*
  Unmap a region of emulation memory.
  This API deletes a memory mapping from the emulation memory space.
@@ -672,6 +1132,47 @@ uc_err uc_mem_unmap(uc_engine *uc, uint64_t address, size_t size);
 UNICORN_EXPORT
 uc_err uc_mem_protect(uc_engine *uc, uint64_t address, size_t size, uint32_t perms);
 
+/*
+ Back guest memory with one flat host mapping, so that translated code
+ accesses it directly instead of looking up the softmmu TLB.
+ Unmapped and protected pages are enforced by the host MMU: an access that
+ faults runs again through the TLB, and raises the same memory events.
+ This must be called before mapping any memory, and is only available on
+ x86_64 Linux hosts, for ARM, MIPS32 and x86 16/32-bit guests.
+ Guest addresses are physical addresses, so the guest MMU must stay disabled.
+ While UC_HOOK_MEM_READ or UC_HOOK_MEM_WRITE hooks are installed, code is
+ translated with TLB lookups as usual.
+
+ NOTE: with flat memory, addresses & sizes given to uc_mem_map(), uc_mem_unmap()
+ and uc_mem_protect() must be aligned to 4KB, and uc_mem_map_ptr() is not
+ available. Pages mapped with UC_PROT_WRITE only can be read by the guest.
+
+ @uc: handle returned by uc_open()
+
+ @return UC_ERR_OK on success, UC_ERR_MODE if the host or guest is not
+   supported, UC_ERR_ARG if memory is mapped already, or other value on failure
+   (refer to uc_err enum for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_mem_flat_enable(uc_engine *uc);
+
+/*
+ Set a demand-paging callback, which provides memory on the first access to
+ unmapped addresses. The memory is mapped right away and the access goes on,
+ without raising UC_HOOK_MEM_*_UNMAPPED hooks, so this is cheaper than
+ mapping memory from such a hook. Accesses by uc_mem_read() & uc_mem_write()
+ do not call the pager.
+
+ @uc: handle returned by uc_open()
+ @callback: callback of type uc_cb_mem_pager_t, or NULL to remove the pager.
+ @user_data: user-defined data, passed to @callback.
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_mem_set_pager(uc_engine *uc, uc_cb_mem_pager_t callback, void *user_data);
+
 /*
  Retrieve all memory regions mapped by uc_mem_map() and uc_mem_map_ptr()
  This API allocates memory for @regions, and user must free this memory later
@@ -689,6 +1190,28 @@ uc_err uc_mem_protect(uc_engine *uc, uint64_t address, size_t size, uint32_t per
 UNICORN_EXPORT
 uc_err uc_mem_regions(uc_engine *uc, uc_mem_region **regions, uint32_t *count);
 
+/*
+ Get the host memory backing guest memory, to access it without copies.
+ The pointer stays valid until this memory is unmapped, or its permissions
+ are changed with uc_mem_protect(), and the memory may be accessed by
+ uc_emu_start() meanwhile.
+ Writes through the pointer are not seen by the translator: code translated
+ from this memory is kept across uc_emu_start() calls, so call
+ uc_cache_flush() after modifying instructions through it, or the old
+ instructions keep running.
+
+ @uc: handle returned by uc_open()
+ @address: guest address of the memory.
+ @ptr: pointer to a variable receiving the host address of @address.
+ @size: pointer to a variable receiving the number of bytes from @address to
+   the end of its memory region, which are contiguous in host memory.
+
+ @return UC_ERR_OK on success, UC_ERR_NOMEM if @address is not mapped, or other
+   value on failure (refer to uc_err enum for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_mem_host_ptr(uc_engine *uc, uint64_t address, void **ptr, size_t *size);
+
 /*
  Allocate a region that can be used with uc_context_{save,restore} to perform
  quick save/rollback of the CPU context, which includes registers and some
@@ -706,6 +1229,27 @@ uc_err uc_mem_regions(uc_engine *uc, uc_mem_region **regions, uint32_t *count);
 UNICORN_EXPORT
 uc_err uc_context_alloc(uc_engine *uc, uc_context **context);
 
+/*
+ Allocate a context holding only some register groups of the CPU, so that
+ saving & restoring it copies less. For example, a context of UC_CTX_GPR alone
+ is enough to switch between guest threads which leave the FPU & the system
+ registers alone, and takes a fraction of the time of a full context.
+ The groups left out keep their value in the CPU across uc_context_restore().
+ Register groups are distinguished on X86, ARM & ARM64: on the other
+ architectures, the context always holds all of them.
+
+ @uc: handle returned by uc_open()
+ @groups: register groups to save & restore, a combination of uc_context_group
+ @context: pointer to a uc_engine*. This will be updated with the pointer to
+   the new context on successful return of this function.
+   Later, this allocated memory must be freed with uc_free().
+
+ @return UC_ERR_OK on success, UC_ERR_ARG if @groups is empty or unknown, or
+   other value on failure (refer to uc_err enum for detailed error).
+*/
+UNICORN_EXPORT
+uc_err uc_context_alloc_groups(uc_engine *uc, int groups, uc_context **context);
+
 /*
  Free the memory allocated by uc_context_alloc & uc_mem_regions.
 
@@ -722,6 +1266,10 @@ uc_err uc_free(void *mem);
  Save a copy of the internal CPU context.
  This API should be used to efficiently make or update a saved copy of the
  internal CPU state.
+ The engine tracks which register groups (see uc_context_group) were changed
+ by uc_reg_write() and emulation: only the groups which differ from the last
+ copy in @context are copied again, so that saving a context after some code
+ which did not touch the FPU skips the FPU registers.
 
  @uc: handle returned by uc_open()
  @context: handle returned by uc_context_alloc()
@@ -736,6 +1284,13 @@ uc_err uc_context_save(uc_engine *uc, uc_context *context);
  Restore the current CPU context from a saved copy.
  This API should be used to roll the CPU context back to a previous
  state saved by uc_context_save().
+ Like uc_context_save(), this only copies the register groups which differ
+ between the CPU & @context.
+ Restoring a context keeps translated code, and the TLB as long as the context
+ has the same address space as the CPU (page tables & paging mode on X86, MMU
+ configuration on ARM & ARM64): switching between the contexts of guest threads
+ sharing their memory needs neither retranslation nor page walks. Otherwise, the TLB
+ is flushed.
 
  @uc: handle returned by uc_open()
  @buffer: handle returned by uc_context_alloc that has been used with uc_context_save
@@ -750,6 +1305,8 @@ uc_err uc_context_restore(uc_engine *uc, uc_context *context);
 /*
   Return the size needed to store the cpu context. Can be used to allocate a buffer
   to contain the cpu context and directly call uc_context_save.
+  Such a buffer always holds all the registers, and is copied in full by
+  uc_context_save() & uc_context_restore().
 
   @uc: handle returned by uc_open()
 
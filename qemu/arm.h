@@ -12,6 +12,14 @@
 #define tb_invalidate_phys_page_fast tb_invalidate_phys_page_fast_arm
 #define phys_mem_clean phys_mem_clean_arm
 #define tb_cleanup tb_cleanup_arm
+#define tb_translate_range tb_translate_range_arm
+#define tb_translate_block tb_translate_block_arm
+#define tb_foreach tb_foreach_arm
+#define tb_flat_fault tb_flat_fault_arm
+#define ram_log_start ram_log_start_arm
+#define ram_log_rewind ram_log_rewind_arm
+#define ram_log_stop ram_log_stop_arm
+#define ram_log_tlb_dirty ram_log_tlb_dirty_arm
 #define memory_map memory_map_arm
 #define memory_map_ptr memory_map_ptr_arm
 #define memory_unmap memory_unmap_arm
@@ -1338,8 +1346,13 @@
 #define handle_vrint handle_vrint_arm
 #define handle_vsel handle_vsel_arm
 #define has_help_option has_help_option_arm
+#define have_aesni have_aesni_arm
+#define have_avx2 have_avx2_arm
 #define have_bmi1 have_bmi1_arm
 #define have_bmi2 have_bmi2_arm
+#define have_pclmul have_pclmul_arm
+#define have_sse41 have_sse41_arm
+#define have_ssse3 have_ssse3_arm
 #define hcr_write hcr_write_arm
 #define helper_access_check_cp_reg helper_access_check_cp_reg_arm
 #define helper_add_saturate helper_add_saturate_arm
@@ -2924,6 +2937,7 @@
 #define tlbimva_write tlbimva_write_arm
 #define tlb_is_dirty_ram tlb_is_dirty_ram_arm
 #define tlb_protect_code tlb_protect_code_arm
+#define tlb_reset_dirty_page tlb_reset_dirty_page_arm
 #define tlb_reset_dirty_range tlb_reset_dirty_range_arm
 #define tlb_reset_dirty_range_all tlb_reset_dirty_range_all_arm
 #define tlb_set_dirty tlb_set_dirty_arm
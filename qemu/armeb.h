@@ -12,6 +12,14 @@
 #define tb_invalidate_phys_page_fast tb_invalidate_phys_page_fast_armeb
 #define phys_mem_clean phys_mem_clean_armeb
 #define tb_cleanup tb_cleanup_armeb
+#define tb_translate_range tb_translate_range_armeb
+#define tb_translate_block tb_translate_block_armeb
+#define tb_foreach tb_foreach_armeb
+#define tb_flat_fault tb_flat_fault_armeb
+#define ram_log_start ram_log_start_armeb
+#define ram_log_rewind ram_log_rewind_armeb
+#define ram_log_stop ram_log_stop_armeb
+#define ram_log_tlb_dirty ram_log_tlb_dirty_armeb
 #define memory_map memory_map_armeb
 #define memory_map_ptr memory_map_ptr_armeb
 #define memory_unmap memory_unmap_armeb
@@ -1338,8 +1346,13 @@
 #define handle_vrint handle_vrint_armeb
 #define handle_vsel handle_vsel_armeb
 #define has_help_option has_help_option_armeb
+#define have_aesni have_aesni_armeb
+#define have_avx2 have_avx2_armeb
 #define have_bmi1 have_bmi1_armeb
 #define have_bmi2 have_bmi2_armeb
+#define have_pclmul have_pclmul_armeb
+#define have_sse41 have_sse41_armeb
+#define have_ssse3 have_ssse3_armeb
 #define hcr_write hcr_write_armeb
 #define helper_access_check_cp_reg helper_access_check_cp_reg_armeb
 #define helper_add_saturate helper_add_saturate_armeb
@@ -2924,6 +2937,7 @@
 #define tlbimva_write tlbimva_write_armeb
 #define tlb_is_dirty_ram tlb_is_dirty_ram_armeb
 #define tlb_protect_code tlb_protect_code_armeb
+#define tlb_reset_dirty_page tlb_reset_dirty_page_armeb
 #define tlb_reset_dirty_range tlb_reset_dirty_range_armeb
 #define tlb_reset_dirty_range_all tlb_reset_dirty_range_all_armeb
 #define tlb_set_dirty tlb_set_dirty_armeb
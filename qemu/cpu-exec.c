@@ -89,6 +89,12 @@ int cpu_exec(struct uc_struct *uc, CPUArchState *env)   // qq
         cpu->exit_request = 1;
     }
 
+    // Unicorn: translated code went stale since the last run
+    if (uc->tb_flush_request) {
+        uc->tb_flush_request = false;
+        tb_flush(env);
+    }
+
     cc->cpu_exec_enter(cpu);
     cpu->exception_index = -1;
     env->invalid_error = UC_ERR_OK;
@@ -103,6 +109,7 @@ int cpu_exec(struct uc_struct *uc, CPUArchState *env)   // qq
             /* if an exception is pending, we execute it here */
             if (cpu->exception_index >= 0) {
                 //printf(">>> GOT INTERRUPT. exception idx = %x\n", cpu->exception_index);	// qq
+                uc->flat_replay = false;
                 if (cpu->exception_index >= EXCP_INTERRUPT) {
                     /* exit request from the cpu execution loop */
                     ret = cpu->exception_index;
@@ -224,7 +231,13 @@ int cpu_exec(struct uc_struct *uc, CPUArchState *env)   // qq
 
                 tb = tb_find_fast(env);	// qq
                 if (!tb) {   // invalid TB due to invalid code?
-                    uc->invalid_error = UC_ERR_FETCH_UNMAPPED;
+                    // Unicorn: or this vCPU stops at an unmapped @until
+                    if (cpu->halted) {
+                        cpu->exception_index = EXCP_HLT;
+                        cpu_loop_exit(cpu);
+                    }
+                    if (!uc->stop_request)
+                        uc->invalid_error = UC_ERR_FETCH_UNMAPPED;
                     ret = EXCP_HLT;
                     break;
                 }
@@ -257,6 +270,9 @@ int cpu_exec(struct uc_struct *uc, CPUArchState *env)   // qq
                     tc_ptr = tb->tc_ptr;
                     /* execute the generated code */
                     next_tb = cpu_tb_exec(cpu, tc_ptr);	// qq
+                    // Unicorn: an instruction run again after a fault on
+                    // flat memory is hooked normally from now on
+                    uc->flat_replay = false;
 
                     switch (next_tb & TB_EXIT_MASK) {
                         case TB_EXIT_REQUESTED:
@@ -270,6 +286,11 @@ int cpu_exec(struct uc_struct *uc, CPUArchState *env)   // qq
                             tb = (TranslationBlock *)(next_tb & ~TB_EXIT_MASK);
                             next_tb = 0;
                             break;
+                        case TB_EXIT_ICOUNT_EXPIRED:
+                            // Unicorn: this vCPU used up its quantum, let the next one run
+                            cpu->exception_index = EXCP_INTERRUPT;
+                            cpu_loop_exit(cpu);
+                            break;
                         default:
                             break;
                     }
@@ -293,10 +314,14 @@ int cpu_exec(struct uc_struct *uc, CPUArchState *env)   // qq
 
     cc->cpu_exec_exit(cpu);
 
-    // Unicorn: flush JIT cache to because emulation might stop in
-    // the middle of translation, thus generate incomplete code.
-    // TODO: optimize this for better performance
-    tb_flush(env);
+    // Unicorn: translated code is kept for the next run, unless it went
+    // stale during this one, or emulation stopped in the middle of
+    // translation (fetching invalid memory), thus generated incomplete code.
+    if (uc->tb_flush_request || uc->quit_request ||
+            uc->invalid_error != UC_ERR_OK || env->invalid_error != UC_ERR_OK) {
+        uc->tb_flush_request = false;
+        tb_flush(env);
+    }
 
     /* fail safe : never use current_cpu outside cpu_exec() */
     uc->current_cpu = NULL;
@@ -322,8 +347,16 @@ static tcg_target_ulong cpu_tb_exec(CPUState *cpu, uint8_t *tb_ptr)
 
         /* Both set_pc() & synchronize_fromtb() can be ignored when code tracing hook is installed,
          * or timer mode is in effect, since these already fix the PC.
+         * Unicorn: but not when the vCPU used up its quantum, as no hook of the block ran.
          */
-        if (!HOOK_EXISTS(env->uc, UC_HOOK_CODE) && !env->uc->timeout) {
+        if ((next_tb & TB_EXIT_MASK) == TB_EXIT_ICOUNT_EXPIRED) {
+            if (cc->synchronize_from_tb) {
+                cc->synchronize_from_tb(cpu, tb);
+            } else {
+                assert(cc->set_pc);
+                cc->set_pc(cpu, tb->pc);
+            }
+        } else if (!HOOK_EXISTS(env->uc, UC_HOOK_CODE) && !env->uc->timeout) {
             if (cc->synchronize_from_tb) {
                 // avoid sync twice when helper_uc_tracecode() already did this.
                 if (env->uc->emu_counter <= env->uc->emu_count &&
@@ -361,6 +394,13 @@ static TranslationBlock *tb_find_slow(CPUArchState *env, target_ulong pc,
 
     tcg_ctx->tb_ctx.tb_invalidated_flag = 0;
 
+    // Unicorn: emulation stops at @until even with no code mapped there,
+    // such as the return address of uc_call()
+    if (pc == env->uc->addr_end && !memory_mapping(env->uc, pc)) {
+        cpu->halted = 1;
+        return NULL;
+    }
+
     /* find translated block using physical mappings */
     phys_pc = get_page_addr_code(env, pc);  // qq
     if (phys_pc == -1) { // invalid code?
@@ -411,6 +451,122 @@ found:
     return tb;
 }
 
+/* Unicorn: translate a block ahead of cpu_exec(), unless it is translated
+   already. Return NULL if its code cannot be fetched. */
+static TranslationBlock *tb_translate_one(struct uc_struct *uc,
+        target_ulong pc, target_ulong cs_base, int flags,
+        uc_cache_info *info, uc_err *err)
+{
+    CPUState *cpu = uc->cpu;
+    CPUArchState *env = cpu->env_ptr;
+    TCGContext *tcg_ctx = uc->tcg_ctx;
+    TranslationBlock *tb = NULL;
+    uint8_t *code_ptr = tcg_ctx->code_gen_ptr;
+
+    uc->current_cpu = cpu;
+    env->invalid_error = UC_ERR_OK;
+
+    if (sigsetjmp(cpu->jmp_env, 0) == 0) {
+        tb = tb_find_slow(env, pc, cs_base, flags);
+    } else {
+        /* the CPU faulted while fetching code */
+        tb = NULL;
+    }
+
+    *err = env->invalid_error;
+    if (tb != NULL && *err != UC_ERR_OK) {
+        /* this block was fetched from invalid memory */
+        tb_phys_invalidate(uc, tb, -1);
+        tb = NULL;
+    } else if (tb == NULL && *err == UC_ERR_OK) {
+        *err = UC_ERR_FETCH_UNMAPPED;
+    }
+
+    if (tb != NULL && (uint8_t *)tcg_ctx->code_gen_ptr != code_ptr) {
+        info->blocks++;
+        if ((uint8_t *)tcg_ctx->code_gen_ptr < code_ptr) {
+            /* the code buffer was full and got flushed */
+            code_ptr = tcg_ctx->code_gen_buffer;
+        }
+        info->code_size += (uint8_t *)tcg_ctx->code_gen_ptr - code_ptr;
+    }
+
+    /* forget about any exit requested by the code fetch */
+    env->invalid_error = UC_ERR_OK;
+    cpu->exit_request = 0;
+    cpu->tcg_exit_req = 0;
+    uc->current_cpu = NULL;
+
+    return tb;
+}
+
+/* Unicorn: translate the blocks in [begin, end) ahead of cpu_exec(),
+   following each block with the next one */
+uc_err tb_translate_range(struct uc_struct *uc, uint64_t begin, uint64_t end,
+        uc_cache_info *info)
+{
+    CPUArchState *env = uc->cpu->env_ptr;
+    TranslationBlock *tb;
+    target_ulong pc, cs_base;
+    int flags;
+    uint64_t addr;
+    uc_err err = UC_ERR_OK;
+
+    if (uc->tb_flush_request) {
+        uc->tb_flush_request = false;
+        tb_flush(env);
+    }
+
+    /* blocks are translated for the current CPU mode */
+    cpu_get_tb_cpu_state(env, &pc, &cs_base, &flags);
+
+    for (addr = begin; addr < end && addr != uc->addr_end; addr += tb->size) {
+        tb = tb_translate_one(uc, (target_ulong)addr, cs_base, flags, info, &err);
+        if (tb == NULL || tb->size == 0) {
+            break;
+        }
+    }
+
+    return err;
+}
+
+/* Unicorn: translate a block saved by tb_foreach() */
+uc_err tb_translate_block(struct uc_struct *uc, uint64_t pc, uint64_t cs_base,
+        uint32_t flags, uc_cache_info *info)
+{
+    uc_err err;
+
+    if (uc->tb_flush_request) {
+        uc->tb_flush_request = false;
+        tb_flush(uc->cpu->env_ptr);
+    }
+
+    tb_translate_one(uc, (target_ulong)pc, (target_ulong)cs_base, (int)flags,
+            info, &err);
+
+    return err;
+}
+
+/* Unicorn: call fn on every translated block */
+void tb_foreach(struct uc_struct *uc, tb_foreach_fn fn, void *opaque)
+{
+    TCGContext *tcg_ctx = uc->tcg_ctx;
+    TranslationBlock *tb;
+    int i;
+
+    if (uc->tb_flush_request) {
+        /* these blocks are stale */
+        return;
+    }
+
+    for (i = 0; i < tcg_ctx->tb_ctx.nb_tbs; i++) {
+        tb = &tcg_ctx->tb_ctx.tbs[i];
+        if (tb->size > 0) {
+            fn(opaque, tb->pc, tb->cs_base, (uint32_t)tb->flags, tb->size);
+        }
+    }
+}
+
 static TranslationBlock *tb_find_fast(CPUArchState *env)    // qq
 {
     CPUState *cpu = ENV_GET_CPU(env);
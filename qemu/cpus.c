@@ -61,18 +61,23 @@ void run_on_cpu(CPUState *cpu, void (*func)(void *data), void *data)
 
 int resume_all_vcpus(struct uc_struct *uc)
 {
-    CPUState *cpu = uc->cpu;
-    // Fix call multiple time (vu).
-    // We have to check whether this is the second time, then reset all CPU.
-    if (!cpu->created) {
-        cpu->created = true;
-        cpu->halted = 0;
-        if (qemu_init_vcpu(cpu))
-            return -1;
+    CPUState *cpu;
+
+    CPU_FOREACH(uc, cpu) {
+        // Fix call multiple time (vu).
+        // We have to check whether this is the second time, then reset all CPU.
+        if (!cpu->created) {
+            cpu->created = true;
+            cpu->halted = 0;
+            if (qemu_init_vcpu(cpu))
+                return -1;
+        }
+
+        //qemu_clock_enable(QEMU_CLOCK_VIRTUAL, true);
+        cpu_resume(cpu);
+        cpu->quantum = uc->quantum;
     }
 
-    //qemu_clock_enable(QEMU_CLOCK_VIRTUAL, true);
-    cpu_resume(cpu);
     qemu_tcg_cpu_loop(uc);
 
     return 0;
@@ -92,18 +97,22 @@ int qemu_init_vcpu(CPUState *cpu)
 
 static void qemu_tcg_cpu_loop(struct uc_struct *uc)
 {
-    CPUState *cpu = uc->cpu;
+    CPUState *cpu;
 
     //qemu_tcg_init_cpu_signals();
 
-    cpu->created = true;
+    CPU_FOREACH(uc, cpu) {
+        cpu->created = true;
+    }
 
     while (1) {
         if (tcg_exec_all(uc))
             break;
     }
 
-    cpu->created = false;
+    CPU_FOREACH(uc, cpu) {
+        cpu->created = false;
+    }
 }
 
 static int qemu_tcg_init_vcpu(CPUState *cpu)
@@ -118,6 +127,26 @@ static int tcg_cpu_exec(struct uc_struct *uc, CPUArchState *env)
     return cpu_exec(uc, env);
 }
 
+// Unicorn: switch to the next vCPU which did not stop yet, in round robin.
+// Return false if all of them stopped.
+static bool tcg_next_vcpu(struct uc_struct *uc)
+{
+    CPUState *cpu = uc->cpu;
+
+    do {
+        cpu = QTAILQ_NEXT(cpu, node);
+        if (cpu == NULL) {
+            cpu = QTAILQ_FIRST(&uc->cpus);
+        }
+        if (cpu_can_run(cpu)) {
+            uc->cpu = cpu;
+            return true;
+        }
+    } while (cpu != uc->cpu);
+
+    return false;
+}
+
 static bool tcg_exec_all(struct uc_struct* uc)
 {
     int r;
@@ -151,6 +180,12 @@ static bool tcg_exec_all(struct uc_struct* uc)
                 break;
             }
 
+            // an unhandled exception stops all vCPUs
+            if (uc->invalid_error) {
+                finish = true;
+                break;
+            }
+
             // printf(">>> stop with r = %x, HLT=%x\n", r, EXCP_HLT);
             if (r == EXCP_DEBUG) {
                 cpu_handle_guest_debug(cpu);
@@ -158,8 +193,19 @@ static bool tcg_exec_all(struct uc_struct* uc)
             }
             if (r == EXCP_HLT) {
                 //printf(">>> got HLT!!!\n");
-                finish = true;
-                break;
+                // Unicorn: this vCPU is done, the others may still run
+                cpu->stopped = true;
+                if (!tcg_next_vcpu(uc)) {
+                    finish = true;
+                    break;
+                }
+                continue;
+            }
+
+            // Unicorn: this vCPU used up its quantum, let the next one run
+            if (uc->cpu_count > 1 && cpu->quantum <= 0) {
+                cpu->quantum = uc->quantum;
+                tcg_next_vcpu(uc);
             }
         } else if (cpu->stop || cpu->stopped) {
             // printf(">>> got stopped!!!\n");
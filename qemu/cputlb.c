@@ -126,6 +126,11 @@ void tlb_protect_code(struct uc_struct *uc, ram_addr_t ram_addr)
 {
     cpu_physical_memory_reset_dirty(uc, ram_addr, TARGET_PAGE_SIZE,
                                     DIRTY_MEMORY_CODE);
+
+    // Unicorn: direct stores to flat memory must fault on translated code
+    if (uc->flat_base) {
+        uc_flat_protect_code(uc, qemu_get_ram_ptr(uc, ram_addr), true);
+    }
 }
 
 /* update the TLB so that writes in physical page 'phys_addr' are no longer
@@ -133,7 +138,25 @@ void tlb_protect_code(struct uc_struct *uc, ram_addr_t ram_addr)
 void tlb_unprotect_code_phys(CPUState *cpu, ram_addr_t ram_addr,
                              target_ulong vaddr)
 {
-    cpu_physical_memory_set_dirty_flag(cpu->uc, ram_addr, DIRTY_MEMORY_CODE);
+    struct uc_struct *uc = cpu->uc;
+    uint8_t *host;
+    ram_addr_t addr, end;
+
+    cpu_physical_memory_set_dirty_flag(uc, ram_addr, DIRTY_MEMORY_CODE);
+
+    // Unicorn: flat memory is write-protected per host page, which may hold
+    // several target pages: none of them may have code left
+    if (uc->flat_base) {
+        host = qemu_get_ram_ptr(uc, ram_addr);
+        addr = ram_addr - ((uintptr_t)host & (UC_FLAT_PAGE_SIZE - 1));
+        end = addr + UC_FLAT_PAGE_SIZE;
+        for (; addr < end; addr += TARGET_PAGE_SIZE) {
+            if (!cpu_physical_memory_get_dirty_flag(uc, addr, DIRTY_MEMORY_CODE)) {
+                return;
+            }
+        }
+        uc_flat_protect_code(uc, host, false);
+    }
 }
 
 void tlb_reset_dirty_range(CPUTLBEntry *tlb_entry, uintptr_t start,
@@ -152,23 +175,24 @@ void tlb_reset_dirty_range(CPUTLBEntry *tlb_entry, uintptr_t start,
 void cpu_tlb_reset_dirty_all(struct uc_struct *uc,
     ram_addr_t start1, ram_addr_t length)
 {
-    CPUState *cpu = uc->cpu;
-    CPUArchState *env;
+    CPUState *cpu;
 
-    int mmu_idx;
+    CPU_FOREACH(uc, cpu) {
+        CPUArchState *env = cpu->env_ptr;
+        int mmu_idx;
 
-    env = cpu->env_ptr;
-    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
-        unsigned int i;
+        for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+            unsigned int i;
 
-        for (i = 0; i < CPU_TLB_SIZE; i++) {
-            tlb_reset_dirty_range(&env->tlb_table[mmu_idx][i],
-                                  start1, length);
-        }
+            for (i = 0; i < CPU_TLB_SIZE; i++) {
+                tlb_reset_dirty_range(&env->tlb_table[mmu_idx][i],
+                                      start1, length);
+            }
 
-        for (i = 0; i < CPU_VTLB_SIZE; i++) {
-            tlb_reset_dirty_range(&env->tlb_v_table[mmu_idx][i],
-                                  start1, length);
+            for (i = 0; i < CPU_VTLB_SIZE; i++) {
+                tlb_reset_dirty_range(&env->tlb_v_table[mmu_idx][i],
+                                      start1, length);
+            }
         }
     }
 }
@@ -194,6 +218,31 @@ void tlb_set_dirty(CPUArchState *env, target_ulong vaddr)
     }
 }
 
+/* Unicorn: update the TLB corresponding to virtual page vaddr so that it
+   is dirty again (RAM write log, see ram_log_rewind()) */
+void tlb_reset_dirty_page(CPUArchState *env, target_ulong vaddr)
+{
+    int i;
+    int mmu_idx;
+
+    vaddr &= TARGET_PAGE_MASK;
+    i = (vaddr >> TARGET_PAGE_BITS) & (CPU_TLB_SIZE - 1);
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        if (env->tlb_table[mmu_idx][i].addr_write == vaddr) {
+            env->tlb_table[mmu_idx][i].addr_write = vaddr | TLB_NOTDIRTY;
+        }
+    }
+
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        int k;
+        for (k = 0; k < CPU_VTLB_SIZE; k++) {
+            if (env->tlb_v_table[mmu_idx][k].addr_write == vaddr) {
+                env->tlb_v_table[mmu_idx][k].addr_write = vaddr | TLB_NOTDIRTY;
+            }
+        }
+    }
+}
+
 
 /* Add a new TLB entry. At most one entry for a given virtual address
    is permitted. Only a single TARGET_PAGE_SIZE region is mapped, the
@@ -274,6 +323,9 @@ void tlb_set_page(CPUState *cpu, target_ulong vaddr,
             te->addr_write = address | TLB_NOTDIRTY;
         } else {
             te->addr_write = address;
+            if (cpu->uc->ram_log && memory_region_is_ram(section->mr)) {
+                ram_log_tlb_dirty(cpu->uc, vaddr);
+            }
         }
     } else {
         te->addr_write = -1;
@@ -384,9 +384,12 @@ address_space_translate_for_iotlb(AddressSpace *as, hwaddr addr, hwaddr *xlat,
 
 CPUState *qemu_get_cpu(struct uc_struct *uc, int index)
 {
-    CPUState *cpu = uc->cpu;
-    if (cpu->cpu_index == index) {
-        return cpu;
+    CPUState *cpu;
+
+    CPU_FOREACH(uc, cpu) {
+        if (cpu->cpu_index == index) {
+            return cpu;
+        }
     }
     return NULL;
 }
@@ -415,14 +418,15 @@ void cpu_exec_init(CPUArchState *env, void *opaque)
     cpu->uc = uc;
     env->uc = uc;
 
-    cpu->cpu_index = 0;
+    /* vCPU 0 also sets up the TCG globals, which all vCPUs share */
+    cpu->cpu_index = uc->cpu_count++;
     cpu->numa_node = 0;
     QTAILQ_INIT(&cpu->breakpoints);
     QTAILQ_INIT(&cpu->watchpoints);
+    QTAILQ_INSERT_TAIL(&uc->cpus, cpu, node);
 
     cpu->as = &uc->as;
 
-    // TODO: assert uc does not already have a cpu?
     uc->cpu = cpu;
 }
 
@@ -731,6 +735,119 @@ void cpu_physical_memory_reset_dirty(struct uc_struct* uc,
     }
 }
 
+/* Unicorn: RAM write log, for uc_emu_batch(). While it is on, the content of
+   a page is saved the first time the page is written, and pages written since
+   the last rewind are marked in DIRTY_MEMORY_LOG. The other pages are write
+   protected in the TLB (TLB_NOTDIRTY), so only their first write is slow. */
+static void ram_log_write(struct uc_struct *uc, ram_addr_t addr, hwaddr length)
+{
+    ram_addr_t page, end;
+    gpointer key;
+
+    if (!uc->ram_log || length == 0) {
+        return;
+    }
+
+    end = TARGET_PAGE_ALIGN(addr + length);
+    for (page = addr & TARGET_PAGE_MASK; page < end; page += TARGET_PAGE_SIZE) {
+        if (cpu_physical_memory_get_dirty_flag(uc, page, DIRTY_MEMORY_LOG)) {
+            continue;
+        }
+        key = (gpointer)(uintptr_t)(page >> TARGET_PAGE_BITS);
+        if (g_hash_table_lookup(uc->ram_log_copies, key) == NULL) {
+            g_hash_table_insert(uc->ram_log_copies, key,
+                    g_memdup(qemu_get_ram_ptr(uc, page), TARGET_PAGE_SIZE));
+        }
+        if (uc->ram_log_count == uc->ram_log_size) {
+            uc->ram_log_size = uc->ram_log_size ? uc->ram_log_size * 2 : 64;
+            uc->ram_log_pages = g_renew(ram_addr_t, uc->ram_log_pages, uc->ram_log_size);
+        }
+        uc->ram_log_pages[uc->ram_log_count++] = page;
+        cpu_physical_memory_set_dirty_flag(uc, page, DIRTY_MEMORY_LOG);
+    }
+}
+
+/* a TLB entry of virtual page vaddr was made writable for a logged page */
+void ram_log_tlb_dirty(struct uc_struct *uc, target_ulong vaddr)
+{
+    if (uc->ram_log_nvaddrs < ARRAY_SIZE(uc->ram_log_vaddrs)) {
+        uc->ram_log_vaddrs[uc->ram_log_nvaddrs] = vaddr & TARGET_PAGE_MASK;
+    }
+    uc->ram_log_nvaddrs++;
+}
+
+void ram_log_start(struct uc_struct *uc)
+{
+    CPUState *cpu;
+
+    uc->ram_log = true;
+    uc->ram_log_copies = g_hash_table_new_full(NULL, NULL, NULL, g_free);
+    uc->ram_log_count = 0;
+    uc->ram_log_nvaddrs = 0;
+
+    /* refill the TLB with every RAM page write protected */
+    CPU_FOREACH(uc, cpu) {
+        tlb_flush(cpu, 1);
+    }
+}
+
+/* put back the pages written since the last rewind, or since ram_log_start() */
+void ram_log_rewind(struct uc_struct *uc)
+{
+    CPUState *cpu;
+    ram_addr_t page;
+    uint8_t *host, *copy;
+    size_t i;
+
+    for (i = 0; i < uc->ram_log_count; i++) {
+        page = uc->ram_log_pages[i];
+        host = qemu_get_ram_ptr(uc, page);
+        copy = g_hash_table_lookup(uc->ram_log_copies,
+                (gpointer)(uintptr_t)(page >> TARGET_PAGE_BITS));
+        if (memcmp(host, copy, TARGET_PAGE_SIZE) != 0) {
+            /* translated code of this page is stale */
+            if (!cpu_physical_memory_get_dirty_flag(uc, page, DIRTY_MEMORY_CODE)) {
+                tb_invalidate_phys_range(uc, page, page + TARGET_PAGE_SIZE, 0);
+            }
+            memcpy(host, copy, TARGET_PAGE_SIZE);
+        }
+        cpu_physical_memory_clear_dirty_range(uc, page, TARGET_PAGE_SIZE, DIRTY_MEMORY_LOG);
+    }
+
+    /* write protect again the TLB entries made writable since the last
+       rewind, or the whole TLB if there were too many of them */
+    if (uc->ram_log_nvaddrs > ARRAY_SIZE(uc->ram_log_vaddrs)) {
+        cpu_tlb_reset_dirty_all(uc, 0, (uintptr_t)-1);
+    } else {
+        CPU_FOREACH(uc, cpu) {
+            for (i = 0; i < uc->ram_log_nvaddrs; i++) {
+                tlb_reset_dirty_page(cpu->env_ptr, uc->ram_log_vaddrs[i]);
+            }
+        }
+    }
+    uc->ram_log_count = 0;
+    uc->ram_log_nvaddrs = 0;
+}
+
+void ram_log_stop(struct uc_struct *uc)
+{
+    CPUState *cpu;
+
+    ram_log_rewind(uc);
+
+    uc->ram_log = false;
+    g_hash_table_destroy(uc->ram_log_copies);
+    uc->ram_log_copies = NULL;
+    g_free(uc->ram_log_pages);
+    uc->ram_log_pages = NULL;
+    uc->ram_log_size = 0;
+
+    /* pages are no longer write protected for the log */
+    CPU_FOREACH(uc, cpu) {
+        tlb_flush(cpu, 1);
+    }
+}
+
 hwaddr memory_region_section_get_iotlb(CPUState *cpu,
         MemoryRegionSection *section,
         target_ulong vaddr,
@@ -914,10 +1031,21 @@ static void mem_add(MemoryListener *listener, MemoryRegionSection *section)
 
 #endif
 
+static int ram_block_offset_cmp(const void *a, const void *b)
+{
+    const RAMBlock *ba = *(RAMBlock * const *)a, *bb = *(RAMBlock * const *)b;
+
+    return ba->offset < bb->offset ? -1 : ba->offset > bb->offset;
+}
+
+/* Unicorn: the blocks are sorted by offset, so that the next block of each
+   one is found in order rather than by walking the whole list again, which
+   made every mapping quadratic in the number of blocks */
 static ram_addr_t find_ram_offset(struct uc_struct *uc, ram_addr_t size)
 {
-    RAMBlock *block, *next_block;
+    RAMBlock *block, **blocks;
     ram_addr_t offset = RAM_ADDR_MAX, mingap = RAM_ADDR_MAX;
+    size_t i, n = 0;
 
     assert(size != 0); /* it would hand out same offset multiple times */
 
@@ -925,20 +1053,28 @@ static ram_addr_t find_ram_offset(struct uc_struct *uc, ram_addr_t size)
         return 0;
 
     QTAILQ_FOREACH(block, &uc->ram_list.blocks, next) {
-        ram_addr_t end, next = RAM_ADDR_MAX;
+        n++;
+    }
+    blocks = g_new(RAMBlock *, n);
+    n = 0;
+    QTAILQ_FOREACH(block, &uc->ram_list.blocks, next) {
+        blocks[n++] = block;
+    }
+    qsort(blocks, n, sizeof(*blocks), ram_block_offset_cmp);
 
-        end = block->offset + block->length;
+    for (i = 0; i < n; i++) {
+        ram_addr_t end, next = RAM_ADDR_MAX;
 
-        QTAILQ_FOREACH(next_block, &uc->ram_list.blocks, next) {
-            if (next_block->offset >= end) {
-                next = MIN(next, next_block->offset);
-            }
+        end = blocks[i]->offset + blocks[i]->length;
+        if (i + 1 < n) {
+            next = blocks[i + 1]->offset;
         }
         if (next - end >= size && next - end < mingap) {
             offset = end;
             mingap = next - end;
         }
     }
+    g_free(blocks);
 
     if (offset == RAM_ADDR_MAX) {
         fprintf(stderr, "Failed to find gap of requested size: %" PRIu64 "\n",
@@ -1343,6 +1479,7 @@ static int subpage_register (subpage_t *mmio, uint32_t start, uint32_t end,
 static void notdirty_mem_write(struct uc_struct* uc, void *opaque, hwaddr ram_addr,
                                uint64_t val, unsigned size)
 {
+    ram_log_write(uc, ram_addr, size);
     if (!cpu_physical_memory_get_dirty_flag(uc, ram_addr, DIRTY_MEMORY_CODE)) {
         tb_invalidate_phys_page_fast(uc, ram_addr, size);
     }
@@ -1364,6 +1501,9 @@ static void notdirty_mem_write(struct uc_struct* uc, void *opaque, hwaddr ram_ad
     if (!cpu_physical_memory_is_clean(uc, ram_addr)) {
         CPUArchState *env = uc->current_cpu->env_ptr;
         tlb_set_dirty(env, uc->current_cpu->mem_io_vaddr);
+        if (uc->ram_log) {
+            ram_log_tlb_dirty(uc, uc->current_cpu->mem_io_vaddr);
+        }
     }
 }
 
@@ -1480,11 +1620,16 @@ static void mem_commit(MemoryListener *listener)
 static void tcg_commit(MemoryListener *listener)
 {
     struct uc_struct* uc = listener->address_space_filter->uc;
+    CPUState *cpu;
 
     /* since each CPU stores ram addresses in its TLB cache, we must
        reset the modified entries */
     /* XXX: slow ! */
-    tlb_flush(uc->cpu, 1);
+    CPU_FOREACH(uc, cpu) {
+        if (cpu->tcg_as_listener == listener) {
+            tlb_flush(cpu, 1);
+        }
+    }
 }
 
 void address_space_init_dispatch(AddressSpace *as)
@@ -1678,6 +1823,7 @@ bool address_space_rw(AddressSpace *as, hwaddr addr, uint8_t *buf,
                 addr1 += memory_region_get_ram_addr(mr);
                 /* RAM case */
                 ptr = qemu_get_ram_ptr(as->uc, addr1);
+                ram_log_write(as->uc, addr1, l);
                 memcpy(ptr, buf, l);
                 invalidate_and_set_dirty(as->uc, addr1, l);
             }
@@ -1768,6 +1914,7 @@ static inline void cpu_physical_memory_write_rom_internal(AddressSpace *as,
             ptr = qemu_get_ram_ptr(as->uc, addr1);
             switch (type) {
                 case WRITE_DATA:
+                    ram_log_write(as->uc, addr1, l);
                     memcpy(ptr, buf, l);
                     invalidate_and_set_dirty(as->uc, addr1, l);
                     break;
@@ -2136,6 +2283,7 @@ void stl_phys_notdirty(AddressSpace *as, hwaddr addr, uint32_t val)
     } else {
         addr1 += memory_region_get_ram_addr(mr) & TARGET_PAGE_MASK;
         ptr = qemu_get_ram_ptr(as->uc, addr1);
+        ram_log_write(as->uc, addr1, 4);
         stl_p(ptr, val);
     }
 }
@@ -2167,6 +2315,7 @@ static inline void stl_phys_internal(AddressSpace *as,
         /* RAM case */
         addr1 += memory_region_get_ram_addr(mr) & TARGET_PAGE_MASK;
         ptr = qemu_get_ram_ptr(as->uc, addr1);
+        ram_log_write(as->uc, addr1, 4);
         switch (endian) {
             case DEVICE_LITTLE_ENDIAN:
                 stl_le_p(ptr, val);
@@ -2230,6 +2379,7 @@ static inline void stw_phys_internal(AddressSpace *as,
         /* RAM case */
         addr1 += memory_region_get_ram_addr(mr) & TARGET_PAGE_MASK;
         ptr = qemu_get_ram_ptr(as->uc, addr1);
+        ram_log_write(as->uc, addr1, 2);
         switch (endian) {
             case DEVICE_LITTLE_ENDIAN:
                 stw_le_p(ptr, val);
@@ -44,6 +44,9 @@ these four paragraphs for those parts of this code that are retained.
 
 /* We only need stdlib for abort() */
 #include <stdlib.h>
+/* Unicorn: math and float for the host FPU fast path */
+#include <math.h>
+#include <float.h>
 
 /*----------------------------------------------------------------------------
 | Primitive arithmetic functions, including multi-word arithmetic, and
@@ -2018,6 +2021,177 @@ static float32 subFloat32Sigs( float32 a, float32 b, flag zSign STATUS_PARAM)
 
 }
 
+/*----------------------------------------------------------------------------
+| Unicorn: host FPU fast path for float32/float64 add, sub, mul, div and sqrt.
+| It is only taken when the host result is bit for bit the one softfloat would
+| return, with the same exception flags:
+|  - the rounding mode is round-to-nearest-even (the host default);
+|  - the inexact flag is already raised, so we don't need to find out whether
+|    this operation is exact;
+|  - the inputs are zero or normal, so no NaN, infinity or denormal handling
+|    (and no input flushing) is involved.
+| A result that overflows, or that could be tiny (underflow, flush-to-zero),
+| is recomputed in softfloat. Hosts that may evaluate in extended precision
+| (x87) don't get the fast path.
+*----------------------------------------------------------------------------*/
+
+#if !defined(UC_NO_HARDFLOAT) && (defined(__x86_64__) || defined(__aarch64__) || \
+    (defined(__i386__) && defined(__SSE2_MATH__)))
+#define UC_HARDFLOAT 1
+#endif
+
+enum {
+    HARD_ADD,
+    HARD_SUB,
+    HARD_MUL,
+    HARD_DIV,
+    HARD_SQRT,
+};
+
+#ifdef UC_HARDFLOAT
+typedef union {
+    uint32_t i;
+    float h;
+} hard_float32;
+
+typedef union {
+    uint64_t i;
+    double h;
+} hard_float64;
+
+static inline bool can_use_fpu(float_status *status)
+{
+    return (STATUS(float_exception_flags) & float_flag_inexact) &&
+        STATUS(float_rounding_mode) == float_round_nearest_even;
+}
+
+static inline bool float32_is_zero_or_normal_hard(float32 a)
+{
+    int_fast16_t exp = extractFloat32Exp(a);
+
+    return (exp != 0 && exp != 0xFF) || float32_is_zero(a);
+}
+
+static inline bool float64_is_zero_or_normal_hard(float64 a)
+{
+    int_fast16_t exp = extractFloat64Exp(a);
+
+    return (exp != 0 && exp != 0x7FF) || float64_is_zero(a);
+}
+
+/* Returns true and sets *r if the operation could be done on the host */
+static bool float32_hard(int op, float32 a, float32 b, float32 *r STATUS_PARAM)
+{
+    hard_float32 ua, ub, ur;
+
+    if (!can_use_fpu(status) || !float32_is_zero_or_normal_hard(a)) {
+        return false;
+    }
+    ua.i = float32_val(a);
+    ub.i = float32_val(b);
+    switch (op) {
+    case HARD_SQRT:
+        if (extractFloat32Sign(a) && !float32_is_zero(a)) {
+            return false;
+        }
+        ur.h = sqrtf(ua.h);
+        break;
+    case HARD_DIV:
+        /* b must not be zero: that's a divide-by-zero or invalid */
+        if (!float32_is_zero_or_normal_hard(b) || float32_is_zero(b)) {
+            return false;
+        }
+        ur.h = ua.h / ub.h;
+        if (isinf(ur.h) || (fabsf(ur.h) <= FLT_MIN && !float32_is_zero(a))) {
+            return false;
+        }
+        break;
+    case HARD_MUL:
+        if (!float32_is_zero_or_normal_hard(b)) {
+            return false;
+        }
+        ur.h = ua.h * ub.h;
+        if (isinf(ur.h) || (fabsf(ur.h) <= FLT_MIN &&
+                            !float32_is_zero(a) && !float32_is_zero(b))) {
+            return false;
+        }
+        break;
+    default:
+        if (!float32_is_zero_or_normal_hard(b)) {
+            return false;
+        }
+        ur.h = op == HARD_ADD ? ua.h + ub.h : ua.h - ub.h;
+        if (isinf(ur.h) || (fabsf(ur.h) <= FLT_MIN &&
+                            !(float32_is_zero(a) && float32_is_zero(b)))) {
+            return false;
+        }
+        break;
+    }
+    *r = make_float32(ur.i);
+    return true;
+}
+
+static bool float64_hard(int op, float64 a, float64 b, float64 *r STATUS_PARAM)
+{
+    hard_float64 ua, ub, ur;
+
+    if (!can_use_fpu(status) || !float64_is_zero_or_normal_hard(a)) {
+        return false;
+    }
+    ua.i = float64_val(a);
+    ub.i = float64_val(b);
+    switch (op) {
+    case HARD_SQRT:
+        if (extractFloat64Sign(a) && !float64_is_zero(a)) {
+            return false;
+        }
+        ur.h = sqrt(ua.h);
+        break;
+    case HARD_DIV:
+        if (!float64_is_zero_or_normal_hard(b) || float64_is_zero(b)) {
+            return false;
+        }
+        ur.h = ua.h / ub.h;
+        if (isinf(ur.h) || (fabs(ur.h) <= DBL_MIN && !float64_is_zero(a))) {
+            return false;
+        }
+        break;
+    case HARD_MUL:
+        if (!float64_is_zero_or_normal_hard(b)) {
+            return false;
+        }
+        ur.h = ua.h * ub.h;
+        if (isinf(ur.h) || (fabs(ur.h) <= DBL_MIN &&
+                            !float64_is_zero(a) && !float64_is_zero(b))) {
+            return false;
+        }
+        break;
+    default:
+        if (!float64_is_zero_or_normal_hard(b)) {
+            return false;
+        }
+        ur.h = op == HARD_ADD ? ua.h + ub.h : ua.h - ub.h;
+        if (isinf(ur.h) || (fabs(ur.h) <= DBL_MIN &&
+                            !(float64_is_zero(a) && float64_is_zero(b)))) {
+            return false;
+        }
+        break;
+    }
+    *r = make_float64(ur.i);
+    return true;
+}
+#else
+static inline bool float32_hard(int op, float32 a, float32 b, float32 *r STATUS_PARAM)
+{
+    return false;
+}
+
+static inline bool float64_hard(int op, float64 a, float64 b, float64 *r STATUS_PARAM)
+{
+    return false;
+}
+#endif
+
 /*----------------------------------------------------------------------------
 | Returns the result of adding the single-precision floating-point values `a'
 | and `b'.  The operation is performed according to the IEC/IEEE Standard for
@@ -2027,6 +2201,12 @@ static float32 subFloat32Sigs( float32 a, float32 b, flag zSign STATUS_PARAM)
 float32 float32_add( float32 a, float32 b STATUS_PARAM )
 {
     flag aSign, bSign;
+    float32 r;
+
+    if (float32_hard(HARD_ADD, a, b, &r STATUS_VAR)) {
+        return r;
+    }
+
     a = float32_squash_input_denormal(a STATUS_VAR);
     b = float32_squash_input_denormal(b STATUS_VAR);
 
@@ -2050,6 +2230,12 @@ float32 float32_add( float32 a, float32 b STATUS_PARAM )
 float32 float32_sub( float32 a, float32 b STATUS_PARAM )
 {
     flag aSign, bSign;
+    float32 r;
+
+    if (float32_hard(HARD_SUB, a, b, &r STATUS_VAR)) {
+        return r;
+    }
+
     a = float32_squash_input_denormal(a STATUS_VAR);
     b = float32_squash_input_denormal(b STATUS_VAR);
 
@@ -2077,6 +2263,11 @@ float32 float32_mul( float32 a, float32 b STATUS_PARAM )
     uint32_t aSig, bSig;
     uint64_t zSig64;
     uint32_t zSig;
+    float32 r;
+
+    if (float32_hard(HARD_MUL, a, b, &r STATUS_VAR)) {
+        return r;
+    }
 
     a = float32_squash_input_denormal(a STATUS_VAR);
     b = float32_squash_input_denormal(b STATUS_VAR);
@@ -2138,6 +2329,12 @@ float32 float32_div( float32 a, float32 b STATUS_PARAM )
     flag aSign, bSign, zSign;
     int_fast16_t aExp, bExp, zExp;
     uint32_t aSig, bSig, zSig;
+    float32 r;
+
+    if (float32_hard(HARD_DIV, a, b, &r STATUS_VAR)) {
+        return r;
+    }
+
     a = float32_squash_input_denormal(a STATUS_VAR);
     b = float32_squash_input_denormal(b STATUS_VAR);
 
@@ -2529,6 +2726,12 @@ float32 float32_sqrt( float32 a STATUS_PARAM )
     int_fast16_t aExp, zExp;
     uint32_t aSig, zSig;
     uint64_t rem, term;
+    float32 r;
+
+    if (float32_hard(HARD_SQRT, a, float32_zero, &r STATUS_VAR)) {
+        return r;
+    }
+
     a = float32_squash_input_denormal(a STATUS_VAR);
 
     aSig = extractFloat32Frac( a );
@@ -3771,6 +3974,12 @@ static float64 subFloat64Sigs( float64 a, float64 b, flag zSign STATUS_PARAM )
 float64 float64_add( float64 a, float64 b STATUS_PARAM )
 {
     flag aSign, bSign;
+    float64 r;
+
+    if (float64_hard(HARD_ADD, a, b, &r STATUS_VAR)) {
+        return r;
+    }
+
     a = float64_squash_input_denormal(a STATUS_VAR);
     b = float64_squash_input_denormal(b STATUS_VAR);
 
@@ -3794,6 +4003,12 @@ float64 float64_add( float64 a, float64 b STATUS_PARAM )
 float64 float64_sub( float64 a, float64 b STATUS_PARAM )
 {
     flag aSign, bSign;
+    float64 r;
+
+    if (float64_hard(HARD_SUB, a, b, &r STATUS_VAR)) {
+        return r;
+    }
+
     a = float64_squash_input_denormal(a STATUS_VAR);
     b = float64_squash_input_denormal(b STATUS_VAR);
 
@@ -3819,6 +4034,11 @@ float64 float64_mul( float64 a, float64 b STATUS_PARAM )
     flag aSign, bSign, zSign;
     int_fast16_t aExp, bExp, zExp;
     uint64_t aSig, bSig, zSig0, zSig1;
+    float64 r;
+
+    if (float64_hard(HARD_MUL, a, b, &r STATUS_VAR)) {
+        return r;
+    }
 
     a = float64_squash_input_denormal(a STATUS_VAR);
     b = float64_squash_input_denormal(b STATUS_VAR);
@@ -3882,6 +4102,12 @@ float64 float64_div( float64 a, float64 b STATUS_PARAM )
     uint64_t aSig, bSig, zSig;
     uint64_t rem0, rem1;
     uint64_t term0, term1;
+    float64 r;
+
+    if (float64_hard(HARD_DIV, a, b, &r STATUS_VAR)) {
+        return r;
+    }
+
     a = float64_squash_input_denormal(a STATUS_VAR);
     b = float64_squash_input_denormal(b STATUS_VAR);
 
@@ -4285,6 +4511,12 @@ float64 float64_sqrt( float64 a STATUS_PARAM )
     int_fast16_t aExp, zExp;
     uint64_t aSig, zSig, doubleZSig;
     uint64_t rem0, rem1, term0, term1;
+    float64 r;
+
+    if (float64_hard(HARD_SQRT, a, float64_zero, &r STATUS_VAR)) {
+        return r;
+    }
+
     a = float64_squash_input_denormal(a STATUS_VAR);
 
     aSig = extractFloat64Frac( a );
@@ -114,6 +114,27 @@ gboolean g_int_equal(gconstpointer v1, gconstpointer v2)
    return *((const gint*)v1) == *((const gint*)v2);
 }
 
+// g_int64_hash() is lifted from glib-2.28.0/glib/gutils.c
+/**
+ * g_int64_hash:
+ * @v: a pointer to a #guint64 key
+ *
+ * Converts a pointer to a #guint64 to a hash value.
+ * It can be passed to g_hash_table_new() as the @hash_func parameter,
+ * when using pointers to 64-bit integers values as keys in a #GHashTable.
+ *
+ * Returns: a hash value corresponding to the key.
+ */
+guint g_int64_hash (gconstpointer v)
+{
+  return (guint) *(const guint64*) v;
+}
+
+gboolean g_int64_equal(gconstpointer v1, gconstpointer v2)
+{
+   return *((const guint64*)v1) == *((const guint64*)v2);
+}
+
 /* Doubly-linked list */
 
 GList *g_list_first(GList *list)
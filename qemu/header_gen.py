@@ -18,6 +18,14 @@ symbols = (
     'tb_invalidate_phys_page_fast',
     'phys_mem_clean',
     'tb_cleanup',
+    'tb_translate_range',
+    'tb_translate_block',
+    'tb_foreach',
+    'tb_flat_fault',
+    'ram_log_start',
+    'ram_log_rewind',
+    'ram_log_stop',
+    'ram_log_tlb_dirty',
     'memory_map',
     'memory_map_ptr',
     'memory_unmap',
@@ -1344,8 +1352,13 @@ symbols = (
     'handle_vrint',
     'handle_vsel',
     'has_help_option',
+    'have_aesni',
+    'have_avx2',
     'have_bmi1',
     'have_bmi2',
+    'have_pclmul',
+    'have_sse41',
+    'have_ssse3',
     'hcr_write',
     'helper_access_check_cp_reg',
     'helper_add_saturate',
@@ -2930,6 +2943,7 @@ symbols = (
     'tlbimva_write',
     'tlb_is_dirty_ram',
     'tlb_protect_code',
+    'tlb_reset_dirty_page',
     'tlb_reset_dirty_range',
     'tlb_reset_dirty_range_all',
     'tlb_set_dirty',
@@ -3192,6 +3206,98 @@ mips_symbols = (
     'helper_msa_ilvev_df',
     'helper_msa_ilvod_df',
     'helper_msa_vshf_df',
+    'helper_msa_addv_b',
+    'helper_msa_addv_h',
+    'helper_msa_addv_w',
+    'helper_msa_addv_d',
+    'helper_msa_subv_b',
+    'helper_msa_subv_h',
+    'helper_msa_subv_w',
+    'helper_msa_subv_d',
+    'helper_msa_mulv_b',
+    'helper_msa_mulv_h',
+    'helper_msa_mulv_w',
+    'helper_msa_mulv_d',
+    'helper_msa_ceq_b',
+    'helper_msa_ceq_h',
+    'helper_msa_ceq_w',
+    'helper_msa_ceq_d',
+    'helper_msa_clt_s_b',
+    'helper_msa_clt_s_h',
+    'helper_msa_clt_s_w',
+    'helper_msa_clt_s_d',
+    'helper_msa_clt_u_b',
+    'helper_msa_clt_u_h',
+    'helper_msa_clt_u_w',
+    'helper_msa_clt_u_d',
+    'helper_msa_cle_s_b',
+    'helper_msa_cle_s_h',
+    'helper_msa_cle_s_w',
+    'helper_msa_cle_s_d',
+    'helper_msa_cle_u_b',
+    'helper_msa_cle_u_h',
+    'helper_msa_cle_u_w',
+    'helper_msa_cle_u_d',
+    'helper_msa_max_s_b',
+    'helper_msa_max_s_h',
+    'helper_msa_max_s_w',
+    'helper_msa_max_s_d',
+    'helper_msa_max_u_b',
+    'helper_msa_max_u_h',
+    'helper_msa_max_u_w',
+    'helper_msa_max_u_d',
+    'helper_msa_min_s_b',
+    'helper_msa_min_s_h',
+    'helper_msa_min_s_w',
+    'helper_msa_min_s_d',
+    'helper_msa_min_u_b',
+    'helper_msa_min_u_h',
+    'helper_msa_min_u_w',
+    'helper_msa_min_u_d',
+    'helper_msa_adds_s_b',
+    'helper_msa_adds_s_h',
+    'helper_msa_adds_s_w',
+    'helper_msa_adds_s_d',
+    'helper_msa_adds_u_b',
+    'helper_msa_adds_u_h',
+    'helper_msa_adds_u_w',
+    'helper_msa_adds_u_d',
+    'helper_msa_subs_s_b',
+    'helper_msa_subs_s_h',
+    'helper_msa_subs_s_w',
+    'helper_msa_subs_s_d',
+    'helper_msa_subs_u_b',
+    'helper_msa_subs_u_h',
+    'helper_msa_subs_u_w',
+    'helper_msa_subs_u_d',
+    'helper_msa_ilvr_b',
+    'helper_msa_ilvr_h',
+    'helper_msa_ilvr_w',
+    'helper_msa_ilvr_d',
+    'helper_msa_ilvl_b',
+    'helper_msa_ilvl_h',
+    'helper_msa_ilvl_w',
+    'helper_msa_ilvl_d',
+    'helper_msa_ilvev_b',
+    'helper_msa_ilvev_h',
+    'helper_msa_ilvev_w',
+    'helper_msa_ilvev_d',
+    'helper_msa_ilvod_b',
+    'helper_msa_ilvod_h',
+    'helper_msa_ilvod_w',
+    'helper_msa_ilvod_d',
+    'helper_msa_pckev_b',
+    'helper_msa_pckev_h',
+    'helper_msa_pckev_w',
+    'helper_msa_pckev_d',
+    'helper_msa_pckod_b',
+    'helper_msa_pckod_h',
+    'helper_msa_pckod_w',
+    'helper_msa_pckod_d',
+    'helper_msa_vshf_b',
+    'helper_msa_vshf_h',
+    'helper_msa_vshf_w',
+    'helper_msa_vshf_d',
     'helper_msa_sldi_df',
     'helper_msa_splati_df',
     'helper_msa_copy_s_df',
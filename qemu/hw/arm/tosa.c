@@ -27,6 +27,8 @@ static int tosa_init(struct uc_struct *uc, MachineState *machine)
         uc->cpu = (CPUState *)cpu_arm_init(uc, "arm946");
     else if (uc->mode & UC_MODE_ARM1176)
         uc->cpu = (CPUState *)cpu_arm_init(uc, "arm1176");
+    else if (uc->mode & UC_MODE_V8)
+        uc->cpu = (CPUState *)cpu_arm_init(uc, "any");
     else
         uc->cpu = (CPUState *)cpu_arm_init(uc, "cortex-a15");
 
@@ -129,7 +129,8 @@ int pc_cpus_init(struct uc_struct *uc, const char *cpu_model)
     }
 
     for (i = 0; i < smp_cpus; i++) {
-        uc->cpu = (CPUState *)pc_new_cpu(uc, cpu_model, x86_cpu_apic_id_from_index(i), &error);
+        // Unicorn: uc_vcpu_add() calls this again for each new vCPU
+        uc->cpu = (CPUState *)pc_new_cpu(uc, cpu_model, x86_cpu_apic_id_from_index(uc->cpu_count), &error);
         if (error) {
             //error_report("%s", error_get_pretty(error));
             error_free(error);
@@ -28,7 +28,10 @@ static int mips_r4k_init(struct uc_struct *uc, MachineState *machine)
 #ifdef TARGET_MIPS64
         cpu_model = "R4000";
 #else
-        cpu_model = "24Kf";
+        if (uc->mode & UC_MODE_MIPS32R5)
+            cpu_model = "mips32r5-generic";
+        else
+            cpu_model = "24Kf";
 #endif
     }
 
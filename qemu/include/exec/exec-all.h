@@ -21,6 +21,7 @@
 #define _EXEC_ALL_H_
 
 #include "qemu-common.h"
+#include "unicorn/unicorn.h"
 
 /* allow to see translation results - the slowdown should be negligible, so we leave it */
 #define DEBUG_DISAS
@@ -83,6 +84,17 @@ void QEMU_NORETURN cpu_io_recompile(CPUState *cpu, uintptr_t retaddr);
 TranslationBlock *tb_gen_code(CPUState *cpu,
                               target_ulong pc, target_ulong cs_base, int flags,
                               int cflags);
+uc_err tb_translate_range(struct uc_struct *uc, uint64_t begin, uint64_t end,
+                          uc_cache_info *info);
+uc_err tb_translate_block(struct uc_struct *uc, uint64_t pc, uint64_t cs_base,
+                          uint32_t flags, uc_cache_info *info);
+typedef void (*tb_foreach_fn)(void *opaque, uint64_t pc, uint64_t cs_base,
+                              uint32_t flags, uint32_t size);
+void tb_foreach(struct uc_struct *uc, tb_foreach_fn fn, void *opaque);
+bool tb_flat_fault(struct uc_struct *uc, uintptr_t host_pc);
+void ram_log_start(struct uc_struct *uc);
+void ram_log_rewind(struct uc_struct *uc);
+void ram_log_stop(struct uc_struct *uc);
 void cpu_exec_init(CPUArchState *env, void *opaque);
 
 void QEMU_NORETURN cpu_loop_exit(CPUState *cpu);
@@ -140,9 +152,10 @@ struct TranslationBlock {
     uint64_t flags; /* flags defining in which context the code was generated */
     uint16_t size;      /* size of target code for this block (1 <=
                            size <= TARGET_PAGE_SIZE) */
-    uint16_t cflags;    /* compile flags */
+    uint32_t cflags;    /* compile flags */
 #define CF_COUNT_MASK  0x7fff
 #define CF_LAST_IO     0x8000 /* Last insn may be an IO access.  */
+#define CF_NOFLAT      0x10000 /* Unicorn: no direct access to flat memory */
 
     void *tc_ptr;    /* pointer to the translated code */
     /* next matching tb for physical address. */
@@ -20,6 +20,24 @@ static inline void gen_tb_start(TCGContext *tcg_ctx)
     tcg_gen_brcondi_i32(tcg_ctx, TCG_COND_NE, flag, 0, tcg_ctx->exitreq_label);
     tcg_temp_free_i32(tcg_ctx, flag);
 
+    // Unicorn: with several vCPUs, leave when this one used up its quantum,
+    // otherwise charge it for the instructions of the block
+    tcg_ctx->quantum_arg = NULL;
+    if (tcg_ctx->uc->cpu_count > 1) {
+        TCGv_i32 count = tcg_temp_local_new_i32(tcg_ctx);
+
+        tcg_ctx->quantum_label = gen_new_label(tcg_ctx);
+        tcg_gen_ld_i32(tcg_ctx, count, tcg_ctx->cpu_env,
+                       offsetof(CPUState, quantum) - ENV_OFFSET);
+        tcg_gen_brcondi_i32(tcg_ctx, TCG_COND_LE, count, 0, tcg_ctx->quantum_label);
+        // gen_tb_end() fills in the number of instructions
+        tcg_ctx->quantum_arg = tcg_ctx->gen_opparam_ptr + 1;
+        tcg_gen_subi_i32(tcg_ctx, count, count, 0xdeadbeef);
+        tcg_gen_st_i32(tcg_ctx, count, tcg_ctx->cpu_env,
+                       offsetof(CPUState, quantum) - ENV_OFFSET);
+        tcg_temp_free_i32(tcg_ctx, count);
+    }
+
 #if 0
     if (!use_icount)
         return;
@@ -44,6 +62,12 @@ static inline void gen_tb_end(TCGContext *tcg_ctx, TranslationBlock *tb, int num
     gen_set_label(tcg_ctx, tcg_ctx->exitreq_label);
     tcg_gen_exit_tb(tcg_ctx, (uintptr_t)tb + TB_EXIT_REQUESTED);
 
+    if (tcg_ctx->quantum_arg) {
+        *tcg_ctx->quantum_arg = num_insns;
+        gen_set_label(tcg_ctx, tcg_ctx->quantum_label);
+        tcg_gen_exit_tb(tcg_ctx, (uintptr_t)tb + TB_EXIT_ICOUNT_EXPIRED);
+    }
+
 #if 0
     if (use_icount) {
         *icount_arg = num_insns;
@@ -17,7 +17,8 @@
 #ifndef CONFIG_USER_ONLY
 
 #define DIRTY_MEMORY_CODE      0
-#define DIRTY_MEMORY_NUM       1        /* num of dirty bits */
+#define DIRTY_MEMORY_LOG       1        /* Unicorn: written since the last ram_log_rewind() */
+#define DIRTY_MEMORY_NUM       2        /* num of dirty bits */
 
 #include "unicorn/platform.h"
 #include "qemu-common.h"
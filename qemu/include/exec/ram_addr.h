@@ -68,9 +68,12 @@ static inline bool cpu_physical_memory_get_dirty_flag(struct uc_struct *uc, ram_
     return cpu_physical_memory_get_dirty(uc, addr, 1, client);
 }
 
+/* Unicorn: with the RAM write log on, pages not written since the last
+   rewind are clean too, so that their first write takes the slow path */
 static inline bool cpu_physical_memory_is_clean(struct uc_struct *uc, ram_addr_t addr)
 {
-    return !cpu_physical_memory_get_dirty_flag(uc, addr, DIRTY_MEMORY_CODE);
+    return !cpu_physical_memory_get_dirty_flag(uc, addr, DIRTY_MEMORY_CODE) ||
+        (uc->ram_log && !cpu_physical_memory_get_dirty_flag(uc, addr, DIRTY_MEMORY_LOG));
 }
 
 static inline bool cpu_physical_memory_range_includes_clean(struct uc_struct *uc, ram_addr_t start,
@@ -60,6 +60,8 @@ gboolean g_str_equal(gconstpointer v1, gconstpointer v2);
 guint g_int_hash(gconstpointer v);
 
 gboolean g_int_equal(gconstpointer v1, gconstpointer v2);
+guint g_int64_hash(gconstpointer v);
+gboolean g_int64_equal(gconstpointer v1, gconstpointer v2);
 
 typedef struct _GList {
   gpointer data;
@@ -32,4 +32,9 @@
 
 uint32_t crc32c(uint32_t crc, const uint8_t *data, unsigned int length);
 
+/* The IEEE 802.3 (zlib) CRC-32, with the same conventions as crc32c(): the
+ * caller supplies the raw initial value and the result is inverted. zlib's
+ * crc32(c, ...) is crc32_ieee(c ^ 0xffffffff, ...). */
+uint32_t crc32_ieee(uint32_t crc, const uint8_t *data, unsigned int length);
+
 #endif
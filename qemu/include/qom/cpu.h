@@ -266,6 +266,14 @@ struct CPUState {
     uint32_t can_do_io;
     int32_t exception_index; /* used by m68k TCG */
 
+    /* Unicorn: set by translated code changing FP/SIMD registers, see uc_context_save() */
+    uint32_t fpu_dirty;
+    /* Unicorn: content of each register group, or 0 if changed since the last
+       uc_context_save() or uc_context_restore() (UC_CTX_GROUPS entries) */
+    uint64_t context_version[3];
+    /* Unicorn: instructions left to run before the next vCPU, see uc_vcpu_set_quantum() */
+    int32_t quantum;
+
     /* Note that this is accessed at the start of every TB via a negative
        offset from AREG0.  Leave this field at the end so as to make the
        (absolute value) offset as small as possible.  This reduces code
@@ -12,6 +12,14 @@
 #define tb_invalidate_phys_page_fast tb_invalidate_phys_page_fast_m68k
 #define phys_mem_clean phys_mem_clean_m68k
 #define tb_cleanup tb_cleanup_m68k
+#define tb_translate_range tb_translate_range_m68k
+#define tb_translate_block tb_translate_block_m68k
+#define tb_foreach tb_foreach_m68k
+#define tb_flat_fault tb_flat_fault_m68k
+#define ram_log_start ram_log_start_m68k
+#define ram_log_rewind ram_log_rewind_m68k
+#define ram_log_stop ram_log_stop_m68k
+#define ram_log_tlb_dirty ram_log_tlb_dirty_m68k
 #define memory_map memory_map_m68k
 #define memory_map_ptr memory_map_ptr_m68k
 #define memory_unmap memory_unmap_m68k
@@ -1338,8 +1346,13 @@
 #define handle_vrint handle_vrint_m68k
 #define handle_vsel handle_vsel_m68k
 #define has_help_option has_help_option_m68k
+#define have_aesni have_aesni_m68k
+#define have_avx2 have_avx2_m68k
 #define have_bmi1 have_bmi1_m68k
 #define have_bmi2 have_bmi2_m68k
+#define have_pclmul have_pclmul_m68k
+#define have_sse41 have_sse41_m68k
+#define have_ssse3 have_ssse3_m68k
 #define hcr_write hcr_write_m68k
 #define helper_access_check_cp_reg helper_access_check_cp_reg_m68k
 #define helper_add_saturate helper_add_saturate_m68k
@@ -2924,6 +2937,7 @@
 #define tlbimva_write tlbimva_write_m68k
 #define tlb_is_dirty_ram tlb_is_dirty_ram_m68k
 #define tlb_protect_code tlb_protect_code_m68k
+#define tlb_reset_dirty_page tlb_reset_dirty_page_m68k
 #define tlb_reset_dirty_range tlb_reset_dirty_range_m68k
 #define tlb_reset_dirty_range_all tlb_reset_dirty_range_all_m68k
 #define tlb_set_dirty tlb_set_dirty_m68k
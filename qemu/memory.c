@@ -361,9 +361,12 @@ static void flatview_simplify(FlatView *view)
             ++j;
         }
         ++i;
-        memmove(&view->ranges[i], &view->ranges[j],
-                (view->nr - j) * sizeof(view->ranges[j]));
-        view->nr -= j - i;
+        /* Unicorn: nothing to move if no range was merged */
+        if (j > i) {
+            memmove(&view->ranges[i], &view->ranges[j],
+                    (view->nr - j) * sizeof(view->ranges[j]));
+            view->nr -= j - i;
+        }
     }
 }
 
@@ -512,6 +515,24 @@ static AddressSpace *memory_region_to_address_space(MemoryRegion *mr)
     return NULL;
 }
 
+/* Unicorn: index of the first range of the sorted VIEW ending after ADDR */
+static unsigned flatview_find(FlatView *view, Int128 addr)
+{
+    unsigned lo = 0, hi = view->nr;
+
+    while (lo < hi) {
+        unsigned mid = (lo + hi) / 2;
+
+        if (int128_ge(addr, addrrange_end(view->ranges[mid].addr))) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
 /* Render a memory region into the global view.  Ranges in @view obscure
  * ranges in @mr.
  */
@@ -569,8 +590,10 @@ static void render_memory_region(FlatView *view,
     fr.romd_mode = mr->romd_mode;
     fr.readonly = readonly;
 
-    /* Render the region itself into any gaps left by the current view. */
-    for (i = 0; i < view->nr && int128_nz(remain); ++i) {
+    /* Render the region itself into any gaps left by the current view.
+       Unicorn: the ranges ending before it are skipped with a binary search,
+       as there is one range per memory mapping.  */
+    for (i = flatview_find(view, base); i < view->nr && int128_nz(remain); ++i) {
         if (int128_ge(base, addrrange_end(view->ranges[i].addr))) {
             continue;
         }
@@ -1280,8 +1303,14 @@ static void memory_region_update_container_subregions(MemoryRegion *subregion)
                other->name);
 #endif
     }
+    /* Unicorn: subregions of the same priority that cannot overlap are kept
+       sorted by address, so that each one is rendered at the end of the flat
+       view instead of moving all the ranges rendered before it */
     QTAILQ_FOREACH(other, &mr->subregions, subregions_link) {
-        if (subregion->priority >= other->priority) {
+        if (subregion->priority > other->priority ||
+            (subregion->priority == other->priority &&
+             (subregion->may_overlap || other->may_overlap ||
+              subregion->addr < other->addr))) {
             QTAILQ_INSERT_BEFORE(other, subregion, subregions_link);
             goto done;
         }
@@ -12,6 +12,14 @@
 #define tb_invalidate_phys_page_fast tb_invalidate_phys_page_fast_mips64el
 #define phys_mem_clean phys_mem_clean_mips64el
 #define tb_cleanup tb_cleanup_mips64el
+#define tb_translate_range tb_translate_range_mips64el
+#define tb_translate_block tb_translate_block_mips64el
+#define tb_foreach tb_foreach_mips64el
+#define tb_flat_fault tb_flat_fault_mips64el
+#define ram_log_start ram_log_start_mips64el
+#define ram_log_rewind ram_log_rewind_mips64el
+#define ram_log_stop ram_log_stop_mips64el
+#define ram_log_tlb_dirty ram_log_tlb_dirty_mips64el
 #define memory_map memory_map_mips64el
 #define memory_map_ptr memory_map_ptr_mips64el
 #define memory_unmap memory_unmap_mips64el
@@ -1338,8 +1346,13 @@
 #define handle_vrint handle_vrint_mips64el
 #define handle_vsel handle_vsel_mips64el
 #define has_help_option has_help_option_mips64el
+#define have_aesni have_aesni_mips64el
+#define have_avx2 have_avx2_mips64el
 #define have_bmi1 have_bmi1_mips64el
 #define have_bmi2 have_bmi2_mips64el
+#define have_pclmul have_pclmul_mips64el
+#define have_sse41 have_sse41_mips64el
+#define have_ssse3 have_ssse3_mips64el
 #define hcr_write hcr_write_mips64el
 #define helper_access_check_cp_reg helper_access_check_cp_reg_mips64el
 #define helper_add_saturate helper_add_saturate_mips64el
@@ -2924,6 +2937,7 @@
 #define tlbimva_write tlbimva_write_mips64el
 #define tlb_is_dirty_ram tlb_is_dirty_ram_mips64el
 #define tlb_protect_code tlb_protect_code_mips64el
+#define tlb_reset_dirty_page tlb_reset_dirty_page_mips64el
 #define tlb_reset_dirty_range tlb_reset_dirty_range_mips64el
 #define tlb_reset_dirty_range_all tlb_reset_dirty_range_all_mips64el
 #define tlb_set_dirty tlb_set_dirty_mips64el
@@ -3139,6 +3153,98 @@
 #define helper_msa_ilvev_df helper_msa_ilvev_df_mips64el
 #define helper_msa_ilvod_df helper_msa_ilvod_df_mips64el
 #define helper_msa_vshf_df helper_msa_vshf_df_mips64el
+#define helper_msa_addv_b helper_msa_addv_b_mips64el
+#define helper_msa_addv_h helper_msa_addv_h_mips64el
+#define helper_msa_addv_w helper_msa_addv_w_mips64el
+#define helper_msa_addv_d helper_msa_addv_d_mips64el
+#define helper_msa_subv_b helper_msa_subv_b_mips64el
+#define helper_msa_subv_h helper_msa_subv_h_mips64el
+#define helper_msa_subv_w helper_msa_subv_w_mips64el
+#define helper_msa_subv_d helper_msa_subv_d_mips64el
+#define helper_msa_mulv_b helper_msa_mulv_b_mips64el
+#define helper_msa_mulv_h helper_msa_mulv_h_mips64el
+#define helper_msa_mulv_w helper_msa_mulv_w_mips64el
+#define helper_msa_mulv_d helper_msa_mulv_d_mips64el
+#define helper_msa_ceq_b helper_msa_ceq_b_mips64el
+#define helper_msa_ceq_h helper_msa_ceq_h_mips64el
+#define helper_msa_ceq_w helper_msa_ceq_w_mips64el
+#define helper_msa_ceq_d helper_msa_ceq_d_mips64el
+#define helper_msa_clt_s_b helper_msa_clt_s_b_mips64el
+#define helper_msa_clt_s_h helper_msa_clt_s_h_mips64el
+#define helper_msa_clt_s_w helper_msa_clt_s_w_mips64el
+#define helper_msa_clt_s_d helper_msa_clt_s_d_mips64el
+#define helper_msa_clt_u_b helper_msa_clt_u_b_mips64el
+#define helper_msa_clt_u_h helper_msa_clt_u_h_mips64el
+#define helper_msa_clt_u_w helper_msa_clt_u_w_mips64el
+#define helper_msa_clt_u_d helper_msa_clt_u_d_mips64el
+#define helper_msa_cle_s_b helper_msa_cle_s_b_mips64el
+#define helper_msa_cle_s_h helper_msa_cle_s_h_mips64el
+#define helper_msa_cle_s_w helper_msa_cle_s_w_mips64el
+#define helper_msa_cle_s_d helper_msa_cle_s_d_mips64el
+#define helper_msa_cle_u_b helper_msa_cle_u_b_mips64el
+#define helper_msa_cle_u_h helper_msa_cle_u_h_mips64el
+#define helper_msa_cle_u_w helper_msa_cle_u_w_mips64el
+#define helper_msa_cle_u_d helper_msa_cle_u_d_mips64el
+#define helper_msa_max_s_b helper_msa_max_s_b_mips64el
+#define helper_msa_max_s_h helper_msa_max_s_h_mips64el
+#define helper_msa_max_s_w helper_msa_max_s_w_mips64el
+#define helper_msa_max_s_d helper_msa_max_s_d_mips64el
+#define helper_msa_max_u_b helper_msa_max_u_b_mips64el
+#define helper_msa_max_u_h helper_msa_max_u_h_mips64el
+#define helper_msa_max_u_w helper_msa_max_u_w_mips64el
+#define helper_msa_max_u_d helper_msa_max_u_d_mips64el
+#define helper_msa_min_s_b helper_msa_min_s_b_mips64el
+#define helper_msa_min_s_h helper_msa_min_s_h_mips64el
+#define helper_msa_min_s_w helper_msa_min_s_w_mips64el
+#define helper_msa_min_s_d helper_msa_min_s_d_mips64el
+#define helper_msa_min_u_b helper_msa_min_u_b_mips64el
+#define helper_msa_min_u_h helper_msa_min_u_h_mips64el
+#define helper_msa_min_u_w helper_msa_min_u_w_mips64el
+#define helper_msa_min_u_d helper_msa_min_u_d_mips64el
+#define helper_msa_adds_s_b helper_msa_adds_s_b_mips64el
+#define helper_msa_adds_s_h helper_msa_adds_s_h_mips64el
+#define helper_msa_adds_s_w helper_msa_adds_s_w_mips64el
+#define helper_msa_adds_s_d helper_msa_adds_s_d_mips64el
+#define helper_msa_adds_u_b helper_msa_adds_u_b_mips64el
+#define helper_msa_adds_u_h helper_msa_adds_u_h_mips64el
+#define helper_msa_adds_u_w helper_msa_adds_u_w_mips64el
+#define helper_msa_adds_u_d helper_msa_adds_u_d_mips64el
+#define helper_msa_subs_s_b helper_msa_subs_s_b_mips64el
+#define helper_msa_subs_s_h helper_msa_subs_s_h_mips64el
+#define helper_msa_subs_s_w helper_msa_subs_s_w_mips64el
+#define helper_msa_subs_s_d helper_msa_subs_s_d_mips64el
+#define helper_msa_subs_u_b helper_msa_subs_u_b_mips64el
+#define helper_msa_subs_u_h helper_msa_subs_u_h_mips64el
+#define helper_msa_subs_u_w helper_msa_subs_u_w_mips64el
+#define helper_msa_subs_u_d helper_msa_subs_u_d_mips64el
+#define helper_msa_ilvr_b helper_msa_ilvr_b_mips64el
+#define helper_msa_ilvr_h helper_msa_ilvr_h_mips64el
+#define helper_msa_ilvr_w helper_msa_ilvr_w_mips64el
+#define helper_msa_ilvr_d helper_msa_ilvr_d_mips64el
+#define helper_msa_ilvl_b helper_msa_ilvl_b_mips64el
+#define helper_msa_ilvl_h helper_msa_ilvl_h_mips64el
+#define helper_msa_ilvl_w helper_msa_ilvl_w_mips64el
+#define helper_msa_ilvl_d helper_msa_ilvl_d_mips64el
+#define helper_msa_ilvev_b helper_msa_ilvev_b_mips64el
+#define helper_msa_ilvev_h helper_msa_ilvev_h_mips64el
+#define helper_msa_ilvev_w helper_msa_ilvev_w_mips64el
+#define helper_msa_ilvev_d helper_msa_ilvev_d_mips64el
+#define helper_msa_ilvod_b helper_msa_ilvod_b_mips64el
+#define helper_msa_ilvod_h helper_msa_ilvod_h_mips64el
+#define helper_msa_ilvod_w helper_msa_ilvod_w_mips64el
+#define helper_msa_ilvod_d helper_msa_ilvod_d_mips64el
+#define helper_msa_pckev_b helper_msa_pckev_b_mips64el
+#define helper_msa_pckev_h helper_msa_pckev_h_mips64el
+#define helper_msa_pckev_w helper_msa_pckev_w_mips64el
+#define helper_msa_pckev_d helper_msa_pckev_d_mips64el
+#define helper_msa_pckod_b helper_msa_pckod_b_mips64el
+#define helper_msa_pckod_h helper_msa_pckod_h_mips64el
+#define helper_msa_pckod_w helper_msa_pckod_w_mips64el
+#define helper_msa_pckod_d helper_msa_pckod_d_mips64el
+#define helper_msa_vshf_b helper_msa_vshf_b_mips64el
+#define helper_msa_vshf_h helper_msa_vshf_h_mips64el
+#define helper_msa_vshf_w helper_msa_vshf_w_mips64el
+#define helper_msa_vshf_d helper_msa_vshf_d_mips64el
 #define helper_msa_sldi_df helper_msa_sldi_df_mips64el
 #define helper_msa_splati_df helper_msa_splati_df_mips64el
 #define helper_msa_copy_s_df helper_msa_copy_s_df_mips64el
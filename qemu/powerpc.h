@@ -12,6 +12,14 @@
 #define tb_invalidate_phys_page_fast tb_invalidate_phys_page_fast_powerpc
 #define phys_mem_clean phys_mem_clean_powerpc
 #define tb_cleanup tb_cleanup_powerpc
+#define tb_translate_range tb_translate_range_powerpc
+#define tb_translate_block tb_translate_block_powerpc
+#define tb_foreach tb_foreach_powerpc
+#define tb_flat_fault tb_flat_fault_powerpc
+#define ram_log_start ram_log_start_powerpc
+#define ram_log_rewind ram_log_rewind_powerpc
+#define ram_log_stop ram_log_stop_powerpc
+#define ram_log_tlb_dirty ram_log_tlb_dirty_powerpc
 #define memory_map memory_map_powerpc
 #define memory_map_ptr memory_map_ptr_powerpc
 #define memory_unmap memory_unmap_powerpc
@@ -1338,8 +1346,13 @@
 #define handle_vrint handle_vrint_powerpc
 #define handle_vsel handle_vsel_powerpc
 #define has_help_option has_help_option_powerpc
+#define have_aesni have_aesni_powerpc
+#define have_avx2 have_avx2_powerpc
 #define have_bmi1 have_bmi1_powerpc
 #define have_bmi2 have_bmi2_powerpc
+#define have_pclmul have_pclmul_powerpc
+#define have_sse41 have_sse41_powerpc
+#define have_ssse3 have_ssse3_powerpc
 #define hcr_write hcr_write_powerpc
 #define helper_access_check_cp_reg helper_access_check_cp_reg_powerpc
 #define helper_add_saturate helper_add_saturate_powerpc
@@ -2924,6 +2937,7 @@
 #define tlbimva_write tlbimva_write_powerpc
 #define tlb_is_dirty_ram tlb_is_dirty_ram_powerpc
 #define tlb_protect_code tlb_protect_code_powerpc
+#define tlb_reset_dirty_page tlb_reset_dirty_page_powerpc
 #define tlb_reset_dirty_range tlb_reset_dirty_range_powerpc
 #define tlb_reset_dirty_range_all tlb_reset_dirty_range_all_powerpc
 #define tlb_set_dirty tlb_set_dirty_powerpc
@@ -723,21 +723,26 @@ object_property_add(Object *obj, const char *name, const char *type,
     size_t name_len = strlen(name);
 
     if (name_len >= 3 && !memcmp(name + name_len - 3, "[*]", 4)) {
-        int i;
+        int i = 0, n;
         ObjectProperty *ret;
         char *name_no_array = g_strdup(name);
+        char *full_name;
 
         name_no_array[name_len - 3] = '\0';
-        for (i = 0; ; ++i) {
-            char *full_name = g_strdup_printf("%s[%d]", name_no_array, i);
-
-            ret = object_property_add(obj, full_name, type, get, set,
-                                      release, opaque, NULL);
-            g_free(full_name);
-            if (ret) {
-                break;
+        /* Unicorn: take the index after the highest one in use, found in one
+           pass, rather than trying each index in turn: every memory mapping
+           adds a "pc.ram[*]" property, so this was quadratic in the number
+           of mappings */
+        QTAILQ_FOREACH(prop, &obj->properties, node) {
+            if (strncmp(prop->name, name_no_array, name_len - 3) == 0 &&
+                sscanf(prop->name + name_len - 3, "[%d]", &n) == 1 && n >= i) {
+                i = n + 1;
             }
         }
+        full_name = g_strdup_printf("%s[%d]", name_no_array, i);
+        ret = object_property_add(obj, full_name, type, get, set,
+                                  release, opaque, errp);
+        g_free(full_name);
         g_free(name_no_array);
         return ret;
     }
@@ -196,6 +196,15 @@ WORD_TYPE helper_le_ld_name(CPUArchState *env, target_ulong addr, int mmu_idx,
     struct uc_struct *uc = env->uc;
     MemoryRegion *mr = memory_mapping(uc, addr);
 
+    // Unicorn: let the pager map memory on first access
+    if (mr == NULL && uc->pager != NULL) {
+#if defined(SOFTMMU_CODE_ACCESS)
+        mr = memory_page_in(uc, UC_MEM_FETCH_UNMAPPED, addr, DATA_SIZE);
+#else
+        mr = memory_page_in(uc, UC_MEM_READ_UNMAPPED, addr, DATA_SIZE);
+#endif
+    }
+
     // memory might be still unmapped while reading or fetching
     if (mr == NULL) {
         handled = false;
@@ -427,6 +436,15 @@ WORD_TYPE helper_be_ld_name(CPUArchState *env, target_ulong addr, int mmu_idx,
     struct uc_struct *uc = env->uc;
     MemoryRegion *mr = memory_mapping(uc, addr);
 
+    // Unicorn: let the pager map memory on first access
+    if (mr == NULL && uc->pager != NULL) {
+#if defined(SOFTMMU_CODE_ACCESS)
+        mr = memory_page_in(uc, UC_MEM_FETCH_UNMAPPED, addr, DATA_SIZE);
+#else
+        mr = memory_page_in(uc, UC_MEM_READ_UNMAPPED, addr, DATA_SIZE);
+#endif
+    }
+
     // memory can be unmapped while reading or fetching
     if (mr == NULL) {
         handled = false;
@@ -702,6 +720,10 @@ void helper_le_st_name(CPUArchState *env, target_ulong addr, DATA_TYPE val,
         ((uc_cb_hookmem_t)hook->callback)(uc, UC_MEM_WRITE, addr, DATA_SIZE, val, hook->user_data);
     }
 
+    // Unicorn: let the pager map memory on first access
+    if (mr == NULL && uc->pager != NULL)
+        mr = memory_page_in(uc, UC_MEM_WRITE_UNMAPPED, addr, DATA_SIZE);
+
     // Unicorn: callback on invalid memory
     if (mr == NULL) {
         handled = false;
@@ -861,6 +883,10 @@ void helper_be_st_name(CPUArchState *env, target_ulong addr, DATA_TYPE val,
         ((uc_cb_hookmem_t)hook->callback)(uc, UC_MEM_WRITE, addr, DATA_SIZE, val, hook->user_data);
     }
 
+    // Unicorn: let the pager map memory on first access
+    if (mr == NULL && uc->pager != NULL)
+        mr = memory_page_in(uc, UC_MEM_WRITE_UNMAPPED, addr, DATA_SIZE);
+
     // Unicorn: callback on invalid memory
     if (mr == NULL) {
         handled = false;
@@ -12,6 +12,14 @@
 #define tb_invalidate_phys_page_fast tb_invalidate_phys_page_fast_sparc
 #define phys_mem_clean phys_mem_clean_sparc
 #define tb_cleanup tb_cleanup_sparc
+#define tb_translate_range tb_translate_range_sparc
+#define tb_translate_block tb_translate_block_sparc
+#define tb_foreach tb_foreach_sparc
+#define tb_flat_fault tb_flat_fault_sparc
+#define ram_log_start ram_log_start_sparc
+#define ram_log_rewind ram_log_rewind_sparc
+#define ram_log_stop ram_log_stop_sparc
+#define ram_log_tlb_dirty ram_log_tlb_dirty_sparc
 #define memory_map memory_map_sparc
 #define memory_map_ptr memory_map_ptr_sparc
 #define memory_unmap memory_unmap_sparc
@@ -1338,8 +1346,13 @@
 #define handle_vrint handle_vrint_sparc
 #define handle_vsel handle_vsel_sparc
 #define has_help_option has_help_option_sparc
+#define have_aesni have_aesni_sparc
+#define have_avx2 have_avx2_sparc
 #define have_bmi1 have_bmi1_sparc
 #define have_bmi2 have_bmi2_sparc
+#define have_pclmul have_pclmul_sparc
+#define have_sse41 have_sse41_sparc
+#define have_ssse3 have_ssse3_sparc
 #define hcr_write hcr_write_sparc
 #define helper_access_check_cp_reg helper_access_check_cp_reg_sparc
 #define helper_add_saturate helper_add_saturate_sparc
@@ -2924,6 +2937,7 @@
 #define tlbimva_write tlbimva_write_sparc
 #define tlb_is_dirty_ram tlb_is_dirty_ram_sparc
 #define tlb_protect_code tlb_protect_code_sparc
+#define tlb_reset_dirty_page tlb_reset_dirty_page_sparc
 #define tlb_reset_dirty_range tlb_reset_dirty_range_sparc
 #define tlb_reset_dirty_range_all tlb_reset_dirty_range_all_sparc
 #define tlb_set_dirty tlb_set_dirty_sparc
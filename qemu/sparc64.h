@@ -12,6 +12,14 @@
 #define tb_invalidate_phys_page_fast tb_invalidate_phys_page_fast_sparc64
 #define phys_mem_clean phys_mem_clean_sparc64
 #define tb_cleanup tb_cleanup_sparc64
+#define tb_translate_range tb_translate_range_sparc64
+#define tb_translate_block tb_translate_block_sparc64
+#define tb_foreach tb_foreach_sparc64
+#define tb_flat_fault tb_flat_fault_sparc64
+#define ram_log_start ram_log_start_sparc64
+#define ram_log_rewind ram_log_rewind_sparc64
+#define ram_log_stop ram_log_stop_sparc64
+#define ram_log_tlb_dirty ram_log_tlb_dirty_sparc64
 #define memory_map memory_map_sparc64
 #define memory_map_ptr memory_map_ptr_sparc64
 #define memory_unmap memory_unmap_sparc64
@@ -1338,8 +1346,13 @@
 #define handle_vrint handle_vrint_sparc64
 #define handle_vsel handle_vsel_sparc64
 #define has_help_option has_help_option_sparc64
+#define have_aesni have_aesni_sparc64
+#define have_avx2 have_avx2_sparc64
 #define have_bmi1 have_bmi1_sparc64
 #define have_bmi2 have_bmi2_sparc64
+#define have_pclmul have_pclmul_sparc64
+#define have_sse41 have_sse41_sparc64
+#define have_ssse3 have_ssse3_sparc64
 #define hcr_write hcr_write_sparc64
 #define helper_access_check_cp_reg helper_access_check_cp_reg_sparc64
 #define helper_add_saturate helper_add_saturate_sparc64
@@ -2924,6 +2937,7 @@
 #define tlbimva_write tlbimva_write_sparc64
 #define tlb_is_dirty_ram tlb_is_dirty_ram_sparc64
 #define tlb_protect_code tlb_protect_code_sparc64
+#define tlb_reset_dirty_page tlb_reset_dirty_page_sparc64
 #define tlb_reset_dirty_range tlb_reset_dirty_range_sparc64
 #define tlb_reset_dirty_range_all tlb_reset_dirty_range_all_sparc64
 #define tlb_set_dirty tlb_set_dirty_sparc64
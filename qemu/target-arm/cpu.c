@@ -295,7 +295,10 @@ static void arm_cpu_initfn(struct uc_struct *uc, Object *obj, void *opaque)
 
     if (tcg_enabled(uc)) {
         cpu->psci_version = 2; /* TCG implements PSCI 0.2 */
-        arm_translate_init(uc);
+        /* the TCG globals are shared by all vCPUs */
+        if (cs->cpu_index == 0) {
+            arm_translate_init(uc);
+        }
     }
 }
 
@@ -977,7 +980,8 @@ static void pxa270c5_initfn(struct uc_struct *uc, Object *obj, void *opaque)
     cpu->reset_sctlr = 0x00000078;
 }
 
-#ifdef CONFIG_USER_ONLY
+/* Unicorn: also built for softmmu, as the ARMv8 AArch32 core UC_MODE_V8
+ * selects */
 static void arm_any_initfn(struct uc_struct *uc, Object *obj, void *opaque)
 {
     ARMCPU *cpu = ARM_CPU(uc, obj);
@@ -992,7 +996,6 @@ static void arm_any_initfn(struct uc_struct *uc, Object *obj, void *opaque)
     set_feature(&cpu->env, ARM_FEATURE_CRC);
     cpu->midr = 0xffffffff;
 }
-#endif
 
 #endif /* !defined(CONFIG_USER_ONLY) || !defined(TARGET_AARCH64) */
 
@@ -1035,9 +1038,7 @@ static const ARMCPUInfo arm_cpus[] = {
     { "pxa270-b1",   pxa270b1_initfn },
     { "pxa270-c0",   pxa270c0_initfn },
     { "pxa270-c5",   pxa270c5_initfn },
-#ifdef CONFIG_USER_ONLY
     { "any",         arm_any_initfn },
-#endif
 #endif
     { NULL }
 };
@@ -22,6 +22,63 @@ union CRYPTO_STATE {
     uint64_t   l[2];
 };
 
+/* Unicorn: on x86_64 hosts with AES-NI (have_aesni, set by tcg_target_init())
+   the AES helpers run on the host instructions; the tables stay as the
+   fallback. The host state layout matches the guest's, byte 0 lowest. */
+#if defined(__x86_64__) && defined(__GNUC__)
+#define CRYPTO_HOST
+#include <wmmintrin.h>
+#include "tcg.h"
+
+static inline __m128i crypto_host_ld(CPUARMState *env, uint32_t reg)
+{
+    return _mm_set_epi64x(float64_val(env->vfp.regs[reg + 1]),
+                          float64_val(env->vfp.regs[reg]));
+}
+
+static inline void crypto_host_st(CPUARMState *env, uint32_t reg, __m128i v)
+{
+    env->vfp.regs[reg] = make_float64(_mm_cvtsi128_si64(v));
+    env->vfp.regs[reg + 1] = make_float64(_mm_cvtsi128_si64(
+                                              _mm_unpackhi_epi64(v, v)));
+}
+
+static __attribute__((target("aes")))
+void crypto_aese_host(CPUARMState *env, uint32_t rd, uint32_t rm,
+                      uint32_t decrypt)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i st = _mm_xor_si128(crypto_host_ld(env, rd),
+                               crypto_host_ld(env, rm));
+
+    /* the last round has no MixColumns, so with a zero round key it is
+       exactly (Inv)ShiftRows + (Inv)SubBytes */
+    if (decrypt) {
+        st = _mm_aesdeclast_si128(st, zero);
+    } else {
+        st = _mm_aesenclast_si128(st, zero);
+    }
+    crypto_host_st(env, rd, st);
+}
+
+static __attribute__((target("aes")))
+void crypto_aesmc_host(CPUARMState *env, uint32_t rd, uint32_t rm,
+                       uint32_t decrypt)
+{
+    __m128i zero = _mm_setzero_si128();
+    __m128i st = crypto_host_ld(env, rm);
+
+    if (decrypt) {
+        st = _mm_aesimc_si128(st);
+    } else {
+        /* undo ShiftRows + SubBytes so that a full round only adds
+           MixColumns */
+        st = _mm_aesenc_si128(_mm_aesdeclast_si128(st, zero), zero);
+    }
+    crypto_host_st(env, rd, st);
+}
+#endif
+
 void HELPER(crypto_aese)(CPUARMState *env, uint32_t rd, uint32_t rm,
                          uint32_t decrypt)
 {
@@ -31,7 +88,14 @@ void HELPER(crypto_aese)(CPUARMState *env, uint32_t rd, uint32_t rm,
     union CRYPTO_STATE rk;
     union CRYPTO_STATE st;
     int i;
-    
+
+#ifdef CRYPTO_HOST
+    if (have_aesni) {
+        crypto_aese_host(env, rd, rm, decrypt);
+        return;
+    }
+#endif
+
     rk.l[0] = float64_val(env->vfp.regs[rm]);
     rk.l[1] = float64_val(env->vfp.regs[rm + 1]);
     st.l[0] = float64_val(env->vfp.regs[rd]);
@@ -190,6 +254,14 @@ void HELPER(crypto_aesmc)(CPUARMState *env, uint32_t rd, uint32_t rm,
     } };
     union CRYPTO_STATE st;
     int i;
+
+#ifdef CRYPTO_HOST
+    if (have_aesni) {
+        crypto_aesmc_host(env, rd, rm, decrypt);
+        return;
+    }
+#endif
+
     st.l[0] = float64_val(env->vfp.regs[rm]);
     st.l[1] = float64_val(env->vfp.regs[rm + 1]);
 
@@ -409,7 +409,7 @@ float32 HELPER(fcvtx_f64_to_f32)(float64 a, CPUARMState *env)
 }
 
 /* 64-bit versions of the CRC helpers. Note that although the operation
- * (and the prototypes of crc32c() and crc32() mean that only the bottom
+ * (and the prototypes of crc32c() and crc32_ieee() mean that only the bottom
  * 32 bits of the accumulator and result are used, we pass and return
  * uint64_t for convenience of the generated code. Unlike the 32-bit
  * instruction set versions, val may genuinely have 64 bits of data in it.
@@ -422,9 +422,8 @@ uint64_t HELPER(crc32_64)(uint64_t acc, uint64_t val, uint32_t bytes)
 
     stq_le_p(buf, val);
 
-    /* zlib crc32 converts the accumulator and output to one's complement.  */
-    // return crc32(acc ^ 0xffffffff, buf, bytes) ^ 0xffffffff;
-    return 0;	// FIXME
+    /* crc32_ieee converts the output to one's complement.  */
+    return crc32_ieee(acc, buf, bytes) ^ 0xffffffff;
 }
 
 uint64_t HELPER(crc32c_64)(uint64_t acc, uint64_t val, uint32_t bytes)
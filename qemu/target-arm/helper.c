@@ -5769,15 +5769,12 @@ int arm_rmode_to_sf(int rmode)
  */
 uint32_t HELPER(crc32_arm)(uint32_t acc, uint32_t val, uint32_t bytes)
 {
-#if 0   // FIXME
     uint8_t buf[4];
 
     stl_le_p(buf, val);
 
-    /* zlib crc32 converts the accumulator and output to one's complement.  */
-    return crc32(acc ^ 0xffffffff, buf, bytes) ^ 0xffffffff;
-#endif
-    return 0;
+    /* crc32_ieee converts the output to one's complement.  */
+    return crc32_ieee(acc, buf, bytes) ^ 0xffffffff;
 }
 
 uint32_t HELPER(crc32c)(uint32_t acc, uint32_t val, uint32_t bytes)
@@ -129,8 +129,7 @@ NEON_VOP_BODY(vtype, n)
     NEON_FN(vdest.v3, vsrc2.v1, vsrc2.v2); \
     NEON_FN(vdest.v4, vsrc2.v3, vsrc2.v4); \
 
-#define NEON_POP(name, vtype, n) \
-uint32_t HELPER(glue(neon_,name))(uint32_t arg1, uint32_t arg2) \
+#define NEON_POP_BODY(vtype, n) \
 { \
     uint32_t res; \
     vtype vsrc1; \
@@ -143,6 +142,10 @@ uint32_t HELPER(glue(neon_,name))(uint32_t arg1, uint32_t arg2) \
     return res; \
 }
 
+#define NEON_POP(name, vtype, n) \
+uint32_t HELPER(glue(neon_,name))(uint32_t arg1, uint32_t arg2) \
+NEON_POP_BODY(vtype, n)
+
 /* Unary operators.  */
 #define NEON_VOP1(name, vtype, n) \
 uint32_t HELPER(glue(neon_,name))(uint32_t arg) \
@@ -155,6 +158,205 @@ uint32_t HELPER(glue(neon_,name))(uint32_t arg) \
     return arg; \
 }
 
+/* Unicorn: on x86_64 hosts the hottest helpers (saturating add/sub,
+ * variable shifts, saturating narrows and pairwise ops) run on host SIMD.
+ * A 32 or 64 bit chunk of a NEON register fits the low lanes of an xmm
+ * register, so a few host instructions replace the per-lane code and its
+ * saturation branches.  That pays off for four 8 bit lanes; with two 16
+ * bit lanes only add/sub and shifts still measured faster, so narrows to
+ * and pairwise ops on 16 bit lanes stay in C.  SSE2 is always there on
+ * x86_64; the shifts check have_avx2, set by tcg_target_init().
+ */
+#if defined(__x86_64__) && defined(__GNUC__)
+#define NEON_HOST
+#include <immintrin.h>
+#include "tcg.h"
+
+#define have_sse2 1
+
+#define NEON_HOST_FN(feat) static __attribute__((target(feat)))
+
+/* Return through the host version of helper NAME if FEAT is there.  */
+#define NEON_HOST_CALL(feat, name, args) \
+    if (feat) { \
+        return glue(glue(neon_, name), _host) args; \
+    }
+
+/* Saturating add/sub: the host saturates per lane, and any lane that
+ * saturated differs from the wrapping result, which is what sets QC.
+ */
+#define NEON_HOST_QOP(name, sat, wrap) \
+NEON_HOST_FN("sse2") uint32_t glue(glue(neon_, name), _host) \
+    (CPUARMState *env, uint32_t a, uint32_t b) \
+{ \
+    __m128i va = _mm_cvtsi32_si128(a); \
+    __m128i vb = _mm_cvtsi32_si128(b); \
+    uint32_t res = _mm_cvtsi128_si32(sat(va, vb)); \
+    if (res != (uint32_t)_mm_cvtsi128_si32(wrap(va, vb))) { \
+        SET_QC(); \
+    } \
+    return res; \
+}
+NEON_HOST_QOP(qadd_u8, _mm_adds_epu8, _mm_add_epi8)
+NEON_HOST_QOP(qadd_s8, _mm_adds_epi8, _mm_add_epi8)
+NEON_HOST_QOP(qadd_u16, _mm_adds_epu16, _mm_add_epi16)
+NEON_HOST_QOP(qadd_s16, _mm_adds_epi16, _mm_add_epi16)
+NEON_HOST_QOP(qsub_u8, _mm_subs_epu8, _mm_sub_epi8)
+NEON_HOST_QOP(qsub_s8, _mm_subs_epi8, _mm_sub_epi8)
+NEON_HOST_QOP(qsub_u16, _mm_subs_epu16, _mm_sub_epi16)
+NEON_HOST_QOP(qsub_s16, _mm_subs_epi16, _mm_sub_epi16)
+#undef NEON_HOST_QOP
+
+/* Shift each 32 bit lane of VAL by the signed count in SHIFT, NEON
+ * style: negative counts shift right, rounding if RND.  vpsllvd and
+ * vpsrlvd give 0 for counts of 32 and up (vpsravd the sign), so only
+ * the rounding constant needs the count clamped: past BITS + 1 the
+ * rounded result of a BITS wide lane is 0 anyway.
+ */
+NEON_HOST_FN("avx2") inline __m128i neon_vshl_host(__m128i val, __m128i shift,
+                                                   int bits, bool sgn, bool rnd)
+{
+    __m128i n = _mm_sub_epi32(_mm_setzero_si128(), shift);
+    __m128i left = _mm_sllv_epi32(val, shift);
+    __m128i right;
+
+    if (rnd) {
+        __m128i one = _mm_set1_epi32(1);
+
+        n = _mm_min_epu32(n, _mm_set1_epi32(bits + 1));
+        val = _mm_add_epi32(val, _mm_sllv_epi32(one, _mm_sub_epi32(n, one)));
+    }
+    right = sgn ? _mm_srav_epi32(val, n) : _mm_srlv_epi32(val, n);
+    return _mm_blendv_epi8(left, right, shift);
+}
+
+#define NEON_HOST_SHL8(name, widen, sgn, rnd) \
+NEON_HOST_FN("avx2") uint32_t glue(glue(neon_, name), _host) \
+    (uint32_t val, uint32_t shift) \
+{ \
+    __m128i r = neon_vshl_host(widen(_mm_cvtsi32_si128(val)), \
+                               _mm_cvtepi8_epi32(_mm_cvtsi32_si128(shift)), \
+                               8, sgn, rnd); \
+    return _mm_cvtsi128_si32(_mm_shuffle_epi8(r, \
+                             _mm_cvtsi32_si128(0x0c080400))); \
+}
+NEON_HOST_SHL8(shl_u8, _mm_cvtepu8_epi32, false, false)
+NEON_HOST_SHL8(shl_s8, _mm_cvtepi8_epi32, true, false)
+NEON_HOST_SHL8(rshl_u8, _mm_cvtepu8_epi32, false, true)
+NEON_HOST_SHL8(rshl_s8, _mm_cvtepi8_epi32, true, true)
+#undef NEON_HOST_SHL8
+
+/* The count is the bottom byte of each 16 bit lane.  */
+#define NEON_HOST_SHL16(name, widen, sgn, rnd) \
+NEON_HOST_FN("avx2") uint32_t glue(glue(neon_, name), _host) \
+    (uint32_t val, uint32_t shift) \
+{ \
+    __m128i s = _mm_cvtepu16_epi32(_mm_cvtsi32_si128(shift)); \
+    __m128i r = neon_vshl_host(widen(_mm_cvtsi32_si128(val)), \
+                               _mm_srai_epi32(_mm_slli_epi32(s, 24), 24), \
+                               16, sgn, rnd); \
+    return _mm_cvtsi128_si32(_mm_shuffle_epi8(r, \
+                             _mm_cvtsi32_si128(0x05040100))); \
+}
+NEON_HOST_SHL16(shl_u16, _mm_cvtepu16_epi32, false, false)
+NEON_HOST_SHL16(shl_s16, _mm_cvtepi16_epi32, true, false)
+NEON_HOST_SHL16(rshl_u16, _mm_cvtepu16_epi32, false, true)
+NEON_HOST_SHL16(rshl_s16, _mm_cvtepi16_epi32, true, true)
+#undef NEON_HOST_SHL16
+
+/* Saturating narrows: the host packs with saturation; a lane saturated,
+ * and QC is set, if widening the result back does not give X.
+ */
+NEON_HOST_FN("sse2") uint32_t neon_narrow_sat_s8_host(CPUARMState *env,
+                                                      uint64_t x)
+{
+    __m128i v = _mm_cvtsi64_si128(x);
+    __m128i r = _mm_packs_epi16(v, v);
+
+    if (_mm_cvtsi128_si64(_mm_srai_epi16(_mm_unpacklo_epi8(r, r), 8)) != x) {
+        SET_QC();
+    }
+    return _mm_cvtsi128_si32(r);
+}
+
+NEON_HOST_FN("sse2") uint32_t neon_unarrow_sat8_host(CPUARMState *env,
+                                                     uint64_t x)
+{
+    __m128i v = _mm_cvtsi64_si128(x);
+    __m128i r = _mm_packus_epi16(v, v);
+
+    if (_mm_cvtsi128_si64(_mm_unpacklo_epi8(r, _mm_setzero_si128())) != x) {
+        SET_QC();
+    }
+    return _mm_cvtsi128_si32(r);
+}
+
+/* min(x, 0xff) as x - saturating(x - 0xff), then a pack that can no
+ * longer saturate.  */
+NEON_HOST_FN("sse2") uint32_t neon_narrow_sat_u8_host(CPUARMState *env,
+                                                      uint64_t x)
+{
+    __m128i v = _mm_cvtsi64_si128(x);
+    __m128i m = _mm_sub_epi16(v, _mm_subs_epu16(v, _mm_set1_epi16(0xff)));
+
+    if (_mm_cvtsi128_si64(m) != x) {
+        SET_QC();
+    }
+    return _mm_cvtsi128_si32(_mm_packus_epi16(m, m));
+}
+
+/* Pairwise ops: both operands go in one register, the even and odd
+ * lanes are split into wider lanes, combined, and narrowed back.
+ */
+#define NEON_HOST_POP8(name, fn, sgn) \
+NEON_HOST_FN("sse2") uint32_t glue(glue(neon_, name), _host) \
+    (uint32_t a, uint32_t b) \
+{ \
+    __m128i v = _mm_cvtsi64_si128(a | (uint64_t)b << 32); \
+    __m128i even, odd, r; \
+    if (sgn) { \
+        even = _mm_srai_epi16(_mm_slli_epi16(v, 8), 8); \
+        odd = _mm_srai_epi16(v, 8); \
+    } else { \
+        even = _mm_and_si128(v, _mm_set1_epi16(0xff)); \
+        odd = _mm_srli_epi16(v, 8); \
+    } \
+    r = _mm_and_si128(fn(even, odd), _mm_set1_epi16(0xff)); \
+    return _mm_cvtsi128_si32(_mm_packus_epi16(r, r)); \
+}
+NEON_HOST_POP8(padd_u8, _mm_add_epi16, false)
+NEON_HOST_POP8(pmin_u8, _mm_min_epi16, false)
+NEON_HOST_POP8(pmin_s8, _mm_min_epi16, true)
+NEON_HOST_POP8(pmax_u8, _mm_max_epi16, false)
+NEON_HOST_POP8(pmax_s8, _mm_max_epi16, true)
+#undef NEON_HOST_POP8
+#else
+#define NEON_HOST_CALL(feat, name, args)
+#endif
+
+/* Like NEON_VOP, NEON_VOP_ENV and NEON_POP, but trying the host version
+ * of the helper first.  */
+#define NEON_VOP_HOST(name, vtype, n, feat) \
+uint32_t HELPER(glue(neon_,name))(uint32_t arg1, uint32_t arg2) \
+{ \
+    NEON_HOST_CALL(feat, name, (arg1, arg2)) \
+    NEON_VOP_BODY(vtype, n) \
+}
+
+#define NEON_VOP_ENV_HOST(name, vtype, n, feat) \
+uint32_t HELPER(glue(neon_,name))(CPUARMState *env, uint32_t arg1, uint32_t arg2) \
+{ \
+    NEON_HOST_CALL(feat, name, (env, arg1, arg2)) \
+    NEON_VOP_BODY(vtype, n) \
+}
+
+#define NEON_POP_HOST(name, vtype, n, feat) \
+uint32_t HELPER(glue(neon_,name))(uint32_t arg1, uint32_t arg2) \
+{ \
+    NEON_HOST_CALL(feat, name, (arg1, arg2)) \
+    NEON_POP_BODY(vtype, n) \
+}
+
 
 #define NEON_USAT(dest, src1, src2, type) do { \
     uint32_t tmp = (uint32_t)src1 + (uint32_t)src2; \
@@ -165,10 +367,10 @@ uint32_t HELPER(glue(neon_,name))(uint32_t arg) \
         dest = tmp; \
     }} while(0)
 #define NEON_FN(dest, src1, src2) NEON_USAT(dest, src1, src2, uint8_t)
-NEON_VOP_ENV(qadd_u8, neon_u8, 4)
+NEON_VOP_ENV_HOST(qadd_u8, neon_u8, 4, have_sse2)
 #undef NEON_FN
 #define NEON_FN(dest, src1, src2) NEON_USAT(dest, src1, src2, uint16_t)
-NEON_VOP_ENV(qadd_u16, neon_u16, 2)
+NEON_VOP_ENV_HOST(qadd_u16, neon_u16, 2, have_sse2)
 #undef NEON_FN
 #undef NEON_USAT
 
@@ -207,10 +409,10 @@ uint64_t HELPER(neon_qadd_u64)(CPUARMState *env, uint64_t src1, uint64_t src2)
     dest = tmp; \
     } while(0)
 #define NEON_FN(dest, src1, src2) NEON_SSAT(dest, src1, src2, int8_t)
-NEON_VOP_ENV(qadd_s8, neon_s8, 4)
+NEON_VOP_ENV_HOST(qadd_s8, neon_s8, 4, have_sse2)
 #undef NEON_FN
 #define NEON_FN(dest, src1, src2) NEON_SSAT(dest, src1, src2, int16_t)
-NEON_VOP_ENV(qadd_s16, neon_s16, 2)
+NEON_VOP_ENV_HOST(qadd_s16, neon_s16, 2, have_sse2)
 #undef NEON_FN
 #undef NEON_SSAT
 
@@ -410,10 +612,10 @@ uint64_t HELPER(neon_sqadd_u64)(CPUARMState *env, uint64_t a, uint64_t b)
         dest = tmp; \
     }} while(0)
 #define NEON_FN(dest, src1, src2) NEON_USAT(dest, src1, src2, uint8_t)
-NEON_VOP_ENV(qsub_u8, neon_u8, 4)
+NEON_VOP_ENV_HOST(qsub_u8, neon_u8, 4, have_sse2)
 #undef NEON_FN
 #define NEON_FN(dest, src1, src2) NEON_USAT(dest, src1, src2, uint16_t)
-NEON_VOP_ENV(qsub_u16, neon_u16, 2)
+NEON_VOP_ENV_HOST(qsub_u16, neon_u16, 2, have_sse2)
 #undef NEON_FN
 #undef NEON_USAT
 
@@ -453,10 +655,10 @@ uint64_t HELPER(neon_qsub_u64)(CPUARMState *env, uint64_t src1, uint64_t src2)
     dest = tmp; \
     } while(0)
 #define NEON_FN(dest, src1, src2) NEON_SSAT(dest, src1, src2, int8_t)
-NEON_VOP_ENV(qsub_s8, neon_s8, 4)
+NEON_VOP_ENV_HOST(qsub_s8, neon_s8, 4, have_sse2)
 #undef NEON_FN
 #define NEON_FN(dest, src1, src2) NEON_SSAT(dest, src1, src2, int16_t)
-NEON_VOP_ENV(qsub_s16, neon_s16, 2)
+NEON_VOP_ENV_HOST(qsub_s16, neon_s16, 2, have_sse2)
 #undef NEON_FN
 #undef NEON_SSAT
 
@@ -588,8 +790,8 @@ NEON_VOP(min_s16, neon_s16, 2)
 NEON_VOP(min_u16, neon_u16, 2)
 NEON_VOP(min_s32, neon_s32, 1)
 NEON_VOP(min_u32, neon_u32, 1)
-NEON_POP(pmin_s8, neon_s8, 4)
-NEON_POP(pmin_u8, neon_u8, 4)
+NEON_POP_HOST(pmin_s8, neon_s8, 4, have_sse2)
+NEON_POP_HOST(pmin_u8, neon_u8, 4, have_sse2)
 NEON_POP(pmin_s16, neon_s16, 2)
 NEON_POP(pmin_u16, neon_u16, 2)
 #undef NEON_FN
@@ -601,8 +803,8 @@ NEON_VOP(max_s16, neon_s16, 2)
 NEON_VOP(max_u16, neon_u16, 2)
 NEON_VOP(max_s32, neon_s32, 1)
 NEON_VOP(max_u32, neon_u32, 1)
-NEON_POP(pmax_s8, neon_s8, 4)
-NEON_POP(pmax_u8, neon_u8, 4)
+NEON_POP_HOST(pmax_s8, neon_s8, 4, have_sse2)
+NEON_POP_HOST(pmax_u8, neon_u8, 4, have_sse2)
 NEON_POP(pmax_s16, neon_s16, 2)
 NEON_POP(pmax_u16, neon_u16, 2)
 #undef NEON_FN
@@ -628,8 +830,8 @@ NEON_VOP(abd_u32, neon_u32, 1)
     } else { \
         dest = src1 << tmp; \
     }} while (0)
-NEON_VOP(shl_u8, neon_u8, 4)
-NEON_VOP(shl_u16, neon_u16, 2)
+NEON_VOP_HOST(shl_u8, neon_u8, 4, have_avx2)
+NEON_VOP_HOST(shl_u16, neon_u16, 2, have_avx2)
 NEON_VOP(shl_u32, neon_u32, 1)
 #undef NEON_FN
 
@@ -658,8 +860,8 @@ uint64_t HELPER(neon_shl_u64)(uint64_t val, uint64_t shiftop)
     } else { \
         dest = src1 << tmp; \
     }} while (0)
-NEON_VOP(shl_s8, neon_s8, 4)
-NEON_VOP(shl_s16, neon_s16, 2)
+NEON_VOP_HOST(shl_s8, neon_s8, 4, have_avx2)
+NEON_VOP_HOST(shl_s16, neon_s16, 2, have_avx2)
 NEON_VOP(shl_s32, neon_s32, 1)
 #undef NEON_FN
 
@@ -690,8 +892,8 @@ uint64_t HELPER(neon_shl_s64)(uint64_t valop, uint64_t shiftop)
     } else { \
         dest = src1 << tmp; \
     }} while (0)
-NEON_VOP(rshl_s8, neon_s8, 4)
-NEON_VOP(rshl_s16, neon_s16, 2)
+NEON_VOP_HOST(rshl_s8, neon_s8, 4, have_avx2)
+NEON_VOP_HOST(rshl_s16, neon_s16, 2, have_avx2)
 #undef NEON_FN
 
 /* The addition of the rounding constant may overflow, so we use an
@@ -750,8 +952,8 @@ uint64_t HELPER(neon_rshl_s64)(uint64_t valop, uint64_t shiftop)
     } else { \
         dest = src1 << tmp; \
     }} while (0)
-NEON_VOP(rshl_u8, neon_u8, 4)
-NEON_VOP(rshl_u16, neon_u16, 2)
+NEON_VOP_HOST(rshl_u8, neon_u8, 4, have_avx2)
+NEON_VOP_HOST(rshl_u16, neon_u16, 2, have_avx2)
 #undef NEON_FN
 
 /* The addition of the rounding constant may overflow, so we use an
@@ -1161,7 +1363,7 @@ uint32_t HELPER(neon_add_u16)(uint32_t a, uint32_t b)
 }
 
 #define NEON_FN(dest, src1, src2) dest = src1 + src2
-NEON_POP(padd_u8, neon_u8, 4)
+NEON_POP_HOST(padd_u8, neon_u8, 4, have_sse2)
 NEON_POP(padd_u16, neon_u16, 2)
 #undef NEON_FN
 
@@ -1404,6 +1606,9 @@ uint32_t HELPER(neon_unarrow_sat8)(CPUARMState *env, uint64_t x)
     uint16_t s;
     uint8_t d;
     uint32_t res = 0;
+
+    NEON_HOST_CALL(have_sse2, unarrow_sat8, (env, x))
+
 #define SAT8(n) \
     s = x >> n; \
     if (s & 0x8000) { \
@@ -1431,6 +1636,9 @@ uint32_t HELPER(neon_narrow_sat_u8)(CPUARMState *env, uint64_t x)
     uint16_t s;
     uint8_t d;
     uint32_t res = 0;
+
+    NEON_HOST_CALL(have_sse2, narrow_sat_u8, (env, x))
+
 #define SAT8(n) \
     s = x >> n; \
     if (s > 0xff) { \
@@ -1454,6 +1662,9 @@ uint32_t HELPER(neon_narrow_sat_s8)(CPUARMState *env, uint64_t x)
     int16_t s;
     uint8_t d;
     uint32_t res = 0;
+
+    NEON_HOST_CALL(have_sse2, narrow_sat_s8, (env, x))
+
 #define SAT8(n) \
     s = x >> n; \
     if (s != (int8_t)s) { \
@@ -2212,6 +2423,22 @@ void HELPER(neon_zip16)(CPUARMState *env, uint32_t rd, uint32_t rm)
     env->vfp.regs[rd] = make_float64(d0);
 }
 
+/* Unicorn: on x86_64 hosts with PCLMUL (have_pclmul, set by
+ * tcg_target_init()) the 64 bit polynomial multiply is one host insn.
+ */
+#if defined(__x86_64__) && defined(__GNUC__)
+#define PMULL_HOST
+#include <wmmintrin.h>
+#include "tcg.h"
+
+static __attribute__((target("pclmul")))
+__m128i pmull_64_host(uint64_t op1, uint64_t op2)
+{
+    return _mm_clmulepi64_si128(_mm_cvtsi64_si128(op1),
+                                _mm_cvtsi64_si128(op2), 0);
+}
+#endif
+
 /* Helper function for 64 bit polynomial multiply case:
  * perform PolynomialMult(op1, op2) and return either the top or
  * bottom half of the 128 bit result.
@@ -2221,6 +2448,12 @@ uint64_t HELPER(neon_pmull_64_lo)(uint64_t op1, uint64_t op2)
     int bitnum;
     uint64_t res = 0;
 
+#ifdef PMULL_HOST
+    if (have_pclmul) {
+        return _mm_cvtsi128_si64(pmull_64_host(op1, op2));
+    }
+#endif
+
     for (bitnum = 0; bitnum < 64; bitnum++) {
         if (op1 & (1ULL << bitnum)) {
             res ^= op2 << bitnum;
@@ -2233,6 +2466,13 @@ uint64_t HELPER(neon_pmull_64_hi)(uint64_t op1, uint64_t op2)
     int bitnum;
     uint64_t res = 0;
 
+#ifdef PMULL_HOST
+    if (have_pclmul) {
+        __m128i r = pmull_64_host(op1, op2);
+        return _mm_cvtsi128_si64(_mm_unpackhi_epi64(r, r));
+    }
+#endif
+
     /* bit 0 of op1 can't influence the high 64 bits at all */
     for (bitnum = 1; bitnum < 64; bitnum++) {
         if (op1 & (1ULL << bitnum)) {
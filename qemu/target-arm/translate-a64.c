@@ -1336,6 +1336,11 @@ static void handle_sys(DisasContext *s, uint32_t insn, bool isread,
     const ARMCPRegInfo *ri;
     TCGv_i64 tcg_rt;
 
+    if (!isread) {
+        /* FPCR & FPSR are system registers */
+        gen_fpu_dirty(s);
+    }
+
     ri = get_arm_cp_reginfo(s->cp_regs,
                             ENCODE_AA64_CP_REG(CP_REG_ARM64_SYSREG_CP,
                                                crn, crm, op0, op1, op2));
@@ -2642,6 +2647,11 @@ static void disas_ldst_single_struct(DisasContext *s, uint32_t insn)
 /* C3.3 Loads and stores */
 static void disas_ldst(DisasContext *s, uint32_t insn)
 {
+    if (extract32(insn, 26, 1)) {
+        /* FP/SIMD register */
+        gen_fpu_dirty(s);
+    }
+
     switch (extract32(insn, 24, 6)) {
     case 0x08: /* Load/store exclusive */
         disas_ldst_excl(s, insn);
@@ -10961,6 +10971,8 @@ static void disas_data_proc_simd(DisasContext *s, uint32_t insn)
 /* C3.6 Data processing - SIMD and floating point */
 static void disas_data_proc_simd_fp(DisasContext *s, uint32_t insn)
 {
+    gen_fpu_dirty(s);
+
     if (extract32(insn, 28, 1) == 1 && extract32(insn, 30, 1) == 0) {
         disas_data_proc_fp(s, insn);
     } else {
@@ -11048,6 +11060,7 @@ void gen_intermediate_code_internal_a64(ARMCPU *cpu,
     pc_start = tb->pc;
 
     dc->uc = env->uc;
+    dc->fpu_dirty = false;
     dc->tb = tb;
 
     gen_opc_end = tcg_ctx->gen_opc_buf + OPC_MAX_SIZE;
@@ -11116,21 +11129,34 @@ void gen_intermediate_code_internal_a64(ARMCPU *cpu,
         goto tb_end;
     }
 
+    // Unicorn: checked before the hooks, which must not run if the block exits early
+    gen_tb_start(tcg_ctx);
+
+    // Unicorn: stop at a breakpoint or exit before this block runs
+    if (uc_stop_addr_exists(env->uc, pc_start)) {
+        gen_a64_set_pc_im(dc, pc_start);
+        gen_uc_stop_addr(tcg_ctx, env->uc, pc_start);
+    }
+
     // Unicorn: trace this block on request
     // Only hook this block if it is not broken from previous translation due to
     // full translation cache
     if (!env->uc->block_full && HOOK_EXISTS_BOUNDED(env->uc, UC_HOOK_BLOCK, pc_start)) {
         // save block address to see if we need to patch block size later
         env->uc->block_addr = pc_start;
-        env->uc->size_arg = tcg_ctx->gen_opparam_buf - tcg_ctx->gen_opparam_ptr + 1;
+        env->uc->size_arg = tcg_ctx->gen_opparam_ptr - tcg_ctx->gen_opparam_buf + 1;
         gen_uc_tracecode(tcg_ctx, 0xf8f8f8f8, UC_HOOK_BLOCK_IDX, env->uc, pc_start);
     } else {
         env->uc->size_arg = -1;
     }
 
-    gen_tb_start(tcg_ctx);
 
     do {
+        // Unicorn: a breakpoint or exit always starts a new block
+        if (dc->pc != pc_start && uc_stop_addr_exists(env->uc, dc->pc)) {
+            break;
+        }
+
         if (unlikely(!QTAILQ_EMPTY(&cs->breakpoints))) {
             QTAILQ_FOREACH(bp, &cs->breakpoints, entry) {
                 if (bp->pc == dc->pc) {
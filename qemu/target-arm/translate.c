@@ -1622,6 +1622,8 @@ static int disas_iwmmxt_insn(DisasContext *s, uint32_t insn)
     TCGv_i32 addr;
     TCGv_i32 tmp, tmp2, tmp3;
 
+    gen_fpu_dirty(s);
+
     if ((insn & 0x0e000e00) == 0x0c000000) {
         if ((insn & 0x0fe00ff0) == 0x0c400000) {
             wrd = insn & 0xf;
@@ -2627,6 +2629,8 @@ static int disas_dsp_insn(DisasContext *s, uint32_t insn)
     int acc, rd0, rd1, rdhi, rdlo;
     TCGv_i32 tmp, tmp2;
 
+    gen_fpu_dirty(s);
+
     if ((insn & 0x0ff00f10) == 0x0e200010) {
         /* Multiply with Internal Accumulate Format */
         rd0 = (insn >> 12) & 0xf;
@@ -3109,6 +3113,8 @@ static int disas_vfp_insn(DisasContext *s, uint32_t insn)
     TCGv_i32 tmp;
     TCGv_i32 tmp2;
 
+    gen_fpu_dirty(s);
+
     if (!arm_dc_feature(s, ARM_FEATURE_VFP)) {
         return 1;
     }
@@ -4441,6 +4447,8 @@ static int disas_neon_ls_insn(DisasContext *s, uint32_t insn)
     TCGv_i32 tmp2;
     TCGv_i64 tmp64;
 
+    gen_fpu_dirty(s);
+
     /* FIXME: this access check should not take precedence over UNDEF
      * for invalid encodings; we will generate incorrect syndrome information
      * for attempts to execute invalid vfp/neon encodings with FP disabled.
@@ -5194,6 +5202,8 @@ static int disas_neon_data_insn(DisasContext *s, uint32_t insn)
     TCGv_i32 tmp, tmp2, tmp3, tmp4, tmp5;
     TCGv_i64 tmp64;
 
+    gen_fpu_dirty(s);
+
     /* FIXME: this access check should not take precedence over UNDEF
      * for invalid encodings; we will generate incorrect syndrome information
      * for attempts to execute invalid vfp/neon encodings with FP disabled.
@@ -11192,6 +11202,7 @@ static inline void gen_intermediate_code_internal(ARMCPU *cpu,
     pc_start = tb->pc;
 
     dc->uc = env->uc;
+    dc->fpu_dirty = false;
     dc->tb = tb;
 
     gen_opc_end = tcg_ctx->gen_opc_buf + OPC_MAX_SIZE;
@@ -11264,19 +11275,27 @@ static inline void gen_intermediate_code_internal(ARMCPU *cpu,
         goto tb_end;
     }
 
+    // Unicorn: checked before the hooks, which must not run if the block exits early
+    gen_tb_start(tcg_ctx);
+
+    // Unicorn: stop at a breakpoint or exit before this block runs
+    if (uc_stop_addr_exists(env->uc, pc_start)) {
+        gen_set_pc_im(dc, pc_start);
+        gen_uc_stop_addr(tcg_ctx, env->uc, pc_start);
+    }
+
     // Unicorn: trace this block on request
     // Only hook this block if it is not broken from previous translation due to
     // full translation cache
     if (!env->uc->block_full && HOOK_EXISTS_BOUNDED(env->uc, UC_HOOK_BLOCK, pc_start)) {
         // save block address to see if we need to patch block size later
         env->uc->block_addr = pc_start;
-        env->uc->size_arg = tcg_ctx->gen_opparam_buf - tcg_ctx->gen_opparam_ptr + 1;
+        env->uc->size_arg = tcg_ctx->gen_opparam_ptr - tcg_ctx->gen_opparam_buf + 1;
         gen_uc_tracecode(tcg_ctx, 0xf8f8f8f8, UC_HOOK_BLOCK_IDX, env->uc, pc_start);
     } else {
         env->uc->size_arg = -1;
     }
 
-    gen_tb_start(tcg_ctx);
 
     /* A note on handling of the condexec (IT) bits:
      *
@@ -11338,6 +11357,11 @@ static inline void gen_intermediate_code_internal(ARMCPU *cpu,
         }
 #endif
 
+        // Unicorn: a breakpoint or exit always starts a new block
+        if (dc->pc != pc_start && uc_stop_addr_exists(env->uc, dc->pc)) {
+            break;
+        }
+
         if (unlikely(!QTAILQ_EMPTY(&cs->breakpoints))) {
             QTAILQ_FOREACH(bp, &cs->breakpoints, entry) {
                 if (bp->pc == dc->pc) {
@@ -60,6 +60,7 @@ typedef struct DisasContext {
 
     // Unicorn engine
     struct uc_struct *uc;
+    bool fpu_dirty; /* the TB already sets cpu->fpu_dirty */
 } DisasContext;
 
 
@@ -73,6 +74,23 @@ static inline int get_mem_index(DisasContext *s)
     return s->current_el;
 }
 
+/* Unicorn: note that the TB changes FP/SIMD registers, see uc_context_save() */
+static inline void gen_fpu_dirty(DisasContext *s)
+{
+    TCGContext *tcg_ctx = s->uc->tcg_ctx;
+    TCGv_i32 tmp;
+
+    if (s->fpu_dirty) {
+        return;
+    }
+    tmp = tcg_const_i32(tcg_ctx, 1);
+    tcg_gen_st_i32(tcg_ctx, tmp, tcg_ctx->cpu_env,
+                   offsetof(CPUState, fpu_dirty) - ENV_OFFSET);
+    tcg_temp_free_i32(tcg_ctx, tmp);
+    /* a conditional instruction may skip the store */
+    s->fpu_dirty = !s->condjmp;
+}
+
 /* target-specific extra values for is_jmp */
 /* These instructions trap after executing, so the A32/T32 decoder must
  * defer them until after the conditional execution state has been updated.
@@ -12,6 +12,47 @@
 
 const int ARM64_REGS_STORAGE_SIZE = offsetof(CPUARMState, tlb_table);
 
+// register groups of CPUARMState, for uc_context_alloc_groups()
+static const uc_context_range arm64_context_ranges[] = {
+    { UC_CTX_GPR, 0, offsetof(CPUARMState, pstate) },
+    { UC_CTX_SYS, offsetof(CPUARMState, pstate), offsetof(CPUARMState, CF) },
+    { UC_CTX_GPR, offsetof(CPUARMState, CF), offsetof(CPUARMState, daif) },
+    { UC_CTX_SYS, offsetof(CPUARMState, daif), offsetof(CPUARMState, vfp) },
+    { UC_CTX_FPU, offsetof(CPUARMState, vfp), offsetof(CPUARMState, exclusive_addr) },
+    { UC_CTX_GPR, offsetof(CPUARMState, exclusive_addr), offsetof(CPUARMState, iwmmxt) },
+    { UC_CTX_FPU, offsetof(CPUARMState, iwmmxt), offsetof(CPUARMState, bswap_code) },
+    { UC_CTX_SYS, offsetof(CPUARMState, bswap_code), offsetof(CPUARMState, tlb_table) },
+    { 0 }
+};
+
+// SCTLR, TTBRs, TTBCR, DACR, HCR, SCR, MAIR & CONTEXTIDR decide how addresses are translated
+static const uc_context_range arm64_context_mmu[] = {
+    { UC_CTX_SYS, offsetof(CPUARMState, cp15.c1_sys), offsetof(CPUARMState, cp15.c2_data) },
+    { UC_CTX_SYS, offsetof(CPUARMState, cp15.c3), offsetof(CPUARMState, cp15.pmsav5_data_ap) },
+    { UC_CTX_SYS, offsetof(CPUARMState, cp15.hcr_el2), offsetof(CPUARMState, cp15.ifsr_el2) },
+    { UC_CTX_SYS, offsetof(CPUARMState, cp15.mair_el1), offsetof(CPUARMState, cp15.vbar_el) },
+    { UC_CTX_SYS, offsetof(CPUARMState, cp15.c13_fcse), offsetof(CPUARMState, cp15.tpidr_el0) },
+    { 0 }
+};
+
+static int arm64_reg_group(unsigned int regid)
+{
+    if ((regid >= UC_ARM64_REG_B0 && regid <= UC_ARM64_REG_S31) ||
+            (regid >= UC_ARM64_REG_V0 && regid <= UC_ARM64_REG_V31)) {
+        return UC_CTX_FPU;
+    }
+
+    switch(regid) {
+        default:
+            return UC_CTX_GPR;
+        case UC_ARM64_REG_CPACR_EL1:
+        case UC_ARM64_REG_TPIDR_EL0:
+        case UC_ARM64_REG_TPIDRRO_EL0:
+        case UC_ARM64_REG_TPIDR_EL1:
+            return UC_CTX_SYS;
+    }
+}
+
 static void arm64_set_pc(struct uc_struct *uc, uint64_t address)
 {
     ((CPUARMState *)uc->current_cpu->env_ptr)->pc = address;
@@ -22,16 +63,19 @@ void arm64_release(void* ctx);
 void arm64_release(void* ctx)
 {
     struct uc_struct* uc;
+    CPUState *cs;
     ARMCPU* cpu;
     TCGContext *s = (TCGContext *) ctx;
 
     g_free(s->tb_ctx.tbs);
     uc = s->uc;
-    cpu = (ARMCPU*) uc->cpu;
-    g_free(cpu->cpreg_indexes);
-    g_free(cpu->cpreg_values);
-    g_free(cpu->cpreg_vmstate_indexes);
-    g_free(cpu->cpreg_vmstate_values);
+    CPU_FOREACH(uc, cs) {
+        cpu = ARM_CPU(uc, cs);
+        g_free(cpu->cpreg_indexes);
+        g_free(cpu->cpreg_values);
+        g_free(cpu->cpreg_vmstate_indexes);
+        g_free(cpu->cpreg_vmstate_values);
+    }
 
     release_common(ctx);
 }
@@ -194,5 +238,8 @@ void arm64_uc_init(struct uc_struct* uc)
     uc->reg_reset = arm64_reg_reset;
     uc->set_pc = arm64_set_pc;
     uc->release = arm64_release;
+    uc->context_ranges = arm64_context_ranges;
+    uc->context_mmu = arm64_context_mmu;
+    uc->reg_group = arm64_reg_group;
     uc_common_init(uc);
 }
@@ -11,6 +11,60 @@
 
 const int ARM_REGS_STORAGE_SIZE = offsetof(CPUARMState, tlb_table);
 
+// register groups of CPUARMState, for uc_context_alloc_groups()
+static const uc_context_range arm_context_ranges[] = {
+    { UC_CTX_GPR, 0, offsetof(CPUARMState, pstate) },
+    { UC_CTX_SYS, offsetof(CPUARMState, pstate), offsetof(CPUARMState, CF) },
+    { UC_CTX_GPR, offsetof(CPUARMState, CF), offsetof(CPUARMState, daif) },
+    { UC_CTX_SYS, offsetof(CPUARMState, daif), offsetof(CPUARMState, vfp) },
+    { UC_CTX_FPU, offsetof(CPUARMState, vfp), offsetof(CPUARMState, exclusive_addr) },
+    { UC_CTX_GPR, offsetof(CPUARMState, exclusive_addr), offsetof(CPUARMState, iwmmxt) },
+    { UC_CTX_FPU, offsetof(CPUARMState, iwmmxt), offsetof(CPUARMState, bswap_code) },
+    { UC_CTX_SYS, offsetof(CPUARMState, bswap_code), offsetof(CPUARMState, tlb_table) },
+    { 0 }
+};
+
+// SCTLR, TTBRs, TTBCR, DACR, HCR, SCR, MAIR & CONTEXTIDR decide how addresses are translated
+static const uc_context_range arm_context_mmu[] = {
+    { UC_CTX_SYS, offsetof(CPUARMState, cp15.c1_sys), offsetof(CPUARMState, cp15.c2_data) },
+    { UC_CTX_SYS, offsetof(CPUARMState, cp15.c3), offsetof(CPUARMState, cp15.pmsav5_data_ap) },
+    { UC_CTX_SYS, offsetof(CPUARMState, cp15.hcr_el2), offsetof(CPUARMState, cp15.ifsr_el2) },
+    { UC_CTX_SYS, offsetof(CPUARMState, cp15.mair_el1), offsetof(CPUARMState, cp15.vbar_el) },
+    { UC_CTX_SYS, offsetof(CPUARMState, cp15.c13_fcse), offsetof(CPUARMState, cp15.tpidr_el0) },
+    { 0 }
+};
+
+static int arm_reg_group(unsigned int regid)
+{
+    if ((regid >= UC_ARM_REG_D0 && regid <= UC_ARM_REG_Q15) ||
+            (regid >= UC_ARM_REG_S0 && regid <= UC_ARM_REG_S31)) {
+        return UC_CTX_FPU;
+    }
+
+    switch(regid) {
+        default:
+            return UC_CTX_GPR;
+        case UC_ARM_REG_FPEXC:
+        case UC_ARM_REG_FPINST:
+        case UC_ARM_REG_FPSCR:
+        case UC_ARM_REG_FPSCR_NZCV:
+        case UC_ARM_REG_FPSID:
+            return UC_CTX_FPU;
+        case UC_ARM_REG_SPSR:
+        case UC_ARM_REG_C1_C0_2:
+        case UC_ARM_REG_C13_C0_2:
+        case UC_ARM_REG_C13_C0_3:
+            return UC_CTX_SYS;
+        case UC_ARM_REG_CPSR:
+        case UC_ARM_REG_IPSR:
+        case UC_ARM_REG_MSP:
+        case UC_ARM_REG_PSP:
+        case UC_ARM_REG_CONTROL:
+            // mode switches bank the stack pointer
+            return UC_CTX_GPR | UC_CTX_SYS;
+    }
+}
+
 static void arm_set_pc(struct uc_struct *uc, uint64_t address)
 {
     ((CPUARMState *)uc->current_cpu->env_ptr)->pc = address;
@@ -21,17 +75,20 @@ void arm_release(void* ctx);
 
 void arm_release(void* ctx)
 {
+    CPUState *cs;
     ARMCPU* cpu;
     struct uc_struct* uc;
     TCGContext *s = (TCGContext *) ctx;
 
     g_free(s->tb_ctx.tbs);
     uc = s->uc;
-    cpu = (ARMCPU*) uc->cpu;
-    g_free(cpu->cpreg_indexes);
-    g_free(cpu->cpreg_values);
-    g_free(cpu->cpreg_vmstate_indexes);
-    g_free(cpu->cpreg_vmstate_values);
+    CPU_FOREACH(uc, cs) {
+        cpu = ARM_CPU(uc, cs);
+        g_free(cpu->cpreg_indexes);
+        g_free(cpu->cpreg_values);
+        g_free(cpu->cpreg_vmstate_indexes);
+        g_free(cpu->cpreg_vmstate_values);
+    }
 
     release_common(ctx);
 }
@@ -233,5 +290,8 @@ void arm_uc_init(struct uc_struct* uc)
     uc->stop_interrupt = arm_stop_interrupt;
     uc->release = arm_release;
     uc->query = arm_query;
+    uc->context_ranges = arm_context_ranges;
+    uc->context_mmu = arm_context_mmu;
+    uc->reg_group = arm_reg_group;
     uc_common_init(uc);
 }
@@ -2507,8 +2507,8 @@ static void x86_cpu_initfn(struct uc_struct *uc, Object *obj, void *opaque)
 
     x86_cpu_load_def(cpu, xcc->cpu_def, &error_abort);
 
-    /* init various static tables used in TCG mode */
-    if (tcg_enabled(env->uc))
+    /* init various static tables used in TCG mode, shared by all vCPUs */
+    if (tcg_enabled(env->uc) && cs->cpu_index == 0)
         optimize_flags_init(env->uc);
 }
 
@@ -885,6 +885,7 @@ typedef struct CPUX86State {
 
     /* emulator internal variables */
     float_status fp_status;
+    uint8_t fp_hard; /* Unicorn: x87 host FPU fast path, see fpu_helper.c */
     floatx80 ft0;
 
     float_status mmx_status; /* for 3DNow! float ops */
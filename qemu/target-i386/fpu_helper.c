@@ -18,12 +18,15 @@
  */
 
 #include <math.h>
+#include <float.h>
 #include "cpu.h"
 #include "exec/helper-proto.h"
 #include "qemu/aes.h"
 #include "qemu/host-utils.h"
 #include "exec/cpu_ldst.h"
 
+#include "uc_priv.h"
+
 #define FPU_RC_MASK         0xc00
 #define FPU_RC_NEAR         0x000
 #define FPU_RC_DOWN         0x400
@@ -118,8 +121,202 @@ static void fpu_set_exception(CPUX86State *env, int mask)
     }
 }
 
+/* Unicorn: host FPU fast path for the x87 add, sub, mul, div and sqrt.
+   With round-to-nearest and the precision control set to double, an
+   operation on two values that are exact doubles gives the same result as
+   the host double operation, as long as that result is a normal double or
+   an exact zero: the x87 registers only add exponent range, so results that
+   overflow or could be tiny in double are left to softfloat, and so are
+   NaNs, infinities and denormals (env->fp_hard == FP_HARD_EXACT).
+   UC_MODE_X87_FAST also takes this path under the other precision controls,
+   rounding the operands to double first (FP_HARD_FAST).
+   Nothing reads the softfloat exception flags of fp_status, so they are not
+   updated; a guest that unmasks FPU exceptions keeps the softfloat path. */
+
+#if !defined(UC_NO_HARDFLOAT) && (defined(__x86_64__) || defined(__aarch64__) || \
+    (defined(__i386__) && defined(__SSE2_MATH__)))
+#define X87_HARDFLOAT 1
+#endif
+
+enum {
+    FP_HARD_NONE,
+    FP_HARD_EXACT,
+    FP_HARD_FAST,
+};
+
+enum {
+    X87_ADD,
+    X87_SUB,
+    X87_MUL,
+    X87_DIV,
+    X87_SQRT,
+};
+
+#define F64_FRAC_MASK ((1ULL << 52) - 1)
+
+/* Returns true and sets *v to the float64 bits of a if a is zero or an
+   exact normal double */
+static inline bool floatx80_to_float64_exact(floatx80 a, uint64_t *v)
+{
+    int exp = a.high & 0x7fff;
+    uint64_t sign = (uint64_t)(a.high >> 15) << 63;
+
+    if (exp == 0 && a.low == 0) {
+        *v = sign;
+        return true;
+    }
+    if (!(a.low >> 63) || (a.low & 0x7ff) ||
+        exp < EXPBIAS - 1022 || exp > EXPBIAS + 1023) {
+        return false;
+    }
+    *v = sign | (uint64_t)(exp - EXPBIAS + 1023) << 52 |
+         ((a.low >> 11) & F64_FRAC_MASK);
+    return true;
+}
+
+/* Converts the float64 bits v, which must be zero or normal */
+static inline floatx80 float64_to_floatx80_exact(uint64_t v)
+{
+    int exp = (v >> 52) & 0x7ff;
+    floatx80 r;
+
+    r.high = (v >> 63) << 15;
+    r.low = 0;
+    if (exp != 0) {
+        r.high |= exp - 1023 + EXPBIAS;
+        r.low = (1ULL << 63) | (v & F64_FRAC_MASK) << 11;
+    }
+    return r;
+}
+
+static inline bool float64_is_zero_or_normal_bits(uint64_t v)
+{
+    int exp = (v >> 52) & 0x7ff;
+
+    return (exp != 0 && exp != 0x7ff) || (v << 1) == 0;
+}
+
+#ifdef X87_HARDFLOAT
+typedef union {
+    uint64_t i;
+    double h;
+} x87_hard_double;
+
+static inline bool x87_hard_operand(CPUX86State *env, floatx80 a, double *d)
+{
+    x87_hard_double u;
+    int exp = a.high & 0x7fff;
+
+    if (floatx80_to_float64_exact(a, &u.i)) {
+        *d = u.h;
+        return true;
+    }
+    if (env->fp_hard != FP_HARD_FAST || exp == 0 || exp == 0x7fff ||
+        !(a.low >> 63)) {
+        return false;
+    }
+    /* round to nearest double; out of range values become inf or denormal */
+    u.i = float64_val(floatx80_to_float64(a, &env->fp_status));
+    if (!float64_is_zero_or_normal_bits(u.i)) {
+        return false;
+    }
+    *d = u.h;
+    return true;
+}
+
+/* Returns true and sets *r if the operation could be done on the host */
+static bool x87_hard(CPUX86State *env, int op, floatx80 a, floatx80 b,
+                     floatx80 *r)
+{
+    x87_hard_double u;
+    double da, db = 0;
+
+    if (env->fp_hard == FP_HARD_NONE || !x87_hard_operand(env, a, &da) ||
+        (op != X87_SQRT && !x87_hard_operand(env, b, &db))) {
+        return false;
+    }
+    switch (op) {
+    case X87_ADD:
+        u.h = da + db;
+        break;
+    case X87_SUB:
+        u.h = da - db;
+        break;
+    case X87_MUL:
+        u.h = da * db;
+        break;
+    case X87_DIV:
+        /* a zero divisor raises ZE, or is invalid */
+        if (db == 0) {
+            return false;
+        }
+        u.h = da / db;
+        break;
+    default:
+        if (da < 0) {
+            return false;
+        }
+        u.h = sqrt(da);
+        break;
+    }
+    if (isinf(u.h)) {
+        return false;
+    }
+    /* a zero is exact after a cancellation or with a zero operand, other
+       tiny results may be rounded differently with the x87 exponent range */
+    if (fabs(u.h) <= DBL_MIN &&
+        (u.h != 0 || (op != X87_ADD && op != X87_SUB && da != 0 &&
+                      (op != X87_MUL || db != 0)))) {
+        return false;
+    }
+    *r = float64_to_floatx80_exact(u.i);
+    return true;
+}
+#else
+static inline bool x87_hard(CPUX86State *env, int op, floatx80 a, floatx80 b,
+                            floatx80 *r)
+{
+    return false;
+}
+#endif
+
+static inline floatx80 x87_add(CPUX86State *env, floatx80 a, floatx80 b)
+{
+    floatx80 r;
+
+    if (x87_hard(env, X87_ADD, a, b, &r)) {
+        return r;
+    }
+    return floatx80_add(a, b, &env->fp_status);
+}
+
+static inline floatx80 x87_sub(CPUX86State *env, floatx80 a, floatx80 b)
+{
+    floatx80 r;
+
+    if (x87_hard(env, X87_SUB, a, b, &r)) {
+        return r;
+    }
+    return floatx80_sub(a, b, &env->fp_status);
+}
+
+static inline floatx80 x87_mul(CPUX86State *env, floatx80 a, floatx80 b)
+{
+    floatx80 r;
+
+    if (x87_hard(env, X87_MUL, a, b, &r)) {
+        return r;
+    }
+    return floatx80_mul(a, b, &env->fp_status);
+}
+
 static inline floatx80 helper_fdiv(CPUX86State *env, floatx80 a, floatx80 b)
 {
+    floatx80 r;
+
+    if (x87_hard(env, X87_DIV, a, b, &r)) {
+        return r;
+    }
     if (floatx80_is_zero(b)) {
         fpu_set_exception(env, FPUS_ZE);
     }
@@ -157,7 +354,11 @@ void helper_fldl_FT0(CPUX86State *env, uint64_t val)
     } u;
 
     u.i = val;
-    FT0 = float64_to_floatx80(u.f, &env->fp_status);
+    if (float64_is_zero_or_normal_bits(val)) {
+        FT0 = float64_to_floatx80_exact(val);
+    } else {
+        FT0 = float64_to_floatx80(u.f, &env->fp_status);
+    }
 }
 
 void helper_fildl_FT0(CPUX86State *env, int32_t val)
@@ -190,7 +391,11 @@ void helper_fldl_ST0(CPUX86State *env, uint64_t val)
 
     new_fpstt = (env->fpstt - 1) & 7;
     u.i = val;
-    env->fpregs[new_fpstt].d = float64_to_floatx80(u.f, &env->fp_status);
+    if (float64_is_zero_or_normal_bits(val)) {
+        env->fpregs[new_fpstt].d = float64_to_floatx80_exact(val);
+    } else {
+        env->fpregs[new_fpstt].d = float64_to_floatx80(u.f, &env->fp_status);
+    }
     env->fpstt = new_fpstt;
     env->fptags[new_fpstt] = 0; /* validate stack entry */
 }
@@ -233,6 +438,9 @@ uint64_t helper_fstl_ST0(CPUX86State *env)
         uint64_t i;
     } u;
 
+    if (floatx80_to_float64_exact(ST0, &u.i)) {
+        return u.i;
+    }
     u.f = floatx80_to_float64(ST0, &env->fp_status);
     return u.i;
 }
@@ -410,22 +618,22 @@ void helper_fucomi_ST0_FT0(CPUX86State *env)
 
 void helper_fadd_ST0_FT0(CPUX86State *env)
 {
-    ST0 = floatx80_add(ST0, FT0, &env->fp_status);
+    ST0 = x87_add(env, ST0, FT0);
 }
 
 void helper_fmul_ST0_FT0(CPUX86State *env)
 {
-    ST0 = floatx80_mul(ST0, FT0, &env->fp_status);
+    ST0 = x87_mul(env, ST0, FT0);
 }
 
 void helper_fsub_ST0_FT0(CPUX86State *env)
 {
-    ST0 = floatx80_sub(ST0, FT0, &env->fp_status);
+    ST0 = x87_sub(env, ST0, FT0);
 }
 
 void helper_fsubr_ST0_FT0(CPUX86State *env)
 {
-    ST0 = floatx80_sub(FT0, ST0, &env->fp_status);
+    ST0 = x87_sub(env, FT0, ST0);
 }
 
 void helper_fdiv_ST0_FT0(CPUX86State *env)
@@ -442,22 +650,22 @@ void helper_fdivr_ST0_FT0(CPUX86State *env)
 
 void helper_fadd_STN_ST0(CPUX86State *env, int st_index)
 {
-    ST(st_index) = floatx80_add(ST(st_index), ST0, &env->fp_status);
+    ST(st_index) = x87_add(env, ST(st_index), ST0);
 }
 
 void helper_fmul_STN_ST0(CPUX86State *env, int st_index)
 {
-    ST(st_index) = floatx80_mul(ST(st_index), ST0, &env->fp_status);
+    ST(st_index) = x87_mul(env, ST(st_index), ST0);
 }
 
 void helper_fsub_STN_ST0(CPUX86State *env, int st_index)
 {
-    ST(st_index) = floatx80_sub(ST(st_index), ST0, &env->fp_status);
+    ST(st_index) = x87_sub(env, ST(st_index), ST0);
 }
 
 void helper_fsubr_STN_ST0(CPUX86State *env, int st_index)
 {
-    ST(st_index) = floatx80_sub(ST0, ST(st_index), &env->fp_status);
+    ST(st_index) = x87_sub(env, ST0, ST(st_index));
 }
 
 void helper_fdiv_STN_ST0(CPUX86State *env, int st_index)
@@ -587,6 +795,18 @@ void update_fp_status(CPUX86State *env)
         break;
     }
     set_floatx80_rounding_precision(rnd_type, &env->fp_status);
+
+    env->fp_hard = FP_HARD_NONE;
+#ifdef X87_HARDFLOAT
+    if ((env->fpuc & FPU_RC_MASK) == FPU_RC_NEAR &&
+        (env->fpuc & FPUC_EM) == FPUC_EM) {
+        if (env->uc->mode & UC_MODE_X87_FAST) {
+            env->fp_hard = FP_HARD_FAST;
+        } else if (rnd_type == 64) {
+            env->fp_hard = FP_HARD_EXACT;
+        }
+    }
+#endif
 }
 
 void helper_fldcw(CPUX86State *env, uint32_t val)
@@ -891,7 +1111,9 @@ void helper_fsqrt(CPUX86State *env)
         env->fpus &= ~0x4700;  /* (C3,C2,C1,C0) <-- 0000 */
         env->fpus |= 0x400;
     }
-    ST0 = floatx80_sqrt(ST0, &env->fp_status);
+    if (!x87_hard(env, X87_SQRT, ST0, ST0, &ST0)) {
+        ST0 = floatx80_sqrt(ST0, &env->fp_status);
+    }
 }
 
 void helper_fsincos(CPUX86State *env)
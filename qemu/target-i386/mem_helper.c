@@ -104,6 +104,185 @@ void helper_boundl(CPUX86State *env, target_ulong a0, int v)
     }
 }
 
+/* Unicorn: bulk REP MOVS/STOS.
+ * The translator only calls these when no memory hook is installed, with
+ * the linear address of the first element. They move as many elements as
+ * can be done without a fault: the run stops at the first page that is not
+ * plain RAM in the TLB, at a 16/32 bit register wrap or when ECX runs out.
+ * The remaining elements (if any) are left to the per-element loop, which
+ * takes care of TLB refills, faults and self-modifying code. */
+static target_ulong rep_mask(int aflag)
+{
+    switch (aflag) {
+    case MO_16:
+        return 0xffff;
+    case MO_32:
+        return 0xffffffff;
+    default:
+        return (target_ulong)-1;
+    }
+}
+
+static void rep_set_reg(CPUX86State *env, int reg, target_ulong val, int aflag)
+{
+    switch (aflag) {
+    case MO_16:
+        env->regs[reg] = (env->regs[reg] & ~(target_ulong)0xffff) | (val & 0xffff);
+        break;
+    case MO_32:
+        env->regs[reg] = (uint32_t)val;
+        break;
+    default:
+        env->regs[reg] = val;
+        break;
+    }
+}
+
+/* limit count so that the register does not wrap around within the run */
+static target_ulong rep_reg_limit(target_ulong reg, target_ulong mask, int n,
+                                  int df, target_ulong count)
+{
+    target_ulong room;
+
+    if (mask == (target_ulong)-1) {
+        return count;
+    }
+    room = df > 0 ? (mask - reg) / n + 1 : reg / n + 1;
+    return MIN(count, room);
+}
+
+/* host address of the element at addr, limiting count to the elements that
+   stay in the same page. NULL if the page is not RAM mapped in the TLB. */
+static uint8_t *rep_host_addr(CPUX86State *env, target_ulong addr, int n,
+                              int df, bool is_write, target_ulong *count)
+{
+    int mmu_idx = cpu_mmu_index(env);
+    int index = (addr >> TARGET_PAGE_BITS) & (CPU_TLB_SIZE - 1);
+    CPUTLBEntry *tlbe = &env->tlb_table[mmu_idx][index];
+    target_ulong page = addr & TARGET_PAGE_MASK;
+    target_ulong tlb_addr = is_write ? tlbe->addr_write : tlbe->addr_read;
+    target_ulong room;
+    int vidx;
+
+    /* any flag (invalid, notdirty, mmio) sends us to the slow path. Source
+       and destination often share a TLB index, so look at the victim TLB
+       before giving up. */
+    if (tlb_addr != page) {
+        for (vidx = 0; vidx < CPU_VTLB_SIZE; vidx++) {
+            tlbe = &env->tlb_v_table[mmu_idx][vidx];
+            tlb_addr = is_write ? tlbe->addr_write : tlbe->addr_read;
+            if (tlb_addr == page) {
+                break;
+            }
+        }
+        if (vidx == CPU_VTLB_SIZE) {
+            return NULL;
+        }
+    }
+    if (((addr + n - 1) & TARGET_PAGE_MASK) != page) {
+        return NULL;
+    }
+    if (df > 0) {
+        room = (page + TARGET_PAGE_SIZE - addr) / n;
+    } else {
+        room = (addr - page) / n + 1;
+    }
+    *count = MIN(*count, room);
+
+    return (uint8_t *)(uintptr_t)(addr + tlbe->addend);
+}
+
+void helper_rep_movs(CPUX86State *env, target_ulong src, target_ulong dst,
+                     uint32_t ot, uint32_t aflag)
+{
+    int n = 1 << ot;
+    int df = env->df;
+    target_ulong mask = rep_mask(aflag);
+    target_ulong count = env->regs[R_ECX] & mask;
+    target_ulong esi = env->regs[R_ESI];
+    target_ulong edi = env->regs[R_EDI];
+    target_ulong len, i;
+    uint8_t *hsrc, *hdst, *lsrc, *ldst;
+    ptrdiff_t step = df * n;
+
+    count = rep_reg_limit(esi & mask, mask, n, df, count);
+    count = rep_reg_limit(edi & mask, mask, n, df, count);
+    hsrc = rep_host_addr(env, src, n, df, false, &count);
+    if (hsrc == NULL) {
+        return;
+    }
+    hdst = rep_host_addr(env, dst, n, df, true, &count);
+    if (hdst == NULL || count == 0) {
+        return;
+    }
+
+    len = count * n;
+    lsrc = df > 0 ? hsrc : hsrc - (len - n);
+    ldst = df > 0 ? hdst : hdst - (len - n);
+    if (ldst + len <= lsrc || lsrc + len <= ldst ||
+        (df > 0 && hdst <= hsrc) || (df < 0 && hdst >= hsrc)) {
+        /* copying in DF order never reads an element written by this run */
+        memmove(ldst, lsrc, len);
+    } else {
+        /* overlapping the other way (e.g. pattern fill with dst = src + 1):
+           element by element, like the hardware */
+        for (i = 0; i < count; i++) {
+            memmove(hdst + (ptrdiff_t)i * step, hsrc + (ptrdiff_t)i * step, n);
+        }
+    }
+
+    rep_set_reg(env, R_ESI, esi + df * len, aflag);
+    rep_set_reg(env, R_EDI, edi + df * len, aflag);
+    rep_set_reg(env, R_ECX, env->regs[R_ECX] - count, aflag);
+}
+
+void helper_rep_stos(CPUX86State *env, target_ulong dst, uint32_t ot,
+                     uint32_t aflag)
+{
+    int n = 1 << ot;
+    int df = env->df;
+    target_ulong mask = rep_mask(aflag);
+    target_ulong count = env->regs[R_ECX] & mask;
+    target_ulong edi = env->regs[R_EDI];
+    target_ulong value = env->regs[R_EAX];
+    target_ulong len, i;
+    uint8_t *hdst;
+
+    count = rep_reg_limit(edi & mask, mask, n, df, count);
+    hdst = rep_host_addr(env, dst, n, df, true, &count);
+    if (hdst == NULL || count == 0) {
+        return;
+    }
+
+    len = count * n;
+    if (df < 0) {
+        hdst -= len - n;
+    }
+    switch (ot) {
+    case MO_8:
+        memset(hdst, (uint8_t)value, len);
+        break;
+    case MO_16:
+        for (i = 0; i < count; i++) {
+            stw_le_p(hdst + i * 2, value);
+        }
+        break;
+    case MO_32:
+        for (i = 0; i < count; i++) {
+            stl_le_p(hdst + i * 4, value);
+        }
+        break;
+    default:
+        for (i = 0; i < count; i++) {
+            stq_le_p(hdst + i * 8, value);
+        }
+        break;
+    }
+
+    rep_set_reg(env, R_EDI, edi + df * len, aflag);
+    rep_set_reg(env, R_ECX, env->regs[R_ECX] - count, aflag);
+}
+
 #if !defined(CONFIG_USER_ONLY)
 /* try to fill the TLB and return an exception if error. If retaddr is
  * NULL, it means that the function was called in C code (i.e. not
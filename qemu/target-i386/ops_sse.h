@@ -38,6 +38,59 @@
 #define SUFFIX _xmm
 #endif
 
+/* Unicorn: on x86_64 hosts the 128-bit integer helpers use host SIMD. SSE2
+   is always there; SSSE3, SSE4.1, AES-NI and PCLMUL versions are picked at
+   run time from the CPUID bits tcg_target_init() found (have_ssse3,
+   have_sse41, have_aesni, have_pclmul). The C code stays as the fallback,
+   and is what the MMX forms use. */
+#if SHIFT == 1 && defined(__x86_64__) && defined(__GNUC__)
+#define SSE_HOST
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <smmintrin.h>
+#include <wmmintrin.h>
+
+#define SSE_HOST_LD(r) _mm_loadu_si128((__m128i *)(r))
+#define SSE_HOST_ST(r, v) _mm_storeu_si128((__m128i *)(r), (v))
+
+/* static glue(name, _host)(d, s): d = op(d, s), built for feature set feat */
+#define SSE_HOST_FN(name, feat, op)                                     \
+    static __attribute__((target(feat))) void glue(name, _host)(Reg *d, Reg *s) \
+    {                                                                   \
+        SSE_HOST_ST(d, op(SSE_HOST_LD(d), SSE_HOST_LD(s)));             \
+    }
+
+/* ops in SSE2: no need for the C version */
+#define SSE_HELPER_HOST(kind, name, F, op)                              \
+    SSE_HOST_FN(name, "sse2", op)                                       \
+    void glue(name, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)           \
+    {                                                                   \
+        glue(name, _host)(d, s);                                        \
+    }
+
+/* ops in later extensions: the C version unless the host has them */
+#define SSE_HELPER_HOST_FEAT(kind, name, F, op, feat, have)             \
+    static SSE_HELPER_ ## kind(glue(name, _c), F)                       \
+    SSE_HOST_FN(name, feat, op)                                         \
+    void glue(name, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)           \
+    {                                                                   \
+        if (have) {                                                     \
+            glue(name, _host)(d, s);                                    \
+        } else {                                                        \
+            glue(glue(name, _c), SUFFIX)(env, d, s);                    \
+        }                                                               \
+    }
+
+/* unary ops take their operand from s */
+#define sse_host_abs_epi8(d, s) _mm_abs_epi8(s)
+#define sse_host_abs_epi16(d, s) _mm_abs_epi16(s)
+#define sse_host_abs_epi32(d, s) _mm_abs_epi32(s)
+#define sse_host_aesimc(d, s) _mm_aesimc_si128(s)
+#else
+#define SSE_HELPER_HOST(kind, name, F, op) SSE_HELPER_ ## kind(name, F)
+#define SSE_HELPER_HOST_FEAT(kind, name, F, op, feat, have) SSE_HELPER_ ## kind(name, F)
+#endif
+
 void glue(helper_psrlw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     int shift;
@@ -371,55 +424,58 @@ static inline int satsw(int x)
 #define FAVG(a, b) (((a) + (b) + 1) >> 1)
 #endif
 
-SSE_HELPER_B(helper_paddb, FADD)
-SSE_HELPER_W(helper_paddw, FADD)
-SSE_HELPER_L(helper_paddl, FADD)
-SSE_HELPER_Q(helper_paddq, FADD)
+SSE_HELPER_HOST(B, helper_paddb, FADD, _mm_add_epi8)
+SSE_HELPER_HOST(W, helper_paddw, FADD, _mm_add_epi16)
+SSE_HELPER_HOST(L, helper_paddl, FADD, _mm_add_epi32)
+SSE_HELPER_HOST(Q, helper_paddq, FADD, _mm_add_epi64)
 
-SSE_HELPER_B(helper_psubb, FSUB)
-SSE_HELPER_W(helper_psubw, FSUB)
-SSE_HELPER_L(helper_psubl, FSUB)
-SSE_HELPER_Q(helper_psubq, FSUB)
+SSE_HELPER_HOST(B, helper_psubb, FSUB, _mm_sub_epi8)
+SSE_HELPER_HOST(W, helper_psubw, FSUB, _mm_sub_epi16)
+SSE_HELPER_HOST(L, helper_psubl, FSUB, _mm_sub_epi32)
+SSE_HELPER_HOST(Q, helper_psubq, FSUB, _mm_sub_epi64)
 
-SSE_HELPER_B(helper_paddusb, FADDUB)
-SSE_HELPER_B(helper_paddsb, FADDSB)
-SSE_HELPER_B(helper_psubusb, FSUBUB)
-SSE_HELPER_B(helper_psubsb, FSUBSB)
+SSE_HELPER_HOST(B, helper_paddusb, FADDUB, _mm_adds_epu8)
+SSE_HELPER_HOST(B, helper_paddsb, FADDSB, _mm_adds_epi8)
+SSE_HELPER_HOST(B, helper_psubusb, FSUBUB, _mm_subs_epu8)
+SSE_HELPER_HOST(B, helper_psubsb, FSUBSB, _mm_subs_epi8)
 
-SSE_HELPER_W(helper_paddusw, FADDUW)
-SSE_HELPER_W(helper_paddsw, FADDSW)
-SSE_HELPER_W(helper_psubusw, FSUBUW)
-SSE_HELPER_W(helper_psubsw, FSUBSW)
+SSE_HELPER_HOST(W, helper_paddusw, FADDUW, _mm_adds_epu16)
+SSE_HELPER_HOST(W, helper_paddsw, FADDSW, _mm_adds_epi16)
+SSE_HELPER_HOST(W, helper_psubusw, FSUBUW, _mm_subs_epu16)
+SSE_HELPER_HOST(W, helper_psubsw, FSUBSW, _mm_subs_epi16)
 
-SSE_HELPER_B(helper_pminub, FMINUB)
-SSE_HELPER_B(helper_pmaxub, FMAXUB)
+SSE_HELPER_HOST(B, helper_pminub, FMINUB, _mm_min_epu8)
+SSE_HELPER_HOST(B, helper_pmaxub, FMAXUB, _mm_max_epu8)
 
-SSE_HELPER_W(helper_pminsw, FMINSW)
-SSE_HELPER_W(helper_pmaxsw, FMAXSW)
+SSE_HELPER_HOST(W, helper_pminsw, FMINSW, _mm_min_epi16)
+SSE_HELPER_HOST(W, helper_pmaxsw, FMAXSW, _mm_max_epi16)
 
-SSE_HELPER_Q(helper_pand, FAND)
-SSE_HELPER_Q(helper_pandn, FANDN)
-SSE_HELPER_Q(helper_por, FOR)
-SSE_HELPER_Q(helper_pxor, FXOR)
+SSE_HELPER_HOST(Q, helper_pand, FAND, _mm_and_si128)
+SSE_HELPER_HOST(Q, helper_pandn, FANDN, _mm_andnot_si128)
+SSE_HELPER_HOST(Q, helper_por, FOR, _mm_or_si128)
+SSE_HELPER_HOST(Q, helper_pxor, FXOR, _mm_xor_si128)
 
-SSE_HELPER_B(helper_pcmpgtb, FCMPGTB)
-SSE_HELPER_W(helper_pcmpgtw, FCMPGTW)
-SSE_HELPER_L(helper_pcmpgtl, FCMPGTL)
+SSE_HELPER_HOST(B, helper_pcmpgtb, FCMPGTB, _mm_cmpgt_epi8)
+SSE_HELPER_HOST(W, helper_pcmpgtw, FCMPGTW, _mm_cmpgt_epi16)
+SSE_HELPER_HOST(L, helper_pcmpgtl, FCMPGTL, _mm_cmpgt_epi32)
 
-SSE_HELPER_B(helper_pcmpeqb, FCMPEQ)
-SSE_HELPER_W(helper_pcmpeqw, FCMPEQ)
-SSE_HELPER_L(helper_pcmpeql, FCMPEQ)
+SSE_HELPER_HOST(B, helper_pcmpeqb, FCMPEQ, _mm_cmpeq_epi8)
+SSE_HELPER_HOST(W, helper_pcmpeqw, FCMPEQ, _mm_cmpeq_epi16)
+SSE_HELPER_HOST(L, helper_pcmpeql, FCMPEQ, _mm_cmpeq_epi32)
 
-SSE_HELPER_W(helper_pmullw, FMULLW)
+SSE_HELPER_HOST(W, helper_pmullw, FMULLW, _mm_mullo_epi16)
 #if SHIFT == 0
 SSE_HELPER_W(helper_pmulhrw, FMULHRW)
 #endif
-SSE_HELPER_W(helper_pmulhuw, FMULHUW)
-SSE_HELPER_W(helper_pmulhw, FMULHW)
+SSE_HELPER_HOST(W, helper_pmulhuw, FMULHUW, _mm_mulhi_epu16)
+SSE_HELPER_HOST(W, helper_pmulhw, FMULHW, _mm_mulhi_epi16)
 
-SSE_HELPER_B(helper_pavgb, FAVG)
-SSE_HELPER_W(helper_pavgw, FAVG)
+SSE_HELPER_HOST(B, helper_pavgb, FAVG, _mm_avg_epu8)
+SSE_HELPER_HOST(W, helper_pavgw, FAVG, _mm_avg_epu16)
 
+#ifdef SSE_HOST
+SSE_HELPER_HOST(Q, helper_pmuludq, F, _mm_mul_epu32)
+#else
 void glue(helper_pmuludq, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     d->Q(0) = (uint64_t)s->L(0) * (uint64_t)d->L(0);
@@ -427,7 +483,11 @@ void glue(helper_pmuludq, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
     d->Q(1) = (uint64_t)s->L(2) * (uint64_t)d->L(2);
 #endif
 }
+#endif
 
+#ifdef SSE_HOST
+SSE_HELPER_HOST(L, helper_pmaddwd, F, _mm_madd_epi16)
+#else
 void glue(helper_pmaddwd, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     int i;
@@ -437,6 +497,7 @@ void glue(helper_pmaddwd, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
             (int16_t)s->W(2 * i + 1) * (int16_t)d->W(2 * i + 1);
     }
 }
+#endif
 
 #if SHIFT == 0
 static inline int abs1(int a)
@@ -448,6 +509,9 @@ static inline int abs1(int a)
     }
 }
 #endif
+#ifdef SSE_HOST
+SSE_HELPER_HOST(Q, helper_psadbw, F, _mm_sad_epu8)
+#else
 void glue(helper_psadbw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     unsigned int val;
@@ -475,6 +539,7 @@ void glue(helper_psadbw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
     d->Q(1) = val;
 #endif
 }
+#endif
 
 void glue(helper_maskmov, SUFFIX)(CPUX86State *env, Reg *d, Reg *s,
                                   target_ulong a0)
@@ -519,6 +584,8 @@ void glue(helper_pshufw, SUFFIX)(Reg *d, Reg *s, int order)
     *d = r;
 }
 #else
+/* the immediate is only known here at run time: building a pshufb mask from
+   it costs more than these moves, so the shuffles stay in C */
 void helper_shufps(Reg *d, Reg *s, int order)
 {
     Reg r;
@@ -1063,6 +1130,12 @@ uint32_t helper_movmskpd(CPUX86State *env, Reg *s)
 
 #endif
 
+#ifdef SSE_HOST
+uint32_t glue(helper_pmovmskb, SUFFIX)(CPUX86State *env, Reg *s)
+{
+    return _mm_movemask_epi8(SSE_HOST_LD(s));
+}
+#else
 uint32_t glue(helper_pmovmskb, SUFFIX)(CPUX86State *env, Reg *s)
 {
     uint32_t val;
@@ -1088,7 +1161,11 @@ uint32_t glue(helper_pmovmskb, SUFFIX)(CPUX86State *env, Reg *s)
 #endif
     return val;
 }
+#endif
 
+#ifdef SSE_HOST
+SSE_HELPER_HOST(B, helper_packsswb, F, _mm_packs_epi16)
+#else
 void glue(helper_packsswb, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     Reg r;
@@ -1115,7 +1192,11 @@ void glue(helper_packsswb, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 #endif
     *d = r;
 }
+#endif
 
+#ifdef SSE_HOST
+SSE_HELPER_HOST(B, helper_packuswb, F, _mm_packus_epi16)
+#else
 void glue(helper_packuswb, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     Reg r;
@@ -1142,7 +1223,11 @@ void glue(helper_packuswb, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 #endif
     *d = r;
 }
+#endif
 
+#ifdef SSE_HOST
+SSE_HELPER_HOST(W, helper_packssdw, F, _mm_packs_epi32)
+#else
 void glue(helper_packssdw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     Reg r;
@@ -1161,6 +1246,7 @@ void glue(helper_packssdw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 #endif
     *d = r;
 }
+#endif
 
 #define UNPCK_OP(base_name, base)                                       \
                                                                         \
@@ -1236,8 +1322,19 @@ void glue(helper_packssdw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
              }                                                          \
                                                                         )
 
+#ifdef SSE_HOST
+SSE_HELPER_HOST(B, helper_punpcklbw, F, _mm_unpacklo_epi8)
+SSE_HELPER_HOST(W, helper_punpcklwd, F, _mm_unpacklo_epi16)
+SSE_HELPER_HOST(L, helper_punpckldq, F, _mm_unpacklo_epi32)
+SSE_HELPER_HOST(Q, helper_punpcklqdq, F, _mm_unpacklo_epi64)
+SSE_HELPER_HOST(B, helper_punpckhbw, F, _mm_unpackhi_epi8)
+SSE_HELPER_HOST(W, helper_punpckhwd, F, _mm_unpackhi_epi16)
+SSE_HELPER_HOST(L, helper_punpckhdq, F, _mm_unpackhi_epi32)
+SSE_HELPER_HOST(Q, helper_punpckhqdq, F, _mm_unpackhi_epi64)
+#else
 UNPCK_OP(l, 0)
 UNPCK_OP(h, 1)
+#endif
 
 /* 3DNow! float ops */
 #if SHIFT == 0
@@ -1389,11 +1486,22 @@ void helper_pswapd(CPUX86State *env, MMXReg *d, MMXReg *s)
 #endif
 
 /* SSSE3 op helpers */
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_pshufb, "ssse3", _mm_shuffle_epi8)
+#endif
+
 void glue(helper_pshufb, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     int i;
     Reg r;
 
+#ifdef SSE_HOST
+    if (have_ssse3) {
+        glue(helper_pshufb, _host)(d, s);
+        return;
+    }
+#endif
+
     for (i = 0; i < (8 << SHIFT); i++) {
         r.B(i) = (s->B(i) & 0x80) ? 0 : (d->B(s->B(i) & ((8 << SHIFT) - 1)));
     }
@@ -1401,40 +1509,89 @@ void glue(helper_pshufb, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
     *d = r;
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_phaddw, "ssse3", _mm_hadd_epi16)
+#endif
+
 void glue(helper_phaddw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
-    d->W(0) = (int16_t)d->W(0) + (int16_t)d->W(1);
-    d->W(1) = (int16_t)d->W(2) + (int16_t)d->W(3);
-    XMM_ONLY(d->W(2) = (int16_t)d->W(4) + (int16_t)d->W(5));
-    XMM_ONLY(d->W(3) = (int16_t)d->W(6) + (int16_t)d->W(7));
-    d->W((2 << SHIFT) + 0) = (int16_t)s->W(0) + (int16_t)s->W(1);
-    d->W((2 << SHIFT) + 1) = (int16_t)s->W(2) + (int16_t)s->W(3);
-    XMM_ONLY(d->W(6) = (int16_t)s->W(4) + (int16_t)s->W(5));
-    XMM_ONLY(d->W(7) = (int16_t)s->W(6) + (int16_t)s->W(7));
+    Reg r;
+
+#ifdef SSE_HOST
+    if (have_ssse3) {
+        glue(helper_phaddw, _host)(d, s);
+        return;
+    }
+#endif
+    r.W(0) = (int16_t)d->W(0) + (int16_t)d->W(1);
+    r.W(1) = (int16_t)d->W(2) + (int16_t)d->W(3);
+    XMM_ONLY(r.W(2) = (int16_t)d->W(4) + (int16_t)d->W(5));
+    XMM_ONLY(r.W(3) = (int16_t)d->W(6) + (int16_t)d->W(7));
+    r.W((2 << SHIFT) + 0) = (int16_t)s->W(0) + (int16_t)s->W(1);
+    r.W((2 << SHIFT) + 1) = (int16_t)s->W(2) + (int16_t)s->W(3);
+    XMM_ONLY(r.W(6) = (int16_t)s->W(4) + (int16_t)s->W(5));
+    XMM_ONLY(r.W(7) = (int16_t)s->W(6) + (int16_t)s->W(7));
+    *d = r;
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_phaddd, "ssse3", _mm_hadd_epi32)
+#endif
+
 void glue(helper_phaddd, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
-    d->L(0) = (int32_t)d->L(0) + (int32_t)d->L(1);
-    XMM_ONLY(d->L(1) = (int32_t)d->L(2) + (int32_t)d->L(3));
-    d->L((1 << SHIFT) + 0) = (uint32_t)((int32_t)s->L(0) + (uint32_t)s->L(1));
-    XMM_ONLY(d->L(3) = (int32_t)s->L(2) + (int32_t)s->L(3));
+    Reg r;
+
+#ifdef SSE_HOST
+    if (have_ssse3) {
+        glue(helper_phaddd, _host)(d, s);
+        return;
+    }
+#endif
+    r.L(0) = (int32_t)d->L(0) + (int32_t)d->L(1);
+    XMM_ONLY(r.L(1) = (int32_t)d->L(2) + (int32_t)d->L(3));
+    r.L((1 << SHIFT) + 0) = (uint32_t)((int32_t)s->L(0) + (uint32_t)s->L(1));
+    XMM_ONLY(r.L(3) = (int32_t)s->L(2) + (int32_t)s->L(3));
+    *d = r;
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_phaddsw, "ssse3", _mm_hadds_epi16)
+#endif
+
 void glue(helper_phaddsw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
-    d->W(0) = satsw((int16_t)d->W(0) + (int16_t)d->W(1));
-    d->W(1) = satsw((int16_t)d->W(2) + (int16_t)d->W(3));
-    XMM_ONLY(d->W(2) = satsw((int16_t)d->W(4) + (int16_t)d->W(5)));
-    XMM_ONLY(d->W(3) = satsw((int16_t)d->W(6) + (int16_t)d->W(7)));
-    d->W((2 << SHIFT) + 0) = satsw((int16_t)s->W(0) + (int16_t)s->W(1));
-    d->W((2 << SHIFT) + 1) = satsw((int16_t)s->W(2) + (int16_t)s->W(3));
-    XMM_ONLY(d->W(6) = satsw((int16_t)s->W(4) + (int16_t)s->W(5)));
-    XMM_ONLY(d->W(7) = satsw((int16_t)s->W(6) + (int16_t)s->W(7)));
+    Reg r;
+
+#ifdef SSE_HOST
+    if (have_ssse3) {
+        glue(helper_phaddsw, _host)(d, s);
+        return;
+    }
+#endif
+    r.W(0) = satsw((int16_t)d->W(0) + (int16_t)d->W(1));
+    r.W(1) = satsw((int16_t)d->W(2) + (int16_t)d->W(3));
+    XMM_ONLY(r.W(2) = satsw((int16_t)d->W(4) + (int16_t)d->W(5)));
+    XMM_ONLY(r.W(3) = satsw((int16_t)d->W(6) + (int16_t)d->W(7)));
+    r.W((2 << SHIFT) + 0) = satsw((int16_t)s->W(0) + (int16_t)s->W(1));
+    r.W((2 << SHIFT) + 1) = satsw((int16_t)s->W(2) + (int16_t)s->W(3));
+    XMM_ONLY(r.W(6) = satsw((int16_t)s->W(4) + (int16_t)s->W(5)));
+    XMM_ONLY(r.W(7) = satsw((int16_t)s->W(6) + (int16_t)s->W(7)));
+    *d = r;
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_pmaddubsw, "ssse3", _mm_maddubs_epi16)
+#endif
+
 void glue(helper_pmaddubsw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
+#ifdef SSE_HOST
+    if (have_ssse3) {
+        glue(helper_pmaddubsw, _host)(d, s);
+        return;
+    }
+#endif
     d->W(0) = satsw((int8_t)s->B(0) * (uint8_t)d->B(0) +
                     (int8_t)s->B(1) * (uint8_t)d->B(1));
     d->W(1) = satsw((int8_t)s->B(2) * (uint8_t)d->B(2) +
@@ -1455,54 +1612,93 @@ void glue(helper_pmaddubsw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 #endif
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_phsubw, "ssse3", _mm_hsub_epi16)
+#endif
+
 void glue(helper_phsubw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
-    d->W(0) = (int16_t)d->W(0) - (int16_t)d->W(1);
-    d->W(1) = (int16_t)d->W(2) - (int16_t)d->W(3);
-    XMM_ONLY(d->W(2) = (int16_t)d->W(4) - (int16_t)d->W(5));
-    XMM_ONLY(d->W(3) = (int16_t)d->W(6) - (int16_t)d->W(7));
-    d->W((2 << SHIFT) + 0) = (int16_t)s->W(0) - (int16_t)s->W(1);
-    d->W((2 << SHIFT) + 1) = (int16_t)s->W(2) - (int16_t)s->W(3);
-    XMM_ONLY(d->W(6) = (int16_t)s->W(4) - (int16_t)s->W(5));
-    XMM_ONLY(d->W(7) = (int16_t)s->W(6) - (int16_t)s->W(7));
+    Reg r;
+
+#ifdef SSE_HOST
+    if (have_ssse3) {
+        glue(helper_phsubw, _host)(d, s);
+        return;
+    }
+#endif
+    r.W(0) = (int16_t)d->W(0) - (int16_t)d->W(1);
+    r.W(1) = (int16_t)d->W(2) - (int16_t)d->W(3);
+    XMM_ONLY(r.W(2) = (int16_t)d->W(4) - (int16_t)d->W(5));
+    XMM_ONLY(r.W(3) = (int16_t)d->W(6) - (int16_t)d->W(7));
+    r.W((2 << SHIFT) + 0) = (int16_t)s->W(0) - (int16_t)s->W(1);
+    r.W((2 << SHIFT) + 1) = (int16_t)s->W(2) - (int16_t)s->W(3);
+    XMM_ONLY(r.W(6) = (int16_t)s->W(4) - (int16_t)s->W(5));
+    XMM_ONLY(r.W(7) = (int16_t)s->W(6) - (int16_t)s->W(7));
+    *d = r;
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_phsubd, "ssse3", _mm_hsub_epi32)
+#endif
+
 void glue(helper_phsubd, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
-    d->L(0) = (int32_t)((int64_t)d->L(0) - (int64_t)d->L(1));
-    XMM_ONLY(d->L(1) = (int32_t)((int64_t)d->L(2) - (int64_t)d->L(3)));
-    d->L((1 << SHIFT) + 0) = (uint32_t)((int32_t)s->L(0) - (int32_t)s->L(1));
-    XMM_ONLY(d->L(3) = (int32_t)s->L(2) - (int32_t)s->L(3));
+    Reg r;
+
+#ifdef SSE_HOST
+    if (have_ssse3) {
+        glue(helper_phsubd, _host)(d, s);
+        return;
+    }
+#endif
+    r.L(0) = (int32_t)((int64_t)d->L(0) - (int64_t)d->L(1));
+    XMM_ONLY(r.L(1) = (int32_t)((int64_t)d->L(2) - (int64_t)d->L(3)));
+    r.L((1 << SHIFT) + 0) = (uint32_t)((int32_t)s->L(0) - (int32_t)s->L(1));
+    XMM_ONLY(r.L(3) = (int32_t)s->L(2) - (int32_t)s->L(3));
+    *d = r;
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_phsubsw, "ssse3", _mm_hsubs_epi16)
+#endif
+
 void glue(helper_phsubsw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
-    d->W(0) = satsw((int16_t)d->W(0) - (int16_t)d->W(1));
-    d->W(1) = satsw((int16_t)d->W(2) - (int16_t)d->W(3));
-    XMM_ONLY(d->W(2) = satsw((int16_t)d->W(4) - (int16_t)d->W(5)));
-    XMM_ONLY(d->W(3) = satsw((int16_t)d->W(6) - (int16_t)d->W(7)));
-    d->W((2 << SHIFT) + 0) = satsw((int16_t)s->W(0) - (int16_t)s->W(1));
-    d->W((2 << SHIFT) + 1) = satsw((int16_t)s->W(2) - (int16_t)s->W(3));
-    XMM_ONLY(d->W(6) = satsw((int16_t)s->W(4) - (int16_t)s->W(5)));
-    XMM_ONLY(d->W(7) = satsw((int16_t)s->W(6) - (int16_t)s->W(7)));
+    Reg r;
+
+#ifdef SSE_HOST
+    if (have_ssse3) {
+        glue(helper_phsubsw, _host)(d, s);
+        return;
+    }
+#endif
+    r.W(0) = satsw((int16_t)d->W(0) - (int16_t)d->W(1));
+    r.W(1) = satsw((int16_t)d->W(2) - (int16_t)d->W(3));
+    XMM_ONLY(r.W(2) = satsw((int16_t)d->W(4) - (int16_t)d->W(5)));
+    XMM_ONLY(r.W(3) = satsw((int16_t)d->W(6) - (int16_t)d->W(7)));
+    r.W((2 << SHIFT) + 0) = satsw((int16_t)s->W(0) - (int16_t)s->W(1));
+    r.W((2 << SHIFT) + 1) = satsw((int16_t)s->W(2) - (int16_t)s->W(3));
+    XMM_ONLY(r.W(6) = satsw((int16_t)s->W(4) - (int16_t)s->W(5)));
+    XMM_ONLY(r.W(7) = satsw((int16_t)s->W(6) - (int16_t)s->W(7)));
+    *d = r;
 }
 
 #define FABSB(_, x) (x > INT8_MAX  ? -(int8_t)x : x)
 #define FABSW(_, x) (x > INT16_MAX ? -(int16_t)x : x)
 #define FABSL(_, x) ((x > INT32_MAX && x != 0x80000000) ? -(int32_t)x : x)
-SSE_HELPER_B(helper_pabsb, FABSB)
-SSE_HELPER_W(helper_pabsw, FABSW)
-SSE_HELPER_L(helper_pabsd, FABSL)
+SSE_HELPER_HOST_FEAT(B, helper_pabsb, FABSB, sse_host_abs_epi8, "ssse3", have_ssse3)
+SSE_HELPER_HOST_FEAT(W, helper_pabsw, FABSW, sse_host_abs_epi16, "ssse3", have_ssse3)
+SSE_HELPER_HOST_FEAT(L, helper_pabsd, FABSL, sse_host_abs_epi32, "ssse3", have_ssse3)
 
 #define FMULHRSW(d, s) (((int16_t) d * (int16_t)s + 0x4000) >> 15)
-SSE_HELPER_W(helper_pmulhrsw, FMULHRSW)
+SSE_HELPER_HOST_FEAT(W, helper_pmulhrsw, FMULHRSW, _mm_mulhrs_epi16, "ssse3", have_ssse3)
 
 #define FSIGNB(d, s) (s <= INT8_MAX  ? s ? d : 0 : -(int8_t)d)
 #define FSIGNW(d, s) (s <= INT16_MAX ? s ? d : 0 : -(int16_t)d)
 #define FSIGNL(d, s) (s <= INT32_MAX ? s ? d : 0 : -(int32_t)d)
-SSE_HELPER_B(helper_psignb, FSIGNB)
-SSE_HELPER_W(helper_psignw, FSIGNW)
-SSE_HELPER_L(helper_psignd, FSIGNL)
+SSE_HELPER_HOST_FEAT(B, helper_psignb, FSIGNB, _mm_sign_epi8, "ssse3", have_ssse3)
+SSE_HELPER_HOST_FEAT(W, helper_psignw, FSIGNW, _mm_sign_epi16, "ssse3", have_ssse3)
+SSE_HELPER_HOST_FEAT(L, helper_psignd, FSIGNL, _mm_sign_epi32, "ssse3", have_ssse3)
 
 void glue(helper_palignr, SUFFIX)(CPUX86State *env, Reg *d, Reg *s,
                                   int32_t shift)
@@ -1644,6 +1840,7 @@ SSE_HELPER_F(helper_pmovzxwd, L, 4, s->W)
 SSE_HELPER_F(helper_pmovzxwq, Q, 2, s->W)
 SSE_HELPER_F(helper_pmovzxdq, Q, 2, s->L)
 
+/* two scalar multiplies beat pmuldq's latency, keep it in C */
 void glue(helper_pmuldq, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     d->Q(0) = (int64_t)(int32_t) d->L(0) * (int32_t) s->L(0);
@@ -1651,35 +1848,48 @@ void glue(helper_pmuldq, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 }
 
 #define FCMPEQQ(d, s) (d == s ? -1 : 0)
-SSE_HELPER_Q(helper_pcmpeqq, FCMPEQQ)
+SSE_HELPER_HOST_FEAT(Q, helper_pcmpeqq, FCMPEQQ, _mm_cmpeq_epi64, "sse4.1", have_sse41)
+
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_packusdw, "sse4.1", _mm_packus_epi32)
+#endif
 
 void glue(helper_packusdw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
-    d->W(0) = satuw((int32_t) d->L(0));
-    d->W(1) = satuw((int32_t) d->L(1));
-    d->W(2) = satuw((int32_t) d->L(2));
-    d->W(3) = satuw((int32_t) d->L(3));
-    d->W(4) = satuw((int32_t) s->L(0));
-    d->W(5) = satuw((int32_t) s->L(1));
-    d->W(6) = satuw((int32_t) s->L(2));
-    d->W(7) = satuw((int32_t) s->L(3));
+    Reg r;
+
+#ifdef SSE_HOST
+    if (have_sse41) {
+        glue(helper_packusdw, _host)(d, s);
+        return;
+    }
+#endif
+    r.W(0) = satuw((int32_t) d->L(0));
+    r.W(1) = satuw((int32_t) d->L(1));
+    r.W(2) = satuw((int32_t) d->L(2));
+    r.W(3) = satuw((int32_t) d->L(3));
+    r.W(4) = satuw((int32_t) s->L(0));
+    r.W(5) = satuw((int32_t) s->L(1));
+    r.W(6) = satuw((int32_t) s->L(2));
+    r.W(7) = satuw((int32_t) s->L(3));
+    *d = r;
 }
 
 #define FMINSB(d, s) MIN((int8_t)d, (int8_t)s)
 #define FMINSD(d, s) MIN((int32_t)d, (int32_t)s)
 #define FMAXSB(d, s) MAX((int8_t)d, (int8_t)s)
 #define FMAXSD(d, s) MAX((int32_t)d, (int32_t)s)
-SSE_HELPER_B(helper_pminsb, FMINSB)
-SSE_HELPER_L(helper_pminsd, FMINSD)
-SSE_HELPER_W(helper_pminuw, MIN)
-SSE_HELPER_L(helper_pminud, MIN)
-SSE_HELPER_B(helper_pmaxsb, FMAXSB)
-SSE_HELPER_L(helper_pmaxsd, FMAXSD)
-SSE_HELPER_W(helper_pmaxuw, MAX)
-SSE_HELPER_L(helper_pmaxud, MAX)
+SSE_HELPER_HOST_FEAT(B, helper_pminsb, FMINSB, _mm_min_epi8, "sse4.1", have_sse41)
+SSE_HELPER_HOST_FEAT(L, helper_pminsd, FMINSD, _mm_min_epi32, "sse4.1", have_sse41)
+SSE_HELPER_HOST_FEAT(W, helper_pminuw, MIN, _mm_min_epu16, "sse4.1", have_sse41)
+SSE_HELPER_HOST_FEAT(L, helper_pminud, MIN, _mm_min_epu32, "sse4.1", have_sse41)
+SSE_HELPER_HOST_FEAT(B, helper_pmaxsb, FMAXSB, _mm_max_epi8, "sse4.1", have_sse41)
+SSE_HELPER_HOST_FEAT(L, helper_pmaxsd, FMAXSD, _mm_max_epi32, "sse4.1", have_sse41)
+SSE_HELPER_HOST_FEAT(W, helper_pmaxuw, MAX, _mm_max_epu16, "sse4.1", have_sse41)
+SSE_HELPER_HOST_FEAT(L, helper_pmaxud, MAX, _mm_max_epu32, "sse4.1", have_sse41)
 
 #define FMULLD(d, s) ((int64_t)d * (int32_t)s)
-SSE_HELPER_L(helper_pmulld, FMULLD)
+SSE_HELPER_HOST_FEAT(L, helper_pmulld, FMULLD, _mm_mullo_epi32, "sse4.1", have_sse41)
 
 void glue(helper_phminposuw, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
@@ -2190,11 +2400,30 @@ target_ulong helper_popcnt(CPUX86State *env, target_ulong n, uint32_t type)
 #endif
 }
 
+#ifdef SSE_HOST
+static __attribute__((target("pclmul")))
+void glue(helper_pclmulqdq, _host)(Reg *d, Reg *s, uint32_t ctrl)
+{
+    /* the insn wants an immediate, so pick the halves here */
+    __m128i a = _mm_cvtsi64_si128(d->Q((ctrl & 1) != 0));
+    __m128i b = _mm_cvtsi64_si128(s->Q((ctrl & 16) != 0));
+
+    SSE_HOST_ST(d, _mm_clmulepi64_si128(a, b, 0));
+}
+#endif
+
 void glue(helper_pclmulqdq, SUFFIX)(CPUX86State *env, Reg *d, Reg *s,
                                     uint32_t ctrl)
 {
     uint64_t ah, al, b, resh, resl;
 
+#ifdef SSE_HOST
+    if (have_pclmul) {
+        glue(helper_pclmulqdq, _host)(d, s, ctrl);
+        return;
+    }
+#endif
+
     ah = 0;
     al = d->Q((ctrl & 1) != 0);
     b = s->Q((ctrl & 16) != 0);
@@ -2214,12 +2443,23 @@ void glue(helper_pclmulqdq, SUFFIX)(CPUX86State *env, Reg *d, Reg *s,
     d->Q(1) = resh;
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_aesdec, "aes", _mm_aesdec_si128)
+#endif
+
 void glue(helper_aesdec, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     int i;
     Reg st = *d;
     Reg rk = *s;
 
+#ifdef SSE_HOST
+    if (have_aesni) {
+        glue(helper_aesdec, _host)(d, s);
+        return;
+    }
+#endif
+
     for (i = 0 ; i < 4 ; i++) {
         d->L(i) = rk.L(i) ^ bswap32(AES_Td0[st.B(AES_ishifts[4*i+0])] ^
                                     AES_Td1[st.B(AES_ishifts[4*i+1])] ^
@@ -2228,23 +2468,45 @@ void glue(helper_aesdec, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
     }
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_aesdeclast, "aes", _mm_aesdeclast_si128)
+#endif
+
 void glue(helper_aesdeclast, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     int i;
     Reg st = *d;
     Reg rk = *s;
 
+#ifdef SSE_HOST
+    if (have_aesni) {
+        glue(helper_aesdeclast, _host)(d, s);
+        return;
+    }
+#endif
+
     for (i = 0; i < 16; i++) {
         d->B(i) = rk.B(i) ^ (AES_Td4[st.B(AES_ishifts[i])] & 0xff);
     }
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_aesenc, "aes", _mm_aesenc_si128)
+#endif
+
 void glue(helper_aesenc, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     int i;
     Reg st = *d;
     Reg rk = *s;
 
+#ifdef SSE_HOST
+    if (have_aesni) {
+        glue(helper_aesenc, _host)(d, s);
+        return;
+    }
+#endif
+
     for (i = 0 ; i < 4 ; i++) {
         d->L(i) = rk.L(i) ^ bswap32(AES_Te0[st.B(AES_shifts[4*i+0])] ^
                                     AES_Te1[st.B(AES_shifts[4*i+1])] ^
@@ -2253,23 +2515,45 @@ void glue(helper_aesenc, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
     }
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_aesenclast, "aes", _mm_aesenclast_si128)
+#endif
+
 void glue(helper_aesenclast, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     int i;
     Reg st = *d;
     Reg rk = *s;
 
+#ifdef SSE_HOST
+    if (have_aesni) {
+        glue(helper_aesenclast, _host)(d, s);
+        return;
+    }
+#endif
+
     for (i = 0; i < 16; i++) {
         d->B(i) = rk.B(i) ^ (AES_Te4[st.B(AES_shifts[i])] & 0xff);
     }
 
 }
 
+#ifdef SSE_HOST
+SSE_HOST_FN(helper_aesimc, "aes", sse_host_aesimc)
+#endif
+
 void glue(helper_aesimc, SUFFIX)(CPUX86State *env, Reg *d, Reg *s)
 {
     int i;
     Reg tmp = *s;
 
+#ifdef SSE_HOST
+    if (have_aesni) {
+        glue(helper_aesimc, _host)(d, s);
+        return;
+    }
+#endif
+
     for (i = 0 ; i < 4 ; i++) {
         d->L(i) = bswap32(AES_Td0[AES_Te4[tmp.B(4*i+0)] & 0xff] ^
                           AES_Td1[AES_Te4[tmp.B(4*i+1)] & 0xff] ^
@@ -2295,6 +2579,18 @@ void glue(helper_aeskeygenassist, SUFFIX)(CPUX86State *env, Reg *d, Reg *s,
 
 #undef SHIFT
 #undef XMM_ONLY
+#ifdef SSE_HOST
+#undef SSE_HOST
+#undef SSE_HOST_LD
+#undef SSE_HOST_ST
+#undef SSE_HOST_FN
+#undef sse_host_abs_epi8
+#undef sse_host_abs_epi16
+#undef sse_host_abs_epi32
+#undef sse_host_aesimc
+#endif
+#undef SSE_HELPER_HOST
+#undef SSE_HELPER_HOST_FEAT
 #undef Reg
 #undef B
 #undef W
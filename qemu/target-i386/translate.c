@@ -106,6 +106,7 @@ typedef struct DisasContext {
 
     // Unicorn
     target_ulong prev_pc; /* save address of the previous instruction */
+    bool fpu_dirty; /* the TB already sets cpu->fpu_dirty */
 } DisasContext;
 
 static void gen_eob(DisasContext *s);
@@ -1449,8 +1450,64 @@ static inline void gen_repz_ ## op(DisasContext *s, TCGMemOp ot,              \
     gen_jmp(s, cur_eip);                                                      \
 }
 
-GEN_REPZ(movs)
-GEN_REPZ(stos)
+/* Unicorn: without memory hooks, the elements that are in RAM are moved
+   in bulk by a helper before falling back to the loop above. A code hook
+   on the instruction also keeps the per-element loop, so it still sees
+   one callback per iteration. */
+static inline bool gen_rep_bulk_ok(DisasContext *s, target_ulong cur_eip)
+{
+    return !HOOK_EXISTS(s->uc, UC_HOOK_MEM_READ) &&
+        !HOOK_EXISTS(s->uc, UC_HOOK_MEM_READ_AFTER) &&
+        !HOOK_EXISTS(s->uc, UC_HOOK_MEM_WRITE) &&
+        !HOOK_EXISTS_BOUNDED(s->uc, UC_HOOK_CODE, cur_eip + s->cs_base);
+}
+
+static inline void gen_movs_bulk(DisasContext *s, TCGMemOp ot)
+{
+    TCGContext *tcg_ctx = s->uc->tcg_ctx;
+    TCGv cpu_A0 = *(TCGv *)tcg_ctx->cpu_A0;
+    TCGv src = tcg_temp_new(tcg_ctx);
+
+    gen_string_movl_A0_ESI(s);
+    tcg_gen_mov_tl(tcg_ctx, src, cpu_A0);
+    gen_string_movl_A0_EDI(s);
+    gen_helper_rep_movs(tcg_ctx, tcg_ctx->cpu_env, src, cpu_A0,
+                        tcg_const_i32(tcg_ctx, ot), tcg_const_i32(tcg_ctx, s->aflag));
+    tcg_temp_free(tcg_ctx, src);
+}
+
+static inline void gen_stos_bulk(DisasContext *s, TCGMemOp ot)
+{
+    TCGContext *tcg_ctx = s->uc->tcg_ctx;
+    TCGv cpu_A0 = *(TCGv *)tcg_ctx->cpu_A0;
+
+    gen_string_movl_A0_EDI(s);
+    gen_helper_rep_stos(tcg_ctx, tcg_ctx->cpu_env, cpu_A0,
+                        tcg_const_i32(tcg_ctx, ot), tcg_const_i32(tcg_ctx, s->aflag));
+}
+
+#define GEN_REPZ_BULK(op)                                                     \
+static inline void gen_repz_ ## op(DisasContext *s, TCGMemOp ot,              \
+                                 target_ulong cur_eip, target_ulong next_eip) \
+{                                                                             \
+    int l2;                                                                   \
+    gen_update_cc_op(s);                                                      \
+    l2 = gen_jz_ecx_string(s, next_eip);                                      \
+    if (gen_rep_bulk_ok(s, cur_eip)) {                                        \
+        gen_ ## op ## _bulk(s, ot);                                           \
+        gen_op_jz_ecx(s->uc->tcg_ctx, s->aflag, l2);                          \
+    }                                                                         \
+    gen_ ## op(s, ot);                                                        \
+    gen_op_add_reg_im(s->uc->tcg_ctx, s->aflag, R_ECX, -1);                   \
+    /* a loop would cause two single step exceptions if ECX = 1               \
+       before rep string_insn */                                              \
+    if (!s->jmp_opt)                                                          \
+        gen_op_jz_ecx(s->uc->tcg_ctx, s->aflag, l2);                          \
+    gen_jmp(s, cur_eip);                                                      \
+}
+
+GEN_REPZ_BULK(movs)
+GEN_REPZ_BULK(stos)
 GEN_REPZ(lods)
 GEN_REPZ(ins)
 GEN_REPZ(outs)
@@ -3515,6 +3572,22 @@ static const struct SSEOpHelper_eppi sse_op_table7[256] = {
 #endif
 };
 
+/* Unicorn: note that the TB changes FPU/SSE registers, see uc_context_save() */
+static void gen_fpu_dirty(DisasContext *s)
+{
+    TCGContext *tcg_ctx = s->uc->tcg_ctx;
+    TCGv_i32 tmp;
+
+    if (s->fpu_dirty) {
+        return;
+    }
+    tmp = tcg_const_i32(tcg_ctx, 1);
+    tcg_gen_st_i32(tcg_ctx, tmp, tcg_ctx->cpu_env,
+                   offsetof(CPUState, fpu_dirty) - ENV_OFFSET);
+    tcg_temp_free_i32(tcg_ctx, tmp);
+    s->fpu_dirty = true;
+}
+
 static void gen_sse(CPUX86State *env, DisasContext *s, int b,
                     target_ulong pc_start, int rex_r)
 {
@@ -3540,6 +3613,7 @@ static void gen_sse(CPUX86State *env, DisasContext *s, int b,
     TCGv **cpu_T = (TCGv **)tcg_ctx->cpu_T;
     TCGv **cpu_regs = (TCGv **)tcg_ctx->cpu_regs;
 
+    gen_fpu_dirty(s);
     b &= 0xff;
     if (s->prefix & PREFIX_DATA)
         b1 = 1;
@@ -6356,6 +6430,7 @@ static target_ulong disas_insn(CPUX86State *env, DisasContext *s,
             gen_exception(s, EXCP07_PREX, pc_start - s->cs_base);
             break;
         }
+        gen_fpu_dirty(s);
         modrm = cpu_ldub_code(env, s->pc++);
         mod = (modrm >> 6) & 3;
         rm = modrm & 7;
@@ -8351,6 +8426,10 @@ static target_ulong disas_insn(CPUX86State *env, DisasContext *s,
         modrm = cpu_ldub_code(env, s->pc++);
         mod = (modrm >> 6) & 3;
         op = (modrm >> 3) & 7;
+        if (op == 1 || op == 2) {
+            /* fxrstor, ldmxcsr */
+            gen_fpu_dirty(s);
+        }
         switch(op) {
         case 0: /* fxsave */
             if (mod == 3 || !(s->cpuid_features & CPUID_FXSR) ||
@@ -8609,6 +8688,7 @@ static inline void gen_intermediate_code_internal(uint8_t *gen_opc_cc_op,
     flags = tb->flags;
 
     dc->uc = env->uc;
+    dc->fpu_dirty = false;
     dc->pe = (flags >> HF_PE_SHIFT) & 1;
     dc->code32 = (flags >> HF_CS32_SHIFT) & 1;
     dc->ss32 = (flags >> HF_SS32_SHIFT) & 1;
@@ -8703,17 +8783,25 @@ static inline void gen_intermediate_code_internal(uint8_t *gen_opc_cc_op,
     if (max_insns == 0)
         max_insns = CF_COUNT_MASK;
 
+    // Unicorn: checked before the hooks, which must not run if the block exits early
+    gen_tb_start(tcg_ctx);
+
+    // Unicorn: stop at a breakpoint or exit before this block runs
+    if (uc_stop_addr_exists(env->uc, pc_start)) {
+        gen_jmp_im(dc, pc_start - dc->cs_base);
+        gen_uc_stop_addr(tcg_ctx, env->uc, pc_start);
+    }
+
     // Unicorn: trace this block on request
     // Only hook this block if the previous block was not truncated due to space
     if (!env->uc->block_full && HOOK_EXISTS_BOUNDED(env->uc, UC_HOOK_BLOCK, pc_start)) {
         env->uc->block_addr = pc_start;
-        env->uc->size_arg = tcg_ctx->gen_opparam_buf - tcg_ctx->gen_opparam_ptr + 1;
+        env->uc->size_arg = tcg_ctx->gen_opparam_ptr - tcg_ctx->gen_opparam_buf + 1;
         gen_uc_tracecode(tcg_ctx, 0xf8f8f8f8, UC_HOOK_BLOCK_IDX, env->uc, pc_start);
     } else {
         env->uc->size_arg = -1;
     }
 
-    gen_tb_start(tcg_ctx);
     for(;;) {
         if (unlikely(!QTAILQ_EMPTY(&cs->breakpoints))) {
             QTAILQ_FOREACH(bp, &cs->breakpoints, entry) {
@@ -8739,6 +8827,13 @@ static inline void gen_intermediate_code_internal(uint8_t *gen_opc_cc_op,
         //if (num_insns + 1 == max_insns && (tb->cflags & CF_LAST_IO))
         //    gen_io_start();
 
+        // Unicorn: a breakpoint or exit always starts a new block, which
+        // stops by itself, so this one can still be chained to it
+        if (pc_ptr != pc_start && uc_stop_addr_exists(env->uc, pc_ptr)) {
+            gen_jmp(dc, pc_ptr - dc->cs_base);
+            break;
+        }
+
         // Unicorn: save current PC address to sync EIP
         dc->prev_pc = pc_ptr;
         pc_ptr = disas_insn(env, dc, pc_ptr);
@@ -23,6 +23,55 @@ extern void helper_rdmsr(CPUX86State *env);
 
 const int X86_REGS_STORAGE_SIZE = offsetof(CPUX86State, tlb_table);
 
+// register groups of CPUX86State, for uc_context_alloc_groups()
+static const uc_context_range x86_context_ranges[] = {
+    { UC_CTX_GPR, 0, offsetof(CPUX86State, hflags) },
+    { UC_CTX_SYS, offsetof(CPUX86State, hflags), offsetof(CPUX86State, fpstt) },
+    { UC_CTX_FPU, offsetof(CPUX86State, fpstt), offsetof(CPUX86State, sysenter_cs) },
+    { UC_CTX_SYS, offsetof(CPUX86State, sysenter_cs), offsetof(CPUX86State, tlb_table) },
+    { 0 }
+};
+
+// control registers, A20 mask & EFER decide how addresses are translated
+static const uc_context_range x86_context_mmu[] = {
+    { UC_CTX_SYS, offsetof(CPUX86State, cr), offsetof(CPUX86State, bnd_regs) },
+    { UC_CTX_SYS, offsetof(CPUX86State, efer), offsetof(CPUX86State, star) },
+    { 0 }
+};
+
+static int x86_reg_group(unsigned int regid)
+{
+    if ((regid >= UC_X86_REG_FP0 && regid <= UC_X86_REG_MM7) ||
+            (regid >= UC_X86_REG_ST0 && regid <= UC_X86_REG_ZMM31)) {
+        return UC_CTX_FPU;
+    }
+
+    switch(regid) {
+        default:
+            if (regid >= UC_X86_REG_CR0 && regid <= UC_X86_REG_DR15) {
+                return UC_CTX_SYS;
+            }
+            return UC_CTX_GPR;
+        case UC_X86_REG_FPSW:
+        case UC_X86_REG_FPCW:
+        case UC_X86_REG_FPTAG:
+        case UC_X86_REG_MXCSR:
+            return UC_CTX_FPU;
+        case UC_X86_REG_CS:
+        case UC_X86_REG_DS:
+        case UC_X86_REG_ES:
+        case UC_X86_REG_FS:
+        case UC_X86_REG_GS:
+        case UC_X86_REG_SS:
+        case UC_X86_REG_IDTR:
+        case UC_X86_REG_GDTR:
+        case UC_X86_REG_LDTR:
+        case UC_X86_REG_TR:
+        case UC_X86_REG_MSR:
+            return UC_CTX_SYS;
+    }
+}
+
 static void x86_set_pc(struct uc_struct *uc, uint64_t address)
 {
     ((CPUX86State *)uc->current_cpu->env_ptr)->eip = address;
@@ -34,8 +83,11 @@ void x86_release(void *ctx)
 {
     int i;
     TCGContext *s = (TCGContext *) ctx;
+    CPUState *cpu;
 
-    cpu_breakpoint_remove_all(s->uc->cpu, BP_CPU);
+    CPU_FOREACH(s->uc, cpu) {
+        cpu_breakpoint_remove_all(cpu, BP_CPU);
+    }
 
     release_common(ctx);
 
@@ -62,7 +114,7 @@ void x86_reg_reset(struct uc_struct *uc)
     CPUArchState *env = uc->cpu->env_ptr;
 
     env->features[FEAT_1_EDX] = CPUID_CX8 | CPUID_CMOV | CPUID_SSE2 | CPUID_FXSR | CPUID_SSE | CPUID_CLFLUSH;
-    env->features[FEAT_1_ECX] = CPUID_EXT_SSSE3 | CPUID_EXT_SSE41 | CPUID_EXT_SSE42 | CPUID_EXT_AES | CPUID_EXT_CX16;
+    env->features[FEAT_1_ECX] = CPUID_EXT_SSSE3 | CPUID_EXT_SSE41 | CPUID_EXT_SSE42 | CPUID_EXT_AES | CPUID_EXT_PCLMULQDQ | CPUID_EXT_CX16;
     env->features[FEAT_8000_0001_EDX] = CPUID_EXT2_3DNOW | CPUID_EXT2_RDTSCP;
     env->features[FEAT_8000_0001_ECX] = CPUID_EXT3_LAHF_LM | CPUID_EXT3_ABM | CPUID_EXT3_SKINIT | CPUID_EXT3_CR8LEG;
     env->features[FEAT_7_0_EBX] = CPUID_7_0_EBX_BMI1 | CPUID_7_0_EBX_BMI2 | CPUID_7_0_EBX_ADX | CPUID_7_0_EBX_SMAP;
@@ -132,7 +184,7 @@ void x86_reg_reset(struct uc_struct *uc)
     // TODO: reset other registers in CPUX86State qemu/target-i386/cpu.h
 
     // properly initialize internal setup for each mode
-    switch(uc->mode) {
+    switch(uc->mode & ~UC_MODE_X87_FAST) {
         default:
             break;
         case UC_MODE_16:
@@ -319,7 +371,7 @@ int x86_reg_read(struct uc_struct *uc, unsigned int *regs, void **vals, int coun
                 }
         }
 
-        switch(uc->mode) {
+        switch(uc->mode & ~UC_MODE_X87_FAST) {
             default:
                 break;
             case UC_MODE_16:
@@ -888,7 +940,7 @@ int x86_reg_write(struct uc_struct *uc, unsigned int *regs, void *const *vals, i
                 }
         }
 
-        switch(uc->mode) {
+        switch(uc->mode & ~UC_MODE_X87_FAST) {
             default:
                 break;
 
@@ -1462,6 +1514,9 @@ void x86_uc_init(struct uc_struct* uc)
     uc->set_pc = x86_set_pc;
     uc->stop_interrupt = x86_stop_interrupt;
     uc->insn_hook_validate = x86_insn_hook_validate;
+    uc->context_ranges = x86_context_ranges;
+    uc->context_mmu = x86_context_mmu;
+    uc->reg_group = x86_reg_group;
     uc_common_init(uc);
 }
 
@@ -168,7 +168,8 @@ static void m68k_cpu_initfn(struct uc_struct *uc, Object *obj, void *opaque)
     cs->env_ptr = env;
     cpu_exec_init(env, opaque);
 
-    if (tcg_enabled(uc)) {
+    /* the TCG globals are shared by all vCPUs */
+    if (tcg_enabled(uc) && cs->cpu_index == 0) {
         m68k_tcg_init(uc);
     }
 }
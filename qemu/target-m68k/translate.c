@@ -3104,21 +3104,34 @@ gen_intermediate_code_internal(M68kCPU *cpu, TranslationBlock *tb,
         goto done_generating;
     }
 
+    // Unicorn: checked before the hooks, which must not run if the block exits early
+    gen_tb_start(tcg_ctx);
+
+    // Unicorn: stop at a breakpoint or exit before this block runs
+    if (uc_stop_addr_exists(env->uc, pc_start)) {
+        tcg_gen_movi_i32(tcg_ctx, *(TCGv *)tcg_ctx->QREG_PC, pc_start);
+        gen_uc_stop_addr(tcg_ctx, env->uc, pc_start);
+    }
+
     // Unicorn: trace this block on request
     // Only hook this block if it is not broken from previous translation due to
     // full translation cache
     if (!env->uc->block_full && HOOK_EXISTS_BOUNDED(env->uc, UC_HOOK_BLOCK, pc_start)) {
         // save block address to see if we need to patch block size later
         env->uc->block_addr = pc_start;
-        env->uc->size_arg = tcg_ctx->gen_opparam_buf - tcg_ctx->gen_opparam_ptr + 1;
+        env->uc->size_arg = tcg_ctx->gen_opparam_ptr - tcg_ctx->gen_opparam_buf + 1;
         gen_uc_tracecode(tcg_ctx, 0xf8f8f8f8, UC_HOOK_BLOCK_IDX, env->uc, pc_start);
     } else {
         env->uc->size_arg = -1;
     }
 
-    gen_tb_start(tcg_ctx);
     do {
         pc_offset = dc->pc - pc_start;
+        // Unicorn: a breakpoint or exit always starts a new block
+        if (dc->pc != pc_start && uc_stop_addr_exists(env->uc, dc->pc)) {
+            break;
+        }
+
         if (unlikely(!QTAILQ_EMPTY(&cs->breakpoints))) {
             QTAILQ_FOREACH(bp, &cs->breakpoints, entry) {
                 if (bp->pc == dc->pc) {
@@ -112,7 +112,8 @@ static void mips_cpu_initfn(struct uc_struct *uc, Object *obj, void *opaque)
     cs->env_ptr = env;
     cpu_exec_init(env, opaque);
 
-    if (tcg_enabled(uc)) {
+    /* the TCG globals are shared by all vCPUs */
+    if (tcg_enabled(uc) && cs->cpu_index == 0) {
         mips_tcg_init(uc);
     }
 }
@@ -1,4 +1,5 @@
 DEF_HELPER_4(uc_tracecode, void, i32, i32, ptr, i64)
+DEF_HELPER_2(uc_stop_addr, void, ptr, i64)
 
 DEF_HELPER_3(raise_exception_err, noreturn, env, i32, int)
 DEF_HELPER_2(raise_exception, noreturn, env, i32)
@@ -851,6 +852,37 @@ DEF_HELPER_5(msa_hadd_u_df, void, env, i32, i32, i32, i32)
 DEF_HELPER_5(msa_hsub_s_df, void, env, i32, i32, i32, i32)
 DEF_HELPER_5(msa_hsub_u_df, void, env, i32, i32, i32, i32)
 
+/* Unicorn: per data format versions of common 3R ops, see msa_helper.c */
+#define DEF_HELPER_MSA_3R_DF(name) \
+    DEF_HELPER_4(msa_ ## name ## _b, void, env, i32, i32, i32) \
+    DEF_HELPER_4(msa_ ## name ## _h, void, env, i32, i32, i32) \
+    DEF_HELPER_4(msa_ ## name ## _w, void, env, i32, i32, i32) \
+    DEF_HELPER_4(msa_ ## name ## _d, void, env, i32, i32, i32)
+DEF_HELPER_MSA_3R_DF(addv)
+DEF_HELPER_MSA_3R_DF(subv)
+DEF_HELPER_MSA_3R_DF(mulv)
+DEF_HELPER_MSA_3R_DF(ceq)
+DEF_HELPER_MSA_3R_DF(clt_s)
+DEF_HELPER_MSA_3R_DF(clt_u)
+DEF_HELPER_MSA_3R_DF(cle_s)
+DEF_HELPER_MSA_3R_DF(cle_u)
+DEF_HELPER_MSA_3R_DF(max_s)
+DEF_HELPER_MSA_3R_DF(max_u)
+DEF_HELPER_MSA_3R_DF(min_s)
+DEF_HELPER_MSA_3R_DF(min_u)
+DEF_HELPER_MSA_3R_DF(adds_s)
+DEF_HELPER_MSA_3R_DF(adds_u)
+DEF_HELPER_MSA_3R_DF(subs_s)
+DEF_HELPER_MSA_3R_DF(subs_u)
+DEF_HELPER_MSA_3R_DF(ilvr)
+DEF_HELPER_MSA_3R_DF(ilvl)
+DEF_HELPER_MSA_3R_DF(ilvev)
+DEF_HELPER_MSA_3R_DF(ilvod)
+DEF_HELPER_MSA_3R_DF(pckev)
+DEF_HELPER_MSA_3R_DF(pckod)
+DEF_HELPER_MSA_3R_DF(vshf)
+#undef DEF_HELPER_MSA_3R_DF
+
 DEF_HELPER_5(msa_sldi_df, void, env, i32, i32, i32, i32)
 DEF_HELPER_5(msa_splati_df, void, env, i32, i32, i32, i32)
 DEF_HELPER_5(msa_copy_s_df, void, env, i32, i32, i32, i32)
@@ -1225,6 +1225,266 @@ MSA_FN_DF(vshf_df)
 #undef MSA_LOOP_COND
 #undef MSA_FN_DF
 
+/* Unicorn: the common integer 3R ops (add, sub, mul, compare, min/max,
+ * saturating add/sub) and the shuffles also come as one helper per data
+ * format, which the translator picks, so the switch on df is not paid
+ * on every call.  On x86_64 hosts each runs as a few SSE instructions
+ * on the whole register; formats the host has no instruction for go to
+ * the generic helper with a constant df.
+ */
+#if defined(__x86_64__) && defined(__GNUC__)
+#define MSA_HOST
+#include <immintrin.h>
+#include "tcg.h"
+
+#define have_sse2 1
+
+/* The target attribute for the code behind each flag */
+#define MSA_TARGET_have_sse2 "sse2"
+#define MSA_TARGET_have_ssse3 "ssse3"
+#define MSA_TARGET_have_sse41 "sse4.1"
+
+#define MSA_HOST_FN(feat) static __attribute__((target(feat)))
+
+#define MSA_LOAD(pwr) _mm_loadu_si128((__m128i *)(pwr))
+#define MSA_ONES _mm_set1_epi32(-1)
+
+/* There is no byte multiply: do the even and odd bytes in 16 bit lanes. */
+MSA_HOST_FN("sse2") __m128i msa_mulv_b_sse(__m128i s, __m128i t)
+{
+    __m128i even = _mm_mullo_epi16(s, t);
+    __m128i odd = _mm_mullo_epi16(_mm_srli_epi16(s, 8), _mm_srli_epi16(t, 8));
+
+    return _mm_or_si128(_mm_and_si128(even, _mm_set1_epi16(0xff)),
+                        _mm_slli_epi16(odd, 8));
+}
+
+/* Unsigned compares are signed ones with the sign bits flipped. */
+#define MSA_BIAS(x, bits) \
+    _mm_xor_si128(x, _mm_set1_epi ## bits(INT ## bits ## _MIN))
+
+/* Even or odd elements of each operand: shift them to the bottom of the
+ * next wider lane, then pack with a saturation that cannot trigger.
+ */
+#define MSA_EVEN16(x) _mm_srai_epi32(_mm_slli_epi32(x, 16), 16)
+#define MSA_SHUFFLE_W(s, t, imm) \
+    _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(t), \
+                                    _mm_castsi128_ps(s), imm))
+
+/* vshf.b: control bytes with bit 6 or 7 set give 0, the others pick
+ * byte k of ws:wt.  pshufb picks from a single register by the low four
+ * bits, so look up both and choose by bit 4.
+ */
+MSA_HOST_FN("ssse3") __m128i msa_vshf_b_ssse3(__m128i c, __m128i s,
+                                              __m128i t)
+{
+    __m128i k = _mm_and_si128(c, _mm_set1_epi8(0x1f));
+    __m128i from_s = _mm_cmpgt_epi8(k, _mm_set1_epi8(0x0f));
+    __m128i zero = _mm_cmpeq_epi8(_mm_and_si128(c, _mm_set1_epi8(0xc0)),
+                                  _mm_setzero_si128());
+    __m128i r = _mm_or_si128(_mm_and_si128(from_s, _mm_shuffle_epi8(s, k)),
+                             _mm_andnot_si128(from_s,
+                                              _mm_shuffle_epi8(t, k)));
+
+    return _mm_and_si128(r, zero);
+}
+
+#define MSA_HOST_CALL(feat, name, pwd, pws, pwt) \
+    if (feat) { \
+        msa_ ## name ## _host(pwd, pws, pwt); \
+        return; \
+    }
+
+/* EXPR computes the new wd from s, t (and d, the old wd).  */
+#define MSA_3R_HOST(name, target, expr) \
+MSA_HOST_FN(target) void msa_ ## name ## _host(wr_t *pwd, wr_t *pws, \
+                                             wr_t *pwt) \
+{ \
+    __m128i s = MSA_LOAD(pws); \
+    __m128i t = MSA_LOAD(pwt); \
+    __m128i d = MSA_LOAD(pwd); \
+    (void)d; \
+    _mm_storeu_si128((__m128i *)pwd, expr); \
+}
+#else
+#define MSA_3R_HOST(name, target, expr)
+#define MSA_HOST_CALL(feat, name, pwd, pws, pwt)
+#endif
+
+#define MSA_3R_FN(func, DF, df, feat, expr) \
+MSA_3R_HOST(func ## _ ## DF, MSA_TARGET_ ## feat, expr) \
+void helper_msa_ ## func ## _ ## DF(CPUMIPSState *env, uint32_t wd, \
+                                   uint32_t ws, uint32_t wt) \
+{ \
+    MSA_HOST_CALL(feat, func ## _ ## DF, &env->active_fpu.fpr[wd].wr, \
+                  &env->active_fpu.fpr[ws].wr, \
+                  &env->active_fpu.fpr[wt].wr) \
+    helper_msa_ ## func ## _df(env, df, wd, ws, wt); \
+}
+
+/* A format without host code only drops the switch.  */
+#define MSA_3R_C(func, DF, df) \
+void helper_msa_ ## func ## _ ## DF(CPUMIPSState *env, uint32_t wd, \
+                                   uint32_t ws, uint32_t wt) \
+{ \
+    helper_msa_ ## func ## _df(env, df, wd, ws, wt); \
+}
+
+MSA_3R_FN(addv, b, DF_BYTE, have_sse2, _mm_add_epi8(s, t))
+MSA_3R_FN(addv, h, DF_HALF, have_sse2, _mm_add_epi16(s, t))
+MSA_3R_FN(addv, w, DF_WORD, have_sse2, _mm_add_epi32(s, t))
+MSA_3R_FN(addv, d, DF_DOUBLE, have_sse2, _mm_add_epi64(s, t))
+
+MSA_3R_FN(subv, b, DF_BYTE, have_sse2, _mm_sub_epi8(s, t))
+MSA_3R_FN(subv, h, DF_HALF, have_sse2, _mm_sub_epi16(s, t))
+MSA_3R_FN(subv, w, DF_WORD, have_sse2, _mm_sub_epi32(s, t))
+MSA_3R_FN(subv, d, DF_DOUBLE, have_sse2, _mm_sub_epi64(s, t))
+
+MSA_3R_FN(mulv, b, DF_BYTE, have_sse2, msa_mulv_b_sse(s, t))
+MSA_3R_FN(mulv, h, DF_HALF, have_sse2, _mm_mullo_epi16(s, t))
+MSA_3R_FN(mulv, w, DF_WORD, have_sse41, _mm_mullo_epi32(s, t))
+MSA_3R_C(mulv, d, DF_DOUBLE)
+
+MSA_3R_FN(ceq, b, DF_BYTE, have_sse2, _mm_cmpeq_epi8(s, t))
+MSA_3R_FN(ceq, h, DF_HALF, have_sse2, _mm_cmpeq_epi16(s, t))
+MSA_3R_FN(ceq, w, DF_WORD, have_sse2, _mm_cmpeq_epi32(s, t))
+MSA_3R_FN(ceq, d, DF_DOUBLE, have_sse41, _mm_cmpeq_epi64(s, t))
+
+MSA_3R_FN(clt_s, b, DF_BYTE, have_sse2, _mm_cmpgt_epi8(t, s))
+MSA_3R_FN(clt_s, h, DF_HALF, have_sse2, _mm_cmpgt_epi16(t, s))
+MSA_3R_FN(clt_s, w, DF_WORD, have_sse2, _mm_cmpgt_epi32(t, s))
+MSA_3R_C(clt_s, d, DF_DOUBLE)
+
+MSA_3R_FN(clt_u, b, DF_BYTE, have_sse2,
+          _mm_cmpgt_epi8(MSA_BIAS(t, 8), MSA_BIAS(s, 8)))
+MSA_3R_FN(clt_u, h, DF_HALF, have_sse2,
+          _mm_cmpgt_epi16(MSA_BIAS(t, 16), MSA_BIAS(s, 16)))
+MSA_3R_FN(clt_u, w, DF_WORD, have_sse2,
+          _mm_cmpgt_epi32(MSA_BIAS(t, 32), MSA_BIAS(s, 32)))
+MSA_3R_C(clt_u, d, DF_DOUBLE)
+
+MSA_3R_FN(cle_s, b, DF_BYTE, have_sse2,
+          _mm_xor_si128(_mm_cmpgt_epi8(s, t), MSA_ONES))
+MSA_3R_FN(cle_s, h, DF_HALF, have_sse2,
+          _mm_xor_si128(_mm_cmpgt_epi16(s, t), MSA_ONES))
+MSA_3R_FN(cle_s, w, DF_WORD, have_sse2,
+          _mm_xor_si128(_mm_cmpgt_epi32(s, t), MSA_ONES))
+MSA_3R_C(cle_s, d, DF_DOUBLE)
+
+MSA_3R_FN(cle_u, b, DF_BYTE, have_sse2,
+          _mm_xor_si128(_mm_cmpgt_epi8(MSA_BIAS(s, 8), MSA_BIAS(t, 8)),
+                        MSA_ONES))
+MSA_3R_FN(cle_u, h, DF_HALF, have_sse2,
+          _mm_xor_si128(_mm_cmpgt_epi16(MSA_BIAS(s, 16), MSA_BIAS(t, 16)),
+                        MSA_ONES))
+MSA_3R_FN(cle_u, w, DF_WORD, have_sse2,
+          _mm_xor_si128(_mm_cmpgt_epi32(MSA_BIAS(s, 32), MSA_BIAS(t, 32)),
+                        MSA_ONES))
+MSA_3R_C(cle_u, d, DF_DOUBLE)
+
+MSA_3R_FN(max_s, b, DF_BYTE, have_sse41, _mm_max_epi8(s, t))
+MSA_3R_FN(max_s, h, DF_HALF, have_sse2, _mm_max_epi16(s, t))
+MSA_3R_FN(max_s, w, DF_WORD, have_sse41, _mm_max_epi32(s, t))
+MSA_3R_C(max_s, d, DF_DOUBLE)
+
+MSA_3R_FN(max_u, b, DF_BYTE, have_sse2, _mm_max_epu8(s, t))
+MSA_3R_FN(max_u, h, DF_HALF, have_sse41, _mm_max_epu16(s, t))
+MSA_3R_FN(max_u, w, DF_WORD, have_sse41, _mm_max_epu32(s, t))
+MSA_3R_C(max_u, d, DF_DOUBLE)
+
+MSA_3R_FN(min_s, b, DF_BYTE, have_sse41, _mm_min_epi8(s, t))
+MSA_3R_FN(min_s, h, DF_HALF, have_sse2, _mm_min_epi16(s, t))
+MSA_3R_FN(min_s, w, DF_WORD, have_sse41, _mm_min_epi32(s, t))
+MSA_3R_C(min_s, d, DF_DOUBLE)
+
+MSA_3R_FN(min_u, b, DF_BYTE, have_sse2, _mm_min_epu8(s, t))
+MSA_3R_FN(min_u, h, DF_HALF, have_sse41, _mm_min_epu16(s, t))
+MSA_3R_FN(min_u, w, DF_WORD, have_sse41, _mm_min_epu32(s, t))
+MSA_3R_C(min_u, d, DF_DOUBLE)
+
+MSA_3R_FN(adds_s, b, DF_BYTE, have_sse2, _mm_adds_epi8(s, t))
+MSA_3R_FN(adds_s, h, DF_HALF, have_sse2, _mm_adds_epi16(s, t))
+MSA_3R_C(adds_s, w, DF_WORD)
+MSA_3R_C(adds_s, d, DF_DOUBLE)
+
+MSA_3R_FN(adds_u, b, DF_BYTE, have_sse2, _mm_adds_epu8(s, t))
+MSA_3R_FN(adds_u, h, DF_HALF, have_sse2, _mm_adds_epu16(s, t))
+MSA_3R_C(adds_u, w, DF_WORD)
+MSA_3R_C(adds_u, d, DF_DOUBLE)
+
+MSA_3R_FN(subs_s, b, DF_BYTE, have_sse2, _mm_subs_epi8(s, t))
+MSA_3R_FN(subs_s, h, DF_HALF, have_sse2, _mm_subs_epi16(s, t))
+MSA_3R_C(subs_s, w, DF_WORD)
+MSA_3R_C(subs_s, d, DF_DOUBLE)
+
+MSA_3R_FN(subs_u, b, DF_BYTE, have_sse2, _mm_subs_epu8(s, t))
+MSA_3R_FN(subs_u, h, DF_HALF, have_sse2, _mm_subs_epu16(s, t))
+MSA_3R_C(subs_u, w, DF_WORD)
+MSA_3R_C(subs_u, d, DF_DOUBLE)
+
+/* ilvr/ilvl: right (low) or left (high) halves of wt and ws interleaved */
+MSA_3R_FN(ilvr, b, DF_BYTE, have_sse2, _mm_unpacklo_epi8(t, s))
+MSA_3R_FN(ilvr, h, DF_HALF, have_sse2, _mm_unpacklo_epi16(t, s))
+MSA_3R_FN(ilvr, w, DF_WORD, have_sse2, _mm_unpacklo_epi32(t, s))
+MSA_3R_FN(ilvr, d, DF_DOUBLE, have_sse2, _mm_unpacklo_epi64(t, s))
+
+MSA_3R_FN(ilvl, b, DF_BYTE, have_sse2, _mm_unpackhi_epi8(t, s))
+MSA_3R_FN(ilvl, h, DF_HALF, have_sse2, _mm_unpackhi_epi16(t, s))
+MSA_3R_FN(ilvl, w, DF_WORD, have_sse2, _mm_unpackhi_epi32(t, s))
+MSA_3R_FN(ilvl, d, DF_DOUBLE, have_sse2, _mm_unpackhi_epi64(t, s))
+
+/* ilvev/ilvod: even (odd) elements of wt below those of ws */
+MSA_3R_FN(ilvev, b, DF_BYTE, have_sse2,
+          _mm_or_si128(_mm_and_si128(t, _mm_set1_epi16(0xff)),
+                       _mm_slli_epi16(s, 8)))
+MSA_3R_FN(ilvev, h, DF_HALF, have_sse2,
+          _mm_or_si128(_mm_and_si128(t, _mm_set1_epi32(0xffff)),
+                       _mm_slli_epi32(s, 16)))
+MSA_3R_FN(ilvev, w, DF_WORD, have_sse2,
+          _mm_or_si128(_mm_and_si128(t, _mm_set1_epi64x(0xffffffff)),
+                       _mm_slli_epi64(s, 32)))
+MSA_3R_FN(ilvev, d, DF_DOUBLE, have_sse2, _mm_unpacklo_epi64(t, s))
+
+MSA_3R_FN(ilvod, b, DF_BYTE, have_sse2,
+          _mm_or_si128(_mm_srli_epi16(t, 8),
+                       _mm_andnot_si128(_mm_set1_epi16(0xff), s)))
+MSA_3R_FN(ilvod, h, DF_HALF, have_sse2,
+          _mm_or_si128(_mm_srli_epi32(t, 16),
+                       _mm_andnot_si128(_mm_set1_epi32(0xffff), s)))
+MSA_3R_FN(ilvod, w, DF_WORD, have_sse2,
+          _mm_or_si128(_mm_srli_epi64(t, 32),
+                       _mm_andnot_si128(_mm_set1_epi64x(0xffffffff), s)))
+MSA_3R_FN(ilvod, d, DF_DOUBLE, have_sse2, _mm_unpackhi_epi64(t, s))
+
+/* pckev/pckod: even (odd) elements of wt in the right half, of ws in the
+ * left half
+ */
+MSA_3R_FN(pckev, b, DF_BYTE, have_sse2,
+          _mm_packus_epi16(_mm_and_si128(t, _mm_set1_epi16(0xff)),
+                           _mm_and_si128(s, _mm_set1_epi16(0xff))))
+MSA_3R_FN(pckev, h, DF_HALF, have_sse2,
+          _mm_packs_epi32(MSA_EVEN16(t), MSA_EVEN16(s)))
+MSA_3R_FN(pckev, w, DF_WORD, have_sse2,
+          MSA_SHUFFLE_W(s, t, _MM_SHUFFLE(2, 0, 2, 0)))
+MSA_3R_FN(pckev, d, DF_DOUBLE, have_sse2, _mm_unpacklo_epi64(t, s))
+
+MSA_3R_FN(pckod, b, DF_BYTE, have_sse2,
+          _mm_packus_epi16(_mm_srli_epi16(t, 8), _mm_srli_epi16(s, 8)))
+MSA_3R_FN(pckod, h, DF_HALF, have_sse2,
+          _mm_packs_epi32(_mm_srai_epi32(t, 16), _mm_srai_epi32(s, 16)))
+MSA_3R_FN(pckod, w, DF_WORD, have_sse2,
+          MSA_SHUFFLE_W(s, t, _MM_SHUFFLE(3, 1, 3, 1)))
+MSA_3R_FN(pckod, d, DF_DOUBLE, have_sse2, _mm_unpackhi_epi64(t, s))
+
+MSA_3R_FN(vshf, b, DF_BYTE, have_ssse3, msa_vshf_b_ssse3(d, s, t))
+MSA_3R_C(vshf, h, DF_HALF)
+MSA_3R_C(vshf, w, DF_WORD)
+MSA_3R_C(vshf, d, DF_DOUBLE)
+#undef MSA_3R_C
+#undef MSA_3R_FN
+#undef MSA_3R_HOST
+#undef MSA_HOST_CALL
+
 void helper_msa_sldi_df(CPUMIPSState *env, uint32_t df, uint32_t wd,
                         uint32_t ws, uint32_t n)
 {
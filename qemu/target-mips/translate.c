@@ -17712,6 +17712,48 @@ static void gen_msa_bit(CPUMIPSState *env, DisasContext *ctx)
     tcg_temp_free_i32(tcg_ctx, tws);
 }
 
+/* Unicorn: helpers specialised for each data format, chosen here once
+   instead of switching on df in every call.  */
+typedef void gen_helper_msa_3r_fn(TCGContext *, TCGv_ptr, TCGv_i32,
+                                  TCGv_i32, TCGv_i32);
+
+#define MSA_3R_DF_FNS(name) \
+static gen_helper_msa_3r_fn * const msa_ ## name ## _fns[4] = { \
+    gen_helper_msa_ ## name ## _b, gen_helper_msa_ ## name ## _h, \
+    gen_helper_msa_ ## name ## _w, gen_helper_msa_ ## name ## _d, \
+};
+MSA_3R_DF_FNS(addv)
+MSA_3R_DF_FNS(subv)
+MSA_3R_DF_FNS(mulv)
+MSA_3R_DF_FNS(ceq)
+MSA_3R_DF_FNS(clt_s)
+MSA_3R_DF_FNS(clt_u)
+MSA_3R_DF_FNS(cle_s)
+MSA_3R_DF_FNS(cle_u)
+MSA_3R_DF_FNS(max_s)
+MSA_3R_DF_FNS(max_u)
+MSA_3R_DF_FNS(min_s)
+MSA_3R_DF_FNS(min_u)
+MSA_3R_DF_FNS(adds_s)
+MSA_3R_DF_FNS(adds_u)
+MSA_3R_DF_FNS(subs_s)
+MSA_3R_DF_FNS(subs_u)
+MSA_3R_DF_FNS(ilvr)
+MSA_3R_DF_FNS(ilvl)
+MSA_3R_DF_FNS(ilvev)
+MSA_3R_DF_FNS(ilvod)
+MSA_3R_DF_FNS(pckev)
+MSA_3R_DF_FNS(pckod)
+MSA_3R_DF_FNS(vshf)
+#undef MSA_3R_DF_FNS
+
+static void gen_msa_3r_df(TCGContext *tcg_ctx,
+                          gen_helper_msa_3r_fn * const *fns, uint8_t df,
+                          TCGv_i32 twd, TCGv_i32 tws, TCGv_i32 twt)
+{
+    fns[df](tcg_ctx, tcg_ctx->cpu_env, twd, tws, twt);
+}
+
 static void gen_msa_3r(CPUMIPSState *env, DisasContext *ctx)
 {
 #define MASK_MSA_3R(op)    (MASK_MSA_MINOR(op) | (op & (0x7 << 23)))
@@ -17731,37 +17773,37 @@ static void gen_msa_3r(CPUMIPSState *env, DisasContext *ctx)
         gen_helper_msa_sll_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_ADDV_df:
-        gen_helper_msa_addv_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_addv_fns, df, twd, tws, twt);
         break;
     case OPC_CEQ_df:
-        gen_helper_msa_ceq_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_ceq_fns, df, twd, tws, twt);
         break;
     case OPC_ADD_A_df:
         gen_helper_msa_add_a_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_SUBS_S_df:
-        gen_helper_msa_subs_s_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_subs_s_fns, df, twd, tws, twt);
         break;
     case OPC_MULV_df:
-        gen_helper_msa_mulv_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_mulv_fns, df, twd, tws, twt);
         break;
     case OPC_SLD_df:
         gen_helper_msa_sld_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_VSHF_df:
-        gen_helper_msa_vshf_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_vshf_fns, df, twd, tws, twt);
         break;
     case OPC_SRA_df:
         gen_helper_msa_sra_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_SUBV_df:
-        gen_helper_msa_subv_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_subv_fns, df, twd, tws, twt);
         break;
     case OPC_ADDS_A_df:
         gen_helper_msa_adds_a_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_SUBS_U_df:
-        gen_helper_msa_subs_u_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_subs_u_fns, df, twd, tws, twt);
         break;
     case OPC_MADDV_df:
         gen_helper_msa_maddv_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
@@ -17776,13 +17818,13 @@ static void gen_msa_3r(CPUMIPSState *env, DisasContext *ctx)
         gen_helper_msa_srl_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_MAX_S_df:
-        gen_helper_msa_max_s_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_max_s_fns, df, twd, tws, twt);
         break;
     case OPC_CLT_S_df:
-        gen_helper_msa_clt_s_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_clt_s_fns, df, twd, tws, twt);
         break;
     case OPC_ADDS_S_df:
-        gen_helper_msa_adds_s_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_adds_s_fns, df, twd, tws, twt);
         break;
     case OPC_SUBSUS_U_df:
         gen_helper_msa_subsus_u_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
@@ -17791,7 +17833,7 @@ static void gen_msa_3r(CPUMIPSState *env, DisasContext *ctx)
         gen_helper_msa_msubv_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_PCKEV_df:
-        gen_helper_msa_pckev_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_pckev_fns, df, twd, tws, twt);
         break;
     case OPC_SRLR_df:
         gen_helper_msa_srlr_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
@@ -17800,28 +17842,28 @@ static void gen_msa_3r(CPUMIPSState *env, DisasContext *ctx)
         gen_helper_msa_bclr_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_MAX_U_df:
-        gen_helper_msa_max_u_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_max_u_fns, df, twd, tws, twt);
         break;
     case OPC_CLT_U_df:
-        gen_helper_msa_clt_u_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_clt_u_fns, df, twd, tws, twt);
         break;
     case OPC_ADDS_U_df:
-        gen_helper_msa_adds_u_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_adds_u_fns, df, twd, tws, twt);
         break;
     case OPC_SUBSUU_S_df:
         gen_helper_msa_subsuu_s_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_PCKOD_df:
-        gen_helper_msa_pckod_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_pckod_fns, df, twd, tws, twt);
         break;
     case OPC_BSET_df:
         gen_helper_msa_bset_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_MIN_S_df:
-        gen_helper_msa_min_s_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_min_s_fns, df, twd, tws, twt);
         break;
     case OPC_CLE_S_df:
-        gen_helper_msa_cle_s_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_cle_s_fns, df, twd, tws, twt);
         break;
     case OPC_AVE_S_df:
         gen_helper_msa_ave_s_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
@@ -17833,16 +17875,16 @@ static void gen_msa_3r(CPUMIPSState *env, DisasContext *ctx)
         gen_helper_msa_div_s_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_ILVL_df:
-        gen_helper_msa_ilvl_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_ilvl_fns, df, twd, tws, twt);
         break;
     case OPC_BNEG_df:
         gen_helper_msa_bneg_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_MIN_U_df:
-        gen_helper_msa_min_u_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_min_u_fns, df, twd, tws, twt);
         break;
     case OPC_CLE_U_df:
-        gen_helper_msa_cle_u_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_cle_u_fns, df, twd, tws, twt);
         break;
     case OPC_AVE_U_df:
         gen_helper_msa_ave_u_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
@@ -17854,7 +17896,7 @@ static void gen_msa_3r(CPUMIPSState *env, DisasContext *ctx)
         gen_helper_msa_div_u_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_ILVR_df:
-        gen_helper_msa_ilvr_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_ilvr_fns, df, twd, tws, twt);
         break;
     case OPC_BINSL_df:
         gen_helper_msa_binsl_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
@@ -17869,7 +17911,7 @@ static void gen_msa_3r(CPUMIPSState *env, DisasContext *ctx)
         gen_helper_msa_mod_s_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_ILVEV_df:
-        gen_helper_msa_ilvev_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_ilvev_fns, df, twd, tws, twt);
         break;
     case OPC_BINSR_df:
         gen_helper_msa_binsr_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
@@ -17884,7 +17926,7 @@ static void gen_msa_3r(CPUMIPSState *env, DisasContext *ctx)
         gen_helper_msa_mod_u_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
         break;
     case OPC_ILVOD_df:
-        gen_helper_msa_ilvod_df(tcg_ctx, tcg_ctx->cpu_env, tdf, twd, tws, twt);
+        gen_msa_3r_df(tcg_ctx, msa_ilvod_fns, df, twd, tws, twt);
         break;
 
     case OPC_DOTP_S_df:
@@ -19213,21 +19255,36 @@ gen_intermediate_code_internal(MIPSCPU *cpu, TranslationBlock *tb,
         goto done_generating;
     }
 
+    // Unicorn: checked before the hooks, which must not run if the block exits early
+    gen_tb_start(tcg_ctx);
+
+    // Unicorn: stop at a breakpoint or exit before this block runs
+    if (uc_stop_addr_exists(env->uc, pc_start)) {
+        save_cpu_state(&ctx, 1);
+        gen_uc_stop_addr(tcg_ctx, env->uc, pc_start);
+    }
+
     // Unicorn: trace this block on request
     // Only hook this block if it is not broken from previous translation due to
     // full translation cache
     if (!env->uc->block_full && HOOK_EXISTS_BOUNDED(env->uc, UC_HOOK_BLOCK, pc_start)) {
         // save block address to see if we need to patch block size later
         env->uc->block_addr = pc_start;
-        env->uc->size_arg = tcg_ctx->gen_opparam_buf - tcg_ctx->gen_opparam_ptr + 1;
+        env->uc->size_arg = tcg_ctx->gen_opparam_ptr - tcg_ctx->gen_opparam_buf + 1;
         gen_uc_tracecode(tcg_ctx, 0xf8f8f8f8, UC_HOOK_BLOCK_IDX, env->uc, pc_start);
     } else {
         env->uc->size_arg = -1;
     }
 
-    gen_tb_start(tcg_ctx);
     while (ctx.bstate == BS_NONE) {
         // printf(">>> mips pc = %x\n", ctx.pc);
+        // Unicorn: a breakpoint or exit always starts a new block, but never
+        // separates a delay slot from its branch
+        if (ctx.pc != pc_start && !(ctx.hflags & MIPS_HFLAG_BMASK) &&
+                uc_stop_addr_exists(env->uc, ctx.pc)) {
+            break;
+        }
+
         if (unlikely(!QTAILQ_EMPTY(&cs->breakpoints))) {
             QTAILQ_FOREACH(bp, &cs->breakpoints, entry) {
                 if (bp->pc == ctx.pc) {
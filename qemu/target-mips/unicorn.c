@@ -45,13 +45,16 @@ static void mips_set_pc(struct uc_struct *uc, uint64_t address)
 void mips_release(void *ctx);
 void mips_release(void *ctx)
 {
+    CPUState *cs;
     MIPSCPU* cpu;
     int i;
     TCGContext *tcg_ctx = (TCGContext *) ctx;
     release_common(ctx);
-    cpu = MIPS_CPU(tcg_ctx->uc, tcg_ctx->uc->cpu);
-    g_free(cpu->env.tlb);
-    g_free(cpu->env.mvp);
+    CPU_FOREACH(tcg_ctx->uc, cs) {
+        cpu = MIPS_CPU(tcg_ctx->uc, cs);
+        g_free(cpu->env.tlb);
+        g_free(cpu->env.mvp);
+    }
 
     for (i = 0; i < MIPS_DSP_ACC; i++) {
         g_free(tcg_ctx->cpu_HI[i]);
@@ -851,7 +851,8 @@ static void sparc_cpu_initfn(struct uc_struct *uc, Object *obj, void *opaque)
     cs->env_ptr = env;
     cpu_exec_init(env, opaque);
 
-    if (tcg_enabled(uc)) {
+    /* the TCG globals are shared by all vCPUs */
+    if (tcg_enabled(uc) && cs->cpu_index == 0) {
         gen_intermediate_code_init(env);
     }
 }
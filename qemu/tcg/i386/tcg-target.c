@@ -117,11 +117,17 @@ static const int tcg_target_call_oarg_regs[] = {
 #ifdef _MSC_VER
 #include <intrin.h>
 /* %ecx */
+#define bit_PCLMUL (1 << 1)
+#define bit_SSSE3  (1 << 9)
+#define bit_SSE4_1 (1 << 19)
 #define bit_MOVBE  (1 << 22)
+#define bit_AES    (1 << 25)
+#define bit_OSXSAVE (1 << 27)
 /* %edx */
 #define bit_CMOV   (1 << 15)
 /* Extended Features (%eax == 7) */
 #define bit_BMI    (1 <<  3)
+#define bit_AVX2   (1 <<  5)
 #define bit_BMI2   (1 <<  8)
 #else
 #include <cpuid.h>
@@ -148,6 +154,14 @@ static bool have_bmi2;
 static bool have_bmi2 = 0;
 #endif
 
+/* Unicorn: host SIMD available to the x86 SSE helpers (ops_sse.h) and
+   the ARM crypto and NEON helpers */
+bool have_ssse3;
+bool have_sse41;
+bool have_aesni;
+bool have_pclmul;
+bool have_avx2;
+
 static void patch_reloc(tcg_insn_unit *code_ptr, int type,
                         intptr_t value, intptr_t addend)
 {
@@ -377,6 +391,7 @@ static inline int tcg_target_const_match(tcg_target_long val, TCGType type,
 #define SHIFT_SAR 7
 
 /* Group 3 opcode extensions for 0xf6, 0xf7.  To be used with OPC_GRP3.  */
+#define EXT3_TEST  0
 #define EXT3_NOT   2
 #define EXT3_NEG   3
 #define EXT3_MUL   4
@@ -1521,6 +1536,54 @@ static void tcg_out_qemu_st_slow_path(TCGContext *s, TCGLabelQemuLdst *l)
     tcg_out_push(s, retaddr);
     tcg_out_jmp(s, qemu_st_helpers[opc]);
 }
+
+/* Unicorn: with flat memory (uc_mem_flat_enable), the 32-bit guest address
+   space is mapped at s->flat_base, so guest accesses go straight to host
+   memory without a TLB lookup.  Unmapped, protected and code pages are not
+   accessible there: the fault is caught, and the block is translated again
+   with TLB lookups (see tb_flat_fault).  Memory hooks still need the slow
+   path for every access.  */
+static inline bool tcg_flat_enabled(TCGContext *s)
+{
+    return TCG_TARGET_REG_BITS == 64 && s->flat_base != NULL &&
+        !HOOK_EXISTS(s->uc, UC_HOOK_MEM_READ) && !HOOK_EXISTS(s->uc, UC_HOOK_MEM_WRITE);
+}
+
+/* Load the host address of the flat access at ADDRLO into the second
+   argument register, plus the returned offset.  For targets that fault on
+   misaligned accesses, LABEL_PTR[0] gets the jump to the slow path, which
+   finds the guest address in the same register as after tcg_out_tlb_load;
+   it is NULL otherwise.  */
+static intptr_t tcg_out_flat_addr(TCGContext *s, TCGReg addrlo,
+                                  TCGMemOp s_bits, tcg_insn_unit **label_ptr)
+{
+    const TCGReg r0 = TCG_REG_L0;
+    const TCGReg r1 = TCG_REG_L1;
+    intptr_t base = (intptr_t)s->flat_base;
+
+    /* MOVL zero-extends the guest address */
+    tcg_out_mov(s, TCG_TYPE_I32, r1, addrlo);
+
+    label_ptr[0] = NULL;
+#ifdef ALIGNED_ONLY
+    if (s_bits != MO_8) {
+        /* test $mask, r1; jne slow_path */
+        tcg_out_modrm(s, OPC_GRP3_Ev, EXT3_TEST, r1);
+        tcg_out32(s, (1 << s_bits) - 1);
+        tcg_out_opc(s, OPC_JCC_long + JCC_JNE, 0, 0, 0);
+        label_ptr[0] = s->code_ptr;
+        s->code_ptr += 4;
+    }
+#endif
+
+    /* the reserved range is placed low enough for a displacement, if possible */
+    if (base == (int32_t)base) {
+        return base;
+    }
+    tcg_out_movi(s, TCG_TYPE_PTR, r0, base);
+    tgen_arithr(s, ARITH_ADD + P_REXW, r1, r0);
+    return 0;
+}
 #elif defined(__x86_64__) && defined(__linux__)
 # include <asm/prctl.h>
 # include <sys/prctl.h>
@@ -1651,6 +1714,17 @@ static void tcg_out_qemu_ld(TCGContext *s, const TCGArg *args, bool is64)
     mem_index = *args++;
     s_bits = opc & MO_SIZE;
 
+    if (tcg_flat_enabled(s)) {
+        intptr_t ofs = tcg_out_flat_addr(s, addrlo, s_bits, label_ptr);
+
+        tcg_out_qemu_ld_direct(s, datalo, datahi, TCG_REG_L1, ofs, 0, opc);
+        if (label_ptr[0]) {
+            add_qemu_ldst_label(s, true, opc, datalo, datahi, addrlo, addrhi,
+                                mem_index, s->code_ptr, label_ptr);
+        }
+        return;
+    }
+
     tcg_out_tlb_load(s, addrlo, addrhi, mem_index, s_bits,
                      label_ptr, offsetof(CPUTLBEntry, addr_read));
 
@@ -1782,6 +1856,17 @@ static void tcg_out_qemu_st(TCGContext *s, const TCGArg *args, bool is64)
     mem_index = *args++;
     s_bits = opc & MO_SIZE;
 
+    if (tcg_flat_enabled(s)) {
+        intptr_t ofs = tcg_out_flat_addr(s, addrlo, s_bits, label_ptr);
+
+        tcg_out_qemu_st_direct(s, datalo, datahi, TCG_REG_L1, ofs, 0, opc);
+        if (label_ptr[0]) {
+            add_qemu_ldst_label(s, false, opc, datalo, datahi, addrlo, addrhi,
+                                mem_index, s->code_ptr, label_ptr);
+        }
+        return;
+    }
+
     tcg_out_tlb_load(s, addrlo, addrhi, mem_index, s_bits,
                      label_ptr, offsetof(CPUTLBEntry, addr_write));
 
@@ -2418,6 +2503,29 @@ static void tcg_target_init(TCGContext *s)
            need to probe for it.  */
         s->have_movbe = (c & bit_MOVBE) != 0;
 #endif
+        have_ssse3 = (c & bit_SSSE3) != 0;
+        have_sse41 = (c & bit_SSE4_1) != 0;
+        have_aesni = (c & bit_AES) != 0;
+        have_pclmul = (c & bit_PCLMUL) != 0;
+    }
+
+    /* AVX2 also needs the OS to save the ymm state across switches.  */
+    if (max >= 7 && (c & bit_OSXSAVE)) {
+        unsigned xcr0;
+#ifdef _MSC_VER
+        xcr0 = (unsigned)_xgetbv(0);
+#else
+        asm("xgetbv" : "=a" (xcr0), "=d" (d) : "c" (0));
+#endif
+        if ((xcr0 & 6) == 6) {
+#ifdef _MSC_VER
+            __cpuidex(cpu_info, 7, 0);
+            b = cpu_info[1];
+#else
+            __cpuid_count(7, 0, a, b, c, d);
+#endif
+            have_avx2 = (b & bit_AVX2) != 0;
+        }
     }
 
     if (max >= 7) {
@@ -74,6 +74,11 @@ typedef enum {
 #endif
 
 extern bool have_bmi1;
+extern bool have_ssse3;
+extern bool have_sse41;
+extern bool have_aesni;
+extern bool have_pclmul;
+extern bool have_avx2;
 
 /* optional instructions */
 #define TCG_TARGET_HAS_div2_i32         1
@@ -679,6 +679,9 @@ struct TCGContext {
     /* qemu/tcg/i386/tcg-target.c */
     void *tb_ret_addr;
     int guest_base_flags;
+    /* Unicorn: flat memory accessed directly by the block being translated,
+       or NULL for TLB lookups */
+    uint8_t *flat_base;
     /* If bit_MOVBE is defined in cpuid.h (added in GCC version 4.6), we are
        going to attempt to determine at runtime whether movbe is available.  */
     bool have_movbe;
@@ -759,6 +762,8 @@ struct TCGContext {
     void *cpu_wim;
 
     int exitreq_label;  // gen_tb_start()
+    int quantum_label;  // gen_tb_start(), with several vCPUs
+    TCGArg *quantum_arg;
 };
 
 typedef struct TCGTargetOpDef {
@@ -209,6 +209,7 @@ static int cpu_gen_code(CPUArchState *env, TranslationBlock *tb, int *gen_code_s
     ti = profile_getclock();
 #endif
     tcg_func_start(s);
+    s->flat_base = (tb->cflags & CF_NOFLAT) ? NULL : env->uc->flat_base;
 
     gen_intermediate_code(env, tb);
 
@@ -275,6 +276,7 @@ static int cpu_restore_state_from_tb(CPUState *cpu, TranslationBlock *tb,
     ti = profile_getclock();
 #endif
     tcg_func_start(s);
+    s->flat_base = (tb->cflags & CF_NOFLAT) ? NULL : env->uc->flat_base;
 
     gen_intermediate_code_pc(env, tb);
 
@@ -323,6 +325,59 @@ bool cpu_restore_state(CPUState *cpu, uintptr_t retaddr)
     return false;
 }
 
+static bool tb_flat_is_slow(struct uc_struct *uc, uint64_t pc)
+{
+    return uc->flat_slow != NULL && g_hash_table_lookup(uc->flat_slow, &pc) != NULL;
+}
+
+// Unicorn: blocks at this PC are translated with TLB lookups from now on
+static void tb_flat_slow(struct uc_struct *uc, uint64_t pc)
+{
+    uint64_t *key;
+
+    if (tb_flat_is_slow(uc, pc)) {
+        return;
+    }
+    key = g_malloc(sizeof(*key));
+    *key = pc;
+    g_hash_table_insert(uc->flat_slow, key, key);
+}
+
+/* Unicorn: translated code at HOST_PC faulted on flat memory, which leaves
+   unmapped, protected and code pages inaccessible.  Its block is translated
+   again with TLB lookups, and emulation resumes at the faulting instruction,
+   so the access raises the memory events or handles self-modifying code as
+   usual.  Returns false if HOST_PC is not in translated code.  */
+bool tb_flat_fault(struct uc_struct *uc, uintptr_t host_pc)
+{
+    TCGContext *tcg_ctx = uc->tcg_ctx;
+    CPUState *cpu = uc->current_cpu;
+    TranslationBlock *tb;
+    target_ulong pc, cs_base;
+    int flags;
+
+    if (cpu == NULL || host_pc < (uintptr_t)tcg_ctx->code_gen_buffer ||
+        host_pc >= (uintptr_t)tcg_ctx->code_gen_buffer + tcg_ctx->code_gen_buffer_size) {
+        return false;
+    }
+    tb = tb_find_pc(uc, host_pc);
+    if (tb == NULL) {
+        return false;
+    }
+
+    tb_flat_slow(uc, tb->pc);
+    cpu_restore_state_from_tb(cpu, tb, host_pc);
+    tb_phys_invalidate(uc, tb, -1);
+
+    // the block now starting at the faulting instruction must not fault again
+    cpu_get_tb_cpu_state(cpu->env_ptr, &pc, &cs_base, &flags);
+    tb_flat_slow(uc, pc);
+    uc->flat_replay = true;
+    uc->flat_replay_pc = pc;
+
+    cpu_loop_exit(cpu);
+}
+
 #ifdef _WIN32
 static inline QEMU_UNUSED_FUNC void map_exec(void *addr, long size)
 {
@@ -890,7 +945,9 @@ void tb_flush(CPUArchState *env1)
     }
     tcg_ctx->tb_ctx.nb_tbs = 0;
 
-    memset(cpu->tb_jmp_cache, 0, sizeof(cpu->tb_jmp_cache));
+    CPU_FOREACH(uc, cpu) {
+        memset(cpu->tb_jmp_cache, 0, sizeof(cpu->tb_jmp_cache));
+    }
 
     memset(tcg_ctx->tb_ctx.tb_phys_hash, 0, sizeof(tcg_ctx->tb_ctx.tb_phys_hash));
     page_flush_tb(uc);
@@ -1015,7 +1072,7 @@ void tb_phys_invalidate(struct uc_struct *uc,
     TranslationBlock *tb, tb_page_addr_t page_addr)
 {
     TCGContext *tcg_ctx = uc->tcg_ctx;
-    CPUState *cpu = uc->cpu;
+    CPUState *cpu;
     PageDesc *p;
     unsigned int h, n1;
     tb_page_addr_t phys_pc;
@@ -1042,8 +1099,10 @@ void tb_phys_invalidate(struct uc_struct *uc,
 
     /* remove the TB from the hash list */
     h = tb_jmp_cache_hash_func(tb->pc);
-    if (cpu->tb_jmp_cache[h] == tb) {
-        cpu->tb_jmp_cache[h] = NULL;
+    CPU_FOREACH(uc, cpu) {
+        if (cpu->tb_jmp_cache[h] == tb) {
+            cpu->tb_jmp_cache[h] = NULL;
+        }
     }
 
     /* suppress this TB from the two jump lists */
@@ -1149,6 +1208,10 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     tb->cs_base = cs_base;
     tb->flags = flags;
     tb->cflags = cflags;
+    // Unicorn: blocks that faulted on flat memory use TLB lookups
+    if (tb_flat_is_slow(env->uc, pc)) {
+        tb->cflags |= CF_NOFLAT;
+    }
     ret = cpu_gen_code(env, tb, &code_gen_size);  // qq
     if (ret == -1) {
         tb_free(env->uc, tb);
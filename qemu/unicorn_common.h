@@ -65,6 +65,12 @@ static void release_common(void *t)
 #endif
 }
 
+// drop the TLB of the CPU, as uc_context_restore() changed its address space
+static void tlb_flush_common(struct uc_struct *uc)
+{
+    tlb_flush(uc->cpu, 1);
+}
+
 static inline void uc_common_init(struct uc_struct* uc)
 {
     memory_register_types(uc);
@@ -74,6 +80,14 @@ static inline void uc_common_init(struct uc_struct* uc)
     uc->tcg_exec_init = tcg_exec_init;
     uc->cpu_exec_init_all = cpu_exec_init_all;
     uc->vm_start = vm_start;
+    uc->tb_translate_range = tb_translate_range;
+    uc->tb_translate_block = tb_translate_block;
+    uc->tb_foreach = tb_foreach;
+    uc->flat_fault = tb_flat_fault;
+    uc->ram_log_start = ram_log_start;
+    uc->ram_log_rewind = ram_log_rewind;
+    uc->ram_log_stop = ram_log_stop;
+    uc->tlb_flush = tlb_flush_common;
     uc->memory_map = memory_map;
     uc->memory_map_ptr = memory_map_ptr;
     uc->memory_unmap = memory_unmap;
@@ -114,6 +114,14 @@ int machine_initialize(struct uc_struct *uc)
     return machine_class->init(uc, current_machine);
 }
 
+// Unicorn: the machine creates one more vCPU, which becomes uc->cpu
+int machine_add_cpu(struct uc_struct *uc)
+{
+    MachineClass *machine_class = MACHINE_GET_CLASS(uc, uc->machine_state);
+
+    return machine_class->init(uc, uc->machine_state);
+}
+
 void qemu_system_reset_request(struct uc_struct* uc)
 {
     cpu_stop_current(uc);
@@ -2,6 +2,7 @@
 #define VL_H_
 
 int machine_initialize(struct uc_struct *uc);
+int machine_add_cpu(struct uc_struct *uc);
 
 #endif
 
@@ -12,6 +12,14 @@
 #define tb_invalidate_phys_page_fast tb_invalidate_phys_page_fast_x86_64
 #define phys_mem_clean phys_mem_clean_x86_64
 #define tb_cleanup tb_cleanup_x86_64
+#define tb_translate_range tb_translate_range_x86_64
+#define tb_translate_block tb_translate_block_x86_64
+#define tb_foreach tb_foreach_x86_64
+#define tb_flat_fault tb_flat_fault_x86_64
+#define ram_log_start ram_log_start_x86_64
+#define ram_log_rewind ram_log_rewind_x86_64
+#define ram_log_stop ram_log_stop_x86_64
+#define ram_log_tlb_dirty ram_log_tlb_dirty_x86_64
 #define memory_map memory_map_x86_64
 #define memory_map_ptr memory_map_ptr_x86_64
 #define memory_unmap memory_unmap_x86_64
@@ -1338,8 +1346,13 @@
 #define handle_vrint handle_vrint_x86_64
 #define handle_vsel handle_vsel_x86_64
 #define has_help_option has_help_option_x86_64
+#define have_aesni have_aesni_x86_64
+#define have_avx2 have_avx2_x86_64
 #define have_bmi1 have_bmi1_x86_64
 #define have_bmi2 have_bmi2_x86_64
+#define have_pclmul have_pclmul_x86_64
+#define have_sse41 have_sse41_x86_64
+#define have_ssse3 have_ssse3_x86_64
 #define hcr_write hcr_write_x86_64
 #define helper_access_check_cp_reg helper_access_check_cp_reg_x86_64
 #define helper_add_saturate helper_add_saturate_x86_64
@@ -2924,6 +2937,7 @@
 #define tlbimva_write tlbimva_write_x86_64
 #define tlb_is_dirty_ram tlb_is_dirty_ram_x86_64
 #define tlb_protect_code tlb_protect_code_x86_64
+#define tlb_reset_dirty_page tlb_reset_dirty_page_x86_64
 #define tlb_reset_dirty_range tlb_reset_dirty_range_x86_64
 #define tlb_reset_dirty_range_all tlb_reset_dirty_range_all_x86_64
 #define tlb_set_dirty tlb_set_dirty_x86_64
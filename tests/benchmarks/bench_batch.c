@@ -0,0 +1,135 @@
+// Time many short runs over independent inputs: a loop of uc_context_restore(),
+// uc_mem_write(), uc_emu_start() and uc_reg_read(), against the same runs
+// given to uc_emu_batch(), reported in microseconds per run.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unicorn/unicorn.h>
+
+#define CODE    0x1000
+#define DATA    0x100000
+#define STACK   0x200000
+#define INPUT   64
+#define RUNS    100000
+
+// hash the INPUT bytes at ESI into EAX, keeping a running hash on the stack
+static const uint8_t code[] = {
+    0x31, 0xc0,                         // xor eax, eax
+    0xb9, INPUT, 0x00, 0x00, 0x00,      // mov ecx, INPUT
+    0x6b, 0xc0, 0x1f,                   // imul eax, eax, 31
+    0x0f, 0xb6, 0x1e,                   // movzx ebx, byte [esi]
+    0x01, 0xd8,                         // add eax, ebx
+    0x50,                               // push eax
+    0x88, 0x06,                         // mov [esi], al
+    0x46,                               // inc esi
+    0x49,                               // dec ecx
+    0x75, 0xf1,                         // jnz CODE + 7
+};
+
+static uint8_t inputs[RUNS][INPUT];
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uc_engine *setup(void)
+{
+    uint32_t esi = DATA, esp = STACK + 0x1000;
+    uc_engine *uc;
+
+    if (uc_open(UC_ARCH_X86, UC_MODE_32, &uc)) {
+        return NULL;
+    }
+    uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE, code, sizeof(code));
+    uc_mem_map(uc, DATA, 0x1000, UC_PROT_READ | UC_PROT_WRITE);
+    uc_mem_map(uc, STACK, 0x1000, UC_PROT_READ | UC_PROT_WRITE);
+    uc_reg_write(uc, UC_X86_REG_ESI, &esi);
+    uc_reg_write(uc, UC_X86_REG_ESP, &esp);
+
+    return uc;
+}
+
+static double bench_loop(uint64_t *sum)
+{
+    uc_engine *uc = setup();
+    uc_context *ctx;
+    uint32_t eax;
+    double start, t;
+    int i;
+
+    uc_context_alloc(uc, &ctx);
+    uc_context_save(uc, ctx);
+
+    start = now();
+    for (i = 0; i < RUNS; i++) {
+        uc_context_restore(uc, ctx);
+        uc_mem_write(uc, DATA, inputs[i], INPUT);
+        uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0);
+        uc_reg_read(uc, UC_X86_REG_EAX, &eax);
+        *sum += eax;
+    }
+    t = (now() - start) * 1e6 / RUNS;
+
+    uc_free(ctx);
+    uc_close(uc);
+    return t;
+}
+
+static double bench_batch(uint64_t *sum)
+{
+    static uc_batch_patch patches[RUNS];
+    static uc_batch_job jobs[RUNS];
+    static uint64_t results[RUNS];
+    const int regs[] = { UC_X86_REG_EAX };
+    uc_engine *uc = setup();
+    double start, t;
+    int i;
+
+    for (i = 0; i < RUNS; i++) {
+        patches[i].address = DATA;
+        patches[i].data = inputs[i];
+        patches[i].size = INPUT;
+        jobs[i].patches = &patches[i];
+        jobs[i].npatches = 1;
+        jobs[i].results = &results[i];
+    }
+
+    start = now();
+    uc_emu_batch(uc, CODE, CODE + sizeof(code), 0, 0, regs, 1, jobs, RUNS);
+    t = (now() - start) * 1e6 / RUNS;
+
+    for (i = 0; i < RUNS; i++) {
+        *sum += (uint32_t)results[i];
+    }
+
+    uc_close(uc);
+    return t;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t sum_loop = 0, sum_batch = 0;
+    int i, j;
+
+    srand(1);
+    for (i = 0; i < RUNS; i++) {
+        for (j = 0; j < INPUT; j++) {
+            inputs[i][j] = rand();
+        }
+    }
+
+    printf("loop   %6.2f us/run\n", bench_loop(&sum_loop));
+    printf("batch  %6.2f us/run\n", bench_batch(&sum_batch));
+    if (sum_loop != sum_batch) {
+        printf("results differ\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,93 @@
+// Time cooperative switches between guest threads: each switch saves the
+// running thread, restores the next one and runs it for a short slice. The
+// contexts are a uc_context_size() buffer, which is always copied in full, a
+// uc_context_alloc() context, and one holding only the GPRs. Reported in
+// nanoseconds per switch, emulation included.
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unicorn/unicorn.h>
+
+#define CODE        0x1000
+#define THREADS     8
+#define SWITCHES    200000
+
+// a slice of integer work, as most guest threads do
+static const uint8_t code[] = {
+    0x40,                               // inc eax
+    0x01, 0xc3,                         // add ebx, eax
+    0x31, 0xd9,                         // xor ecx, ebx
+};
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench(int groups, uint64_t *sum)
+{
+    uc_context *threads[THREADS];
+    uc_engine *uc;
+    uint32_t eax;
+    double start, t;
+    int i;
+
+    if (uc_open(UC_ARCH_X86, UC_MODE_32, &uc)) {
+        return 0;
+    }
+    uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE, code, sizeof(code));
+
+    for (i = 0; i < THREADS; i++) {
+        if (groups) {
+            uc_context_alloc_groups(uc, groups, &threads[i]);
+        } else {
+            // hand-made buffer: untracked, copied in full
+            threads[i] = malloc(sizeof(size_t) + uc_context_size(uc));
+            *(size_t *)threads[i] = uc_context_size(uc);
+        }
+        eax = i;
+        uc_reg_write(uc, UC_X86_REG_EAX, &eax);
+        uc_context_save(uc, threads[i]);
+    }
+
+    start = now();
+    for (i = 0; i < SWITCHES; i++) {
+        uc_context_save(uc, threads[i % THREADS]);
+        uc_context_restore(uc, threads[(i + 1) % THREADS]);
+        uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0);
+    }
+    t = (now() - start) * 1e9 / SWITCHES;
+
+    for (i = 0; i < THREADS; i++) {
+        uc_context_restore(uc, threads[i]);
+        uc_reg_read(uc, UC_X86_REG_EAX, &eax);
+        *sum += eax;
+        if (groups) {
+            uc_free(threads[i]);
+        } else {
+            free(threads[i]);
+        }
+    }
+
+    uc_close(uc);
+    return t;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t sum_full = 0, sum_all = 0, sum_gpr = 0;
+
+    printf("full buffer  %6.0f ns/switch\n", bench(0, &sum_full));
+    printf("all groups   %6.0f ns/switch\n", bench(UC_CTX_ALL, &sum_all));
+    printf("GPR only     %6.0f ns/switch\n", bench(UC_CTX_GPR, &sum_gpr));
+    if (sum_full != sum_all || sum_full != sum_gpr) {
+        printf("results differ\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+// Time loading a 64MB file in guest memory, with read() & uc_mem_write() and
+// with uc_mem_map_file(), followed by a 32-bit guest loop reading one dword
+// every 64KB of it, reported in milliseconds.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <unicorn/unicorn.h>
+
+#define CODE 0x1000
+#define DATA 0x1000000
+#define SIZE (64 << 20)
+#define STEP 0x10000
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench(int fd, int use_file)
+{
+    const uint8_t code[] = {
+        0x8b, 0x06,                         // mov eax, [esi]
+        0x81, 0xc6, 0x00, 0x00, 0x01, 0x00, // add esi, STEP
+        0x49,                               // dec ecx
+        0x75, 0xf5,                         // jnz CODE
+    };
+    uint32_t steps = SIZE / STEP, esi = DATA;
+    uc_engine *uc;
+    double start, t;
+    uint8_t *buf;
+
+    if (uc_open(UC_ARCH_X86, UC_MODE_32, &uc)) {
+        return 0;
+    }
+    uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE, code, sizeof(code));
+    uc_reg_write(uc, UC_X86_REG_ECX, &steps);
+    uc_reg_write(uc, UC_X86_REG_ESI, &esi);
+
+    start = now();
+    if (use_file) {
+        uc_mem_map_file(uc, DATA, SIZE, UC_PROT_READ | UC_PROT_WRITE, fd, 0, UC_MAP_PRIVATE);
+    } else {
+        buf = malloc(SIZE);
+        if (pread(fd, buf, SIZE, 0) != SIZE) {
+            printf("short read\n");
+        }
+        uc_mem_map(uc, DATA, SIZE, UC_PROT_READ | UC_PROT_WRITE);
+        uc_mem_write(uc, DATA, buf, SIZE);
+        free(buf);
+    }
+    uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0);
+    t = (now() - start) * 1e3;
+
+    uc_close(uc);
+    return t;
+}
+
+int main(int argc, char **argv)
+{
+    char path[] = "/tmp/bench_mem_map_file.XXXXXX";
+    int fd;
+
+    fd = mkstemp(path);
+    if (fd < 0 || ftruncate(fd, SIZE) != 0) {
+        return 1;
+    }
+    unlink(path);
+
+    printf("copy  %8.2f ms\n", bench(fd, 0));
+    printf("file  %8.2f ms\n", bench(fd, 1));
+
+    close(fd);
+    return 0;
+}
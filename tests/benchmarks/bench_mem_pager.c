@@ -0,0 +1,80 @@
+// Time first-touch faults on a lazily populated 32-bit guest address space:
+// pages mapped from a UC_HOOK_MEM_*_UNMAPPED hook, and by a demand-paging
+// callback set with uc_mem_set_pager(), reported in microseconds per page.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unicorn/unicorn.h>
+
+#define CODE 0x1000
+#define DATA 0x1000000
+#define PAGES 1024
+
+static uint8_t fill[0x1000];
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static bool hook_unmapped(uc_engine *uc, uc_mem_type type,
+        uint64_t address, int size, int64_t value, void *user_data)
+{
+    address &= ~0xfffULL;
+    return uc_mem_map(uc, address, 0x1000, UC_PROT_READ | UC_PROT_WRITE) == UC_ERR_OK &&
+        uc_mem_write(uc, address, fill, sizeof(fill)) == UC_ERR_OK;
+}
+
+static bool pager(uc_engine *uc, uc_mem_type type, uint64_t address,
+        int size, uc_mem_page *page, void *user_data)
+{
+    page->perms = UC_PROT_READ | UC_PROT_WRITE;
+    page->data = fill;
+    return true;
+}
+
+static double bench(int use_pager)
+{
+    const uint8_t code[] = {
+        0x8b, 0x06,                         // mov eax, [esi]
+        0x81, 0xc6, 0x00, 0x10, 0x00, 0x00, // add esi, 0x1000
+        0x49,                               // dec ecx
+        0x75, 0xf5,                         // jnz CODE
+    };
+    uint32_t pages = PAGES, esi = DATA;
+    uc_engine *uc;
+    double start, t;
+    uc_hook h;
+
+    if (uc_open(UC_ARCH_X86, UC_MODE_32, &uc)) {
+        return 0;
+    }
+    uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE, code, sizeof(code));
+    if (use_pager) {
+        uc_mem_set_pager(uc, pager, NULL);
+    } else {
+        uc_hook_add(uc, &h, UC_HOOK_MEM_READ_UNMAPPED, hook_unmapped, NULL, 1, 0);
+    }
+    uc_reg_write(uc, UC_X86_REG_ECX, &pages);
+    uc_reg_write(uc, UC_X86_REG_ESI, &esi);
+
+    start = now();
+    uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0);
+    t = (now() - start) * 1e6 / PAGES;
+
+    uc_close(uc);
+    return t;
+}
+
+int main(int argc, char **argv)
+{
+    printf("hook   %6.2f us/page\n", bench(0));
+    printf("pager  %6.2f us/page\n", bench(1));
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+// Time the SSE integer helpers: each op runs in an unrolled guest loop
+// over four destination (xmm0-xmm3) and four source registers (xmm4-xmm7)
+// loaded with random data, reported in nanoseconds per instruction.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unicorn/unicorn.h>
+
+#define CODE 0x1000
+#define UNROLL 64
+#define LOOPS 20000
+
+struct op {
+    const char *name;
+    uint8_t op[4];
+    size_t len;
+    uint8_t imm;    // immediate after the operands, if not 0
+};
+
+static const struct op ops[] = {
+    { "add",        { 0x48, 0x01 }, 2 },
+    { "paddb",      { 0x66, 0x0f, 0xfc }, 3 },
+    { "paddq",      { 0x66, 0x0f, 0xd4 }, 3 },
+    { "paddusb",    { 0x66, 0x0f, 0xdc }, 3 },
+    { "psubsw",     { 0x66, 0x0f, 0xe9 }, 3 },
+    { "pminub",     { 0x66, 0x0f, 0xda }, 3 },
+    { "pmaxsw",     { 0x66, 0x0f, 0xee }, 3 },
+    { "pand",       { 0x66, 0x0f, 0xdb }, 3 },
+    { "pxor",       { 0x66, 0x0f, 0xef }, 3 },
+    { "pcmpeqb",    { 0x66, 0x0f, 0x74 }, 3 },
+    { "pcmpgtw",    { 0x66, 0x0f, 0x65 }, 3 },
+    { "pmullw",     { 0x66, 0x0f, 0xd5 }, 3 },
+    { "pmulhuw",    { 0x66, 0x0f, 0xe4 }, 3 },
+    { "pavgb",      { 0x66, 0x0f, 0xe0 }, 3 },
+    { "pmuludq",    { 0x66, 0x0f, 0xf4 }, 3 },
+    { "pmaddwd",    { 0x66, 0x0f, 0xf5 }, 3 },
+    { "psadbw",     { 0x66, 0x0f, 0xf6 }, 3 },
+    { "packsswb",   { 0x66, 0x0f, 0x63 }, 3 },
+    { "packuswb",   { 0x66, 0x0f, 0x67 }, 3 },
+    { "punpcklbw",  { 0x66, 0x0f, 0x60 }, 3 },
+    { "punpckhwd",  { 0x66, 0x0f, 0x69 }, 3 },
+    { "shufps",     { 0x0f, 0xc6 }, 2, 0x1b },
+    { "pshufd",     { 0x66, 0x0f, 0x70 }, 3, 0x1b },
+    { "pshuflw",    { 0xf2, 0x0f, 0x70 }, 3, 0x1b },
+    { "pshufb",     { 0x66, 0x0f, 0x38, 0x00 }, 4 },
+    { "phaddw",     { 0x66, 0x0f, 0x38, 0x01 }, 4 },
+    { "pmaddubsw",  { 0x66, 0x0f, 0x38, 0x04 }, 4 },
+    { "psignb",     { 0x66, 0x0f, 0x38, 0x08 }, 4 },
+    { "pmulhrsw",   { 0x66, 0x0f, 0x38, 0x0b }, 4 },
+    { "pabsb",      { 0x66, 0x0f, 0x38, 0x1c }, 4 },
+    { "pmuldq",     { 0x66, 0x0f, 0x38, 0x28 }, 4 },
+    { "packusdw",   { 0x66, 0x0f, 0x38, 0x2b }, 4 },
+    { "pminsb",     { 0x66, 0x0f, 0x38, 0x38 }, 4 },
+    { "pmaxud",     { 0x66, 0x0f, 0x38, 0x3f }, 4 },
+    { "pmulld",     { 0x66, 0x0f, 0x38, 0x40 }, 4 },
+};
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench(uc_engine *uc, const struct op *op)
+{
+    uint8_t code[UNROLL * 6 + 16];
+    uint64_t rcx = LOOPS;
+    uint64_t xmm[2];
+    size_t n = 0;
+    double start;
+    int i;
+
+    for (i = 0; i < UNROLL; i++) {
+        memcpy(code + n, op->op, op->len);
+        n += op->len;
+        // xmm0-3, xmm4-7
+        code[n++] = 0xc0 | (i & 3) << 3 | (4 + ((i >> 2) & 3));
+        if (op->imm) {
+            code[n++] = op->imm;
+        }
+    }
+    code[n++] = 0x48;                   // dec rcx
+    code[n++] = 0xff;
+    code[n++] = 0xc9;
+    code[n++] = 0x0f;                   // jnz CODE
+    code[n++] = 0x85;
+    *(int32_t *)(code + n) = -(int32_t)(n + 4);
+    n += 4;
+
+    uc_mem_write(uc, CODE, code, n);
+    uc_reg_write(uc, UC_X86_REG_RCX, &rcx);
+    srand(1);
+    for (i = 0; i < 8; i++) {
+        xmm[0] = (uint64_t)rand() << 42 ^ (uint64_t)rand() << 21 ^ rand();
+        xmm[1] = (uint64_t)rand() << 42 ^ (uint64_t)rand() << 21 ^ rand();
+        uc_reg_write(uc, UC_X86_REG_XMM0 + i, xmm);
+    }
+    start = now();
+    uc_emu_start(uc, CODE, CODE + n, 0, 0);
+    return (now() - start) * 1e9 / ((double)UNROLL * LOOPS);
+}
+
+int main(int argc, char **argv)
+{
+    uc_engine *uc;
+    uc_err err;
+    size_t i;
+
+    err = uc_open(UC_ARCH_X86, UC_MODE_64, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+    uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL);
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (argc > 1 && strcmp(argv[1], ops[i].name)) {
+            continue;
+        }
+        printf("%-12s %6.2f ns/insn\n", ops[i].name, bench(uc, &ops[i]));
+    }
+
+    uc_close(uc);
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Time the x87 add, mul, div and sqrt under the default extended precision,
+// double precision, and extended precision with UC_MODE_X87_FAST: each runs
+// in an unrolled 32-bit guest loop, reported in nanoseconds per instruction.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unicorn/unicorn.h>
+
+#define CODE 0x1000
+#define DATA 0x2000
+#define UNROLL 64
+#define LOOPS 20000
+
+struct op {
+    const char *name;
+    uint8_t insn[2];
+};
+
+// ST0 op ST(1-4); the operands stay close to 1.0
+static const struct op ops[] = {
+    { "fadd",  { 0xd8, 0xc0 } },
+    { "fmul",  { 0xd8, 0xc8 } },
+    { "fdiv",  { 0xd8, 0xf0 } },
+    { "fsqrt", { 0xd9, 0xfa } },
+};
+
+static const struct {
+    const char *name;
+    uint16_t cw;
+    uc_mode mode;
+} configs[] = {
+    { "ext",      0x37f, UC_MODE_32 },
+    { "double",   0x27f, UC_MODE_32 },
+    { "ext+fast", 0x37f, UC_MODE_32 | UC_MODE_X87_FAST },
+};
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench(const struct op *op, uint16_t cw, uc_mode mode)
+{
+    static const double init[] = { 1.0, 1.0000001, 0.9999999, 1.0000002, 0.9999998 };
+    uint8_t code[36 + UNROLL * 2 + 7];
+    uint32_t loops = LOOPS;
+    uc_engine *uc;
+    double start, t;
+    size_t n = 0;
+    int i;
+
+    if (uc_open(UC_ARCH_X86, mode, &uc)) {
+        return 0;
+    }
+    uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL);
+    uc_mem_map(uc, DATA, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, DATA, &cw, 2);
+    uc_mem_write(uc, DATA + 8, init, sizeof(init));
+
+    // fldcw [DATA]; fld qword [DATA + 8 * (5..1)]
+    code[n++] = 0xd9;
+    code[n++] = 0x2d;
+    *(uint32_t *)(code + n) = DATA;
+    n += 4;
+    for (i = 4; i >= 0; i--) {
+        code[n++] = 0xdd;
+        code[n++] = 0x05;
+        *(uint32_t *)(code + n) = DATA + 8 + 8 * i;
+        n += 4;
+    }
+    // the loop starts here
+    for (i = 0; i < UNROLL; i++) {
+        code[n++] = op->insn[0];
+        code[n++] = op->insn[1] | (op->insn[0] == 0xd8 ? 1 + i % 4 : 0);
+    }
+    code[n++] = 0x49;                   // dec ecx
+    code[n++] = 0x0f;                   // jnz loop
+    code[n++] = 0x85;
+    *(int32_t *)(code + n) = -(int32_t)(UNROLL * 2 + 7);
+    n += 4;
+
+    uc_reg_write(uc, UC_X86_REG_ECX, &loops);
+    uc_mem_write(uc, CODE, code, n);
+
+    start = now();
+    uc_emu_start(uc, CODE, CODE + n, 0, 0);
+    t = (now() - start) * 1e9 / ((double)UNROLL * LOOPS);
+
+    uc_close(uc);
+    return t;
+}
+
+int main(int argc, char **argv)
+{
+    size_t i, c;
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (argc > 1 && strcmp(argv[1], ops[i].name)) {
+            continue;
+        }
+        printf("%-6s", ops[i].name);
+        for (c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+            printf("  %s %6.2f ns", configs[c].name,
+                   bench(&ops[i], configs[c].cw, configs[c].mode));
+        }
+        printf("\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,321 @@
+// Test batched runs with uc_emu_batch()
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE    0x1000
+#define DATA    0x100000
+#define STACK   0x200000
+
+/* Called before every test to set up a new instance */
+static int setup32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+// sum the ECX dwords at ESI into EAX, and overwrite them with the partial sums
+static const uint8_t sum_code[] = {
+    0x31, 0xc0,                 // xor eax, eax
+    0x53,                       // push ebx
+    0x03, 0x06,                 // add eax, [esi]
+    0x89, 0x06,                 // mov [esi], eax
+    0x83, 0xc6, 0x04,           // add esi, 4
+    0x49,                       // dec ecx
+    0x75, 0xf6,                 // jnz CODE + 3
+    0x5b,                       // pop ebx
+};
+
+static void setup_sum(uc_engine *uc)
+{
+    const uint32_t data[] = { 1, 2, 3, 4 };
+    uint32_t r_esi = DATA, r_ecx = 4, r_esp = STACK + 0x1000;
+
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, sum_code, sizeof(sum_code)));
+    OK(uc_mem_map(uc, DATA, 0x1000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_mem_write(uc, DATA, data, sizeof(data)));
+    OK(uc_mem_map(uc, STACK, 0x1000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_reg_write(uc, UC_X86_REG_ESI, &r_esi));
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+    OK(uc_reg_write(uc, UC_X86_REG_ESP, &r_esp));
+}
+
+static void test_batch_patches(void **state)
+{
+    uc_engine *uc = *state;
+    const uint32_t in1[] = { 10, 20 }, in2[] = { 100 }, in3[] = { 7, 7, 7, 7 };
+    const uc_batch_patch p1 = { DATA, in1, sizeof(in1) };
+    const uc_batch_patch p2 = { DATA + 8, in2, sizeof(in2) };
+    const uc_batch_patch p3 = { DATA, in3, sizeof(in3) };
+    const int regs[] = { UC_X86_REG_EAX, UC_X86_REG_ESI };
+    uint64_t results[4][2];
+    uc_batch_job jobs[4] = {
+        { NULL, &p1, 1, results[0] },
+        { NULL, &p2, 1, results[1] },
+        { NULL, NULL, 0, results[2] },
+        { NULL, &p3, 1, results[3] },
+    };
+    uint32_t data[4], r_esi, r_eax = 0x1234;
+    int i;
+
+    setup_sum(uc);
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &r_eax));
+
+    OK(uc_emu_batch(uc, CODE, CODE + sizeof(sum_code), 0, 0, regs, 2, jobs, 4));
+
+    // each job sees its own patches only, on top of the initial memory
+    for (i = 0; i < 4; i++) {
+        OK(jobs[i].err);
+        assert_int_equal(results[i][1], DATA + 16);
+    }
+    assert_int_equal(results[0][0], 10 + 20 + 3 + 4);
+    assert_int_equal(results[1][0], 1 + 2 + 100 + 4);
+    assert_int_equal(results[2][0], 1 + 2 + 3 + 4);
+    assert_int_equal(results[3][0], 28);
+
+    // the engine is left as it was
+    OK(uc_mem_read(uc, DATA, data, sizeof(data)));
+    assert_int_equal(data[0], 1);
+    assert_int_equal(data[1], 2);
+    assert_int_equal(data[2], 3);
+    assert_int_equal(data[3], 4);
+    OK(uc_reg_read(uc, UC_X86_REG_ESI, &r_esi));
+    assert_int_equal(r_esi, DATA);
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &r_eax));
+    assert_int_equal(r_eax, 0x1234);
+
+    // and runs as before
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(sum_code), 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &r_eax));
+    assert_int_equal(r_eax, 10);
+    OK(uc_mem_read(uc, DATA, data, sizeof(data)));
+    assert_int_equal(data[3], 10);
+}
+
+static void test_batch_contexts(void **state)
+{
+    uc_engine *uc = *state;
+    const int regs[] = { UC_X86_REG_EAX };
+    uint64_t results[3];
+    uc_batch_job jobs[3];
+    uc_context *ctx[2];
+    uint32_t r_ecx;
+    int i;
+
+    setup_sum(uc);
+
+    // contexts summing the first 1 and 2 dwords
+    for (i = 0; i < 2; i++) {
+        OK(uc_context_alloc(uc, &ctx[i]));
+        r_ecx = i + 1;
+        OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+        OK(uc_context_save(uc, ctx[i]));
+    }
+    r_ecx = 3;
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+
+    memset(jobs, 0, sizeof(jobs));
+    jobs[0].context = ctx[1];
+    jobs[1].context = NULL;
+    jobs[2].context = ctx[0];
+    for (i = 0; i < 3; i++)
+        jobs[i].results = &results[i];
+
+    OK(uc_emu_batch(uc, CODE, CODE + sizeof(sum_code), 0, 0, regs, 1, jobs, 3));
+
+    assert_int_equal(results[0], 3);
+    assert_int_equal(results[1], 6);
+    assert_int_equal(results[2], 1);
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_ecx, 3);
+
+    uc_free(ctx[0]);
+    uc_free(ctx[1]);
+}
+
+static void test_batch_errors(void **state)
+{
+    uc_engine *uc = *state;
+    const uint32_t bad = 0x300000, unmapped = 0x400000;
+    const uc_batch_patch p_bad = { DATA, &bad, sizeof(bad) };
+    const uc_batch_patch p_unmapped = { unmapped, &bad, sizeof(bad) };
+    const uint8_t code[] = {
+        0x8b, 0x1e,                 // mov ebx, [esi]
+        0x8b, 0x03,                 // mov eax, [ebx]
+    };
+    const int regs[] = { UC_X86_REG_EAX };
+    uint64_t results[3] = { 1, 1, 1 };
+    uc_batch_job jobs[3] = {
+        { NULL, &p_bad, 1, &results[0] },
+        { NULL, &p_unmapped, 1, &results[1] },
+        { NULL, NULL, 0, &results[2] },
+    };
+    const uint32_t ptr = DATA + 4, value = 0xcafe;
+    uint32_t r_esi = DATA;
+
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_map(uc, DATA, 0x1000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_mem_write(uc, DATA, &ptr, sizeof(ptr)));
+    OK(uc_mem_write(uc, DATA + 4, &value, sizeof(value)));
+    OK(uc_reg_write(uc, UC_X86_REG_ESI, &r_esi));
+
+    // a failing job does not stop the batch
+    OK(uc_emu_batch(uc, CODE, CODE + sizeof(code), 0, 0, regs, 1, jobs, 3));
+    uc_assert_err(UC_ERR_READ_UNMAPPED, jobs[0].err);
+    uc_assert_err(UC_ERR_WRITE_UNMAPPED, jobs[1].err);
+    OK(jobs[2].err);
+    // the job whose patch failed did not run, and has no results
+    assert_int_equal(results[1], 0);
+    assert_int_equal(results[2], 0xcafe);
+
+    uc_assert_err(UC_ERR_ARG, uc_emu_batch(uc, CODE, CODE + sizeof(code), 0, 0, NULL, 1, jobs, 3));
+}
+
+static void test_batch_code_patch(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0xb8, 0x01, 0x00, 0x00, 0x00,   // mov eax, 1
+        0xc7, 0x05, 0x01, 0x10, 0x00, 0x00, 0x63, 0x00, 0x00, 0x00,   // mov dword [CODE + 1], 99
+    };
+    const uint32_t imm[2] = { 5, 6 };
+    const uc_batch_patch p[2] = {
+        { CODE + 1, &imm[0], 4 },
+        { CODE + 1, &imm[1], 4 },
+    };
+    const int regs[] = { UC_X86_REG_EAX };
+    uint64_t results[4];
+    uc_batch_job jobs[4] = {
+        { NULL, &p[0], 1, &results[0] },
+        { NULL, NULL, 0, &results[1] },
+        { NULL, &p[1], 1, &results[2] },
+        { NULL, NULL, 0, &results[3] },
+    };
+    uint32_t r_eax;
+
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+
+    // translated code follows the patched, self-modified and restored code
+    OK(uc_emu_batch(uc, CODE, CODE + sizeof(code), 0, 0, regs, 1, jobs, 4));
+    assert_int_equal(results[0], 5);
+    assert_int_equal(results[1], 1);
+    assert_int_equal(results[2], 6);
+    assert_int_equal(results[3], 1);
+
+    OK(uc_emu_start(uc, CODE, CODE + 5, 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &r_eax));
+    assert_int_equal(r_eax, 1);
+}
+
+static void test_batch_many_pages(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0xb9, 0x00, 0x00, 0x00, 0x00,   // mov ecx, 0
+        0xbf, 0x00, 0x00, 0x10, 0x00,   // mov edi, DATA
+        0xb8, 0x11, 0x11, 0x11, 0x11,   // mov eax, 0x11111111
+        0xf3, 0xab,                     // rep stosd
+        0x8b, 0x1d, 0xfc, 0xff, 0x11, 0x00,   // mov ebx, [DATA + 0x1fffc]
+    };
+    const uint32_t fill = 0x8000;
+    const uc_batch_patch p = { CODE + 1, &fill, sizeof(fill) };
+    const int regs[] = { UC_X86_REG_EBX };
+    uint64_t results[3];
+    uc_batch_job jobs[3] = {
+        { NULL, &p, 1, &results[0] },
+        { NULL, NULL, 0, &results[1] },
+        { NULL, &p, 1, &results[2] },
+    };
+    uint32_t value;
+
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_map(uc, DATA, 0x20000, UC_PROT_READ | UC_PROT_WRITE));
+
+    // more pages are written than are tracked one by one in the TLB
+    OK(uc_emu_batch(uc, CODE, CODE + sizeof(code), 0, 0, regs, 1, jobs, 3));
+    assert_int_equal(results[0], 0x11111111);
+    assert_int_equal(results[1], 0);
+    assert_int_equal(results[2], 0x11111111);
+
+    OK(uc_mem_read(uc, DATA, &value, 4));
+    assert_int_equal(value, 0);
+    OK(uc_mem_read(uc, DATA + 0x10000, &value, 4));
+    assert_int_equal(value, 0);
+}
+
+static void test_batch_arm(void **state)
+{
+    const uint32_t code[] = {
+        0xe5901000,     // ldr r1, [r0]
+        0xe0811001,     // add r1, r1, r1
+        0xe5801000,     // str r1, [r0]
+        0xe5801400,     // str r1, [r0, #0x400]
+    };
+    const uint32_t in[3] = { 1, 2, 3 };
+    const uc_batch_patch p[3] = {
+        { DATA, &in[0], 4 }, { DATA, &in[1], 4 }, { DATA, &in[2], 4 },
+    };
+    const int regs[] = { UC_ARM_REG_R1 };
+    uint64_t results[3];
+    uc_batch_job jobs[3] = {
+        { NULL, &p[0], 1, &results[0] },
+        { NULL, &p[1], 1, &results[1] },
+        { NULL, &p[2], 1, &results[2] },
+    };
+    uint32_t r0 = DATA, value;
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_ARM, UC_MODE_ARM, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_map(uc, DATA, 0x1000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_reg_write(uc, UC_ARM_REG_R0, &r0));
+
+    OK(uc_emu_batch(uc, CODE, CODE + sizeof(code), 0, 0, regs, 1, jobs, 3));
+    assert_int_equal(results[0], 2);
+    assert_int_equal(results[1], 4);
+    assert_int_equal(results[2], 6);
+
+    // both target pages of the data are put back
+    OK(uc_mem_read(uc, DATA, &value, 4));
+    assert_int_equal(value, 0);
+    OK(uc_mem_read(uc, DATA + 0x400, &value, 4));
+    assert_int_equal(value, 0);
+
+    OK(uc_close(uc));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_batch_patches, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_batch_contexts, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_batch_errors, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_batch_code_patch, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_batch_many_pages, setup32, teardown),
+        cmocka_unit_test(test_batch_arm),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,124 @@
+// Test breakpoints set with uc_breakpoint_add()
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define ADDRESS 0x1000000
+
+/* Called before every test to set up a new instance */
+static int setup32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+static void test_code_hook(uc_engine *uc, uint64_t address, uint32_t size, void *user_data)
+{
+    int *count = user_data;
+    (*count)++;
+}
+
+static void test_breakpoint_loop(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0x41,       // inc ecx
+        0x4a,       // dec edx      <- breakpoint
+        0x75, 0xfc, // jnz ADDRESS
+        0x90,       // nop
+    };
+    uint32_t r_ecx = 0, r_edx = 3, r_eip;
+    uint64_t pc = ADDRESS;
+    int stops = 0;
+
+    OK(uc_mem_map(uc, ADDRESS, 2 * 1024 * 1024, UC_PROT_ALL));
+    OK(uc_mem_write(uc, ADDRESS, code, sizeof(code)));
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+    OK(uc_reg_write(uc, UC_X86_REG_EDX, &r_edx));
+
+    OK(uc_breakpoint_add(uc, ADDRESS + 1));
+
+    // stop once per loop iteration, right before "dec edx"
+    for (;;) {
+        uc_err err = uc_emu_start(uc, pc, ADDRESS + sizeof(code), 0, 0);
+        if (err == UC_ERR_OK)
+            break;
+        uc_assert_err(UC_ERR_BREAKPOINT, err);
+
+        stops++;
+        OK(uc_reg_read(uc, UC_X86_REG_EIP, &r_eip));
+        OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+        assert_int_equal(r_eip, ADDRESS + 1);
+        assert_int_equal(r_ecx, stops);
+        pc = r_eip;
+    }
+
+    assert_int_equal(stops, 3);
+    OK(uc_reg_read(uc, UC_X86_REG_EDX, &r_edx));
+    assert_int_equal(r_edx, 0);
+}
+
+static void test_breakpoint_del(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0x41,       // inc ecx
+        0x41,       // inc ecx      <- breakpoint
+        0x41,       // inc ecx
+    };
+    uint32_t r_ecx = 0;
+    int count = 0;
+    uc_hook trace;
+
+    OK(uc_mem_map(uc, ADDRESS, 2 * 1024 * 1024, UC_PROT_ALL));
+    OK(uc_mem_write(uc, ADDRESS, code, sizeof(code)));
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+    OK(uc_hook_add(uc, &trace, UC_HOOK_CODE, test_code_hook, &count, 1, 0));
+
+    uc_assert_err(UC_ERR_ARG, uc_breakpoint_del(uc, ADDRESS + 1));
+    OK(uc_breakpoint_add(uc, ADDRESS + 1));
+    OK(uc_breakpoint_add(uc, ADDRESS + 1));
+
+    // the instruction at the breakpoint is not executed
+    uc_assert_err(UC_ERR_BREAKPOINT, uc_emu_start(uc, ADDRESS, ADDRESS + sizeof(code), 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_ecx, 1);
+    assert_int_equal(count, 1);
+
+    // without the breakpoint, the code runs to the end
+    OK(uc_breakpoint_del(uc, ADDRESS + 1));
+    uc_assert_err(UC_ERR_ARG, uc_breakpoint_del(uc, ADDRESS + 1));
+    r_ecx = 0;
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+    OK(uc_emu_start(uc, ADDRESS, ADDRESS + sizeof(code), 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_ecx, 3);
+    assert_int_equal(count, 4);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_breakpoint_loop, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_breakpoint_del, setup32, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,160 @@
+// Test translation ahead of emulation with uc_cache_translate()
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define ADDRESS 0x1000000
+
+/* Called before every test to set up a new instance */
+static int setup32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+static void test_cache_translate(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0x41,       // inc ecx
+        0x4a,       // dec edx
+        0x75, 0xfc, // jnz ADDRESS
+        0x90,       // nop
+        0x90,       // nop
+    };
+    uint32_t r_ecx = 0, r_edx = 3;
+    uc_cache_info info;
+
+    OK(uc_mem_map(uc, ADDRESS, 2 * 1024 * 1024, UC_PROT_ALL));
+    OK(uc_mem_write(uc, ADDRESS, code, sizeof(code)));
+
+    // the loop & the nop after it, which stops at @until
+    OK(uc_cache_translate(uc, ADDRESS, ADDRESS + sizeof(code), ADDRESS + 5, &info));
+    assert_int_equal(info.blocks, 2);
+    assert_true(info.code_size > 0);
+
+    // these blocks are already translated
+    OK(uc_cache_translate(uc, ADDRESS, ADDRESS + sizeof(code), ADDRESS + 5, &info));
+    assert_int_equal(info.blocks, 0);
+    assert_int_equal(info.code_size, 0);
+
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+    OK(uc_reg_write(uc, UC_X86_REG_EDX, &r_edx));
+    OK(uc_emu_start(uc, ADDRESS, ADDRESS + 5, 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    OK(uc_reg_read(uc, UC_X86_REG_EDX, &r_edx));
+    assert_int_equal(r_ecx, 3);
+    assert_int_equal(r_edx, 0);
+
+    // translated code survives emulation
+    OK(uc_cache_translate(uc, ADDRESS, ADDRESS + sizeof(code), ADDRESS + 5, &info));
+    assert_int_equal(info.blocks, 0);
+
+    // ... but not a change of @until
+    OK(uc_cache_translate(uc, ADDRESS, ADDRESS + sizeof(code), ADDRESS + 6, &info));
+    assert_int_equal(info.blocks, 2);
+
+    OK(uc_cache_flush(uc));
+    OK(uc_cache_translate(uc, ADDRESS, ADDRESS + sizeof(code), ADDRESS + 6, &info));
+    assert_int_equal(info.blocks, 2);
+
+    uc_assert_err(UC_ERR_FETCH_UNMAPPED, uc_cache_translate(uc, 0x10000, 0x10010, 0, &info));
+    assert_int_equal(info.blocks, 0);
+}
+
+static void test_cache_code_changed(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code1[] = { 0x41 };   // inc ecx
+    const uint8_t code2[] = { 0x49 };   // dec ecx
+    uint32_t r_ecx = 0;
+
+    OK(uc_mem_map(uc, ADDRESS, 2 * 1024 * 1024, UC_PROT_ALL));
+    OK(uc_mem_write(uc, ADDRESS, code1, sizeof(code1)));
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+
+    OK(uc_emu_start(uc, ADDRESS, ADDRESS + 1, 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_ecx, 1);
+
+    // the code translated by the first run must not be reused
+    OK(uc_mem_write(uc, ADDRESS, code2, sizeof(code2)));
+    OK(uc_emu_start(uc, ADDRESS, ADDRESS + 1, 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_ecx, 0);
+}
+
+static void test_cache_list(void **state)
+{
+    uc_engine *uc = *state, *uc2;
+    const uint8_t code[] = {
+        0x41,       // inc ecx
+        0x4a,       // dec edx
+        0x75, 0xfc, // jnz ADDRESS
+        0x90,       // nop
+        0x90,       // nop
+    };
+    const uint8_t nop = 0x90;
+    const char *path = "test_cache.bin";
+    uint32_t r_ecx = 0, r_edx = 3;
+    uc_cache_info info;
+
+    OK(uc_mem_map(uc, ADDRESS, 2 * 1024 * 1024, UC_PROT_ALL));
+    OK(uc_mem_write(uc, ADDRESS, code, sizeof(code)));
+    OK(uc_cache_translate(uc, ADDRESS, ADDRESS + sizeof(code), ADDRESS + sizeof(code), &info));
+    assert_int_equal(info.blocks, 2);
+    OK(uc_cache_save_list(uc, path));
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc2));
+    OK(uc_mem_map(uc2, ADDRESS, 2 * 1024 * 1024, UC_PROT_ALL));
+    OK(uc_mem_write(uc2, ADDRESS, code, sizeof(code)));
+    OK(uc_cache_translate_list(uc2, path, ADDRESS + sizeof(code), &info));
+    assert_int_equal(info.blocks, 2);
+
+    OK(uc_reg_write(uc2, UC_X86_REG_ECX, &r_ecx));
+    OK(uc_reg_write(uc2, UC_X86_REG_EDX, &r_edx));
+    OK(uc_emu_start(uc2, ADDRESS, ADDRESS + sizeof(code), 0, 0));
+    OK(uc_reg_read(uc2, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_ecx, 3);
+
+    // the block whose code changed is not translated
+    OK(uc_cache_flush(uc2));
+    OK(uc_mem_write(uc2, ADDRESS, &nop, 1));
+    OK(uc_cache_translate_list(uc2, path, ADDRESS + sizeof(code), &info));
+    assert_int_equal(info.blocks, 1);
+    OK(uc_close(uc2));
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_64, &uc2));
+    uc_assert_err(UC_ERR_MODE, uc_cache_translate_list(uc2, path, 0, &info));
+    OK(uc_close(uc2));
+
+    remove(path);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_cache_translate, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_cache_code_changed, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_cache_list, setup32, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,245 @@
+// Test calling guest functions with uc_call()
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE    0x10000
+#define STACK   0x200000
+
+static uc_engine *setup(uc_arch arch, uc_mode mode, const void *code, size_t size, int sp)
+{
+    uc_engine *uc;
+    uint64_t stack = STACK + 0xf000;
+
+    OK(uc_open(arch, mode, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, size));
+    OK(uc_mem_map(uc, STACK, 0x10000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_reg_write(uc, sp, &stack));
+    return uc;
+}
+
+/******************************************************************************/
+
+static void test_call_cdecl(void **state)
+{
+    const uint8_t code[] = {
+        0x8b, 0x44, 0x24, 0x04,     // mov eax, [esp+4]
+        0x2b, 0x44, 0x24, 0x08,     // sub eax, [esp+8]
+        0xc3,                       // ret
+    };
+    const uint64_t args[] = { 1000, 42 };
+    uc_engine *uc = setup(UC_ARCH_X86, UC_MODE_32, code, sizeof(code), UC_X86_REG_ESP);
+    uint64_t result = 0;
+    uint32_t esp;
+    int i;
+
+    // the same code runs again for each call
+    for (i = 0; i < 3; i++) {
+        OK(uc_call(uc, CODE, UC_CALL_DEFAULT, args, 2, &result, 0, 0));
+        assert_int_equal(result, 958);
+    }
+
+    // the stack is aligned at the call, and the return address popped
+    OK(uc_reg_read(uc, UC_X86_REG_ESP, &esp));
+    assert_int_equal(esp % 16, 0);
+
+    uc_assert_err(UC_ERR_ARG, uc_call(uc, CODE, UC_CALL_SYSV64, args, 2, &result, 0, 0));
+    OK(uc_close(uc));
+}
+
+static void hook_stop(uc_engine *uc, uint64_t address, uint32_t size, void *user_data)
+{
+    uc_emu_stop(uc);
+}
+
+static void test_call_unfinished(void **state)
+{
+    const uint8_t code[] = {
+        0x40,                       // inc eax
+        0xc3,                       // ret
+    };
+    uc_engine *uc = setup(UC_ARCH_X86, UC_MODE_32, code, sizeof(code), UC_X86_REG_ESP);
+    uint64_t result = 1234;
+    uint32_t eip;
+    uc_hook hook;
+
+    // the function does not return: @result is cleared
+    uc_assert_err(UC_ERR_CALL_STOPPED, uc_call(uc, CODE, UC_CALL_CDECL, NULL, 0, &result, 0, 1));
+    assert_int_equal(result, 0);
+    OK(uc_reg_read(uc, UC_X86_REG_EIP, &eip));
+    assert_int_equal(eip, CODE + 1);
+
+    // nor when emulation is stopped from a hook
+    result = 1234;
+    OK(uc_hook_add(uc, &hook, UC_HOOK_CODE, hook_stop, NULL, CODE + 1, CODE + 1));
+    uc_assert_err(UC_ERR_CALL_STOPPED, uc_call(uc, CODE, UC_CALL_CDECL, NULL, 0, &result, 0, 0));
+    assert_int_equal(result, 0);
+    OK(uc_hook_del(uc, hook));
+
+    // but a call run to the end succeeds
+    OK(uc_call(uc, CODE, UC_CALL_CDECL, NULL, 0, &result, 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_EIP, &eip));
+    assert_int_equal(eip, 0xfffff000);
+
+    OK(uc_close(uc));
+}
+
+static void test_call_sysv64(void **state)
+{
+    const uint8_t code[] = {
+        0x48, 0x89, 0xf8,               // mov rax, rdi
+        0x4c, 0x01, 0xc8,               // add rax, r9
+        0x48, 0x03, 0x44, 0x24, 0x08,   // add rax, [rsp+8]
+        0x48, 0x2b, 0x44, 0x24, 0x10,   // sub rax, [rsp+16]
+        0xc3,                           // ret
+    };
+    const uint64_t args[] = { 0x100000000ULL, 2, 3, 4, 5, 6000, 70000, 8 };
+    uc_engine *uc = setup(UC_ARCH_X86, UC_MODE_64, code, sizeof(code), UC_X86_REG_RSP);
+    uint64_t result = 0;
+
+    OK(uc_call(uc, CODE, UC_CALL_DEFAULT, args, 8, &result, 0, 0));
+    assert_true(result == 0x100000000ULL + 6000 + 70000 - 8);
+
+    OK(uc_close(uc));
+}
+
+static void test_call_ms64(void **state)
+{
+    const uint8_t code[] = {
+        0x48, 0x89, 0xc8,               // mov rax, rcx
+        0x4c, 0x01, 0xc8,               // add rax, r9
+        0x48, 0x03, 0x44, 0x24, 0x28,   // add rax, [rsp+40]
+        0xc3,                           // ret
+    };
+    const uint64_t args[] = { 100, 2, 3, 4000, 50000 };
+    uc_engine *uc = setup(UC_ARCH_X86, UC_MODE_64, code, sizeof(code), UC_X86_REG_RSP);
+    uint64_t result = 0;
+
+    OK(uc_call(uc, CODE, UC_CALL_MS64, args, 5, &result, 0, 0));
+    assert_int_equal(result, 54100);
+
+    OK(uc_close(uc));
+}
+
+static void test_call_aapcs(void **state)
+{
+    const uint32_t code[] = {
+        0xe0400003,     // sub r0, r0, r3
+        0xe59d1000,     // ldr r1, [sp]
+        0xe0800001,     // add r0, r0, r1
+        0xe12fff1e,     // bx lr
+    };
+    const uint16_t thumb[] = {
+        0x1a40,         // subs r0, r0, r1
+        0x4770,         // bx lr
+    };
+    const uint64_t args[] = { 1000, 2, 3, 40, 500 };
+    uc_engine *uc = setup(UC_ARCH_ARM, UC_MODE_ARM, code, sizeof(code), UC_ARM_REG_SP);
+    uint64_t result = 0;
+
+    OK(uc_call(uc, CODE, UC_CALL_DEFAULT, args, 5, &result, 0, 0));
+    assert_int_equal(result, 1460);
+
+    // the lowest bit of the address selects Thumb mode
+    OK(uc_mem_write(uc, CODE + 0x100, thumb, sizeof(thumb)));
+    OK(uc_call(uc, CODE + 0x101, UC_CALL_AAPCS, args, 2, &result, 0, 0));
+    assert_int_equal(result, 998);
+
+    OK(uc_close(uc));
+}
+
+static void test_call_aapcs64(void **state)
+{
+    const uint32_t code[] = {
+        0x8b070000,     // add x0, x0, x7
+        0xa9400be1,     // ldp x1, x2, [sp]
+        0x8b010000,     // add x0, x0, x1
+        0xcb020000,     // sub x0, x0, x2
+        0xd65f03c0,     // ret
+    };
+    const uint64_t args[] = { 1000, 1, 2, 3, 4, 5, 6, 200, 30, 4 };
+    uc_engine *uc = setup(UC_ARCH_ARM64, UC_MODE_ARM, code, sizeof(code), UC_ARM64_REG_SP);
+    uint64_t result = 0;
+
+    OK(uc_call(uc, CODE, UC_CALL_DEFAULT, args, 10, &result, 0, 0));
+    assert_int_equal(result, 1226);
+
+    OK(uc_close(uc));
+}
+
+static void test_call_mips_o32(void **state)
+{
+    const uint32_t code[] = {
+        0x00871023,     // subu v0, a0, a3
+        0x8fa80010,     // lw t0, 16(sp)
+        0x03e00008,     // jr ra
+        0x00481021,     // addu v0, v0, t0
+    };
+    const uint64_t args[] = { 1000, 2, 3, 40, 500 };
+    uc_engine *uc = setup(UC_ARCH_MIPS, UC_MODE_MIPS32 | UC_MODE_LITTLE_ENDIAN, code, sizeof(code), UC_MIPS_REG_SP);
+    uint64_t result = 0;
+    uint32_t t9;
+
+    OK(uc_call(uc, CODE, UC_CALL_DEFAULT, args, 5, &result, 0, 0));
+    assert_int_equal(result, 1460);
+
+    // position-independent code finds its address in t9
+    OK(uc_reg_read(uc, UC_MIPS_REG_T9, &t9));
+    assert_int_equal(t9, CODE);
+
+    OK(uc_close(uc));
+}
+
+static void test_call_mips_o32_be(void **state)
+{
+    const uint8_t code[] = {
+        0x00, 0x87, 0x10, 0x23,     // subu v0, a0, a3
+        0x8f, 0xa8, 0x00, 0x10,     // lw t0, 16(sp)
+        0x03, 0xe0, 0x00, 0x08,     // jr ra
+        0x00, 0x48, 0x10, 0x21,     // addu v0, v0, t0
+    };
+    const uint64_t args[] = { 1000, 2, 3, 40, 500 };
+    uc_engine *uc = setup(UC_ARCH_MIPS, UC_MODE_MIPS32 | UC_MODE_BIG_ENDIAN, code, sizeof(code), UC_MIPS_REG_SP);
+    uint64_t result = 0;
+
+    OK(uc_call(uc, CODE, UC_CALL_MIPS_O32, args, 5, &result, 0, 0));
+    assert_int_equal(result, 1460);
+
+    OK(uc_close(uc));
+}
+
+static void test_call_mips_n64(void **state)
+{
+    const uint32_t code[] = {
+        0x008b102d,     // daddu v0, a0, $11
+        0xdfac0000,     // ld $12, 0(sp)
+        0x03e00008,     // jr ra
+        0x004c102d,     // daddu v0, v0, $12
+    };
+    const uint64_t args[] = { 0x100000000ULL, 1, 2, 3, 4, 5, 6, 200, 30 };
+    uc_engine *uc = setup(UC_ARCH_MIPS, UC_MODE_MIPS64 | UC_MODE_LITTLE_ENDIAN, code, sizeof(code), UC_MIPS_REG_SP);
+    uint64_t result = 0;
+
+    OK(uc_call(uc, CODE, UC_CALL_DEFAULT, args, 9, &result, 0, 0));
+    assert_true(result == 0x100000000ULL + 200 + 30);
+
+    OK(uc_close(uc));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_call_cdecl),
+        cmocka_unit_test(test_call_unfinished),
+        cmocka_unit_test(test_call_sysv64),
+        cmocka_unit_test(test_call_ms64),
+        cmocka_unit_test(test_call_aapcs),
+        cmocka_unit_test(test_call_aapcs64),
+        cmocka_unit_test(test_call_mips_o32),
+        cmocka_unit_test(test_call_mips_o32_be),
+        cmocka_unit_test(test_call_mips_n64),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,375 @@
+// Test CPU contexts holding some register groups, and copying only what changed
+#include <string.h>
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE    0x1000
+
+/* Called before every test to set up a new instance */
+static int setup32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+    OK(uc_mem_map(uc, 0, 0x100000, UC_PROT_ALL));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+static void test_context_groups(void **state)
+{
+    uc_engine *uc = *state;
+    uc_context *gpr, *all;
+    uint64_t xmm0[2] = { 5, 5 };
+    uint32_t eax = 1;
+
+    OK(uc_context_alloc_groups(uc, UC_CTX_GPR, &gpr));
+    OK(uc_context_alloc(uc, &all));
+
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_reg_write(uc, UC_X86_REG_XMM0, xmm0));
+    OK(uc_context_save(uc, gpr));
+    OK(uc_context_save(uc, all));
+
+    eax = 2;
+    xmm0[0] = 6;
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_reg_write(uc, UC_X86_REG_XMM0, xmm0));
+
+    // the FPU is not part of the context
+    OK(uc_context_restore(uc, gpr));
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_reg_read(uc, UC_X86_REG_XMM0, xmm0));
+    assert_int_equal(eax, 1);
+    assert_int_equal(xmm0[0], 6);
+
+    OK(uc_context_restore(uc, all));
+    OK(uc_reg_read(uc, UC_X86_REG_XMM0, xmm0));
+    assert_int_equal(xmm0[0], 5);
+
+    assert_int_equal(uc_context_alloc_groups(uc, 0, &gpr), UC_ERR_ARG);
+    assert_int_equal(uc_context_alloc_groups(uc, UC_CTX_ALL + 1, &gpr), UC_ERR_ARG);
+
+    OK(uc_free(gpr));
+    OK(uc_free(all));
+}
+
+// switch between two threads, which change their SSE registers
+static void test_context_threads_sse(void **state)
+{
+    uc_engine *uc = *state;
+    static const uint8_t code[] = { 0x66, 0x0f, 0xfe, 0xc0 };  // paddd xmm0, xmm0
+    uc_context *a, *b;
+    uint64_t xmm0[2] = { 1, 0 };
+
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_context_alloc(uc, &a));
+    OK(uc_context_alloc(uc, &b));
+
+    OK(uc_reg_write(uc, UC_X86_REG_XMM0, xmm0));
+    OK(uc_context_save(uc, a));
+    xmm0[0] = 100;
+    OK(uc_reg_write(uc, UC_X86_REG_XMM0, xmm0));
+    OK(uc_context_save(uc, b));
+
+    OK(uc_context_restore(uc, a));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    OK(uc_context_save(uc, a));
+
+    OK(uc_context_restore(uc, b));
+    OK(uc_reg_read(uc, UC_X86_REG_XMM0, xmm0));
+    assert_int_equal(xmm0[0], 100);
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    OK(uc_context_save(uc, b));
+
+    OK(uc_context_restore(uc, a));
+    OK(uc_reg_read(uc, UC_X86_REG_XMM0, xmm0));
+    assert_int_equal(xmm0[0], 2);
+
+    OK(uc_context_restore(uc, b));
+    OK(uc_reg_read(uc, UC_X86_REG_XMM0, xmm0));
+    assert_int_equal(xmm0[0], 200);
+
+    OK(uc_free(a));
+    OK(uc_free(b));
+}
+
+// the same with the x87 stack
+static void test_context_threads_x87(void **state)
+{
+    uc_engine *uc = *state;
+    static const uint8_t code[] = { 0xd9, 0xe8 };  // fld1
+    uc_context *a, *b;
+    uint16_t fpsw;
+
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_context_alloc(uc, &a));
+    OK(uc_context_alloc(uc, &b));
+    OK(uc_context_save(uc, a));
+    OK(uc_context_save(uc, b));
+
+    OK(uc_context_restore(uc, a));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    OK(uc_context_save(uc, a));
+
+    // TOP of the stack
+    OK(uc_context_restore(uc, b));
+    OK(uc_reg_read(uc, UC_X86_REG_FPSW, &fpsw));
+    assert_int_equal((fpsw >> 11) & 7, 0);
+
+    OK(uc_context_restore(uc, a));
+    OK(uc_reg_read(uc, UC_X86_REG_FPSW, &fpsw));
+    assert_int_equal((fpsw >> 11) & 7, 7);
+
+    OK(uc_free(a));
+    OK(uc_free(b));
+}
+
+static void save_hook(uc_engine *uc, uint64_t address, uint32_t size, void *user_data)
+{
+    OK(uc_context_save(uc, user_data));
+}
+
+// save a context from a hook, while emulation changes the registers
+static void test_context_save_in_hook(void **state)
+{
+    uc_engine *uc = *state;
+    static const uint8_t code[] = {
+        0x66, 0x0f, 0xfe, 0xc0,     // paddd xmm0, xmm0
+        0x40,                       // inc eax
+        0x90,                       // nop
+    };
+    uc_context *ctx;
+    uc_hook hh;
+    uint64_t xmm0[2] = { 3, 0 };
+    uint32_t eax = 10;
+
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_reg_write(uc, UC_X86_REG_XMM0, xmm0));
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_context_alloc(uc, &ctx));
+    OK(uc_context_save(uc, ctx));
+
+    OK(uc_hook_add(uc, &hh, UC_HOOK_CODE, save_hook, ctx, CODE + 5, CODE + 5));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    xmm0[0] = 0;
+    eax = 0;
+    OK(uc_reg_write(uc, UC_X86_REG_XMM0, xmm0));
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_context_restore(uc, ctx));
+    OK(uc_reg_read(uc, UC_X86_REG_XMM0, xmm0));
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &eax));
+    assert_int_equal(xmm0[0], 6);
+    assert_int_equal(eax, 11);
+
+    OK(uc_free(ctx));
+}
+
+// two threads with their own page tables: only A maps 0x400000
+static void test_context_address_space(void **state)
+{
+    uc_engine *uc = *state;
+    static const uint8_t code[] = { 0xa1, 0x00, 0x00, 0x40, 0x00 };  // mov eax, [0x400000]
+    // mov eax, 0x10000; mov cr3, eax; mov eax, cr0; or eax, 0x80000001; mov cr0, eax
+    static const uint8_t paging[] = {
+        0xb8, 0x00, 0x00, 0x01, 0x00, 0x0f, 0x22, 0xd8, 0x0f, 0x20, 0xc0,
+        0x0d, 0x01, 0x00, 0x00, 0x80, 0x0f, 0x22, 0xc0,
+    };
+    const uint32_t pt0 = 0x12000 | 3, pt_a = 0x13000 | 3;
+    const uint32_t code_pte = CODE | 3, pte_a = 0x400000 | 3;
+    const uint32_t val = 0xaaaa;
+    uint32_t cr3, eax;
+    uc_context *a, *b;
+
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_write(uc, CODE + 0x100, paging, sizeof(paging)));
+    OK(uc_mem_map(uc, 0x400000, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, 0x400000, &val, 4));
+    // directories of A & B
+    OK(uc_mem_write(uc, 0x10000, &pt0, 4));
+    OK(uc_mem_write(uc, 0x10004, &pt_a, 4));
+    OK(uc_mem_write(uc, 0x11000, &pt0, 4));
+    // tables mapping the code, then 0x400000
+    OK(uc_mem_write(uc, 0x12000 + (CODE >> 12) * 4, &code_pte, 4));
+    OK(uc_mem_write(uc, 0x13000, &pte_a, 4));
+
+    OK(uc_context_alloc(uc, &a));
+    OK(uc_context_alloc(uc, &b));
+    // the guest turns paging on, as uc_reg_write() does not update the MMU mode
+    OK(uc_emu_start(uc, CODE + 0x100, CODE + 0x100 + sizeof(paging), 0, 0));
+    OK(uc_context_save(uc, a));
+    cr3 = 0x11000;
+    OK(uc_reg_write(uc, UC_X86_REG_CR3, &cr3));
+    OK(uc_context_save(uc, b));
+
+    OK(uc_context_restore(uc, a));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &eax));
+    assert_int_equal(eax, val);
+
+    // the TLB of A must not leak into B
+    OK(uc_context_restore(uc, b));
+    assert_int_equal(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0), UC_ERR_EXCEPTION);
+
+    OK(uc_context_restore(uc, a));
+    eax = 0;
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &eax));
+    assert_int_equal(eax, val);
+
+    OK(uc_free(a));
+    OK(uc_free(b));
+}
+
+// a buffer sized with uc_context_size() is copied in full
+static void test_context_buffer(void **state)
+{
+    uc_engine *uc = *state;
+    size_t size = uc_context_size(uc);
+    uc_context *ctx = malloc(sizeof(size_t) + size);
+    uint64_t xmm0[2] = { 7, 0 };
+    uint32_t eax = 1;
+
+    *(size_t *)ctx = size;
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_reg_write(uc, UC_X86_REG_XMM0, xmm0));
+    OK(uc_context_save(uc, ctx));
+
+    eax = 2;
+    xmm0[0] = 8;
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_reg_write(uc, UC_X86_REG_XMM0, xmm0));
+    OK(uc_context_restore(uc, ctx));
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_reg_read(uc, UC_X86_REG_XMM0, xmm0));
+    assert_int_equal(eax, 1);
+    assert_int_equal(xmm0[0], 7);
+
+    free(ctx);
+}
+
+// a skipped conditional VFP instruction does not hide the next one
+static void test_context_arm_vfp(void **state)
+{
+    static const uint32_t code[] = {
+        0xe3500001,     // cmp r0, #1
+        0x1e300b00,     // vaddne.f64 d0, d0, d0
+        0xee311b01,     // vadd.f64 d1, d1, d1
+    };
+    uint32_t cpacr, fpexc = 0x40000000, r0 = 1;
+    uint64_t d1 = 0x3ff0000000000000ULL;   // 1.0
+    uc_context *a, *b;
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_ARM, UC_MODE_ARM, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_reg_read(uc, UC_ARM_REG_C1_C0_2, &cpacr));
+    cpacr |= 0xf << 20;
+    OK(uc_reg_write(uc, UC_ARM_REG_C1_C0_2, &cpacr));
+    OK(uc_reg_write(uc, UC_ARM_REG_FPEXC, &fpexc));
+    OK(uc_reg_write(uc, UC_ARM_REG_R0, &r0));
+
+    OK(uc_context_alloc(uc, &a));
+    OK(uc_context_alloc(uc, &b));
+    OK(uc_reg_write(uc, UC_ARM_REG_D1, &d1));
+    OK(uc_context_save(uc, a));
+    d1 = 0x4014000000000000ULL;     // 5.0
+    OK(uc_reg_write(uc, UC_ARM_REG_D1, &d1));
+    OK(uc_context_save(uc, b));
+
+    OK(uc_context_restore(uc, a));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    OK(uc_context_save(uc, a));
+
+    OK(uc_context_restore(uc, b));
+    OK(uc_reg_read(uc, UC_ARM_REG_D1, &d1));
+    assert_int_equal(d1, 0x4014000000000000ULL);
+
+    OK(uc_context_restore(uc, a));
+    OK(uc_reg_read(uc, UC_ARM_REG_D1, &d1));
+    assert_int_equal(d1, 0x4000000000000000ULL);    // 2.0
+
+    OK(uc_free(a));
+    OK(uc_free(b));
+    OK(uc_close(uc));
+}
+
+static void test_context_arm64_fp(void **state)
+{
+    static const uint32_t code[] = {
+        0x1e602800,     // fadd d0, d0, d0
+    };
+    uint64_t d0 = 0x3ff0000000000000ULL;   // 1.0
+    uint64_t tpidr = 0x1234, cpacr;
+    uc_context *a, *b;
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_ARM64, UC_MODE_ARM, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_reg_read(uc, UC_ARM64_REG_CPACR_EL1, &cpacr));
+    cpacr |= 3 << 20;   // FPEN
+    OK(uc_reg_write(uc, UC_ARM64_REG_CPACR_EL1, &cpacr));
+
+    OK(uc_context_alloc_groups(uc, UC_CTX_GPR | UC_CTX_FPU, &a));
+    OK(uc_context_alloc_groups(uc, UC_CTX_GPR | UC_CTX_FPU, &b));
+    OK(uc_reg_write(uc, UC_ARM64_REG_D0, &d0));
+    OK(uc_context_save(uc, a));
+    d0 = 0x4014000000000000ULL;     // 5.0
+    OK(uc_reg_write(uc, UC_ARM64_REG_D0, &d0));
+    OK(uc_context_save(uc, b));
+
+    OK(uc_context_restore(uc, a));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    OK(uc_context_save(uc, a));
+
+    // the thread register is left out of the contexts
+    OK(uc_reg_write(uc, UC_ARM64_REG_TPIDR_EL0, &tpidr));
+    OK(uc_context_restore(uc, b));
+    OK(uc_reg_read(uc, UC_ARM64_REG_D0, &d0));
+    assert_int_equal(d0, 0x4014000000000000ULL);
+    OK(uc_reg_read(uc, UC_ARM64_REG_TPIDR_EL0, &tpidr));
+    assert_int_equal(tpidr, 0x1234);
+
+    OK(uc_context_restore(uc, a));
+    OK(uc_reg_read(uc, UC_ARM64_REG_D0, &d0));
+    assert_int_equal(d0, 0x4000000000000000ULL);    // 2.0
+
+    OK(uc_free(a));
+    OK(uc_free(b));
+    OK(uc_close(uc));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_context_groups, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_context_threads_sse, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_context_threads_x87, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_context_save_in_hook, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_context_address_space, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_context_buffer, setup32, teardown),
+        cmocka_unit_test(test_context_arm_vfp),
+        cmocka_unit_test(test_context_arm64_fp),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
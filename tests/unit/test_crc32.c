@@ -0,0 +1,209 @@
+// Check the ARMv8 CRC32/CRC32C instructions, AArch32 (A32 and T32) and
+// AArch64, against a bitwise model of both polynomials.
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+#include <string.h>
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE 0x1000
+
+#define POLY_CRC32  0xedb88320
+#define POLY_CRC32C 0x82f63b78
+
+/* Called before every test to set up a new instance */
+static int setup_a32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_ARM, UC_MODE_ARM | UC_MODE_V8, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+
+    *state = uc;
+    return 0;
+}
+
+static int setup_t32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_ARM, UC_MODE_THUMB | UC_MODE_V8, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+
+    *state = uc;
+    return 0;
+}
+
+static int setup_a64(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_ARM64, UC_MODE_ARM, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+static uint64_t rnd_state = 0x853c49e6748fea9bULL;
+
+static uint64_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+// what the instructions compute: no inversion of input or output
+static uint32_t ref_crc(uint32_t poly, uint32_t crc, uint64_t val, int bytes)
+{
+    int i, j;
+
+    for (i = 0; i < bytes; i++) {
+        crc ^= (val >> (8 * i)) & 0xff;
+        for (j = 0; j < 8; j++) {
+            crc = (crc >> 1) ^ ((crc & 1) ? poly : 0);
+        }
+    }
+    return crc;
+}
+
+static void test_crc32_model(void **state)
+{
+    const char *check = "123456789";
+    uint32_t crc = 0xffffffff, crcc = 0xffffffff;
+    int i;
+
+    for (i = 0; check[i]; i++) {
+        crc = ref_crc(POLY_CRC32, crc, check[i], 1);
+        crcc = ref_crc(POLY_CRC32C, crcc, check[i], 1);
+    }
+    assert_int_equal(crc ^ 0xffffffff, 0xcbf43926);
+    assert_int_equal(crcc ^ 0xffffffff, 0xe3069283);
+}
+
+struct crc_insn {
+    const char *name;
+    uint8_t code[4];
+    uint32_t poly;
+    int bytes;
+};
+
+// crc32{c}{b,h,w} r0, r1, r2
+static const struct crc_insn a32_insns[] = {
+    { "crc32b", { 0x42, 0x00, 0x01, 0xe1 }, POLY_CRC32, 1 },
+    { "crc32h", { 0x42, 0x00, 0x21, 0xe1 }, POLY_CRC32, 2 },
+    { "crc32w", { 0x42, 0x00, 0x41, 0xe1 }, POLY_CRC32, 4 },
+    { "crc32cb", { 0x42, 0x02, 0x01, 0xe1 }, POLY_CRC32C, 1 },
+    { "crc32ch", { 0x42, 0x02, 0x21, 0xe1 }, POLY_CRC32C, 2 },
+    { "crc32cw", { 0x42, 0x02, 0x41, 0xe1 }, POLY_CRC32C, 4 },
+};
+
+static const struct crc_insn t32_insns[] = {
+    { "crc32b", { 0xc1, 0xfa, 0x82, 0xf0 }, POLY_CRC32, 1 },
+    { "crc32h", { 0xc1, 0xfa, 0x92, 0xf0 }, POLY_CRC32, 2 },
+    { "crc32w", { 0xc1, 0xfa, 0xa2, 0xf0 }, POLY_CRC32, 4 },
+    { "crc32cb", { 0xd1, 0xfa, 0x82, 0xf0 }, POLY_CRC32C, 1 },
+    { "crc32ch", { 0xd1, 0xfa, 0x92, 0xf0 }, POLY_CRC32C, 2 },
+    { "crc32cw", { 0xd1, 0xfa, 0xa2, 0xf0 }, POLY_CRC32C, 4 },
+};
+
+// crc32{c}{b,h,w} w0, w1, w2 and crc32{c}x w0, w1, x2
+static const struct crc_insn a64_insns[] = {
+    { "crc32b", { 0x20, 0x40, 0xc2, 0x1a }, POLY_CRC32, 1 },
+    { "crc32h", { 0x20, 0x44, 0xc2, 0x1a }, POLY_CRC32, 2 },
+    { "crc32w", { 0x20, 0x48, 0xc2, 0x1a }, POLY_CRC32, 4 },
+    { "crc32x", { 0x20, 0x4c, 0xc2, 0x9a }, POLY_CRC32, 8 },
+    { "crc32cb", { 0x20, 0x50, 0xc2, 0x1a }, POLY_CRC32C, 1 },
+    { "crc32ch", { 0x20, 0x54, 0xc2, 0x1a }, POLY_CRC32C, 2 },
+    { "crc32cw", { 0x20, 0x58, 0xc2, 0x1a }, POLY_CRC32C, 4 },
+    { "crc32cx", { 0x20, 0x5c, 0xc2, 0x9a }, POLY_CRC32C, 8 },
+};
+
+static void check_arm(uc_engine *uc, const struct crc_insn *insns, size_t n,
+                      uint64_t start)
+{
+    size_t i;
+    int k;
+
+    for (i = 0; i < n; i++) {
+        OK(uc_mem_write(uc, CODE, insns[i].code, 4));
+        for (k = 0; k < 300; k++) {
+            uint32_t acc = rnd(), val = rnd(), r0;
+
+            OK(uc_reg_write(uc, UC_ARM_REG_R1, &acc));
+            OK(uc_reg_write(uc, UC_ARM_REG_R2, &val));
+            OK(uc_emu_start(uc, start, CODE + 4, 0, 0));
+            OK(uc_reg_read(uc, UC_ARM_REG_R0, &r0));
+            if (r0 != ref_crc(insns[i].poly, acc, val, insns[i].bytes)) {
+                fail_msg("%s %08x, %08x: got %08x, expected %08x",
+                         insns[i].name, acc, val, r0,
+                         ref_crc(insns[i].poly, acc, val, insns[i].bytes));
+            }
+        }
+    }
+}
+
+static void test_crc32_a32(void **state)
+{
+    check_arm(*state, a32_insns, sizeof(a32_insns) / sizeof(a32_insns[0]),
+              CODE);
+}
+
+static void test_crc32_t32(void **state)
+{
+    check_arm(*state, t32_insns, sizeof(t32_insns) / sizeof(t32_insns[0]),
+              CODE | 1);
+}
+
+static void test_crc32_a64(void **state)
+{
+    uc_engine *uc = *state;
+    size_t i;
+    int k;
+
+    for (i = 0; i < sizeof(a64_insns) / sizeof(a64_insns[0]); i++) {
+        OK(uc_mem_write(uc, CODE, a64_insns[i].code, 4));
+        for (k = 0; k < 300; k++) {
+            uint64_t acc = rnd(), val = rnd(), x0;
+            uint32_t expect;
+
+            expect = ref_crc(a64_insns[i].poly, acc, val, a64_insns[i].bytes);
+            OK(uc_reg_write(uc, UC_ARM64_REG_X1, &acc));
+            OK(uc_reg_write(uc, UC_ARM64_REG_X2, &val));
+            OK(uc_emu_start(uc, CODE, CODE + 4, 0, 0));
+            OK(uc_reg_read(uc, UC_ARM64_REG_X0, &x0));
+            if (x0 != expect) {
+                fail_msg("%s %016llx, %016llx: got %016llx, expected %08x",
+                         a64_insns[i].name, (unsigned long long)acc,
+                         (unsigned long long)val, (unsigned long long)x0,
+                         expect);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_crc32_model),
+        cmocka_unit_test_setup_teardown(test_crc32_a32, setup_a32, teardown),
+        cmocka_unit_test_setup_teardown(test_crc32_t32, setup_t32, teardown),
+        cmocka_unit_test_setup_teardown(test_crc32_a64, setup_a64, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,411 @@
+// Check the AES and carry-less multiply instructions of x86 and ARMv8
+// against a straightforward model of FIPS-197 and of polynomial multiply.
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+#include <string.h>
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE 0x1000
+
+typedef uint8_t aes_state[16];
+
+/* Called before every test to set up a new instance */
+static int setup_x86(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_64, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+
+    *state = uc;
+    return 0;
+}
+
+static int setup_arm64(void **state)
+{
+    uc_engine *uc;
+    uint64_t cpacr;
+
+    OK(uc_open(UC_ARCH_ARM64, UC_MODE_ARM, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+
+    // enable FP/SIMD
+    OK(uc_reg_read(uc, UC_ARM64_REG_CPACR_EL1, &cpacr));
+    cpacr |= 3 << 20;
+    OK(uc_reg_write(uc, UC_ARM64_REG_CPACR_EL1, &cpacr));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+static uint64_t rnd_state = 0x2545f4914f6cdd1dULL;
+
+static uint64_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+static void rnd_state128(aes_state s)
+{
+    uint64_t q[2] = { rnd(), rnd() };
+
+    memcpy(s, q, 16);
+}
+
+static uint8_t gmul(uint8_t a, uint8_t b)
+{
+    uint8_t r = 0;
+
+    while (b) {
+        if (b & 1) {
+            r ^= a;
+        }
+        a = (a << 1) ^ ((a & 0x80) ? 0x1b : 0);
+        b >>= 1;
+    }
+    return r;
+}
+
+static uint8_t sbox(uint8_t x)
+{
+    uint8_t inv = 0, r;
+    int i;
+
+    for (i = 1; x && i < 256; i++) {
+        if (gmul(x, i) == 1) {
+            inv = i;
+            break;
+        }
+    }
+    r = inv;
+    for (i = 1; i < 5; i++) {
+        r ^= (uint8_t)(inv << i | inv >> (8 - i));
+    }
+    return r ^ 0x63;
+}
+
+static uint8_t sbox_tab[256], isbox_tab[256];
+
+static void init_sbox(void)
+{
+    int i;
+
+    for (i = 0; i < 256; i++) {
+        sbox_tab[i] = sbox(i);
+        isbox_tab[sbox_tab[i]] = i;
+    }
+}
+
+// byte i of the state is row i % 4, column i / 4
+static void shift_rows(aes_state s, int inv)
+{
+    aes_state t;
+    int r, c;
+
+    for (r = 0; r < 4; r++) {
+        for (c = 0; c < 4; c++) {
+            if (inv) {
+                t[r + 4 * ((c + r) % 4)] = s[r + 4 * c];
+            } else {
+                t[r + 4 * c] = s[r + 4 * ((c + r) % 4)];
+            }
+        }
+    }
+    memcpy(s, t, 16);
+}
+
+static void sub_bytes(aes_state s, int inv)
+{
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        s[i] = inv ? isbox_tab[s[i]] : sbox_tab[s[i]];
+    }
+}
+
+static void mix_columns(aes_state s, int inv)
+{
+    static const uint8_t m[2][4] = { { 2, 3, 1, 1 }, { 14, 11, 13, 9 } };
+    aes_state t;
+    int r, c, k;
+
+    for (c = 0; c < 4; c++) {
+        for (r = 0; r < 4; r++) {
+            t[r + 4 * c] = 0;
+            for (k = 0; k < 4; k++) {
+                t[r + 4 * c] ^= gmul(m[inv][(k - r + 4) % 4], s[k + 4 * c]);
+            }
+        }
+    }
+    memcpy(s, t, 16);
+}
+
+static void xor_state(aes_state s, const aes_state k)
+{
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        s[i] ^= k[i];
+    }
+}
+
+static void clmul(uint64_t r[2], uint64_t a, uint64_t b)
+{
+    int i;
+
+    r[0] = r[1] = 0;
+    for (i = 0; i < 64; i++) {
+        if (b & (1ULL << i)) {
+            r[0] ^= a << i;
+            r[1] ^= i ? a >> (64 - i) : 0;
+        }
+    }
+}
+
+static void test_crypto_model(void **state)
+{
+    // FIPS-197 section 5.1.1 and appendix B round 1
+    aes_state s = {
+        0x19, 0x3d, 0xe3, 0xbe, 0xa0, 0xf4, 0xe2, 0x2b,
+        0x9a, 0xc6, 0x8d, 0x2a, 0xe9, 0xf8, 0x48, 0x08,
+    };
+    const aes_state after_mix = {
+        0x04, 0x66, 0x81, 0xe5, 0xe0, 0xcb, 0x19, 0x9a,
+        0x48, 0xf8, 0xd3, 0x7a, 0x28, 0x06, 0x26, 0x4c,
+    };
+
+    init_sbox();
+    assert_int_equal(sbox_tab[0x53], 0xed);
+    shift_rows(s, 0);
+    sub_bytes(s, 0);
+    mix_columns(s, 0);
+    assert_memory_equal(s, after_mix, 16);
+    mix_columns(s, 1);
+    sub_bytes(s, 1);
+    shift_rows(s, 1);
+    assert_int_equal(s[0], 0x19);
+}
+
+/******************************************************************************/
+
+enum {
+    ENC, ENCLAST, DEC, DECLAST, IMC,
+};
+
+static void ref_x86(int op, aes_state d, const aes_state s)
+{
+    switch (op) {
+    case ENC:
+    case ENCLAST:
+        shift_rows(d, 0);
+        sub_bytes(d, 0);
+        if (op == ENC) {
+            mix_columns(d, 0);
+        }
+        xor_state(d, s);
+        break;
+    case DEC:
+    case DECLAST:
+        shift_rows(d, 1);
+        sub_bytes(d, 1);
+        if (op == DEC) {
+            mix_columns(d, 1);
+        }
+        xor_state(d, s);
+        break;
+    case IMC:
+        memcpy(d, s, 16);
+        mix_columns(d, 1);
+        break;
+    }
+}
+
+static void run_x86(uc_engine *uc, const uint8_t *code, size_t size,
+                    aes_state d, const aes_state s)
+{
+    uint64_t xmm[2];
+
+    OK(uc_mem_write(uc, CODE, code, size));
+    memcpy(xmm, d, 16);
+    OK(uc_reg_write(uc, UC_X86_REG_XMM0, xmm));
+    memcpy(xmm, s, 16);
+    OK(uc_reg_write(uc, UC_X86_REG_XMM1, xmm));
+    OK(uc_emu_start(uc, CODE, CODE + size, 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_XMM0, xmm));
+    memcpy(d, xmm, 16);
+}
+
+static void test_crypto_x86_aes(void **state)
+{
+    static const struct {
+        int op;
+        uint8_t code[5];
+    } ops[] = {
+        { ENC, { 0x66, 0x0f, 0x38, 0xdc, 0xc1 } },      // aesenc xmm0, xmm1
+        { ENCLAST, { 0x66, 0x0f, 0x38, 0xdd, 0xc1 } },  // aesenclast xmm0, xmm1
+        { DEC, { 0x66, 0x0f, 0x38, 0xde, 0xc1 } },      // aesdec xmm0, xmm1
+        { DECLAST, { 0x66, 0x0f, 0x38, 0xdf, 0xc1 } },  // aesdeclast xmm0, xmm1
+        { IMC, { 0x66, 0x0f, 0x38, 0xdb, 0xc1 } },      // aesimc xmm0, xmm1
+    };
+    uc_engine *uc = *state;
+    size_t i;
+    int k;
+
+    init_sbox();
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        for (k = 0; k < 200; k++) {
+            uint8_t d[16], s[16], expect[16];
+
+            rnd_state128(d);
+            rnd_state128(s);
+            memcpy(expect, d, 16);
+            ref_x86(ops[i].op, expect, s);
+            run_x86(uc, ops[i].code, sizeof(ops[i].code), d, s);
+            assert_memory_equal(d, expect, 16);
+        }
+    }
+}
+
+static void test_crypto_x86_pclmul(void **state)
+{
+    uc_engine *uc = *state;
+    // pclmulqdq xmm0, xmm1, imm
+    uint8_t code[] = { 0x66, 0x0f, 0x3a, 0x44, 0xc1, 0x00 };
+    static const uint8_t imm[] = { 0x00, 0x01, 0x10, 0x11 };
+    size_t i;
+    int k;
+
+    for (i = 0; i < sizeof(imm); i++) {
+        code[5] = imm[i];
+        for (k = 0; k < 200; k++) {
+            uint64_t d[2] = { rnd(), rnd() }, s[2] = { rnd(), rnd() };
+            uint64_t expect[2];
+
+            clmul(expect, d[imm[i] & 1], s[imm[i] >> 4]);
+            run_x86(uc, code, sizeof(code), (uint8_t *)d, (uint8_t *)s);
+            assert_memory_equal(d, expect, 16);
+        }
+    }
+}
+
+/******************************************************************************/
+
+enum {
+    AESE, AESD, AESMC, AESIMC,
+};
+
+static void ref_arm64(int op, aes_state d, const aes_state n)
+{
+    switch (op) {
+    case AESE:
+    case AESD:
+        xor_state(d, n);
+        shift_rows(d, op == AESD);
+        sub_bytes(d, op == AESD);
+        break;
+    case AESMC:
+    case AESIMC:
+        memcpy(d, n, 16);
+        mix_columns(d, op == AESIMC);
+        break;
+    }
+}
+
+static void run_arm64(uc_engine *uc, const uint8_t *code, aes_state d,
+                      const aes_state n, const aes_state m)
+{
+    uint64_t q[2];
+
+    OK(uc_mem_write(uc, CODE, code, 4));
+    memcpy(q, d, 16);
+    OK(uc_reg_write(uc, UC_ARM64_REG_Q0, q));
+    memcpy(q, n, 16);
+    OK(uc_reg_write(uc, UC_ARM64_REG_Q1, q));
+    memcpy(q, m, 16);
+    OK(uc_reg_write(uc, UC_ARM64_REG_Q2, q));
+    OK(uc_emu_start(uc, CODE, CODE + 4, 0, 0));
+    OK(uc_reg_read(uc, UC_ARM64_REG_Q0, q));
+    memcpy(d, q, 16);
+}
+
+static void test_crypto_arm64_aes(void **state)
+{
+    static const struct {
+        int op;
+        uint8_t code[4];
+    } ops[] = {
+        { AESE, { 0x20, 0x48, 0x28, 0x4e } },   // aese v0.16b, v1.16b
+        { AESD, { 0x20, 0x58, 0x28, 0x4e } },   // aesd v0.16b, v1.16b
+        { AESMC, { 0x20, 0x68, 0x28, 0x4e } },  // aesmc v0.16b, v1.16b
+        { AESIMC, { 0x20, 0x78, 0x28, 0x4e } }, // aesimc v0.16b, v1.16b
+    };
+    uc_engine *uc = *state;
+    size_t i;
+    int k;
+
+    init_sbox();
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        for (k = 0; k < 200; k++) {
+            uint8_t d[16], n[16], m[16] = { 0 }, expect[16];
+
+            rnd_state128(d);
+            rnd_state128(n);
+            memcpy(expect, d, 16);
+            ref_arm64(ops[i].op, expect, n);
+            run_arm64(uc, ops[i].code, d, n, m);
+            assert_memory_equal(d, expect, 16);
+        }
+    }
+}
+
+static void test_crypto_arm64_pmull(void **state)
+{
+    uc_engine *uc = *state;
+    // pmull v0.1q, v1.1d, v2.1d and pmull2 v0.1q, v1.2d, v2.2d
+    static const uint8_t code[2][4] = {
+        { 0x20, 0xe0, 0xe2, 0x0e }, { 0x20, 0xe0, 0xe2, 0x4e },
+    };
+    int half, k;
+
+    for (half = 0; half < 2; half++) {
+        for (k = 0; k < 200; k++) {
+            uint64_t d[2] = { 0 };
+            uint64_t n[2] = { rnd(), rnd() }, m[2] = { rnd(), rnd() };
+            uint64_t expect[2];
+
+            clmul(expect, n[half], m[half]);
+            run_arm64(uc, code[half], (uint8_t *)d, (uint8_t *)n,
+                      (uint8_t *)m);
+            assert_memory_equal(d, expect, 16);
+        }
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_crypto_model),
+        cmocka_unit_test_setup_teardown(test_crypto_x86_aes, setup_x86, teardown),
+        cmocka_unit_test_setup_teardown(test_crypto_x86_pclmul, setup_x86, teardown),
+        cmocka_unit_test_setup_teardown(test_crypto_arm64_aes, setup_arm64, teardown),
+        cmocka_unit_test_setup_teardown(test_crypto_arm64_pmull, setup_arm64, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
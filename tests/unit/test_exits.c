@@ -0,0 +1,128 @@
+// Test exits set with uc_emu_set_exits()
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define ADDRESS 0x1000000
+
+/* Called before every test to set up a new instance */
+static int setup32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+static void test_exits_branch(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0x85, 0xc9,     // test ecx, ecx
+        0x74, 0x03,     // jz ADDRESS + 7
+        0x41,           // inc ecx      <- exit 1
+        0xeb, 0x01,     // jmp ADDRESS + 8
+        0x49,           // dec ecx      <- exit 0
+        0x90,           // nop
+    };
+    const uint64_t exits[] = { ADDRESS + 7, ADDRESS + 4 };
+    uint32_t r_ecx, r_eip;
+    size_t index;
+
+    OK(uc_mem_map(uc, ADDRESS, 2 * 1024 * 1024, UC_PROT_ALL));
+    OK(uc_mem_write(uc, ADDRESS, code, sizeof(code)));
+    OK(uc_emu_set_exits(uc, exits, 2));
+
+    r_ecx = 0;
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+    OK(uc_emu_start(uc, ADDRESS, ADDRESS + sizeof(code), 0, 0));
+    OK(uc_query(uc, UC_QUERY_EXIT, &index));
+    OK(uc_reg_read(uc, UC_X86_REG_EIP, &r_eip));
+    assert_int_equal(index, 0);
+    assert_int_equal(r_eip, ADDRESS + 7);
+
+    r_ecx = 1;
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+    OK(uc_emu_start(uc, ADDRESS, ADDRESS + sizeof(code), 0, 0));
+    OK(uc_query(uc, UC_QUERY_EXIT, &index));
+    OK(uc_reg_read(uc, UC_X86_REG_EIP, &r_eip));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(index, 1);
+    assert_int_equal(r_eip, ADDRESS + 4);
+    assert_int_equal(r_ecx, 1);
+
+    // without exits, the code runs up to the @until address
+    OK(uc_emu_set_exits(uc, NULL, 0));
+    OK(uc_emu_start(uc, ADDRESS, ADDRESS + sizeof(code), 0, 0));
+    OK(uc_query(uc, UC_QUERY_EXIT, &index));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(index, (size_t)-1);
+    assert_int_equal(r_ecx, 2);
+}
+
+// Thumb addresses, with the lowest bit set, stop at the instruction
+static void test_exits_thumb(void **state)
+{
+    uc_engine *uc;
+    const uint8_t code[] = {
+        0x01, 0x30,     // adds r0, #1
+        0x01, 0x30,     // adds r0, #1      <- exit
+        0x01, 0x30,     // adds r0, #1      <- breakpoint
+        0x01, 0x30,     // adds r0, #1
+    };
+    const uint64_t exits[] = { ADDRESS + 2 + 1 };
+    uint32_t r_r0, r_pc;
+    size_t index;
+
+    OK(uc_open(UC_ARCH_ARM, UC_MODE_THUMB, &uc));
+    OK(uc_mem_map(uc, ADDRESS, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, ADDRESS, code, sizeof(code)));
+    OK(uc_emu_set_exits(uc, exits, 1));
+
+    r_r0 = 0;
+    OK(uc_reg_write(uc, UC_ARM_REG_R0, &r_r0));
+    OK(uc_emu_start(uc, ADDRESS | 1, ADDRESS + sizeof(code), 0, 0));
+    OK(uc_query(uc, UC_QUERY_EXIT, &index));
+    OK(uc_reg_read(uc, UC_ARM_REG_R0, &r_r0));
+    OK(uc_reg_read(uc, UC_ARM_REG_PC, &r_pc));
+    assert_int_equal(index, 0);
+    assert_int_equal(r_r0, 1);
+    assert_int_equal(r_pc, ADDRESS + 2);
+
+    // breakpoints ignore the Thumb bit too
+    OK(uc_emu_set_exits(uc, NULL, 0));
+    OK(uc_breakpoint_add(uc, ADDRESS + 4 + 1));
+    uc_assert_err(UC_ERR_BREAKPOINT, uc_emu_start(uc, (ADDRESS + 2) | 1, ADDRESS + sizeof(code), 0, 0));
+    OK(uc_reg_read(uc, UC_ARM_REG_R0, &r_r0));
+    OK(uc_reg_read(uc, UC_ARM_REG_PC, &r_pc));
+    assert_int_equal(r_r0, 2);
+    assert_int_equal(r_pc, ADDRESS + 4);
+    OK(uc_breakpoint_del(uc, ADDRESS + 4));
+
+    OK(uc_close(uc));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_exits_branch, setup32, teardown),
+        cmocka_unit_test(test_exits_thumb),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,176 @@
+// Differential test of the host FPU fast path in softfloat: every operation
+// is run once with the FPSCR inexact flag clear, which forces softfloat, and
+// once with it set, which allows the host FPU. Results and the other
+// exception flags must be identical.
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define ADDRESS 0x10000
+
+#define FPSCR_IXC   (1 << 4)
+#define FPSCR_FLAGS 0x9f
+#define FPSCR_FZ    (1 << 24)
+#define FPSCR_DN    (1 << 25)
+#define FPSCR_RMODE (3 << 22)
+
+/* Called before every test to set up a new instance */
+static int setup_arm(void **state)
+{
+    uc_engine *uc;
+    uint32_t cpacr, fpexc = 0x40000000;     // FPEXC.EN
+
+    OK(uc_open(UC_ARCH_ARM, UC_MODE_ARM, &uc));
+    OK(uc_mem_map(uc, ADDRESS, 0x1000, UC_PROT_ALL));
+
+    // enable cp10/cp11, then VFP
+    OK(uc_reg_read(uc, UC_ARM_REG_C1_C0_2, &cpacr));
+    cpacr |= 0xf << 20;
+    OK(uc_reg_write(uc, UC_ARM_REG_C1_C0_2, &cpacr));
+    OK(uc_reg_write(uc, UC_ARM_REG_FPEXC, &fpexc));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+// vmsr fpscr, r0; <op>; vmrs r1, fpscr
+static const uint32_t ops[] = {
+    0xee302a20,     // vadd.f32 s4, s0, s1
+    0xee302a60,     // vsub.f32 s4, s0, s1
+    0xee202a20,     // vmul.f32 s4, s0, s1
+    0xee802a20,     // vdiv.f32 s4, s0, s1
+    0xeeb12ac0,     // vsqrt.f32 s4, s0
+    0xee302b01,     // vadd.f64 d2, d0, d1
+    0xee302b41,     // vsub.f64 d2, d0, d1
+    0xee202b01,     // vmul.f64 d2, d0, d1
+    0xee802b01,     // vdiv.f64 d2, d0, d1
+    0xeeb12bc0,     // vsqrt.f64 d2, d0
+};
+
+static uint64_t rnd_state = 0x2545f4914f6cdd1dULL;
+
+static uint64_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+// random operands, biased towards the cases the fast path must reject
+static uint32_t rnd_f32(void)
+{
+    uint32_t sign = (rnd() & 1) << 31, frac = rnd() & 0x7fffff;
+
+    switch (rnd() % 8) {
+    case 0:
+        return sign | (rnd() % 3 == 0 ? 0 : frac);                 // zero, denormal
+    case 1:
+        return sign | 0x7f800000 | (rnd() % 2 ? 0 : frac | 1);      // inf, nan
+    case 2:
+        return sign | ((uint32_t)(1 + rnd() % 24) << 23) | frac;    // tiny
+    case 3:
+        return sign | ((uint32_t)(230 + rnd() % 24) << 23) | frac;  // huge
+    case 4:
+        return sign | (127u << 23) | (rnd() % 4);                   // ~1.0
+    default:
+        return sign | ((uint32_t)(1 + rnd() % 254) << 23) | frac;
+    }
+}
+
+static uint64_t rnd_f64(void)
+{
+    uint64_t sign = (rnd() & 1) << 63, frac = rnd() & 0xfffffffffffffULL;
+
+    switch (rnd() % 8) {
+    case 0:
+        return sign | (rnd() % 3 == 0 ? 0 : frac);
+    case 1:
+        return sign | 0x7ff0000000000000ULL | (rnd() % 2 ? 0 : frac | 1);
+    case 2:
+        return sign | ((uint64_t)(1 + rnd() % 53) << 52) | frac;
+    case 3:
+        return sign | ((uint64_t)(1990 + rnd() % 56) << 52) | frac;
+    case 4:
+        return sign | (1023ULL << 52) | (rnd() % 4);
+    default:
+        return sign | ((uint64_t)(1 + rnd() % 2046) << 52) | frac;
+    }
+}
+
+static void run_op(uc_engine *uc, uint32_t fpscr_in, uint64_t d0, uint64_t d1,
+                   uint64_t *d2, uint32_t *fpscr_out)
+{
+    OK(uc_reg_write(uc, UC_ARM_REG_R0, &fpscr_in));
+    OK(uc_reg_write(uc, UC_ARM_REG_D0, &d0));
+    OK(uc_reg_write(uc, UC_ARM_REG_D1, &d1));
+    OK(uc_emu_start(uc, ADDRESS, ADDRESS + 12, 0, 0));
+    OK(uc_reg_read(uc, UC_ARM_REG_D2, d2));
+    OK(uc_reg_read(uc, UC_ARM_REG_R1, fpscr_out));
+}
+
+static void test_hardfloat_vfp(void **state)
+{
+    uc_engine *uc = *state;
+    static const uint32_t modes[] = { 0, FPSCR_DN, FPSCR_FZ | FPSCR_DN, FPSCR_RMODE };
+    int i, m, n;
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        const uint32_t code[] = { 0xeee10a10, ops[i], 0xeef11a10 };
+        int dp = (ops[i] & 0xf00) == 0xb00;
+
+        OK(uc_mem_write(uc, ADDRESS, code, sizeof(code)));
+        for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+            for (n = 0; n < 2000; n++) {
+                uint64_t d0, d1, soft, hard;
+                uint32_t soft_fpscr, hard_fpscr;
+
+                if (dp) {
+                    d0 = rnd_f64();
+                    d1 = rnd_f64();
+                } else {
+                    d0 = rnd_f32() | (uint64_t)rnd_f32() << 32;
+                    d1 = 0;
+                }
+
+                run_op(uc, modes[m], d0, d1, &soft, &soft_fpscr);
+                run_op(uc, modes[m] | FPSCR_IXC, d0, d1, &hard, &hard_fpscr);
+
+                if (!dp) {
+                    soft &= 0xffffffff;
+                    hard &= 0xffffffff;
+                }
+                if (soft != hard ||
+                    ((soft_fpscr | FPSCR_IXC) & FPSCR_FLAGS) != (hard_fpscr & FPSCR_FLAGS)) {
+                    fail_msg("op %08x mode %08x: %016llx, %016llx -> "
+                             "soft %016llx (%08x) hard %016llx (%08x)",
+                             ops[i], modes[m], (unsigned long long)d0,
+                             (unsigned long long)d1, (unsigned long long)soft,
+                             soft_fpscr, (unsigned long long)hard, hard_fpscr);
+                }
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_hardfloat_vfp, setup_arm, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
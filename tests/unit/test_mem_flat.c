@@ -0,0 +1,295 @@
+// Test guest memory backed by flat host memory, with uc_mem_flat_enable()
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE    0x1000
+#define DATA    0x4000
+
+/* Open an engine with flat memory, or NULL on unsupported hosts */
+static uc_engine *flat_open(uc_arch arch, uc_mode mode)
+{
+    uc_engine *uc;
+    uc_err err;
+
+    OK(uc_open(arch, mode, &uc));
+    err = uc_mem_flat_enable(uc);
+    if (err == UC_ERR_MODE) {
+        uc_close(uc);
+        return NULL;
+    }
+    OK(err);
+
+    return uc;
+}
+
+/******************************************************************************/
+
+static void hook_code(uc_engine *uc, uint64_t address, uint32_t size, void *user_data)
+{
+    int *count = user_data;
+    (*count)++;
+}
+
+static bool hook_unmapped(uc_engine *uc, uc_mem_type type,
+        uint64_t address, int size, int64_t value, void *user_data)
+{
+    uint64_t *fault = user_data;
+    *fault = address;
+    return false;
+}
+
+static void test_flat_enable(void **state)
+{
+    uc_engine *uc;
+
+    // only 32-bit guests
+    OK(uc_open(UC_ARCH_X86, UC_MODE_64, &uc));
+    uc_assert_err(UC_ERR_MODE, uc_mem_flat_enable(uc));
+    OK(uc_close(uc));
+
+    // only before mapping memory
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    uc_assert_err(UC_ERR_ARG, uc_mem_flat_enable(uc));
+    OK(uc_close(uc));
+
+    // mappings are aligned to 4KB, even with 1KB guest pages
+    uc = flat_open(UC_ARCH_ARM, UC_MODE_ARM);
+    if (uc == NULL)
+        return;
+    OK(uc_mem_flat_enable(uc));
+    uc_assert_err(UC_ERR_ARG, uc_mem_map(uc, CODE, 0x400, UC_PROT_ALL));
+    uc_assert_err(UC_ERR_ARG, uc_mem_map(uc, 0xfffff000, 0x2000, UC_PROT_ALL));
+    uc_assert_err(UC_ERR_ARG, uc_mem_map_ptr(uc, CODE, 0x1000, UC_PROT_ALL, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    uc_assert_err(UC_ERR_ARG, uc_mem_protect(uc, CODE, 0x400, UC_PROT_READ));
+    uc_assert_err(UC_ERR_ARG, uc_mem_unmap(uc, CODE, 0x400));
+    OK(uc_close(uc));
+}
+
+static void test_flat_x86(void **state)
+{
+    const uint8_t code[] = {
+        0x8b, 0x05, 0x00, 0x40, 0x00, 0x00,     // mov eax, [DATA]
+        0x40,                                   // inc eax
+        0x89, 0x05, 0x04, 0x40, 0x00, 0x00,     // mov [DATA + 4], eax
+        0x66, 0x89, 0x05, 0xfe, 0x4f, 0x00, 0x00,   // mov [DATA + 0xffe], ax
+    };
+    uint32_t value = 0x12345678, r_eax;
+    uint16_t half;
+    uc_engine *uc;
+
+    uc = flat_open(UC_ARCH_X86, UC_MODE_32);
+    if (uc == NULL)
+        return;
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_map(uc, DATA, 0x1000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_write(uc, DATA, &value, sizeof(value)));
+
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &r_eax));
+    assert_int_equal(r_eax, 0x12345679);
+    OK(uc_mem_read(uc, DATA + 4, &value, sizeof(value)));
+    assert_int_equal(value, 0x12345679);
+    OK(uc_mem_read(uc, DATA + 0xffe, &half, sizeof(half)));
+    assert_int_equal(half, 0x5679);
+
+    OK(uc_close(uc));
+}
+
+static void test_flat_unmapped(void **state)
+{
+    const uint8_t code[] = {
+        0x41,                                   // inc ecx
+        0x8b, 0x05, 0x00, 0x80, 0x00, 0x00,     // mov eax, [0x8000]
+        0x41,                                   // inc ecx
+    };
+    uint64_t fault = 0;
+    uint32_t r_ecx, r_eip;
+    int count = 0;
+    uc_hook h1, h2;
+    uc_engine *uc;
+
+    uc = flat_open(UC_ARCH_X86, UC_MODE_32);
+    if (uc == NULL)
+        return;
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_hook_add(uc, &h1, UC_HOOK_CODE, hook_code, &count, 1, 0));
+    OK(uc_hook_add(uc, &h2, UC_HOOK_MEM_READ_UNMAPPED, hook_unmapped, &fault, 1, 0));
+
+    uc_assert_err(UC_ERR_READ_UNMAPPED, uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    // the faulting instruction is hooked once
+    assert_int_equal(count, 2);
+    assert_int_equal(fault, 0x8000);
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_ecx, 1);
+    OK(uc_reg_read(uc, UC_X86_REG_EIP, &r_eip));
+    assert_int_equal(r_eip, CODE + 1);
+
+    // once mapped, the same code runs through
+    OK(uc_mem_map(uc, 0x8000, 0x1000, UC_PROT_READ));
+    count = 0;
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    assert_int_equal(count, 3);
+
+    OK(uc_close(uc));
+}
+
+static void test_flat_protect(void **state)
+{
+    const uint8_t code[] = {
+        0x8b, 0x05, 0x00, 0x40, 0x00, 0x00,     // mov eax, [DATA]
+        0x89, 0x05, 0x00, 0x50, 0x00, 0x00,     // mov [DATA + 0x1000], eax
+    };
+    uint8_t buf[0x3000];
+    uint32_t value;
+    uc_engine *uc;
+    size_t i;
+
+    uc = flat_open(UC_ARCH_X86, UC_MODE_32);
+    if (uc == NULL)
+        return;
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_map(uc, DATA, 0x3000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = (uint8_t)(i * 7);
+    OK(uc_mem_write(uc, DATA, buf, sizeof(buf)));
+
+    // splitting the region keeps its content
+    OK(uc_mem_protect(uc, DATA + 0x1000, 0x1000, UC_PROT_READ));
+    memset(buf, 0, sizeof(buf));
+    OK(uc_mem_read(uc, DATA, buf, sizeof(buf)));
+    for (i = 0; i < sizeof(buf); i++)
+        assert_int_equal(buf[i], (uint8_t)(i * 7));
+
+    uc_assert_err(UC_ERR_WRITE_PROT, uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    OK(uc_mem_protect(uc, DATA + 0x1000, 0x1000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    OK(uc_mem_read(uc, DATA + 0x1000, &value, sizeof(value)));
+    assert_int_equal(value, 0x150e0700);
+
+    // unmapped pages read back as zero when mapped again
+    OK(uc_mem_unmap(uc, DATA + 0x1000, 0x1000));
+    uc_assert_err(UC_ERR_READ_UNMAPPED, uc_mem_read(uc, DATA + 0x1000, &value, sizeof(value)));
+    OK(uc_mem_read(uc, DATA + 0x2000, buf, 0x1000));
+    for (i = 0; i < 0x1000; i++)
+        assert_int_equal(buf[i], (uint8_t)((i + 0x2000) * 7));
+    OK(uc_mem_map(uc, DATA + 0x1000, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_read(uc, DATA + 0x1000, &value, sizeof(value)));
+    assert_int_equal(value, 0);
+
+    OK(uc_close(uc));
+}
+
+static void test_flat_smc(void **state)
+{
+    const uint8_t code[] = {
+        0xc6, 0x05, 0x10, 0x10, 0x00, 0x00, 0x41,   // mov byte [CODE + 0x10], 0x41
+        0xeb, 0x07,                                 // jmp CODE + 0x10
+    };
+    uint8_t nop = 0x90;
+    uint32_t r_ecx = 0;
+    uc_engine *uc;
+
+    uc = flat_open(UC_ARCH_X86, UC_MODE_32);
+    if (uc == NULL)
+        return;
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_write(uc, CODE + 0x10, &nop, 1));
+
+    // translate the nop first, then overwrite it with "inc ecx"
+    OK(uc_emu_start(uc, CODE + 0x10, CODE + 0x11, 0, 0));
+    OK(uc_emu_start(uc, CODE, CODE + 0x11, 0, 0));
+
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_ecx, 1);
+
+    OK(uc_close(uc));
+}
+
+static void test_flat_arm(void **state)
+{
+    const uint32_t code[] = {
+        0xe5901000,     // ldr r1, [r0]
+        0xe2811001,     // add r1, r1, #1
+        0xe5801004,     // str r1, [r0, #4]
+    };
+    uint32_t value = 41, r0 = DATA, r1;
+    uc_engine *uc;
+
+    uc = flat_open(UC_ARCH_ARM, UC_MODE_ARM);
+    if (uc == NULL)
+        return;
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_map(uc, DATA, 0x1000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_write(uc, DATA, &value, sizeof(value)));
+    OK(uc_reg_write(uc, UC_ARM_REG_R0, &r0));
+
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    OK(uc_reg_read(uc, UC_ARM_REG_R1, &r1));
+    assert_int_equal(r1, 42);
+    OK(uc_mem_read(uc, DATA + 4, &value, sizeof(value)));
+    assert_int_equal(value, 42);
+
+    OK(uc_close(uc));
+}
+
+static void test_flat_mips_kseg0(void **state)
+{
+    const uint32_t code[] = {
+        0x8c890000,     // lw $t1, 0($a0)
+        0x25290001,     // addiu $t1, $t1, 1
+        0xac890004,     // sw $t1, 4($a0)
+    };
+    uint32_t value = 41, a0 = 0x80000000 + DATA, t1;
+    uc_engine *uc;
+
+    uc = flat_open(UC_ARCH_MIPS, UC_MODE_MIPS32 | UC_MODE_LITTLE_ENDIAN);
+    if (uc == NULL)
+        return;
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_map(uc, DATA, 0x1000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_write(uc, DATA, &value, sizeof(value)));
+    OK(uc_reg_write(uc, UC_MIPS_REG_A0, &a0));
+
+    OK(uc_emu_start(uc, 0x80000000 + CODE, 0x80000000 + CODE + sizeof(code), 0, 0));
+
+    OK(uc_reg_read(uc, UC_MIPS_REG_T1, &t1));
+    assert_int_equal(t1, 42);
+    OK(uc_mem_read(uc, 0xa0000000 + DATA + 4, &value, sizeof(value)));
+    assert_int_equal(value, 42);
+
+    // misaligned accesses raise the usual exception
+    a0 = 0x80000000 + DATA + 2;
+    OK(uc_reg_write(uc, UC_MIPS_REG_A0, &a0));
+    uc_assert_err(UC_ERR_READ_UNALIGNED,
+            uc_emu_start(uc, 0x80000000 + CODE, 0x80000000 + CODE + sizeof(code), 0, 0));
+
+    OK(uc_close(uc));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_flat_enable),
+        cmocka_unit_test(test_flat_x86),
+        cmocka_unit_test(test_flat_unmapped),
+        cmocka_unit_test(test_flat_protect),
+        cmocka_unit_test(test_flat_smc),
+        cmocka_unit_test(test_flat_arm),
+        cmocka_unit_test(test_flat_mips_kseg0),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
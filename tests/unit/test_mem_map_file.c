@@ -0,0 +1,187 @@
+// Test file-backed memory with uc_mem_map_file()
+#include <fcntl.h>
+#include <unistd.h>
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE    0x1000
+#define DATA    0x100000
+#define PAGES   4
+
+/* Called before every test to set up a new instance */
+static int setup32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+// a temporary file of PAGES pages, each filled with its index
+static int temp_file(void)
+{
+    char path[] = "/tmp/test_mem_map_file.XXXXXX";
+    uint8_t page[0x1000];
+    int fd, i;
+
+    fd = mkstemp(path);
+    assert_true(fd >= 0);
+    unlink(path);
+    for (i = 0; i < PAGES; i++) {
+        memset(page, i, sizeof(page));
+        assert_int_equal(write(fd, page, sizeof(page)), sizeof(page));
+    }
+
+    return fd;
+}
+
+static uint32_t file_read32(int fd, off_t offset)
+{
+    uint32_t value;
+
+    assert_int_equal(pread(fd, &value, sizeof(value), offset), sizeof(value));
+    return value;
+}
+
+// mov dword [DATA + 0x1010], 0x12345678
+static void guest_write(uc_engine *uc)
+{
+    const uint8_t code[] = {
+        0xc7, 0x05, 0x10, 0x10, 0x10, 0x00, 0x78, 0x56, 0x34, 0x12,
+    };
+
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+}
+
+static void test_map_file_private(void **state)
+{
+    uc_engine *uc = *state;
+    int fd = temp_file(), copy = dup(fd);
+    uint32_t value;
+
+    // the descriptor is not needed afterwards
+    OK(uc_mem_map_file(uc, DATA, PAGES * 0x1000, UC_PROT_READ | UC_PROT_WRITE, fd, 0, UC_MAP_PRIVATE));
+    close(fd);
+
+    OK(uc_mem_read(uc, DATA + 0x2ffc, &value, sizeof(value)));
+    assert_int_equal(value, 0x02020202);
+
+    // writes stay in the emulator
+    guest_write(uc);
+    OK(uc_mem_read(uc, DATA + 0x1010, &value, sizeof(value)));
+    assert_int_equal(value, 0x12345678);
+    assert_int_equal(file_read32(copy, 0x1010), 0x01010101);
+
+    close(copy);
+}
+
+static void test_map_file_shared(void **state)
+{
+    uc_engine *uc = *state;
+    int fd = temp_file();
+    uint32_t value = 0xdeadbeef;
+
+    // from the second page of the file
+    OK(uc_mem_map_file(uc, DATA, 0x2000, UC_PROT_READ | UC_PROT_WRITE, fd, 0x1000, UC_MAP_SHARED));
+
+    // writes go to the file, both ways
+    guest_write(uc);
+    assert_int_equal(file_read32(fd, 0x2010), 0x12345678);
+    assert_int_equal(pwrite(fd, &value, sizeof(value), 0x1000), sizeof(value));
+    OK(uc_mem_read(uc, DATA, &value, sizeof(value)));
+    assert_int_equal(value, 0xdeadbeef);
+
+    close(fd);
+}
+
+static void test_map_file_split(void **state)
+{
+    uc_engine *uc = *state;
+    int fd = temp_file();
+    uc_mem_region *regions;
+    uint32_t count, value = 0xdeadbeef;
+    uint8_t byte;
+
+    OK(uc_mem_map_file(uc, DATA, PAGES * 0x1000, UC_PROT_READ | UC_PROT_WRITE, fd, 0, UC_MAP_SHARED));
+
+    OK(uc_mem_protect(uc, DATA + 0x1000, 0x1000, UC_PROT_READ));
+    OK(uc_mem_unmap(uc, DATA + 0x2000, 0x1000));
+    OK(uc_mem_regions(uc, &regions, &count));
+    assert_int_equal(count, 3);
+    free(regions);
+
+    // the pieces still map the file
+    OK(uc_mem_read(uc, DATA + 0x1fff, &byte, 1));
+    assert_int_equal(byte, 0x01);
+    uc_assert_err(UC_ERR_READ_UNMAPPED, uc_mem_read(uc, DATA + 0x2000, &byte, 1));
+    assert_int_equal(pwrite(fd, &value, sizeof(value), 0x3000), sizeof(value));
+    OK(uc_mem_read(uc, DATA + 0x3000, &byte, 1));
+    assert_int_equal(byte, 0xef);
+
+    // until the last one is gone
+    OK(uc_mem_unmap(uc, DATA, 0x2000));
+    OK(uc_mem_unmap(uc, DATA + 0x3000, 0x1000));
+    OK(uc_mem_map(uc, DATA, PAGES * 0x1000, UC_PROT_ALL));
+
+    close(fd);
+}
+
+static void test_map_file_args(void **state)
+{
+    uc_engine *uc = *state;
+    char path[] = "/tmp/test_mem_map_file.XXXXXX";
+    int fd = temp_file(), rd;
+
+    // unaligned offset, past the end of the file, unknown flags
+    uc_assert_err(UC_ERR_ARG, uc_mem_map_file(uc, DATA, 0x1000, UC_PROT_ALL, fd, 0x800, UC_MAP_PRIVATE));
+    uc_assert_err(UC_ERR_ARG, uc_mem_map_file(uc, DATA, 0x2000, UC_PROT_ALL, fd, 0x3000, UC_MAP_PRIVATE));
+    uc_assert_err(UC_ERR_ARG, uc_mem_map_file(uc, DATA, 0x1000, UC_PROT_ALL, fd, 0, 2));
+    uc_assert_err(UC_ERR_ARG, uc_mem_map_file(uc, DATA, 0x1000, UC_PROT_ALL, -1, 0, UC_MAP_PRIVATE));
+
+    // sharing needs a writable file
+    close(fd);
+    fd = mkstemp(path);
+    assert_true(fd >= 0);
+    assert_int_equal(ftruncate(fd, 0x1000), 0);
+    rd = open(path, O_RDONLY);
+    unlink(path);
+    assert_true(rd >= 0);
+    uc_assert_err(UC_ERR_ARG, uc_mem_map_file(uc, DATA, 0x1000, UC_PROT_ALL, rd, 0, UC_MAP_SHARED));
+    OK(uc_mem_map_file(uc, DATA, 0x1000, UC_PROT_ALL, rd, 0, UC_MAP_PRIVATE));
+
+    // and overlaps are refused as usual
+    uc_assert_err(UC_ERR_MAP, uc_mem_map_file(uc, DATA, 0x1000, UC_PROT_ALL, fd, 0, UC_MAP_SHARED));
+
+    close(rd);
+    close(fd);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_map_file_private, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_map_file_shared, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_map_file_split, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_map_file_args, setup32, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,185 @@
+// Test demand paging with uc_mem_set_pager()
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE    0x1000
+#define DATA    0x100000
+
+/* Called before every test to set up a new instance */
+static int setup32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+struct pager {
+    int calls;
+    uc_mem_type type;
+    uint64_t address;
+    void *ptr;              // host memory to give, or NULL
+    uint8_t fill[0x1000];   // content of the page, if ptr is NULL
+};
+
+static bool pager_cb(uc_engine *uc, uc_mem_type type, uint64_t address,
+        int size, uc_mem_page *page, void *user_data)
+{
+    struct pager *p = user_data;
+
+    p->calls++;
+    p->type = type;
+    p->address = address;
+
+    // nothing above 16MB
+    if (address >= 0x1000000)
+        return false;
+
+    if (p->ptr != NULL) {
+        page->ptr = p->ptr;
+    } else {
+        memset(p->fill, (int)(page->begin >> 12), sizeof(p->fill));
+        page->data = p->fill;
+    }
+    if (type != UC_MEM_FETCH_UNMAPPED)
+        page->perms = UC_PROT_READ | UC_PROT_WRITE;
+    return true;
+}
+
+static bool hook_unmapped(uc_engine *uc, uc_mem_type type,
+        uint64_t address, int size, int64_t value, void *user_data)
+{
+    int *count = user_data;
+    (*count)++;
+    return false;
+}
+
+static void test_pager_read(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0x8b, 0x06,                     // mov eax, [esi]
+        0x81, 0xc6, 0x00, 0x08, 0x00, 0x00,   // add esi, 0x800
+        0x49,                           // dec ecx
+        0x75, 0xf5,                     // jnz CODE
+    };
+    uint32_t r_esi = DATA, r_ecx = 8, r_eax;
+    static struct pager p;
+    uint8_t byte;
+
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_reg_write(uc, UC_X86_REG_ESI, &r_esi));
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+    OK(uc_mem_set_pager(uc, pager_cb, &p));
+
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    // one call per page
+    assert_int_equal(p.calls, 4);
+    assert_int_equal(p.type, UC_MEM_READ_UNMAPPED);
+    assert_int_equal(p.address, DATA + 0x3000);
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &r_eax));
+    assert_int_equal(r_eax, 0x03030303);
+
+    // the pages stay mapped, with the given permissions
+    OK(uc_mem_read(uc, DATA + 0x2fff, &byte, 1));
+    assert_int_equal(byte, 0x02);
+    uc_assert_err(UC_ERR_READ_UNMAPPED, uc_mem_read(uc, DATA + 0x4000, &byte, 1));
+}
+
+static void test_pager_ptr(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0xc7, 0x05, 0x10, 0x00, 0x10, 0x00, 0x78, 0x56, 0x34, 0x12,   // mov dword [DATA + 0x10], 0x12345678
+    };
+    static uint8_t host[0x1000] __attribute__((aligned(0x1000)));
+    static struct pager p;
+    uint32_t value;
+
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    p.ptr = host;
+    OK(uc_mem_set_pager(uc, pager_cb, &p));
+
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    assert_int_equal(p.calls, 1);
+    assert_int_equal(p.type, UC_MEM_WRITE_UNMAPPED);
+    memcpy(&value, host + 0x10, sizeof(value));
+    assert_int_equal(value, 0x12345678);
+}
+
+static void test_pager_fetch(void **state)
+{
+    uc_engine *uc = *state;
+    static struct pager p;
+    uint32_t r_eip;
+
+    // the code page is filled with "inc ecx"
+    OK(uc_mem_set_pager(uc, pager_cb, &p));
+    p.ptr = NULL;
+
+    OK(uc_emu_start(uc, 0x41000, 0x41010, 0, 0));
+
+    assert_int_equal(p.calls, 1);
+    assert_int_equal(p.type, UC_MEM_FETCH_UNMAPPED);
+    OK(uc_reg_read(uc, UC_X86_REG_EIP, &r_eip));
+    assert_int_equal(r_eip, 0x41010);
+}
+
+static void test_pager_decline(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0x8b, 0x05, 0x00, 0x00, 0x00, 0x02,   // mov eax, [0x2000000]
+    };
+    static struct pager p;
+    int unmapped = 0;
+    uc_hook h;
+
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_set_pager(uc, pager_cb, &p));
+    OK(uc_hook_add(uc, &h, UC_HOOK_MEM_READ_UNMAPPED, hook_unmapped, &unmapped, 1, 0));
+
+    // the access goes on to the hooks
+    uc_assert_err(UC_ERR_READ_UNMAPPED, uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    assert_int_equal(p.calls, 1);
+    assert_int_equal(unmapped, 1);
+
+    // and only to the hooks without a pager
+    OK(uc_mem_set_pager(uc, NULL, NULL));
+    uc_assert_err(UC_ERR_READ_UNMAPPED, uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    assert_int_equal(p.calls, 1);
+    assert_int_equal(unmapped, 2);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_pager_read, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_pager_ptr, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_pager_fetch, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_pager_decline, setup32, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,330 @@
+// Check the MIPS MSA integer ops that have per data format helpers (add/sub,
+// multiply, compares, min/max, saturating add/sub, interleave, pack and
+// vshf) element by element against a scalar model, for all four formats.
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE 0x1000
+#define DATA 0x2000
+
+// Status.CU1|FR and Config5.MSAEn, then wd = op(ws, wt) on vectors at $a0
+static const uint32_t prologue[] = {
+    0x40086000,     // mfc0 $t0, $12
+    0x3c092400,     // lui $t1, 0x2400
+    0x01094025,     // or $t0, $t0, $t1
+    0x40886000,     // mtc0 $t0, $12
+    0x40088005,     // mfc0 $t0, $16, 5
+    0x3c090800,     // lui $t1, 0x0800
+    0x01094025,     // or $t0, $t0, $t1
+    0x40888005,     // mtc0 $t0, $16, 5
+    0x78102060,     // ld.b $w1, 16($a0)
+    0x782020a0,     // ld.b $w2, 32($a0)
+    0x78302020,     // ld.b $w0, 48($a0)
+};
+#define ST_W0 0x78002024    // st.b $w0, 0($a0)
+
+/* Called before every test to set up a new instance */
+static int setup_msa(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_MIPS, UC_MODE_MIPS32 | UC_MODE_MIPS32R5, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_map(uc, DATA, 0x1000, UC_PROT_ALL));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+static uint64_t elem(const uint8_t *v, int i, int esize)
+{
+    uint64_t x = 0;
+    int b;
+
+    for (b = esize / 8 - 1; b >= 0; b--) {
+        x = x << 8 | v[i * esize / 8 + b];
+    }
+    return x;
+}
+
+static void put(uint8_t *v, int i, int esize, uint64_t x)
+{
+    int b;
+
+    for (b = 0; b < esize / 8; b++) {
+        v[i * esize / 8 + b] = x >> (8 * b);
+    }
+}
+
+static int64_t sext(uint64_t x, int esize)
+{
+    return esize == 64 ? (int64_t)x : (int64_t)(x << (64 - esize)) >> (64 - esize);
+}
+
+// random vector of ESIZE bit elements, often close to the saturation points
+// and sometimes equal to the matching element of SAME
+static void rnd_vec(uint8_t *v, int esize, const uint8_t *same)
+{
+    static const uint64_t edge[] = { 0, 1, 2, -1, -2, 0x7f, 0x80, 0xff,
+                                     0x7fff, 0x8000, 0x7fffffff, 0x80000000,
+                                     0x7fffffffffffffffULL };
+    int i;
+
+    for (i = 0; i < 128 / esize; i++) {
+        uint64_t x = rnd();
+        if ((x & 7) == 0) {
+            x = edge[(x >> 8) % (sizeof(edge) / sizeof(edge[0]))];
+        } else if ((x & 7) == 1 && same) {
+            x = elem(same, i, esize);
+        } else if ((x & 7) == 2) {
+            x = (uint64_t)sext(x >> 8 & 0xff, 8);   // small, either sign
+        }
+        put(v, i, esize, x);
+    }
+}
+
+enum kind {
+    ADDV, SUBV, MULV, CEQ, CLT_S, CLT_U, CLE_S, CLE_U,
+    MAX_S, MAX_U, MIN_S, MIN_U, ADDS_S, ADDS_U, SUBS_S, SUBS_U,
+    ILVR, ILVL, ILVEV, ILVOD, PCKEV, PCKOD, VSHF,
+};
+
+struct op {
+    const char *name;
+    uint32_t insn;      // op.b $w0, $w1, $w2; the format goes in bits 21-22
+    enum kind kind;
+};
+
+static const struct op arith_ops[] = {
+    { "addv",   0x7802080e, ADDV },
+    { "subv",   0x7882080e, SUBV },
+    { "mulv",   0x78020812, MULV },
+    { "adds_s", 0x79020810, ADDS_S },
+    { "adds_u", 0x79820810, ADDS_U },
+    { "subs_s", 0x78020811, SUBS_S },
+    { "subs_u", 0x78820811, SUBS_U },
+};
+
+static const struct op compare_ops[] = {
+    { "ceq",    0x7802080f, CEQ },
+    { "clt_s",  0x7902080f, CLT_S },
+    { "clt_u",  0x7982080f, CLT_U },
+    { "cle_s",  0x7a02080f, CLE_S },
+    { "cle_u",  0x7a82080f, CLE_U },
+    { "max_s",  0x7902080e, MAX_S },
+    { "max_u",  0x7982080e, MAX_U },
+    { "min_s",  0x7a02080e, MIN_S },
+    { "min_u",  0x7a82080e, MIN_U },
+};
+
+static const struct op permute_ops[] = {
+    { "ilvr",   0x7a820814, ILVR },
+    { "ilvl",   0x7a020814, ILVL },
+    { "ilvev",  0x7b020814, ILVEV },
+    { "ilvod",  0x7b820814, ILVOD },
+    { "pckev",  0x79020814, PCKEV },
+    { "pckod",  0x79820814, PCKOD },
+    { "vshf",   0x78020815, VSHF },
+};
+
+static uint64_t sat(int64_t x, int esize, int sgn, int carry)
+{
+    // for 64-bit elements the caller passes the overflow in CARRY
+    if (esize == 64) {
+        if (!carry) {
+            return x;
+        }
+        return sgn ? (carry < 0 ? INT64_MIN : INT64_MAX) : (carry < 0 ? 0 : -1);
+    } else {
+        int64_t lo = sgn ? -(1LL << (esize - 1)) : 0;
+        int64_t hi = sgn ? (1LL << (esize - 1)) - 1 : (1LL << esize) - 1;
+        return x < lo ? lo : x > hi ? hi : x;
+    }
+}
+
+static uint64_t model_elem(enum kind kind, uint64_t s, uint64_t t, int esize)
+{
+    int64_t ss = sext(s, esize), st = sext(t, esize);
+    uint64_t r;
+
+    switch (kind) {
+    case ADDV:   return s + t;
+    case SUBV:   return s - t;
+    case MULV:   return s * t;
+    case CEQ:    return -(uint64_t)(s == t);
+    case CLT_S:  return -(uint64_t)(ss < st);
+    case CLT_U:  return -(uint64_t)(s < t);
+    case CLE_S:  return -(uint64_t)(ss <= st);
+    case CLE_U:  return -(uint64_t)(s <= t);
+    case MAX_S:  return ss > st ? s : t;
+    case MAX_U:  return s > t ? s : t;
+    case MIN_S:  return ss < st ? s : t;
+    case MIN_U:  return s < t ? s : t;
+    case ADDS_S:
+        r = s + t;
+        return sat(ss + st, esize, 1,
+                   ((ss < 0) == (st < 0) && ((int64_t)r < 0) != (ss < 0)) ?
+                   (ss < 0 ? -1 : 1) : 0);
+    case ADDS_U:
+        return sat(s + t, esize, 0, s + t < s);
+    case SUBS_S:
+        r = s - t;
+        return sat(ss - st, esize, 1,
+                   ((ss < 0) != (st < 0) && ((int64_t)r < 0) != (ss < 0)) ?
+                   (ss < 0 ? -1 : 1) : 0);
+    case SUBS_U:
+        return sat(s - t, esize, 0, s < t ? -1 : 0);
+    default:
+        return 0;
+    }
+}
+
+static void model(enum kind kind, int esize, const uint8_t *s, const uint8_t *t,
+                  const uint8_t *d, uint8_t *out)
+{
+    uint64_t mask = esize == 64 ? -1 : (1ULL << esize) - 1;
+    int n = 128 / esize, h = n / 2;
+    int i;
+
+    memset(out, 0, 16);
+    for (i = 0; i < n; i++) {
+        uint64_t x;
+
+        switch (kind) {
+        case ILVR:
+            x = (i & 1) ? elem(s, i / 2, esize) : elem(t, i / 2, esize);
+            break;
+        case ILVL:
+            x = (i & 1) ? elem(s, h + i / 2, esize) : elem(t, h + i / 2, esize);
+            break;
+        case ILVEV:
+            x = (i & 1) ? elem(s, i - 1, esize) : elem(t, i, esize);
+            break;
+        case ILVOD:
+            x = (i & 1) ? elem(s, i, esize) : elem(t, i + 1, esize);
+            break;
+        case PCKEV:
+            x = i < h ? elem(t, 2 * i, esize) : elem(s, 2 * (i - h), esize);
+            break;
+        case PCKOD:
+            x = i < h ? elem(t, 2 * i + 1, esize) : elem(s, 2 * (i - h) + 1, esize);
+            break;
+        case VSHF: {
+            uint64_t c = elem(d, i, esize);
+            int k = (c & 0x3f) % (2 * n);
+            x = (c & 0xc0) ? 0 : k < n ? elem(t, k, esize) : elem(s, k - n, esize);
+            break;
+        }
+        default:
+            x = model_elem(kind, elem(s, i, esize), elem(t, i, esize), esize);
+            break;
+        }
+        put(out, i, esize, x & mask);
+    }
+}
+
+// emit the prologue, OP for data format DF and the store at ADDR
+static void write_code(uc_engine *uc, uint64_t addr, const struct op *op, int df)
+{
+    uint32_t code[sizeof(prologue) / 4 + 2];
+
+    memcpy(code, prologue, sizeof(prologue));
+    code[sizeof(prologue) / 4] = op->insn | df << 21;
+    code[sizeof(prologue) / 4 + 1] = ST_W0;
+    OK(uc_mem_write(uc, addr, code, sizeof(code)));
+}
+
+static void run_ops(uc_engine *uc, const struct op *ops, size_t nops, int iters)
+{
+    size_t len = sizeof(prologue) + 8;
+    uint32_t a0 = DATA;
+    size_t i;
+    int df, it;
+
+    for (i = 0; i < nops; i++) {
+        for (df = 0; df < 4; df++) {
+            uint64_t addr = CODE + (i * 4 + df) * 0x40;
+            int esize = 8 << df;
+
+            write_code(uc, addr, &ops[i], df);
+            for (it = 0; it < iters; it++) {
+                uint8_t s[16], t[16], d[16], want[16], got[16];
+
+                rnd_vec(s, esize, NULL);
+                rnd_vec(t, esize, s);
+                rnd_vec(d, esize, NULL);
+                OK(uc_mem_write(uc, DATA + 16, s, 16));
+                OK(uc_mem_write(uc, DATA + 32, t, 16));
+                OK(uc_mem_write(uc, DATA + 48, d, 16));
+                OK(uc_reg_write(uc, UC_MIPS_REG_A0, &a0));
+                OK(uc_emu_start(uc, addr, addr + len, 0, 0));
+                OK(uc_mem_read(uc, DATA, got, 16));
+
+                model(ops[i].kind, esize, s, t, d, want);
+                if (memcmp(got, want, 16)) {
+                    fail_msg("%s.%c: mismatch at iteration %d",
+                             ops[i].name, "bhwd"[df], it);
+                }
+            }
+        }
+    }
+}
+
+static void test_msa_arith(void **state)
+{
+    run_ops(*state, arith_ops, sizeof(arith_ops) / sizeof(arith_ops[0]), 300);
+}
+
+static void test_msa_compare(void **state)
+{
+    run_ops(*state, compare_ops, sizeof(compare_ops) / sizeof(compare_ops[0]), 300);
+}
+
+static void test_msa_permute(void **state)
+{
+    run_ops(*state, permute_ops, sizeof(permute_ops) / sizeof(permute_ops[0]), 300);
+}
+
+// the MIPS32R5 cpu type only exists for 32-bit MIPS
+static void test_msa_mode(void **state)
+{
+    uc_engine *uc;
+
+    uc_assert_err(UC_ERR_MODE, uc_open(UC_ARCH_MIPS, UC_MODE_MIPS64 | UC_MODE_MIPS32R5, &uc));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_msa_arith, setup_msa, teardown),
+        cmocka_unit_test_setup_teardown(test_msa_compare, setup_msa, teardown),
+        cmocka_unit_test_setup_teardown(test_msa_permute, setup_msa, teardown),
+        cmocka_unit_test(test_msa_mode),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,324 @@
+// Check the NEON integer helpers that have host SIMD versions (saturating
+// add/sub, register shifts, saturating narrows, pairwise ops) lane by lane
+// against a scalar model, including the QC flag.
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE 0x1000
+
+#define FPSCR_QC (1 << 27)
+
+/* Called before every test to set up a new instance */
+static int setup_arm(void **state)
+{
+    uc_engine *uc;
+    uint32_t cpacr, fpexc = 0x40000000;     // FPEXC.EN
+
+    OK(uc_open(UC_ARCH_ARM, UC_MODE_ARM, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+
+    // enable cp10/cp11, then VFP
+    OK(uc_reg_read(uc, UC_ARM_REG_C1_C0_2, &cpacr));
+    cpacr |= 0xf << 20;
+    OK(uc_reg_write(uc, UC_ARM_REG_C1_C0_2, &cpacr));
+    OK(uc_reg_write(uc, UC_ARM_REG_FPEXC, &fpexc));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+// random lanes of ESIZE bits, often close to the saturation points
+static uint64_t rnd_lanes(int esize)
+{
+    static const uint64_t edge[] = { 0, 1, 2, -1, -2, 0x7f, 0x80, 0xff,
+                                     0x7fff, 0x8000, 0xffff, 0x8001 };
+    uint64_t mask = (esize == 64) ? -1 : (1ULL << esize) - 1;
+    uint64_t v = 0;
+    int i;
+
+    for (i = 0; i < 64; i += esize) {
+        uint64_t lane = rnd();
+        if ((lane & 3) == 0) {
+            lane = edge[(lane >> 8) % (sizeof(edge) / sizeof(edge[0]))];
+        }
+        v |= (lane & mask) << i;
+    }
+    return v;
+}
+
+// shift counts: mostly within a lane or just past it, either direction
+static uint64_t rnd_shifts(int esize)
+{
+    uint64_t v = rnd_lanes(esize);
+    int i;
+
+    for (i = 0; i < 64; i += esize) {
+        uint64_t r = rnd();
+        if (r & 3) {
+            int8_t sh = (int8_t)((r >> 8) % (2 * esize + 7)) - (esize + 3);
+            v &= ~(0xffULL << i);
+            v |= (uint64_t)(uint8_t)sh << i;
+        }
+    }
+    return v;
+}
+
+static int64_t lane(uint64_t v, int i, int esize, int sgn)
+{
+    uint64_t x = (v >> (i * esize)) & ((1ULL << esize) - 1);
+
+    if (sgn && (x >> (esize - 1))) {
+        x -= 1ULL << esize;
+    }
+    return (int64_t)x;
+}
+
+static int64_t sat(int64_t x, int esize, int sgn, int *qc)
+{
+    int64_t lo = sgn ? -(1LL << (esize - 1)) : 0;
+    int64_t hi = sgn ? (1LL << (esize - 1)) - 1 : (1LL << esize) - 1;
+
+    if (x < lo || x > hi) {
+        *qc = 1;
+        return x < lo ? lo : hi;
+    }
+    return x;
+}
+
+static uint64_t put(uint64_t v, int i, int esize, int64_t x)
+{
+    return v | ((uint64_t)x & ((1ULL << esize) - 1)) << (i * esize);
+}
+
+enum kind { QADD, QSUB, SHL, RSHL, QMOVN, QMOVUN, PADD, PMIN, PMAX };
+
+struct op {
+    const char *name;
+    uint32_t insn;      // d0 = op(d1, d2), or d0 = op(q1) for narrows
+    enum kind kind;
+    int esize;          // source lane size
+    int sgn;
+};
+
+static const struct op ops[] = {
+    { "vqadd.u8",    0xf3010012, QADD, 8, 0 },
+    { "vqadd.s8",    0xf2010012, QADD, 8, 1 },
+    { "vqadd.u16",   0xf3110012, QADD, 16, 0 },
+    { "vqadd.s16",   0xf2110012, QADD, 16, 1 },
+    { "vqsub.u8",    0xf3010212, QSUB, 8, 0 },
+    { "vqsub.s8",    0xf2010212, QSUB, 8, 1 },
+    { "vqsub.u16",   0xf3110212, QSUB, 16, 0 },
+    { "vqsub.s16",   0xf2110212, QSUB, 16, 1 },
+    { "vshl.u8",     0xf3020401, SHL, 8, 0 },
+    { "vshl.s8",     0xf2020401, SHL, 8, 1 },
+    { "vshl.u16",    0xf3120401, SHL, 16, 0 },
+    { "vshl.s16",    0xf2120401, SHL, 16, 1 },
+    { "vrshl.u8",    0xf3020501, RSHL, 8, 0 },
+    { "vrshl.s8",    0xf2020501, RSHL, 8, 1 },
+    { "vrshl.u16",   0xf3120501, RSHL, 16, 0 },
+    { "vrshl.s16",   0xf2120501, RSHL, 16, 1 },
+    { "vqmovn.s16",  0xf3b20282, QMOVN, 16, 1 },
+    { "vqmovn.u16",  0xf3b202c2, QMOVN, 16, 0 },
+    { "vqmovun.s16", 0xf3b20242, QMOVUN, 16, 1 },
+    { "vqmovn.s32",  0xf3b60282, QMOVN, 32, 1 },
+    { "vqmovn.u32",  0xf3b602c2, QMOVN, 32, 0 },
+    { "vqmovun.s32", 0xf3b60242, QMOVUN, 32, 1 },
+    { "vpadd.i8",    0xf2010b12, PADD, 8, 0 },
+    { "vpadd.i16",   0xf2110b12, PADD, 16, 0 },
+    { "vpmin.u8",    0xf3010a12, PMIN, 8, 0 },
+    { "vpmin.s8",    0xf2010a12, PMIN, 8, 1 },
+    { "vpmin.u16",   0xf3110a12, PMIN, 16, 0 },
+    { "vpmin.s16",   0xf2110a12, PMIN, 16, 1 },
+    { "vpmax.u8",    0xf3010a02, PMAX, 8, 0 },
+    { "vpmax.s8",    0xf2010a02, PMAX, 8, 1 },
+    { "vpmax.u16",   0xf3110a02, PMAX, 16, 0 },
+    { "vpmax.s16",   0xf2110a02, PMAX, 16, 1 },
+};
+
+// NEON shift by a signed count, rounding right shifts if RND
+static int64_t vshl(int64_t x, int8_t sh, int esize, int sgn, int rnd)
+{
+    if (sh >= 0) {
+        return sh >= esize ? 0 : (int64_t)((uint64_t)x << sh);
+    }
+    if (-sh > esize) {
+        // everything is shifted out; a signed non-rounding shift leaves the sign
+        return (sgn && !rnd) ? (x < 0 ? -1 : 0) : 0;
+    }
+    if (rnd) {
+        x += 1LL << (-sh - 1);
+    }
+    return x >> -sh;
+}
+
+static uint64_t model(const struct op *op, uint64_t a, uint64_t b, int *qc)
+{
+    int n = 64 / op->esize, i;
+    uint64_t r = 0;
+
+    *qc = 0;
+    for (i = 0; i < n; i++) {
+        int64_t x = lane(a, i, op->esize, op->sgn);
+        int64_t y = lane(b, i, op->esize, op->sgn);
+        int64_t lo, hi;
+
+        switch (op->kind) {
+        case QADD:
+            r = put(r, i, op->esize, sat(x + y, op->esize, op->sgn, qc));
+            break;
+        case QSUB:
+            r = put(r, i, op->esize, sat(x - y, op->esize, op->sgn, qc));
+            break;
+        case SHL:
+        case RSHL:
+            r = put(r, i, op->esize, vshl(x, (int8_t)lane(b, i, op->esize, 0),
+                                          op->esize, op->sgn,
+                                          op->kind == RSHL));
+            break;
+        case QMOVN:
+        case QMOVUN:
+            // q1 is A:B, narrowed into the low and high halves of d0
+            r = put(r, i, op->esize / 2,
+                    sat(x, op->esize / 2, op->kind == QMOVN && op->sgn, qc));
+            r = put(r, i + n, op->esize / 2,
+                    sat(y, op->esize / 2, op->kind == QMOVN && op->sgn, qc));
+            break;
+        case PADD:
+        case PMIN:
+        case PMAX:
+            // first half from A, second half from B
+            lo = lane(i < n / 2 ? a : b, 2 * (i % (n / 2)), op->esize, op->sgn);
+            hi = lane(i < n / 2 ? a : b, 2 * (i % (n / 2)) + 1, op->esize,
+                      op->sgn);
+            r = put(r, i, op->esize, op->kind == PADD ? lo + hi :
+                    op->kind == PMIN ? (lo < hi ? lo : hi) :
+                                       (lo > hi ? lo : hi));
+            break;
+        }
+    }
+    return r;
+}
+
+static void run_op(uc_engine *uc, const struct op *op, int iters)
+{
+    uint32_t code[] = {
+        0xeee10a10,     // vmsr fpscr, r0
+        op->insn,
+        0xeef11a10,     // vmrs r1, fpscr
+    };
+    int i;
+
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+
+    for (i = 0; i < iters; i++) {
+        int narrow = op->kind == QMOVN || op->kind == QMOVUN;
+        uint64_t a = rnd_lanes(op->esize), b, d0, expect;
+        uint32_t fpscr = 0;
+        int qc;
+
+        b = (op->kind == SHL || op->kind == RSHL) ? rnd_shifts(op->esize)
+                                                  : rnd_lanes(op->esize);
+        expect = model(op, a, b, &qc);
+
+        OK(uc_reg_write(uc, UC_ARM_REG_R0, &fpscr));
+        OK(uc_reg_write(uc, narrow ? UC_ARM_REG_D2 : UC_ARM_REG_D1, &a));
+        OK(uc_reg_write(uc, narrow ? UC_ARM_REG_D3 : UC_ARM_REG_D2, &b));
+        OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+        OK(uc_reg_read(uc, UC_ARM_REG_D0, &d0));
+        OK(uc_reg_read(uc, UC_ARM_REG_R1, &fpscr));
+
+        if (d0 != expect || !!(fpscr & FPSCR_QC) != qc) {
+            print_message("%s %016llx %016llx: got %016llx qc=%d, "
+                          "expected %016llx qc=%d\n", op->name,
+                          (unsigned long long)a, (unsigned long long)b,
+                          (unsigned long long)d0, !!(fpscr & FPSCR_QC),
+                          (unsigned long long)expect, qc);
+        }
+        assert_true(d0 == expect);
+        assert_int_equal(!!(fpscr & FPSCR_QC), qc);
+    }
+}
+
+static void test_neon_saturate(void **state)
+{
+    uc_engine *uc = *state;
+    size_t i;
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (ops[i].kind == QADD || ops[i].kind == QSUB) {
+            run_op(uc, &ops[i], 500);
+        }
+    }
+}
+
+static void test_neon_shift(void **state)
+{
+    uc_engine *uc = *state;
+    size_t i;
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (ops[i].kind == SHL || ops[i].kind == RSHL) {
+            run_op(uc, &ops[i], 500);
+        }
+    }
+}
+
+static void test_neon_narrow(void **state)
+{
+    uc_engine *uc = *state;
+    size_t i;
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (ops[i].kind == QMOVN || ops[i].kind == QMOVUN) {
+            run_op(uc, &ops[i], 500);
+        }
+    }
+}
+
+static void test_neon_pairwise(void **state)
+{
+    uc_engine *uc = *state;
+    size_t i;
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (ops[i].kind == PADD || ops[i].kind == PMIN || ops[i].kind == PMAX) {
+            run_op(uc, &ops[i], 500);
+        }
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_neon_saturate, setup_arm, teardown),
+        cmocka_unit_test_setup_teardown(test_neon_shift, setup_arm, teardown),
+        cmocka_unit_test_setup_teardown(test_neon_narrow, setup_arm, teardown),
+        cmocka_unit_test_setup_teardown(test_neon_pairwise, setup_arm, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
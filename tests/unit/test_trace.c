@@ -0,0 +1,147 @@
+// Test trace collectors added with uc_trace_add()
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE    0x1000
+#define DATA    0x100000
+
+// loop 3 times over: mov [esi], ecx; mov eax, [esi + 4]; add esi, 8
+static const uint8_t code[] = {
+    0xb9, 0x03, 0x00, 0x00, 0x00,       // mov ecx, 3
+    0x89, 0x0e,                         // mov [esi], ecx
+    0x8b, 0x46, 0x04,                   // mov eax, [esi + 4]
+    0x83, 0xc6, 0x08,                   // add esi, 8
+    0x49,                               // dec ecx
+    0x75, 0xf5,                         // jnz CODE + 5
+};
+
+/* Called before every test to set up a new instance */
+static int setup32(void **state)
+{
+    uc_engine *uc;
+    uint32_t r_esi = DATA;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_map(uc, DATA, 0x1000, UC_PROT_READ | UC_PROT_WRITE));
+    OK(uc_reg_write(uc, UC_X86_REG_ESI, &r_esi));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+static void test_trace_code(void **state)
+{
+    uc_engine *uc = *state;
+    const uint64_t *pcs;
+    size_t count;
+    uc_hook hcode, hblock;
+
+    OK(uc_trace_add(uc, &hcode, UC_TRACE_CODE, 1, 0));
+    OK(uc_trace_add(uc, &hblock, UC_TRACE_BLOCK, 1, 0));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    OK(uc_trace_get(uc, hcode, (const void **)&pcs, &count));
+    assert_int_equal(count, 1 + 3 * 5);
+    assert_int_equal(pcs[0], CODE);
+    assert_int_equal(pcs[1], CODE + 5);
+    assert_int_equal(pcs[15], CODE + 14);
+
+    OK(uc_trace_get(uc, hblock, (const void **)&pcs, &count));
+    assert_int_equal(count, 3);
+    assert_int_equal(pcs[0], CODE);
+    assert_int_equal(pcs[2], CODE + 5);
+
+    // reset drops the records
+    OK(uc_trace_reset(uc, hcode));
+    OK(uc_trace_get(uc, hcode, (const void **)&pcs, &count));
+    assert_int_equal(count, 0);
+
+    // and deleted collectors are gone
+    OK(uc_trace_del(uc, hblock));
+    uc_assert_err(UC_ERR_ARG, uc_trace_get(uc, hblock, (const void **)&pcs, &count));
+    uc_assert_err(UC_ERR_ARG, uc_trace_del(uc, hblock));
+}
+
+static void test_trace_mem(void **state)
+{
+    uc_engine *uc = *state;
+    const uc_trace_mem_access *accesses;
+    size_t count;
+    uc_hook hh;
+
+    OK(uc_trace_add(uc, &hh, UC_TRACE_MEM, 1, 0));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    OK(uc_trace_get(uc, hh, (const void **)&accesses, &count));
+    assert_int_equal(count, 6);
+    assert_int_equal(accesses[0].type, UC_MEM_WRITE);
+    assert_int_equal(accesses[0].address, DATA);
+    assert_int_equal(accesses[0].value, 3);
+    assert_int_equal(accesses[0].size, 4);
+    assert_int_equal(accesses[1].type, UC_MEM_READ);
+    assert_int_equal(accesses[1].address, DATA + 4);
+    assert_int_equal(accesses[5].address, DATA + 20);
+}
+
+static void test_trace_coverage(void **state)
+{
+    uc_engine *uc = *state;
+    const uint64_t *pcs;
+    size_t count;
+    uc_hook hh;
+
+    OK(uc_trace_add(uc, &hh, UC_TRACE_COVERAGE, 1, 0));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    // each block once, across runs
+    OK(uc_trace_get(uc, hh, (const void **)&pcs, &count));
+    assert_int_equal(count, 2);
+    assert_int_equal(pcs[0], CODE);
+    assert_int_equal(pcs[1], CODE + 5);
+}
+
+static void test_trace_range(void **state)
+{
+    uc_engine *uc = *state;
+    const uint64_t *pcs;
+    size_t count;
+    uc_hook hh;
+
+    uc_assert_err(UC_ERR_ARG, uc_trace_add(uc, &hh, 0, 1, 0));
+
+    // only the loop body
+    OK(uc_trace_add(uc, &hh, UC_TRACE_CODE, CODE + 5, CODE + 9));
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    OK(uc_trace_get(uc, hh, (const void **)&pcs, &count));
+    assert_int_equal(count, 3 * 2);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_trace_code, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_trace_mem, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_trace_coverage, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_trace_range, setup32, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
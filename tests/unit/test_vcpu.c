@@ -0,0 +1,290 @@
+// Test several vCPUs sharing an engine, run in turn by uc_emu_start()
+#include <string.h>
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE    0x1000
+#define DATA    0x2000
+
+// each vCPU adds ECX times 1 to the counter at DATA
+static const uint8_t count_code[] = {
+    0xff, 0x05, 0x00, 0x20, 0x00, 0x00, // inc dword ptr [0x2000]
+    0x49,                               // dec ecx
+    0x75, 0xf7,                         // jnz CODE
+};
+
+/* Called before every test to set up a new instance */
+static int setup32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+    OK(uc_mem_map(uc, 0, 0x100000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, count_code, sizeof(count_code)));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+// select vCPU @index and point it at the counting code
+static void start_counting(uc_engine *uc, int index, uint32_t ecx)
+{
+    uint32_t eip = CODE;
+
+    OK(uc_vcpu_select(uc, index));
+    OK(uc_reg_write(uc, UC_X86_REG_EIP, &eip));
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &ecx));
+}
+
+struct switches {
+    int last;       // vCPU of the last instruction
+    int count;      // times another vCPU ran
+    int seen[4];    // instructions run by each vCPU
+};
+
+static void hook_switch(uc_engine *uc, uint64_t address, uint32_t size, void *user_data)
+{
+    struct switches *s = user_data;
+    size_t index;
+
+    uc_assert_success(uc_query(uc, UC_QUERY_VCPU, &index));
+    if ((int)index != s->last) {
+        s->last = (int)index;
+        s->count++;
+    }
+    s->seen[index]++;
+}
+
+/******************************************************************************/
+
+static void test_vcpu_registers(void **state)
+{
+    uc_engine *uc = *state;
+    uint32_t eax;
+    size_t index;
+    int vcpu;
+
+    OK(uc_vcpu_add(uc, &vcpu));
+    assert_int_equal(vcpu, 1);
+
+    // registers belong to the selected vCPU
+    eax = 1;
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_vcpu_select(uc, 1));
+    eax = 2;
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &eax));
+
+    OK(uc_vcpu_select(uc, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &eax));
+    assert_int_equal(eax, 1);
+    OK(uc_vcpu_select(uc, 1));
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &eax));
+    assert_int_equal(eax, 2);
+
+    assert_int_equal(uc_vcpu_select(uc, 2), UC_ERR_ARG);
+    assert_int_equal(uc_vcpu_select(uc, -1), UC_ERR_ARG);
+    assert_int_equal(uc_vcpu_set_quantum(uc, 0), UC_ERR_ARG);
+
+    OK(uc_query(uc, UC_QUERY_VCPU, &index));
+    assert_int_equal(index, 0);
+}
+
+// vCPUs take turns, each for its quantum, and share memory
+static void test_vcpu_round_robin(void **state)
+{
+    uc_engine *uc = *state;
+    struct switches s = { -1, 0, { 0 } };
+    uc_hook hook;
+    uint32_t ecx, counter = 0;
+
+    OK(uc_vcpu_add(uc, NULL));
+    OK(uc_vcpu_add(uc, NULL));
+    OK(uc_vcpu_set_quantum(uc, 30));
+    OK(uc_mem_write(uc, DATA, &counter, sizeof(counter)));
+    OK(uc_hook_add(uc, &hook, UC_HOOK_CODE, hook_switch, &s, 1, 0));
+
+    start_counting(uc, 1, 100);
+    start_counting(uc, 2, 200);
+    start_counting(uc, 0, 300);
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(count_code), 0, 0));
+
+    OK(uc_mem_read(uc, DATA, &counter, sizeof(counter)));
+    assert_int_equal(counter, 600);
+
+    // each ran to the end, switching every 10 loops or so
+    assert_int_equal(s.seen[0], 900);
+    assert_int_equal(s.seen[1], 300);
+    assert_int_equal(s.seen[2], 600);
+    assert_true(s.count > 20);
+    assert_int_equal(s.last, 0);
+
+    OK(uc_vcpu_select(uc, 1));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &ecx));
+    assert_int_equal(ecx, 0);
+    OK(uc_vcpu_select(uc, 2));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &ecx));
+    assert_int_equal(ecx, 0);
+}
+
+// a single vCPU does not switch, and neither does a quantum larger than the work
+static void test_vcpu_quantum(void **state)
+{
+    uc_engine *uc = *state;
+    struct switches s = { -1, 0, { 0 } };
+    uc_hook hook;
+    size_t index;
+
+    OK(uc_hook_add(uc, &hook, UC_HOOK_CODE, hook_switch, &s, 1, 0));
+    start_counting(uc, 0, 100);
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(count_code), 0, 0));
+    assert_int_equal(s.count, 1);
+
+    OK(uc_vcpu_add(uc, NULL));
+    OK(uc_vcpu_set_quantum(uc, 1000));
+    memset(&s, 0, sizeof(s));
+    s.last = -1;
+    start_counting(uc, 1, 100);
+    start_counting(uc, 0, 100);
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(count_code), 0, 0));
+    assert_int_equal(s.count, 2);
+    assert_int_equal(s.seen[0], 300);
+    assert_int_equal(s.seen[1], 300);
+
+    // vCPU 1 ran last
+    OK(uc_query(uc, UC_QUERY_VCPU, &index));
+    assert_int_equal(index, 1);
+}
+
+// an error, or uc_emu_stop(), stops all vCPUs
+static void test_vcpu_stop(void **state)
+{
+    uc_engine *uc = *state;
+    static const uint8_t fault[] = { 0xa1, 0x00, 0x00, 0x00, 0x80 };    // mov eax, [0x80000000]
+    struct switches s = { -1, 0, { 0 } };
+    uc_hook hook;
+    uint32_t counter = 0;
+
+    OK(uc_mem_write(uc, CODE + 0x100, fault, sizeof(fault)));
+    OK(uc_mem_write(uc, DATA, &counter, sizeof(counter)));
+    OK(uc_vcpu_add(uc, NULL));
+    OK(uc_vcpu_set_quantum(uc, 10));
+
+    // vCPU 1 counts forever while vCPU 0 faults
+    start_counting(uc, 1, 0);
+    start_counting(uc, 0, 0);
+    assert_int_equal(uc_emu_start(uc, CODE + 0x100, CODE + 0x200, 0, 0), UC_ERR_READ_UNMAPPED);
+
+    // the count of uc_emu_start() covers all vCPUs
+    OK(uc_hook_add(uc, &hook, UC_HOOK_CODE, hook_switch, &s, 1, 0));
+    start_counting(uc, 1, 0);
+    start_counting(uc, 0, 0);
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(count_code), 0, 100));
+    assert_int_equal(s.seen[0] + s.seen[1], 100);
+    assert_true(s.seen[1] > 0);
+}
+
+// vCPUs stop one by one at @until, also when it is not mapped
+static void test_vcpu_until_unmapped(void **state)
+{
+    uc_engine *uc = *state;
+    static const uint8_t code[] = {
+        0x49,                               // dec ecx
+        0x75, 0xfd,                         // jnz CODE
+        0xe9, 0xf8, 0xff, 0x0f, 0x00,       // jmp 0x101000
+    };
+    uint32_t ecx;
+
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_vcpu_add(uc, NULL));
+    OK(uc_vcpu_set_quantum(uc, 5));
+
+    start_counting(uc, 1, 50);
+    start_counting(uc, 0, 10);
+    OK(uc_emu_start(uc, CODE, 0x101000, 0, 0));
+
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &ecx));
+    assert_int_equal(ecx, 0);
+    OK(uc_vcpu_select(uc, 1));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &ecx));
+    assert_int_equal(ecx, 0);
+}
+
+static void hook_add_vcpu(uc_engine *uc, uint64_t address, uint32_t size, void *user_data)
+{
+    *(uc_err *)user_data = uc_vcpu_add(uc, NULL);
+}
+
+static void test_vcpu_add_running(void **state)
+{
+    uc_engine *uc = *state;
+    uc_hook hook;
+    uc_err err = UC_ERR_OK;
+
+    OK(uc_hook_add(uc, &hook, UC_HOOK_CODE, hook_add_vcpu, &err, CODE, CODE));
+    start_counting(uc, 0, 1);
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(count_code), 0, 0));
+    assert_int_equal(err, UC_ERR_ARG);
+}
+
+static void test_vcpu_arm(void **state)
+{
+    uc_engine *uc;
+    static const uint8_t code[] = {
+        0x00, 0x10, 0x92, 0xe5,     // ldr r1, [r2]
+        0x01, 0x10, 0x81, 0xe2,     // add r1, r1, #1
+        0x00, 0x10, 0x82, 0xe5,     // str r1, [r2]
+        0x01, 0x00, 0x50, 0xe2,     // subs r0, r0, #1
+        0xfa, 0xff, 0xff, 0x1a,     // bne CODE
+    };
+    uint32_t r0, r2 = DATA, pc = CODE, counter = 0;
+    int i;
+
+    OK(uc_open(UC_ARCH_ARM, UC_MODE_ARM, &uc));
+    OK(uc_mem_map(uc, 0, 0x10000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    OK(uc_mem_write(uc, DATA, &counter, sizeof(counter)));
+    OK(uc_vcpu_add(uc, NULL));
+    OK(uc_vcpu_set_quantum(uc, 7));
+
+    // vCPUs do not race, as only one runs at a time
+    for (i = 1; i >= 0; i--) {
+        r0 = 50 * (i + 1);
+        OK(uc_vcpu_select(uc, i));
+        OK(uc_reg_write(uc, UC_ARM_REG_R0, &r0));
+        OK(uc_reg_write(uc, UC_ARM_REG_R2, &r2));
+        OK(uc_reg_write(uc, UC_ARM_REG_PC, &pc));
+    }
+    OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+
+    OK(uc_mem_read(uc, DATA, &counter, sizeof(counter)));
+    assert_int_equal(counter, 150);
+
+    OK(uc_close(uc));
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_vcpu_registers, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_vcpu_round_robin, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_vcpu_quantum, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_vcpu_stop, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_vcpu_until_unmapped, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_vcpu_add_running, setup32, teardown),
+        cmocka_unit_test(test_vcpu_arm),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,147 @@
+// Test the bulk path of REP MOVS/STOS against the per-element semantics
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+#include <string.h>
+
+#define OK(x)   uc_assert_success(x)
+
+/* Called before every test to set up a new instance */
+static int setup32(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_32, &uc));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+#define REP_CODE 0x1000000
+#define REP_DATA 0x2000000
+
+static void hook_rep_write(uc_engine *uc, uc_mem_type type,
+        uint64_t address, int size, int64_t value, void *user_data)
+{
+    int *count = user_data;
+    (*count)++;
+}
+
+static void rep_run(uc_engine *uc, const uint8_t *code, size_t size,
+                    uint32_t esi, uint32_t edi, uint32_t ecx, uint32_t eax)
+{
+    OK(uc_mem_write(uc, REP_CODE, code, size));
+    OK(uc_reg_write(uc, UC_X86_REG_ESI, &esi));
+    OK(uc_reg_write(uc, UC_X86_REG_EDI, &edi));
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &ecx));
+    OK(uc_reg_write(uc, UC_X86_REG_EAX, &eax));
+    OK(uc_emu_start(uc, REP_CODE, REP_CODE + size, 0, 0));
+}
+
+static void test_i386_rep_movs(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0xf3, 0xa4,     // rep movsb
+    };
+    static uint8_t src[0x1800], buf[0x1800];
+    uint32_t r_esi, r_edi, r_ecx;
+    int i, writes = 0;
+    uc_hook trace;
+
+    for (i = 0; i < sizeof(src); i++)
+        src[i] = i * 7;
+
+    OK(uc_mem_map(uc, REP_CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_map(uc, REP_DATA, 0x4000, UC_PROT_ALL));
+    OK(uc_mem_write(uc, REP_DATA + 0x100, src, sizeof(src)));
+
+    // both ranges cross a page boundary, the copy goes in bulk
+    rep_run(uc, code, sizeof(code), REP_DATA + 0x100, REP_DATA + 0x2080, sizeof(src), 0);
+    OK(uc_mem_read(uc, REP_DATA + 0x2080, buf, sizeof(buf)));
+    assert_memory_equal(buf, src, sizeof(src));
+    OK(uc_reg_read(uc, UC_X86_REG_ESI, &r_esi));
+    OK(uc_reg_read(uc, UC_X86_REG_EDI, &r_edi));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_esi, REP_DATA + 0x100 + sizeof(src));
+    assert_int_equal(r_edi, REP_DATA + 0x2080 + sizeof(src));
+    assert_int_equal(r_ecx, 0);
+
+    // with a write hook, every element is still reported
+    OK(uc_hook_add(uc, &trace, UC_HOOK_MEM_WRITE, hook_rep_write, &writes, 1, 0));
+    rep_run(uc, code, sizeof(code), REP_DATA + 0x100, REP_DATA + 0x2000, 0x10, 0);
+    assert_int_equal(writes, 0x10);
+    OK(uc_hook_del(uc, trace));
+
+    // overlapping copy with dst = src + 1 replicates the first byte
+    memset(buf, 0, sizeof(buf));
+    buf[0] = 0xab;
+    OK(uc_mem_write(uc, REP_DATA + 0xf00, buf, 0x200));
+    rep_run(uc, code, sizeof(code), REP_DATA + 0xf00, REP_DATA + 0xf01, 0x1ff, 0);
+    OK(uc_mem_read(uc, REP_DATA + 0xf00, buf, 0x200));
+    for (i = 0; i < 0x200; i++)
+        assert_int_equal(buf[i], 0xab);
+}
+
+static void test_i386_rep_stos(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code_down[] = {
+        0xfd,           // std
+        0xf3, 0xab,     // rep stosd
+        0xfc,           // cld
+    };
+    const uint8_t code_byte[] = {
+        0xf3, 0xaa,     // rep stosb
+    };
+    uint32_t buf[8], r_edi, r_ecx;
+    int i;
+
+    OK(uc_mem_map(uc, REP_CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_map(uc, REP_DATA, 0x4000, UC_PROT_ALL));
+
+    // backwards across a page boundary
+    rep_run(uc, code_down, sizeof(code_down), 0, REP_DATA + 0x100c, 8, 0x11223344);
+    OK(uc_mem_read(uc, REP_DATA + 0xff0, buf, sizeof(buf)));
+    for (i = 0; i < 8; i++)
+        assert_int_equal(buf[i], 0x11223344);
+    OK(uc_reg_read(uc, UC_X86_REG_EDI, &r_edi));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_edi, REP_DATA + 0xfec);
+    assert_int_equal(r_ecx, 0);
+
+    // running off the end of the mapping faults on the first unmapped byte,
+    // with the registers pointing at it
+    OK(uc_mem_write(uc, REP_CODE, code_byte, sizeof(code_byte)));
+    r_edi = REP_DATA + 0x3f00;
+    r_ecx = 0x200;
+    OK(uc_reg_write(uc, UC_X86_REG_EDI, &r_edi));
+    OK(uc_reg_write(uc, UC_X86_REG_ECX, &r_ecx));
+    uc_assert_err(UC_ERR_WRITE_UNMAPPED,
+            uc_emu_start(uc, REP_CODE, REP_CODE + sizeof(code_byte), 0, 0));
+    OK(uc_reg_read(uc, UC_X86_REG_EDI, &r_edi));
+    OK(uc_reg_read(uc, UC_X86_REG_ECX, &r_ecx));
+    assert_int_equal(r_edi, REP_DATA + 0x4000);
+    assert_int_equal(r_ecx, 0x100);
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_i386_rep_movs, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_i386_rep_stos, setup32, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
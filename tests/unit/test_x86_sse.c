@@ -0,0 +1,558 @@
+// Check the SSE integer helpers against their MMX forms (which keep the C
+// implementation) and, for instructions without an MMX form or whose lanes
+// cross the 64-bit halves, against a reference model.
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+#include <stdbool.h>
+#include <string.h>
+
+// On x86_64 hosts, the SSSE3 and SSE4.1 helpers fall back to C when the
+// host lacks them. This test is linked with the static library, to clear
+// these flags and check the C code as well.
+#ifdef __x86_64__
+extern bool have_ssse3_x86_64, have_sse41_x86_64;
+#endif
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE 0x1000
+#define DATA 0x2000
+
+typedef union {
+    uint8_t b[16];
+    int8_t sb[16];
+    uint16_t w[8];
+    int16_t sw[8];
+    uint32_t l[4];
+    int32_t sl[4];
+    uint64_t q[2];
+    int64_t sq[2];
+} vec;
+
+/* Called before every test to set up a new instance */
+static int setup64(void **state)
+{
+    uc_engine *uc;
+
+    OK(uc_open(UC_ARCH_X86, UC_MODE_64, &uc));
+    OK(uc_mem_map(uc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_map(uc, DATA, 0x1000, UC_PROT_ALL));
+
+    *state = uc;
+    return 0;
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+static uint64_t rnd_state = 0x9e3779b97f4a7c15ULL;
+
+static uint64_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+// random vector, with a good share of lanes at the saturation boundaries
+static void rnd_vec(vec *v)
+{
+    static const uint8_t edge[] = { 0x00, 0x01, 0x7f, 0x80, 0x81, 0xff };
+    int i;
+
+    v->q[0] = rnd();
+    v->q[1] = rnd();
+    for (i = 0; i < 16; i++) {
+        if (rnd() % 4 == 0) {
+            v->b[i] = edge[rnd() % sizeof(edge)];
+        }
+    }
+}
+
+// code: load xmm0/xmm1 from [rsi], [rsi + 16], run the op, store xmm0 to [rdi]
+static size_t gen_xmm(uint8_t *code, const uint8_t *op, size_t op_len)
+{
+    static const uint8_t head[] = {
+        0xf3, 0x0f, 0x6f, 0x06,         // movdqu xmm0, [rsi]
+        0xf3, 0x0f, 0x6f, 0x4e, 0x10,   // movdqu xmm1, [rsi + 16]
+        0x66,
+    };
+    static const uint8_t tail[] = {
+        0xf3, 0x0f, 0x7f, 0x07,         // movdqu [rdi], xmm0
+    };
+    size_t n = 0;
+
+    memcpy(code + n, head, sizeof(head));
+    n += sizeof(head);
+    memcpy(code + n, op, op_len);
+    n += op_len;
+    code[n++] = 0xc1;                   // xmm0, xmm1
+    memcpy(code + n, tail, sizeof(tail));
+    n += sizeof(tail);
+    return n;
+}
+
+// same op on the two 64-bit halves in MMX registers, stored to [rdi + 16]
+static size_t gen_mmx(uint8_t *code, const uint8_t *op, size_t op_len)
+{
+    static const uint8_t head[] = {
+        0x0f, 0x6f, 0x06,               // movq mm0, [rsi]
+        0x0f, 0x6f, 0x4e, 0x10,         // movq mm1, [rsi + 16]
+        0x0f, 0x6f, 0x56, 0x08,         // movq mm2, [rsi + 8]
+        0x0f, 0x6f, 0x5e, 0x18,         // movq mm3, [rsi + 24]
+    };
+    static const uint8_t tail[] = {
+        0x0f, 0x7f, 0x47, 0x10,         // movq [rdi + 16], mm0
+        0x0f, 0x7f, 0x57, 0x18,         // movq [rdi + 24], mm2
+    };
+    size_t n = 0;
+
+    memcpy(code + n, head, sizeof(head));
+    n += sizeof(head);
+    memcpy(code + n, op, op_len);
+    n += op_len;
+    code[n++] = 0xc1;                   // mm0, mm1
+    memcpy(code + n, op, op_len);
+    n += op_len;
+    code[n++] = 0xd3;                   // mm2, mm3
+    memcpy(code + n, tail, sizeof(tail));
+    n += sizeof(tail);
+    return n;
+}
+
+static void run(uc_engine *uc, const uint8_t *code, size_t size,
+                const vec *a, const vec *b, vec *r, vec *r_mmx)
+{
+    uint64_t rsi = DATA, rdi = DATA + 0x100;
+    vec out[2];
+
+    OK(uc_mem_write(uc, DATA, a, sizeof(*a)));
+    OK(uc_mem_write(uc, DATA + 16, b, sizeof(*b)));
+    OK(uc_reg_write(uc, UC_X86_REG_RSI, &rsi));
+    OK(uc_reg_write(uc, UC_X86_REG_RDI, &rdi));
+    OK(uc_emu_start(uc, CODE, CODE + size, 0, 0));
+    OK(uc_mem_read(uc, DATA + 0x100, out, sizeof(out)));
+    *r = out[0];
+    if (r_mmx) {
+        *r_mmx = out[1];
+    }
+}
+
+static void fail_vec(const char *name, const vec *a, const vec *b,
+                     const vec *got, const vec *expect)
+{
+    fail_msg("%s: %016llx%016llx, %016llx%016llx -> %016llx%016llx, "
+             "expected %016llx%016llx", name,
+             (unsigned long long)a->q[1], (unsigned long long)a->q[0],
+             (unsigned long long)b->q[1], (unsigned long long)b->q[0],
+             (unsigned long long)got->q[1], (unsigned long long)got->q[0],
+             (unsigned long long)expect->q[1], (unsigned long long)expect->q[0]);
+}
+
+struct mmx_op {
+    const char *name;
+    uint8_t op[3];
+    size_t len;
+};
+
+static const struct mmx_op mmx_ops[] = {
+    { "paddb", { 0x0f, 0xfc }, 2 },     { "paddw", { 0x0f, 0xfd }, 2 },
+    { "paddd", { 0x0f, 0xfe }, 2 },     { "paddq", { 0x0f, 0xd4 }, 2 },
+    { "psubb", { 0x0f, 0xf8 }, 2 },     { "psubw", { 0x0f, 0xf9 }, 2 },
+    { "psubd", { 0x0f, 0xfa }, 2 },     { "psubq", { 0x0f, 0xfb }, 2 },
+    { "paddusb", { 0x0f, 0xdc }, 2 },   { "paddsb", { 0x0f, 0xec }, 2 },
+    { "psubusb", { 0x0f, 0xd8 }, 2 },   { "psubsb", { 0x0f, 0xe8 }, 2 },
+    { "paddusw", { 0x0f, 0xdd }, 2 },   { "paddsw", { 0x0f, 0xed }, 2 },
+    { "psubusw", { 0x0f, 0xd9 }, 2 },   { "psubsw", { 0x0f, 0xe9 }, 2 },
+    { "pminub", { 0x0f, 0xda }, 2 },    { "pmaxub", { 0x0f, 0xde }, 2 },
+    { "pminsw", { 0x0f, 0xea }, 2 },    { "pmaxsw", { 0x0f, 0xee }, 2 },
+    { "pand", { 0x0f, 0xdb }, 2 },      { "pandn", { 0x0f, 0xdf }, 2 },
+    { "por", { 0x0f, 0xeb }, 2 },       { "pxor", { 0x0f, 0xef }, 2 },
+    { "pcmpgtb", { 0x0f, 0x64 }, 2 },   { "pcmpgtw", { 0x0f, 0x65 }, 2 },
+    { "pcmpgtd", { 0x0f, 0x66 }, 2 },   { "pcmpeqb", { 0x0f, 0x74 }, 2 },
+    { "pcmpeqw", { 0x0f, 0x75 }, 2 },   { "pcmpeqd", { 0x0f, 0x76 }, 2 },
+    { "pmullw", { 0x0f, 0xd5 }, 2 },    { "pmulhuw", { 0x0f, 0xe4 }, 2 },
+    { "pmulhw", { 0x0f, 0xe5 }, 2 },    { "pavgb", { 0x0f, 0xe0 }, 2 },
+    { "pavgw", { 0x0f, 0xe3 }, 2 },     { "pmuludq", { 0x0f, 0xf4 }, 2 },
+    { "pmaddwd", { 0x0f, 0xf5 }, 2 },   { "psadbw", { 0x0f, 0xf6 }, 2 },
+    { "pmaddubsw", { 0x0f, 0x38, 0x04 }, 3 },
+    { "psignb", { 0x0f, 0x38, 0x08 }, 3 },
+    { "psignw", { 0x0f, 0x38, 0x09 }, 3 },
+    { "psignd", { 0x0f, 0x38, 0x0a }, 3 },
+    { "pmulhrsw", { 0x0f, 0x38, 0x0b }, 3 },
+    { "pabsb", { 0x0f, 0x38, 0x1c }, 3 },
+    { "pabsw", { 0x0f, 0x38, 0x1d }, 3 },
+    { "pabsd", { 0x0f, 0x38, 0x1e }, 3 },
+};
+
+static void test_x86_sse_vs_mmx(void **state)
+{
+    uc_engine *uc = *state;
+    uint8_t code[128];
+    size_t i, n, size;
+    int k;
+
+    for (i = 0; i < sizeof(mmx_ops) / sizeof(mmx_ops[0]); i++) {
+        n = gen_xmm(code, mmx_ops[i].op, mmx_ops[i].len);
+        size = n + gen_mmx(code + n, mmx_ops[i].op, mmx_ops[i].len);
+        OK(uc_mem_write(uc, CODE, code, size));
+        for (k = 0; k < 500; k++) {
+            vec a, b, r, r_mmx;
+
+            rnd_vec(&a);
+            rnd_vec(&b);
+            run(uc, code, size, &a, &b, &r, &r_mmx);
+            if (memcmp(&r, &r_mmx, sizeof(r))) {
+                fail_vec(mmx_ops[i].name, &a, &b, &r, &r_mmx);
+            }
+        }
+    }
+}
+
+/******************************************************************************/
+
+static int64_t sat(int64_t x, int64_t lo, int64_t hi)
+{
+    return x < lo ? lo : x > hi ? hi : x;
+}
+
+static void ref_packsswb(vec *r, const vec *a, const vec *b)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        r->sb[i] = sat(a->sw[i], -128, 127);
+        r->sb[i + 8] = sat(b->sw[i], -128, 127);
+    }
+}
+
+static void ref_packuswb(vec *r, const vec *a, const vec *b)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        r->b[i] = sat(a->sw[i], 0, 255);
+        r->b[i + 8] = sat(b->sw[i], 0, 255);
+    }
+}
+
+static void ref_packssdw(vec *r, const vec *a, const vec *b)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        r->sw[i] = sat(a->sl[i], -32768, 32767);
+        r->sw[i + 4] = sat(b->sl[i], -32768, 32767);
+    }
+}
+
+static void ref_packusdw(vec *r, const vec *a, const vec *b)
+{
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        r->w[i] = sat(a->sl[i], 0, 65535);
+        r->w[i + 4] = sat(b->sl[i], 0, 65535);
+    }
+}
+
+#define REF_UNPCK(name, lane, num, half)                            \
+static void ref_ ## name(vec *r, const vec *a, const vec *b)        \
+{                                                                   \
+    int i;                                                          \
+                                                                    \
+    for (i = 0; i < num / 2; i++) {                                 \
+        r->lane[2 * i] = a->lane[half * num / 2 + i];               \
+        r->lane[2 * i + 1] = b->lane[half * num / 2 + i];           \
+    }                                                               \
+}
+
+REF_UNPCK(punpcklbw, b, 16, 0)
+REF_UNPCK(punpcklwd, w, 8, 0)
+REF_UNPCK(punpckldq, l, 4, 0)
+REF_UNPCK(punpcklqdq, q, 2, 0)
+REF_UNPCK(punpckhbw, b, 16, 1)
+REF_UNPCK(punpckhwd, w, 8, 1)
+REF_UNPCK(punpckhdq, l, 4, 1)
+REF_UNPCK(punpckhqdq, q, 2, 1)
+
+static void ref_pshufb(vec *r, const vec *a, const vec *b)
+{
+    int i;
+
+    for (i = 0; i < 16; i++) {
+        r->b[i] = (b->b[i] & 0x80) ? 0 : a->b[b->b[i] & 15];
+    }
+}
+
+#define REF_HORIZ(name, lane, num, op, lo, hi)                      \
+static void ref_ ## name(vec *r, const vec *a, const vec *b)        \
+{                                                                   \
+    int i;                                                          \
+                                                                    \
+    for (i = 0; i < num / 2; i++) {                                 \
+        r->lane[i] = sat((int64_t)a->lane[2 * i] op a->lane[2 * i + 1], lo, hi); \
+        r->lane[i + num / 2] =                                      \
+            sat((int64_t)b->lane[2 * i] op b->lane[2 * i + 1], lo, hi); \
+    }                                                               \
+}
+
+// the non-saturating forms wrap, which the int16/int32 store does for us
+REF_HORIZ(phaddw, sw, 8, +, INT64_MIN, INT64_MAX)
+REF_HORIZ(phaddd, sl, 4, +, INT64_MIN, INT64_MAX)
+REF_HORIZ(phaddsw, sw, 8, +, -32768, 32767)
+REF_HORIZ(phsubw, sw, 8, -, INT64_MIN, INT64_MAX)
+REF_HORIZ(phsubd, sl, 4, -, INT64_MIN, INT64_MAX)
+REF_HORIZ(phsubsw, sw, 8, -, -32768, 32767)
+
+static void ref_pmuldq(vec *r, const vec *a, const vec *b)
+{
+    r->sq[0] = (int64_t)a->sl[0] * b->sl[0];
+    r->sq[1] = (int64_t)a->sl[2] * b->sl[2];
+}
+
+static void ref_pcmpeqq(vec *r, const vec *a, const vec *b)
+{
+    r->q[0] = a->q[0] == b->q[0] ? -1 : 0;
+    r->q[1] = a->q[1] == b->q[1] ? -1 : 0;
+}
+
+#define REF_LANES(name, lane, num, expr)                            \
+static void ref_ ## name(vec *r, const vec *a, const vec *b)        \
+{                                                                   \
+    int i;                                                          \
+                                                                    \
+    for (i = 0; i < num; i++) {                                     \
+        r->lane[i] = expr;                                          \
+    }                                                               \
+}
+
+#define MIN(x, y) ((x) < (y) ? (x) : (y))
+#define MAX(x, y) ((x) > (y) ? (x) : (y))
+REF_LANES(pminsb, sb, 16, MIN(a->sb[i], b->sb[i]))
+REF_LANES(pminsd, sl, 4, MIN(a->sl[i], b->sl[i]))
+REF_LANES(pminuw, w, 8, MIN(a->w[i], b->w[i]))
+REF_LANES(pminud, l, 4, MIN(a->l[i], b->l[i]))
+REF_LANES(pmaxsb, sb, 16, MAX(a->sb[i], b->sb[i]))
+REF_LANES(pmaxsd, sl, 4, MAX(a->sl[i], b->sl[i]))
+REF_LANES(pmaxuw, w, 8, MAX(a->w[i], b->w[i]))
+REF_LANES(pmaxud, l, 4, MAX(a->l[i], b->l[i]))
+REF_LANES(pmulld, l, 4, a->l[i] * b->l[i])
+
+struct ref_op {
+    const char *name;
+    uint8_t op[3];
+    size_t len;
+    void (*ref)(vec *r, const vec *a, const vec *b);
+};
+
+#define OP2(name, b1) { #name, { 0x0f, b1 }, 2, ref_ ## name }
+#define OP3(name, b2) { #name, { 0x0f, 0x38, b2 }, 3, ref_ ## name }
+
+static const struct ref_op ref_ops[] = {
+    OP2(packsswb, 0x63), OP2(packuswb, 0x67), OP2(packssdw, 0x6b),
+    OP2(punpcklbw, 0x60), OP2(punpcklwd, 0x61), OP2(punpckldq, 0x62),
+    OP2(punpcklqdq, 0x6c), OP2(punpckhbw, 0x68), OP2(punpckhwd, 0x69),
+    OP2(punpckhdq, 0x6a), OP2(punpckhqdq, 0x6d),
+    OP3(pshufb, 0x00), OP3(phaddw, 0x01), OP3(phaddd, 0x02),
+    OP3(phaddsw, 0x03), OP3(phsubw, 0x05), OP3(phsubd, 0x06),
+    OP3(phsubsw, 0x07),
+    OP3(pmuldq, 0x28), OP3(pcmpeqq, 0x29), OP3(packusdw, 0x2b),
+    OP3(pminsb, 0x38), OP3(pminsd, 0x39), OP3(pminuw, 0x3a),
+    OP3(pminud, 0x3b), OP3(pmaxsb, 0x3c), OP3(pmaxsd, 0x3d),
+    OP3(pmaxuw, 0x3e), OP3(pmaxud, 0x3f), OP3(pmulld, 0x40),
+};
+
+static void test_x86_sse_vs_ref(void **state)
+{
+    uc_engine *uc = *state;
+    uint8_t code[64];
+    size_t i, size;
+    int k;
+
+    for (i = 0; i < sizeof(ref_ops) / sizeof(ref_ops[0]); i++) {
+        size = gen_xmm(code, ref_ops[i].op, ref_ops[i].len);
+        OK(uc_mem_write(uc, CODE, code, size));
+        for (k = 0; k < 500; k++) {
+            vec a, b, r, expect;
+
+            rnd_vec(&a);
+            rnd_vec(&b);
+            run(uc, code, size, &a, &b, &r, NULL);
+            ref_ops[i].ref(&expect, &a, &b);
+            if (memcmp(&r, &expect, sizeof(r))) {
+                fail_vec(ref_ops[i].name, &a, &b, &r, &expect);
+            }
+        }
+    }
+}
+
+static void test_x86_sse_pmovmskb(void **state)
+{
+    uc_engine *uc = *state;
+    const uint8_t code[] = {
+        0xf3, 0x0f, 0x6f, 0x06,         // movdqu xmm0, [rsi]
+        0x66, 0x0f, 0xd7, 0xc0,         // pmovmskb eax, xmm0
+    };
+    uint64_t rsi = DATA, rax;
+    int i, k;
+
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    for (k = 0; k < 500; k++) {
+        vec a;
+        uint64_t expect = 0;
+
+        rnd_vec(&a);
+        for (i = 0; i < 16; i++) {
+            expect |= (uint64_t)(a.b[i] >> 7) << i;
+        }
+        OK(uc_mem_write(uc, DATA, &a, sizeof(a)));
+        OK(uc_reg_write(uc, UC_X86_REG_RSI, &rsi));
+        OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+        OK(uc_reg_read(uc, UC_X86_REG_RAX, &rax));
+        assert_int_equal(rax, expect);
+    }
+}
+
+// the shuffles, whose order comes from an immediate, for every immediate
+static void test_x86_sse_shuffles(void **state)
+{
+    static const struct {
+        const char *name;
+        uint8_t op[3];
+        size_t len;
+    } ops[] = {
+        { "shufps", { 0x0f, 0xc6 }, 2 },
+        { "pshufd", { 0x66, 0x0f, 0x70 }, 3 },
+        { "pshuflw", { 0xf2, 0x0f, 0x70 }, 3 },
+        { "pshufhw", { 0xf3, 0x0f, 0x70 }, 3 },
+    };
+    static const uint8_t head[] = {
+        0xf3, 0x0f, 0x6f, 0x06,         // movdqu xmm0, [rsi]
+        0xf3, 0x0f, 0x6f, 0x4e, 0x10,   // movdqu xmm1, [rsi + 16]
+    };
+    static const uint8_t tail[] = {
+        0xf3, 0x0f, 0x7f, 0x07,         // movdqu [rdi], xmm0
+    };
+    uc_engine *uc = *state;
+    uint8_t code[64];
+    size_t i, n;
+    int order, k;
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        for (order = 0; order < 256; order++) {
+            vec a, b, r, expect;
+
+            n = 0;
+            memcpy(code + n, head, sizeof(head));
+            n += sizeof(head);
+            memcpy(code + n, ops[i].op, ops[i].len);
+            n += ops[i].len;
+            code[n++] = 0xc1;           // xmm0, xmm1
+            code[n++] = order;
+            memcpy(code + n, tail, sizeof(tail));
+            n += sizeof(tail);
+            OK(uc_mem_write(uc, CODE, code, n));
+
+            rnd_vec(&a);
+            rnd_vec(&b);
+            run(uc, code, n, &a, &b, &r, NULL);
+            expect = i == 0 ? a : b;
+            for (k = 0; k < 4; k++) {
+                switch (i) {
+                case 0:
+                    expect.l[k] = (k < 2 ? a : b).l[(order >> (2 * k)) & 3];
+                    break;
+                case 1:
+                    expect.l[k] = b.l[(order >> (2 * k)) & 3];
+                    break;
+                case 2:
+                    expect.w[k] = b.w[(order >> (2 * k)) & 3];
+                    break;
+                case 3:
+                    expect.w[4 + k] = b.w[4 + ((order >> (2 * k)) & 3)];
+                    break;
+                }
+            }
+            if (memcmp(&r, &expect, sizeof(r))) {
+                fail_vec(ops[i].name, &a, &b, &r, &expect);
+            }
+        }
+    }
+}
+
+// phadd/phsub & packusdw with the same register as source and destination,
+// on the host SIMD path and on the C fallback
+static void test_x86_sse_same_reg(void **state)
+{
+    static const char *const names[] = {
+        "phaddw", "phaddd", "phaddsw", "phsubw", "phsubd", "phsubsw", "packusdw",
+    };
+    uc_engine *uc = *state;
+    uint8_t code[64];
+    size_t i, j, size;
+    int k;
+
+    for (i = 0; i < sizeof(ref_ops) / sizeof(ref_ops[0]); i++) {
+        for (j = 0; j < sizeof(names) / sizeof(names[0]); j++) {
+            if (!strcmp(ref_ops[i].name, names[j])) {
+                break;
+            }
+        }
+        if (j == sizeof(names) / sizeof(names[0])) {
+            continue;
+        }
+
+        size = gen_xmm(code, ref_ops[i].op, ref_ops[i].len);
+        code[size - 5] = 0xc0;          // xmm0, xmm0
+        OK(uc_mem_write(uc, CODE, code, size));
+        for (k = 0; k < 100; k++) {
+            vec a, r, r_c, expect;
+
+            rnd_vec(&a);
+            run(uc, code, size, &a, &a, &r, NULL);
+#ifdef __x86_64__
+            {
+                bool ssse3 = have_ssse3_x86_64, sse41 = have_sse41_x86_64;
+
+                have_ssse3_x86_64 = have_sse41_x86_64 = false;
+                run(uc, code, size, &a, &a, &r_c, NULL);
+                have_ssse3_x86_64 = ssse3;
+                have_sse41_x86_64 = sse41;
+            }
+#else
+            r_c = r;
+#endif
+            ref_ops[i].ref(&expect, &a, &a);
+            if (memcmp(&r, &expect, sizeof(r))) {
+                fail_vec(ref_ops[i].name, &a, &a, &r, &expect);
+            }
+            if (memcmp(&r_c, &expect, sizeof(r_c))) {
+                fail_vec(ref_ops[i].name, &a, &a, &r_c, &expect);
+            }
+        }
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_x86_sse_vs_mmx, setup64, teardown),
+        cmocka_unit_test_setup_teardown(test_x86_sse_vs_ref, setup64, teardown),
+        cmocka_unit_test_setup_teardown(test_x86_sse_pmovmskb, setup64, teardown),
+        cmocka_unit_test_setup_teardown(test_x86_sse_shuffles, setup64, teardown),
+        cmocka_unit_test_setup_teardown(test_x86_sse_same_reg, setup64, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,318 @@
+// Differential test of the x87 host FPU fast path: every operation is run
+// once with an FPU exception unmasked, which forces softfloat, and once with
+// all of them masked, which allows the host FPU under round-to-nearest and
+// double precision. Results and the status word must be identical.
+// UC_MODE_X87_FAST is checked against softfloat at double precision.
+#include "unicorn_test.h"
+#include "unicorn/unicorn.h"
+
+#define OK(x)   uc_assert_success(x)
+
+#define CODE 0x10000
+#define DATA 0x20000
+
+#define CW      (DATA + 0x00)   // control word
+#define OPA     (DATA + 0x10)   // 80-bit ST0 operand
+#define OPB     (DATA + 0x20)   // 80-bit ST1 operand
+#define OPM     (DATA + 0x30)   // 64-bit memory operand
+#define OUT     (DATA + 0x40)   // ST0 and ST1 after the operation
+
+#define FPUC_IM     0x01        // invalid operation exception mask
+#define FPUC_PC_DBL 0x200
+#define FPUC_PC_EXT 0x300
+
+/* Called before every test to set up a new instance */
+static int setup_x87(uc_engine **puc, uc_mode mode)
+{
+    OK(uc_open(UC_ARCH_X86, mode, puc));
+    OK(uc_mem_map(*puc, CODE, 0x1000, UC_PROT_ALL));
+    OK(uc_mem_map(*puc, DATA, 0x1000, UC_PROT_ALL));
+    return 0;
+}
+
+static int setup32(void **state)
+{
+    return setup_x87((uc_engine **)state, UC_MODE_32);
+}
+
+static int setup32_fast(void **state)
+{
+    return setup_x87((uc_engine **)state, UC_MODE_32 | UC_MODE_X87_FAST);
+}
+
+/* Called after every test to clean up */
+static int teardown(void **state)
+{
+    uc_engine *uc = *state;
+
+    OK(uc_close(uc));
+
+    *state = NULL;
+    return 0;
+}
+
+/******************************************************************************/
+
+struct op {
+    const char *name;
+    uint8_t insn[6];
+    size_t len;
+};
+
+// ST0 = a, ST1 = b; OPM is the memory operand
+static const struct op ops[] = {
+    { "fadd st0, st1",  { 0xd8, 0xc1 }, 2 },
+    { "fsub st0, st1",  { 0xd8, 0xe1 }, 2 },
+    { "fsubr st0, st1", { 0xd8, 0xe9 }, 2 },
+    { "fmul st0, st1",  { 0xd8, 0xc9 }, 2 },
+    { "fdiv st0, st1",  { 0xd8, 0xf1 }, 2 },
+    { "fdivr st0, st1", { 0xd8, 0xf9 }, 2 },
+    { "fadd st1, st0",  { 0xdc, 0xc1 }, 2 },
+    { "fsub st1, st0",  { 0xdc, 0xe9 }, 2 },
+    { "fmul st1, st0",  { 0xdc, 0xc9 }, 2 },
+    { "fdiv st1, st0",  { 0xdc, 0xf9 }, 2 },
+    { "fsqrt",          { 0xd9, 0xfa }, 2 },
+    { "fadd m64",       { 0xdc, 0x05 }, 6 },
+    { "fsub m64",       { 0xdc, 0x25 }, 6 },
+    { "fmul m64",       { 0xdc, 0x0d }, 6 },
+    { "fdiv m64",       { 0xdc, 0x35 }, 6 },
+};
+
+static uint64_t rnd_state = 0x2545f4914f6cdd1dULL;
+
+static uint64_t rnd(void)
+{
+    rnd_state ^= rnd_state << 13;
+    rnd_state ^= rnd_state >> 7;
+    rnd_state ^= rnd_state << 17;
+    return rnd_state;
+}
+
+// random 80-bit operands, biased towards the cases the fast path must
+// reject; NARROW keeps to doubles whose results stay in the double range
+static void rnd_f80(uint8_t *v, int narrow)
+{
+    uint16_t sign = (rnd() & 1) << 15, exp;
+    uint64_t mant = rnd() | 1ULL << 63;
+
+    mant &= ~0x7ffULL;      // most operands are doubles
+    switch (narrow ? 7 : rnd() % 10) {
+    case 0:
+        exp = 0;
+        mant = rnd() % 3 == 0 ? 0 : mant >> (rnd() % 64);   // zero, denormal
+        break;
+    case 1:
+        exp = 0x7fff;
+        mant = rnd() % 2 ? 1ULL << 63 : mant | 1;           // inf, nan
+        break;
+    case 2:
+        exp = 0x3fff - 1022 + rnd() % 60 - 30;              // near DBL_MIN
+        break;
+    case 3:
+        exp = 0x3fff + 1023 - rnd() % 60 + 30;              // near DBL_MAX
+        break;
+    case 4:
+        exp = 0x3fff - rnd() % 3;                           // ~1.0
+        mant = rnd() % 2 ? 1ULL << 63 | (rnd() % 4) << 11 : mant;
+        break;
+    case 5:
+        exp = 0x3fff + rnd() % 64 - 32;
+        mant = rnd() | 1ULL << 63;                          // not a double
+        break;
+    case 6:
+        exp = 1 + rnd() % 0x7ffe;                           // any exponent
+        break;
+    default:
+        exp = 0x3fff + rnd() % 400 - 200;
+        break;
+    }
+    memcpy(v, &mant, 8);
+    exp |= sign;
+    memcpy(v + 8, &exp, 2);
+}
+
+static uint64_t rnd_f64(int narrow)
+{
+    uint64_t sign = (rnd() & 1) << 63, frac = rnd() & 0xfffffffffffffULL;
+
+    switch (narrow ? 7 : rnd() % 8) {
+    case 0:
+        return sign | (rnd() % 3 == 0 ? 0 : frac);
+    case 1:
+        return sign | 0x7ff0000000000000ULL | (rnd() % 2 ? 0 : frac | 1);
+    case 2:
+        return sign | ((uint64_t)(1 + rnd() % 53) << 52) | frac;
+    case 3:
+        return sign | ((uint64_t)(1990 + rnd() % 56) << 52) | frac;
+    default:
+        return sign | ((uint64_t)(1023 + rnd() % 400 - 200) << 52) | frac;
+    }
+}
+
+// fldcw [CW]; fld tbyte [OPB]; fld tbyte [OPA]; <op>;
+// fstp tbyte [OUT]; fstp tbyte [OUT + 16]; fnstsw ax
+static size_t gen_code(uint8_t *code, const struct op *op)
+{
+    uint32_t addr[5] = { CW, OPB, OPA, OUT, OUT + 16 };
+    static const uint8_t pre[3][2] = { { 0xd9, 0x2d }, { 0xdb, 0x2d }, { 0xdb, 0x2d } };
+    size_t n = 0;
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        memcpy(code + n, pre[i], 2);
+        memcpy(code + n + 2, &addr[i], 4);
+        n += 6;
+    }
+    memcpy(code + n, op->insn, 2);
+    if (op->len == 6) {
+        uint32_t m = OPM;
+        memcpy(code + n + 2, &m, 4);
+    }
+    n += op->len;
+    for (i = 3; i < 5; i++) {
+        code[n] = 0xdb;
+        code[n + 1] = 0x3d;
+        memcpy(code + n + 2, &addr[i], 4);
+        n += 6;
+    }
+    code[n++] = 0xdf;
+    code[n++] = 0xe0;
+    return n;
+}
+
+static void run_op(uc_engine *uc, size_t len, uint16_t cw, const uint8_t *a,
+                   const uint8_t *b, uint64_t m, uint8_t *out, uint16_t *sw)
+{
+    uint32_t eax = 0;
+
+    OK(uc_mem_write(uc, CW, &cw, 2));
+    OK(uc_mem_write(uc, OPA, a, 10));
+    OK(uc_mem_write(uc, OPB, b, 10));
+    OK(uc_mem_write(uc, OPM, &m, 8));
+    OK(uc_emu_start(uc, CODE, CODE + len, 0, 0));
+    OK(uc_mem_read(uc, OUT, out, 26));
+    OK(uc_reg_read(uc, UC_X86_REG_EAX, &eax));
+    *sw = eax & ~0x3800;    // the stack top depends on the previous run
+}
+
+static void dump(char *buf, const uint8_t *v)
+{
+    int i;
+
+    for (i = 9; i >= 0; i--) {
+        sprintf(buf + 2 * (9 - i), "%02x", v[i]);
+    }
+}
+
+// run each op with control words HARD and SOFT, results must match
+static void check_ops(uc_engine *uc, uint16_t hard_cw, uint16_t soft_cw,
+                      int narrow, int iters)
+{
+    uint8_t code[64];
+    size_t i, len;
+    int n;
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        len = gen_code(code, &ops[i]);
+        OK(uc_mem_write(uc, CODE, code, len));
+        for (n = 0; n < iters; n++) {
+            uint8_t a[10], b[10], soft[26], hard[26];
+            uint64_t m = rnd_f64(narrow);
+            uint16_t soft_sw, hard_sw;
+
+            rnd_f80(a, narrow);
+            rnd_f80(b, narrow);
+            run_op(uc, len, soft_cw, a, b, m, soft, &soft_sw);
+            run_op(uc, len, hard_cw, a, b, m, hard, &hard_sw);
+
+            if (memcmp(soft, hard, 10) || memcmp(soft + 16, hard + 16, 10) ||
+                soft_sw != hard_sw) {
+                char sa[21], sb[21], s0[21], h0[21], s1[21], h1[21];
+
+                dump(sa, a);
+                dump(sb, b);
+                dump(s0, soft);
+                dump(h0, hard);
+                dump(s1, soft + 16);
+                dump(h1, hard + 16);
+                fail_msg("%s cw %04x: %s, %s, %016llx -> soft %s %s (%04x) "
+                         "hard %s %s (%04x)", ops[i].name, hard_cw, sa, sb,
+                         (unsigned long long)m, s0, s1, soft_sw, h0, h1,
+                         hard_sw);
+            }
+        }
+    }
+}
+
+static void test_x87_double(void **state)
+{
+    // double precision, round to nearest
+    check_ops(*state, 0x27f, 0x27f & ~FPUC_IM, 0, 3000);
+}
+
+static void test_x87_other_modes(void **state)
+{
+    // extended and single precision, and the other rounding modes, are not
+    // affected by masking exceptions
+    check_ops(*state, 0x37f, 0x37f & ~FPUC_IM, 0, 300);
+    check_ops(*state, 0x07f, 0x07f & ~FPUC_IM, 0, 300);
+    check_ops(*state, 0x67f, 0x67f & ~FPUC_IM, 0, 300);
+    check_ops(*state, 0xe7f, 0xe7f & ~FPUC_IM, 0, 300);
+}
+
+static void test_x87_fast(void **state)
+{
+    // with UC_MODE_X87_FAST, extended precision computes like double
+    // precision on doubles that stay in range
+    check_ops(*state, 0x37f, 0x27f & ~FPUC_IM, 1, 1000);
+}
+
+static void test_x87_convert(void **state)
+{
+    uc_engine *uc = *state;
+    // fld qword [OPM]; fstp tbyte [OUT]; fld tbyte [OPA]; fstp qword [OUT + 16]
+    static const uint8_t code[] = {
+        0xdd, 0x05, 0x30, 0x00, 0x02, 0x00, 0xdb, 0x3d, 0x40, 0x00, 0x02, 0x00,
+        0xdb, 0x2d, 0x10, 0x00, 0x02, 0x00, 0xdd, 0x1d, 0x50, 0x00, 0x02, 0x00,
+    };
+    static const struct {
+        uint64_t f64;
+        uint64_t mant;
+        uint16_t exp;
+    } vec[] = {
+        { 0x3ff0000000000000ULL, 0x8000000000000000ULL, 0x3fff },  // 1.0
+        { 0xc004000000000000ULL, 0xa000000000000000ULL, 0xc000 },  // -2.5
+        { 0x0010000000000000ULL, 0x8000000000000000ULL, 0x3c01 },  // DBL_MIN
+        { 0x7fefffffffffffffULL, 0xfffffffffffff800ULL, 0x43fe },  // DBL_MAX
+        { 0x0000000000000001ULL, 0x8000000000000000ULL, 0x3bcd },  // denormal
+        { 0x8000000000000000ULL, 0, 0x8000 },                      // -0.0
+        { 0x7ff0000000000000ULL, 0x8000000000000000ULL, 0x7fff },  // inf
+    };
+    uint8_t a[10], out[24];
+    uint64_t f64;
+    size_t i;
+
+    OK(uc_mem_write(uc, CODE, code, sizeof(code)));
+    for (i = 0; i < sizeof(vec) / sizeof(vec[0]); i++) {
+        memcpy(a, &vec[i].mant, 8);
+        memcpy(a + 8, &vec[i].exp, 2);
+        OK(uc_mem_write(uc, OPM, &vec[i].f64, 8));
+        OK(uc_mem_write(uc, OPA, a, 10));
+        OK(uc_emu_start(uc, CODE, CODE + sizeof(code), 0, 0));
+        OK(uc_mem_read(uc, OUT, out, 24));
+        assert_memory_equal(out, a, 10);
+        memcpy(&f64, out + 16, 8);
+        assert_int_equal(f64, vec[i].f64);
+    }
+}
+
+int main(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test_setup_teardown(test_x87_double, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_x87_other_modes, setup32, teardown),
+        cmocka_unit_test_setup_teardown(test_x87_fast, setup32_fast, teardown),
+        cmocka_unit_test_setup_teardown(test_x87_convert, setup32, teardown),
+    };
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -1,6 +1,10 @@
 /* Unicorn Emulator Engine */
 /* By Nguyen Anh Quynh <aquynh@gmail.com>, 2015 */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     // REG_RIP, for faults on flat memory
+#endif
+
 #if defined(UNICORN_HAS_OSXKERNEL)
 #include <libkern/libkern.h>
 #else
@@ -24,6 +28,26 @@
 
 #include "qemu/include/hw/boards.h"
 #include "qemu/include/qemu/queue.h"
+#include "qemu/include/qemu/crc32c.h"
+#include "qemu/include/qemu/bitops.h"
+#include "qemu/include/qemu/atomic.h"
+
+#ifdef UC_FLAT_MEMORY
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <ucontext.h>
+#include <unistd.h>
+#endif
+
+#if !defined(_WIN32) && !defined(UNICORN_HAS_OSXKERNEL)
+#define UC_FILE_MAP     // uc_mem_map_file() needs mmap()
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 static void free_table(gpointer key, gpointer value, gpointer data)
 {
@@ -103,6 +127,10 @@ const char *uc_strerror(uc_err code)
             return "Unhandled CPU exception (UC_ERR_EXCEPTION)";
         case UC_ERR_TIMEOUT:
             return "Emulation timed out (UC_ERR_TIMEOUT)";
+        case UC_ERR_BREAKPOINT:
+            return "Emulation stopped at a breakpoint (UC_ERR_BREAKPOINT)";
+        case UC_ERR_CALL_STOPPED:
+            return "Emulation stopped before the function returned (UC_ERR_CALL_STOPPED)";
     }
 }
 
@@ -164,6 +192,10 @@ uc_err uc_open(uc_arch arch, uc_mode mode, uc_engine **result)
         uc->address_spaces.tqh_first = NULL;
         uc->address_spaces.tqh_last = &uc->address_spaces.tqh_first;
 
+        uc->cpus.tqh_first = NULL;
+        uc->cpus.tqh_last = &uc->cpus.tqh_first;
+        uc->quantum = UC_VCPU_QUANTUM;
+
         switch(arch) {
             default:
                 break;
@@ -223,7 +255,8 @@ uc_err uc_open(uc_arch arch, uc_mode mode, uc_engine **result)
 #if defined(UNICORN_HAS_MIPS) || defined(UNICORN_HAS_MIPSEL) || defined(UNICORN_HAS_MIPS64) || defined(UNICORN_HAS_MIPS64EL)
             case UC_ARCH_MIPS:
                 if ((mode & ~UC_MODE_MIPS_MASK) ||
-                        !(mode & (UC_MODE_MIPS32|UC_MODE_MIPS64))) {
+                        !(mode & (UC_MODE_MIPS32|UC_MODE_MIPS64)) ||
+                        ((mode & UC_MODE_MIPS32R5) && !(mode & UC_MODE_MIPS32))) {
                     free(uc);
                     return UC_ERR_MODE;
                 }
@@ -283,6 +316,258 @@ uc_err uc_open(uc_arch arch, uc_mode mode, uc_engine **result)
     }
 }
 
+#ifdef UC_FLAT_MEMORY
+#ifndef SYS_memfd_create
+#define SYS_memfd_create 319
+#endif
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 1
+#endif
+
+// flat_base is placed low if possible, so translated code can add it as a
+// 32-bit displacement
+#define FLAT_HINT   0x40000000UL
+
+// MIPS kseg0 & kseg1 show the low 512MB of physical memory
+#define FLAT_MIPS_KSEG0     0x80000000ULL
+#define FLAT_MIPS_KSEG1     0xa0000000ULL
+#define FLAT_MIPS_KSEG_SIZE 0x20000000ULL
+
+static __thread struct uc_struct *flat_current;    // engine emulating on this thread
+static struct sigaction flat_old_action;
+static pthread_once_t flat_once = PTHREAD_ONCE_INIT;
+
+static void flat_signal(int sig, siginfo_t *info, void *context)
+{
+    struct uc_struct *uc = flat_current;
+    ucontext_t *ctx = (ucontext_t *)context;
+    uint8_t *addr = (uint8_t *)info->si_addr;
+
+    // translated code faulted on flat memory: this does not return
+    if (uc != NULL && uc->flat_base != NULL &&
+            addr >= uc->flat_base && addr < uc->flat_base + UC_FLAT_SIZE + UC_FLAT_PAGE_SIZE &&
+            uc->flat_fault(uc, (uintptr_t)ctx->uc_mcontext.gregs[REG_RIP]))
+        return;
+
+    // not ours: chain to the previous handler
+    if (flat_old_action.sa_flags & SA_SIGINFO) {
+        flat_old_action.sa_sigaction(sig, info, context);
+    } else if (flat_old_action.sa_handler == SIG_DFL) {
+        // fault again on return, and terminate
+        signal(sig, SIG_DFL);
+    } else if (flat_old_action.sa_handler != SIG_IGN) {
+        flat_old_action.sa_handler(sig);
+    }
+}
+
+static void flat_install(void)
+{
+    struct sigaction act;
+
+    memset(&act, 0, sizeof(act));
+    act.sa_sigaction = flat_signal;
+    // the handler leaves by siglongjmp(), which does not restore the signal mask
+    act.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&act.sa_mask);
+    sigaction(SIGSEGV, &act, &flat_old_action);
+}
+
+static void flat_enter(struct uc_struct *uc)
+{
+    if (uc->flat_base != NULL)
+        flat_current = uc;
+}
+
+static void flat_leave(struct uc_struct *uc)
+{
+    if (flat_current == uc)
+        flat_current = NULL;
+}
+
+// set the host protection of [begin, end[ of flat memory
+static void flat_mprotect(struct uc_struct *uc, uint64_t begin, uint64_t end, int prot)
+{
+    if (uc->arch == UC_ARCH_MIPS) {
+        // kseg0 & kseg1 are only aliases, kseg2 & kseg3 go through the TLB
+        if (begin >= FLAT_MIPS_KSEG0)
+            return;
+        if (begin < FLAT_MIPS_KSEG_SIZE) {
+            size_t len = (size_t)(MIN(end, FLAT_MIPS_KSEG_SIZE) - begin);
+            mprotect(uc->flat_base + FLAT_MIPS_KSEG0 + begin, len, prot);
+            mprotect(uc->flat_base + FLAT_MIPS_KSEG1 + begin, len, prot);
+        }
+        end = MIN(end, FLAT_MIPS_KSEG0);
+    }
+
+    mprotect(uc->flat_base + begin, (size_t)(end - begin), prot);
+}
+
+// host protection of the flat memory page at @address: reads & writes
+// that must be checked by the TLB fault
+static int flat_prot(struct uc_struct *uc, uint64_t address)
+{
+    MemoryRegion *mr = memory_mapping(uc, address);
+    int prot = PROT_NONE;
+
+    if (mr == NULL)
+        return PROT_NONE;
+
+    if (mr->perms & UC_PROT_READ)
+        prot |= PROT_READ;
+
+    // pages holding translated code stay read-only, to detect self-modifying code
+    if ((mr->perms & UC_PROT_WRITE) && !test_bit(address >> UC_FLAT_PAGE_BITS, uc->flat_code))
+        prot |= PROT_WRITE;
+
+    return prot;
+}
+
+// update the host protection of [begin, end[ of flat memory, after a change
+// of mappings, permissions or translated code
+static void flat_update(struct uc_struct *uc, uint64_t begin, uint64_t end)
+{
+    uint64_t address, start = begin;
+    int prot, start_prot = flat_prot(uc, begin);
+
+    for (address = begin + UC_FLAT_PAGE_SIZE; address < end; address += UC_FLAT_PAGE_SIZE) {
+        prot = flat_prot(uc, address);
+        if (prot != start_prot) {
+            flat_mprotect(uc, start, address, start_prot);
+            start = address;
+            start_prot = prot;
+        }
+    }
+    flat_mprotect(uc, start, end, start_prot);
+}
+
+// [address, address + size[ of flat memory was unmapped: free its pages,
+// which also zeroes them for the next mapping
+static void flat_release(struct uc_struct *uc, uint64_t address, size_t size)
+{
+    uint64_t page;
+
+    for (page = address; page < address + size; page += UC_FLAT_PAGE_SIZE)
+        clear_bit(page >> UC_FLAT_PAGE_BITS, uc->flat_code);
+
+    flat_update(uc, address, address + size);
+    madvise(uc->flat_ram + address, size, MADV_REMOVE);
+}
+
+void uc_flat_protect_code(struct uc_struct *uc, void *host, bool protect)
+{
+    uint64_t address = (uint64_t)((uint8_t *)host - uc->flat_ram);
+
+    if ((uint8_t *)host < uc->flat_ram || address >= UC_FLAT_SIZE)
+        return;
+
+    address &= ~(uint64_t)(UC_FLAT_PAGE_SIZE - 1);
+    if (test_bit(address >> UC_FLAT_PAGE_BITS, uc->flat_code) == protect)
+        return;
+
+    if (protect)
+        set_bit(address >> UC_FLAT_PAGE_BITS, uc->flat_code);
+    else
+        clear_bit(address >> UC_FLAT_PAGE_BITS, uc->flat_code);
+
+    flat_update(uc, address, address + UC_FLAT_PAGE_SIZE);
+}
+
+static void flat_free(struct uc_struct *uc)
+{
+    if (uc->flat_base == NULL)
+        return;
+
+    munmap(uc->flat_base, UC_FLAT_SIZE + UC_FLAT_PAGE_SIZE);
+    munmap(uc->flat_ram, UC_FLAT_SIZE);
+    close(uc->flat_fd);
+    g_free(uc->flat_code);
+    g_hash_table_destroy(uc->flat_slow);
+}
+
+// flat memory is for guests with a 32-bit address space
+static bool flat_supported(struct uc_struct *uc)
+{
+    switch(uc->arch) {
+        default:
+            return false;
+        case UC_ARCH_ARM:
+            return true;
+        case UC_ARCH_MIPS:
+            return (uc->mode & UC_MODE_MIPS32) != 0;
+        case UC_ARCH_X86:
+            return (uc->mode & (UC_MODE_16 | UC_MODE_32)) != 0;
+    }
+}
+#else
+static void flat_enter(struct uc_struct *uc) { }
+static void flat_leave(struct uc_struct *uc) { }
+static void flat_update(struct uc_struct *uc, uint64_t begin, uint64_t end) { }
+static void flat_release(struct uc_struct *uc, uint64_t address, size_t size) { }
+static void flat_free(struct uc_struct *uc) { }
+void uc_flat_protect_code(struct uc_struct *uc, void *host, bool protect) { }
+#endif
+
+#ifdef UC_FILE_MAP
+// a file mapped by uc_mem_map_file(), maybe split in several regions since
+struct file_map {
+    uint8_t *host;
+    size_t size;
+    size_t mapped;      // bytes still mapped in the guest
+};
+
+// @size bytes at @host are unmapped from the guest: release the file with its last page
+static void file_unmapped(struct uc_struct *uc, uint8_t *host, size_t size)
+{
+    struct list_item *cur;
+    struct file_map *fm;
+
+    for (cur = uc->file_maps.head; cur != NULL; cur = cur->next) {
+        fm = cur->data;
+        if (host >= fm->host && host < fm->host + fm->size) {
+            fm->mapped -= size;
+            if (fm->mapped == 0) {
+                munmap(fm->host, fm->size);
+                list_remove(&uc->file_maps, fm);
+                free(fm);
+            }
+            return;
+        }
+    }
+}
+
+static void file_map_free(struct uc_struct *uc)
+{
+    struct list_item *cur;
+    struct file_map *fm;
+
+    for (cur = uc->file_maps.head; cur != NULL; cur = cur->next) {
+        fm = cur->data;
+        munmap(fm->host, fm->size);
+        free(fm);
+    }
+    list_clear(&uc->file_maps);
+}
+#else
+static void file_unmapped(struct uc_struct *uc, uint8_t *host, size_t size) { }
+static void file_map_free(struct uc_struct *uc) { }
+#endif
+
+// a trace collector: a hook recording events in a growing array
+struct trace {
+    uc_hook hh;
+    uint8_t *records;
+    size_t record_size;
+    size_t count, max;
+    GHashTable *seen;   // block addresses recorded by UC_TRACE_COVERAGE
+};
+
+static void trace_free(struct trace *trace)
+{
+    if (trace->seen)
+        g_hash_table_destroy(trace->seen);
+    g_free(trace->records);
+    free(trace);
+}
 
 UNICORN_EXPORT
 uc_err uc_close(uc_engine *uc)
@@ -290,6 +575,7 @@ uc_err uc_close(uc_engine *uc)
     int i;
     struct list_item *cur;
     struct hook *hook;
+    CPUState *cpu, *next_cpu;
 
     // Cleanup internally.
     if (uc->release)
@@ -297,8 +583,10 @@ uc_err uc_close(uc_engine *uc)
     g_free(uc->tcg_ctx);
 
     // Cleanup CPU.
-    g_free(uc->cpu->tcg_as_listener);
-    g_free(uc->cpu->thread);
+    CPU_FOREACH(uc, cpu) {
+        g_free(cpu->tcg_as_listener);
+        g_free(cpu->thread);
+    }
 
     // Cleanup all objects.
     OBJECT(uc->machine_state->accelerator)->ref = 1;
@@ -308,7 +596,9 @@ uc_err uc_close(uc_engine *uc)
 
     object_unref(uc, OBJECT(uc->machine_state->accelerator));
     object_unref(uc, OBJECT(uc->machine_state));
-    object_unref(uc, OBJECT(uc->cpu));
+    QTAILQ_FOREACH_SAFE(cpu, &uc->cpus, node, next_cpu) {
+        object_unref(uc, OBJECT(cpu));
+    }
     object_unref(uc, OBJECT(&uc->io_mem_notdirty));
     object_unref(uc, OBJECT(&uc->io_mem_unassigned));
     object_unref(uc, OBJECT(&uc->io_mem_rom));
@@ -352,6 +642,21 @@ uc_err uc_close(uc_engine *uc)
 
     free(uc->mapped_blocks);
 
+    if (uc->breakpoints)
+        g_hash_table_destroy(uc->breakpoints);
+
+    if (uc->exits)
+        g_hash_table_destroy(uc->exits);
+    g_free(uc->exit_list);
+
+    flat_free(uc);
+    file_map_free(uc);
+
+    for (cur = uc->traces.head; cur != NULL; cur = cur->next) {
+        trace_free(cur->data);
+    }
+    list_clear(&uc->traces);
+
     // finally, free uc itself.
     memset(uc, 0, sizeof(*uc));
     free(uc);
@@ -372,15 +677,38 @@ uc_err uc_reg_read_batch(uc_engine *uc, int *ids, void **vals, int count)
 }
 
 
+// the register groups of the vCPU no longer hold what uc_context_save() copied
+static void context_dirty(CPUState *cpu, int groups)
+{
+    int i;
+
+    for (i = 0; i < UC_CTX_GROUPS; i++) {
+        if (groups & (1 << i)) {
+            cpu->context_version[i] = 0;
+        }
+    }
+}
+
 UNICORN_EXPORT
 uc_err uc_reg_write_batch(uc_engine *uc, int *ids, void *const *vals, int count)
 {
     int ret = UC_ERR_OK;
+    int i, groups = 0;
+
     if (uc->reg_write)
         ret = uc->reg_write(uc, (unsigned int *)ids, vals, count);
     else
         return UC_ERR_EXCEPTION;  // FIXME: need a proper uc_err
 
+    if (uc->reg_group) {
+        for (i = 0; i < count; i++) {
+            groups |= uc->reg_group(ids[i]);
+        }
+    } else {
+        groups = UC_CTX_ALL;
+    }
+    context_dirty(uc->cpu, groups);
+
     return ret;
 }
 
@@ -535,12 +863,21 @@ static void hook_count_cb(struct uc_struct *uc, uint64_t address, uint32_t size,
 UNICORN_EXPORT
 uc_err uc_emu_start(uc_engine* uc, uint64_t begin, uint64_t until, uint64_t timeout, size_t count)
 {
+    // the scheduler switches uc->cpu to the vCPU it runs
+    CPUState *cpu, *selected = uc->cpu;
+
     // reset the counter
     uc->emu_counter = 0;
     uc->invalid_error = UC_ERR_OK;
     uc->block_full = false;
     uc->emulation_done = false;
     uc->timed_out = false;
+    uc->breakpoint_hit = false;
+    uc->exit_index = (size_t)-1;
+
+    // do not stop again at the breakpoint we are resuming from
+    uc->breakpoint_skip = true;
+    uc->breakpoint_skip_addr = begin;
 
     switch(uc->arch) {
         default:
@@ -552,7 +889,7 @@ uc_err uc_emu_start(uc_engine* uc, uint64_t begin, uint64_t until, uint64_t time
 #endif
 #ifdef UNICORN_HAS_X86
         case UC_ARCH_X86:
-            switch(uc->mode) {
+            switch(uc->mode & ~UC_MODE_X87_FAST) {
                 default:
                     break;
                 case UC_MODE_16: {
@@ -577,6 +914,8 @@ uc_err uc_emu_start(uc_engine* uc, uint64_t begin, uint64_t until, uint64_t time
 #ifdef UNICORN_HAS_ARM
         case UC_ARCH_ARM:
             uc_reg_write(uc, UC_ARM_REG_R15, &begin);
+            // the lowest bit of @begin only selects Thumb mode
+            uc->breakpoint_skip_addr = begin & ~1ULL;
             break;
 #endif
 #ifdef UNICORN_HAS_ARM64
@@ -621,14 +960,31 @@ uc_err uc_emu_start(uc_engine* uc, uint64_t begin, uint64_t until, uint64_t time
         }
     }
 
-    uc->addr_end = until;
+    // translated code stops at @until, so it can only be reused for the same @until
+    if (uc->addr_end != until) {
+        uc->addr_end = until;
+        uc->tb_flush_request = true;
+    }
 
     if (timeout)
         enable_emu_timer(uc, timeout * 1000);   // microseconds -> nanoseconds
 
+    uc->flat_replay = false;
+    flat_enter(uc);
     if (uc->vm_start(uc)) {
+        flat_leave(uc);
+        uc->cpu = selected;
         return UC_ERR_RESOURCE;
     }
+    flat_leave(uc);
+
+    uc->cpu_last = uc->cpu->cpu_index;
+    uc->cpu = selected;
+
+    // translated code tells if it changed the FPU, see context_sync()
+    CPU_FOREACH(uc, cpu) {
+        context_dirty(cpu, UC_CTX_GPR | UC_CTX_SYS);
+    }
 
     // emulation is done
     uc->emulation_done = true;
@@ -641,6 +997,9 @@ uc_err uc_emu_start(uc_engine* uc, uint64_t begin, uint64_t until, uint64_t time
     if(uc->timed_out)
         return UC_ERR_TIMEOUT;
 
+    if (uc->breakpoint_hit)
+        return UC_ERR_BREAKPOINT;
+
     return uc->invalid_error;
 }
 
@@ -661,136 +1020,977 @@ uc_err uc_emu_stop(uc_engine *uc)
     return UC_ERR_OK;
 }
 
-// find if a memory range overlaps with existing mapped regions
-static bool memory_overlap(struct uc_struct *uc, uint64_t begin, size_t size)
-{
-    unsigned int i;
-    uint64_t end = begin + size - 1;
+// how arguments are passed and results returned by a calling convention
+struct call_abi {
+    uc_arch arch;
+    int mode;           // UC_MODE_32 or UC_MODE_64, or 0 for any mode
+    uc_call_conv conv;
+    int word;           // size of registers & stack slots
+    int nregs;          // number of arguments passed in registers
+    int regs[8];
+    int home;           // bytes reserved for the callee above the return address
+    int align;          // alignment of the stack at the call
+    int sp;
+    int link;           // register receiving the return address, or 0 to push it
+    int target;         // register receiving the function address, or 0
+    int result;
+    int pc;
+};
+
+static const struct call_abi call_abis[] = {
+#ifdef UNICORN_HAS_X86
+    { UC_ARCH_X86, UC_MODE_32, UC_CALL_CDECL, 4, 0, { 0 }, 0, 16,
+        UC_X86_REG_ESP, 0, 0, UC_X86_REG_EAX, UC_X86_REG_EIP },
+    { UC_ARCH_X86, UC_MODE_64, UC_CALL_SYSV64, 8, 6,
+        { UC_X86_REG_RDI, UC_X86_REG_RSI, UC_X86_REG_RDX, UC_X86_REG_RCX, UC_X86_REG_R8, UC_X86_REG_R9 }, 0, 16,
+        UC_X86_REG_RSP, 0, 0, UC_X86_REG_RAX, UC_X86_REG_RIP },
+    { UC_ARCH_X86, UC_MODE_64, UC_CALL_MS64, 8, 4,
+        { UC_X86_REG_RCX, UC_X86_REG_RDX, UC_X86_REG_R8, UC_X86_REG_R9 }, 32, 16,
+        UC_X86_REG_RSP, 0, 0, UC_X86_REG_RAX, UC_X86_REG_RIP },
+#endif
+#ifdef UNICORN_HAS_ARM
+    { UC_ARCH_ARM, 0, UC_CALL_AAPCS, 4, 4,
+        { UC_ARM_REG_R0, UC_ARM_REG_R1, UC_ARM_REG_R2, UC_ARM_REG_R3 }, 0, 8,
+        UC_ARM_REG_SP, UC_ARM_REG_LR, 0, UC_ARM_REG_R0, UC_ARM_REG_PC },
+#endif
+#ifdef UNICORN_HAS_ARM64
+    { UC_ARCH_ARM64, 0, UC_CALL_AAPCS64, 8, 8,
+        { UC_ARM64_REG_X0, UC_ARM64_REG_X1, UC_ARM64_REG_X2, UC_ARM64_REG_X3,
+          UC_ARM64_REG_X4, UC_ARM64_REG_X5, UC_ARM64_REG_X6, UC_ARM64_REG_X7 }, 0, 16,
+        UC_ARM64_REG_SP, UC_ARM64_REG_LR, 0, UC_ARM64_REG_X0, UC_ARM64_REG_PC },
+#endif
+#ifdef UNICORN_HAS_MIPS
+    // o32 callers reserve a slot on the stack for each register argument
+    { UC_ARCH_MIPS, UC_MODE_32, UC_CALL_MIPS_O32, 4, 4,
+        { UC_MIPS_REG_A0, UC_MIPS_REG_A1, UC_MIPS_REG_A2, UC_MIPS_REG_A3 }, 16, 8,
+        UC_MIPS_REG_SP, UC_MIPS_REG_RA, UC_MIPS_REG_T9, UC_MIPS_REG_V0, UC_MIPS_REG_PC },
+    { UC_ARCH_MIPS, UC_MODE_64, UC_CALL_MIPS_N64, 8, 8,
+        { UC_MIPS_REG_4, UC_MIPS_REG_5, UC_MIPS_REG_6, UC_MIPS_REG_7,
+          UC_MIPS_REG_8, UC_MIPS_REG_9, UC_MIPS_REG_10, UC_MIPS_REG_11 }, 0, 16,
+        UC_MIPS_REG_SP, UC_MIPS_REG_RA, UC_MIPS_REG_T9, UC_MIPS_REG_V0, UC_MIPS_REG_PC },
+#endif
+};
 
-    for(i = 0; i < uc->mapped_block_count; i++) {
-        // begin address falls inside this region?
-        if (begin >= uc->mapped_blocks[i]->addr && begin <= uc->mapped_blocks[i]->end - 1)
-            return true;
+// the first convention listed for the arch & mode is the default one
+static const struct call_abi *call_abi(uc_engine *uc, uc_call_conv conv)
+{
+    size_t i;
 
-        // end address falls inside this region?
-        if (end >= uc->mapped_blocks[i]->addr && end <= uc->mapped_blocks[i]->end - 1)
-            return true;
+    for (i = 0; i < ARR_SIZE(call_abis); i++) {
+        const struct call_abi *abi = &call_abis[i];
 
-        // this region falls totally inside this range?
-        if (begin < uc->mapped_blocks[i]->addr && end > uc->mapped_blocks[i]->end - 1)
-            return true;
+        if (abi->arch == uc->arch && (abi->mode == 0 || (uc->mode & abi->mode)) &&
+                (conv == UC_CALL_DEFAULT || conv == abi->conv))
+            return abi;
     }
 
-    // not found
-    return false;
+    return NULL;
 }
 
-// common setup/error checking shared between uc_mem_map and uc_mem_map_ptr
-static uc_err mem_map(uc_engine *uc, uint64_t address, size_t size, uint32_t perms, MemoryRegion *block)
+// store a register-sized value in guest byte order
+static void call_store(uc_engine *uc, uint8_t *p, uint64_t value, int size)
 {
-    MemoryRegion **regions;
+    int i;
 
-    if (block == NULL)
-        return UC_ERR_NOMEM;
+    for (i = 0; i < size; i++)
+        p[(uc->mode & UC_MODE_BIG_ENDIAN) ? size - 1 - i : i] = (uint8_t)(value >> (8 * i));
+}
 
-    if ((uc->mapped_block_count & (MEM_BLOCK_INCR - 1)) == 0) {  //time to grow
-        regions = (MemoryRegion**)g_realloc(uc->mapped_blocks,
-                sizeof(MemoryRegion*) * (uc->mapped_block_count + MEM_BLOCK_INCR));
-        if (regions == NULL) {
-            return UC_ERR_NOMEM;
+UNICORN_EXPORT
+uc_err uc_call(uc_engine *uc, uint64_t address, uc_call_conv conv,
+        const uint64_t *args, size_t nargs, uint64_t *result,
+        uint64_t timeout, size_t count)
+{
+    const struct call_abi *abi = call_abi(uc, conv);
+    uint64_t mask, ret, sp = 0, frame, pc = 0, value = 0;
+    size_t i, nstack, on_stack;
+    uint8_t *stack;
+    uc_err err;
+
+    if (result)
+        *result = 0;
+    if (abi == NULL || (nargs && args == NULL))
+        return UC_ERR_ARG;
+
+    mask = abi->word == 8 ? UINT64_MAX : UINT32_MAX;
+    ret = mask & ~0xfffULL;
+
+    // the stack receives the return address unless it goes in a register,
+    // the home area, then the arguments left over by the registers
+    nstack = nargs > (size_t)abi->nregs ? nargs - abi->nregs : 0;
+    frame = abi->home + nstack * abi->word;
+    uc_reg_read(uc, abi->sp, &sp);
+    sp = ((sp & mask) - frame) & ~(uint64_t)(abi->align - 1);
+    if (!abi->link) {
+        sp -= abi->word;
+        frame += abi->word;
+    }
+
+    stack = g_malloc0(frame);
+    if (stack == NULL && frame)
+        return UC_ERR_NOMEM;
+    if (!abi->link)
+        call_store(uc, stack, ret, abi->word);
+    on_stack = frame - nstack * abi->word;
+    for (i = 0; i < nargs; i++) {
+        if (i < (size_t)abi->nregs) {
+            value = args[i] & mask;
+            uc_reg_write(uc, abi->regs[i], &value);
+        } else {
+            call_store(uc, stack + on_stack, args[i], abi->word);
+            on_stack += abi->word;
         }
-        uc->mapped_blocks = regions;
+    }
+    err = frame ? uc_mem_write(uc, sp, stack, frame) : UC_ERR_OK;
+    g_free(stack);
+    if (err != UC_ERR_OK)
+        return err;
+
+    uc_reg_write(uc, abi->sp, &sp);
+    if (abi->link)
+        uc_reg_write(uc, abi->link, &ret);
+    if (abi->target) {
+        value = address & mask;
+        uc_reg_write(uc, abi->target, &value);
     }
 
-    uc->mapped_blocks[uc->mapped_block_count] = block;
-    uc->mapped_block_count++;
+    err = uc_emu_start(uc, address, ret, timeout, count);
+    if (err != UC_ERR_OK)
+        return err;
+
+    // @count or uc_emu_stop() end emulation without an error
+    uc_reg_read(uc, abi->pc, &pc);
+    if ((pc & mask) != ret)
+        return UC_ERR_CALL_STOPPED;
+
+    if (result) {
+        value = 0;
+        uc_reg_read(uc, abi->result, &value);
+        *result = value & mask;
+    }
 
     return UC_ERR_OK;
 }
 
-static uc_err mem_map_check(uc_engine *uc, uint64_t address, size_t size, uint32_t perms)
+UNICORN_EXPORT
+uc_err uc_emu_batch(uc_engine *uc, uint64_t begin, uint64_t until,
+        uint64_t timeout, size_t count, const int *regs, size_t nregs,
+        uc_batch_job *jobs, size_t njobs)
 {
-    if (size == 0)
-        // invalid memory mapping
-        return UC_ERR_ARG;
+    uc_context *initial;
+    uc_batch_job *job;
+    size_t i, j;
+    uc_err err;
 
-    // address cannot wrapp around
-    if (address + size - 1 < address)
+    if ((njobs && jobs == NULL) || (nregs && regs == NULL))
         return UC_ERR_ARG;
 
-    // address must be aligned to uc->target_page_size
-    if ((address & uc->target_page_align) != 0)
+    // flat memory is written without the TLB, so writes cannot be logged
+    if (uc->flat_base != NULL || uc->ram_log)
         return UC_ERR_ARG;
 
-    // size must be multiple of uc->target_page_size
-    if ((size & uc->target_page_align) != 0)
-        return UC_ERR_ARG;
+    err = uc_context_alloc(uc, &initial);
+    if (err != UC_ERR_OK)
+        return err;
+    err = uc_context_save(uc, initial);
+    if (err != UC_ERR_OK) {
+        uc_free(initial);
+        return err;
+    }
 
-    // check for only valid permissions
-    if ((perms & ~UC_PROT_ALL) != 0)
-        return UC_ERR_ARG;
+    uc->ram_log_start(uc);
+    for (i = 0; i < njobs; i++) {
+        job = &jobs[i];
+        if (job->results)
+            memset(job->results, 0, nregs * sizeof(*job->results));
 
-    // this area overlaps existing mapped regions?
-    if (memory_overlap(uc, address, size)) {
-        return UC_ERR_MAP;
+        job->err = uc_context_restore(uc, job->context ? job->context : initial);
+        for (j = 0; j < job->npatches && job->err == UC_ERR_OK; j++) {
+            job->err = uc_mem_write(uc, job->patches[j].address,
+                    job->patches[j].data, job->patches[j].size);
+        }
+        if (job->err == UC_ERR_OK) {
+            job->err = uc_emu_start(uc, begin, until, timeout, count);
+
+            // a job that did not run has no results
+            for (j = 0; job->results && j < nregs; j++)
+                uc_reg_read(uc, regs[j], &job->results[j]);
+        }
+
+        // only the pages written by this job are put back
+        uc->ram_log_rewind(uc);
     }
+    uc->ram_log_stop(uc);
+
+    uc_context_restore(uc, initial);
+    uc_free(initial);
 
     return UC_ERR_OK;
 }
 
+// translated code is stale, so flush it. If emulation is running, quit the
+// current TB to flush it now and continue at the same place
+static void tb_flush_now(uc_engine *uc)
+{
+    uc->tb_flush_request = true;
+    if (uc->current_cpu) {
+        uc->quit_request = true;
+        uc_emu_stop(uc);
+    }
+}
+
+// address of the instruction at @address, as the translators see it: on ARM,
+// the lowest bit of a code address only selects Thumb mode
+static uint64_t stop_addr(uc_engine *uc, uint64_t address)
+{
+    if (uc->arch == UC_ARCH_ARM)
+        return address & ~1ULL;
+
+    return address;
+}
+
 UNICORN_EXPORT
-uc_err uc_mem_map(uc_engine *uc, uint64_t address, size_t size, uint32_t perms)
+uc_err uc_breakpoint_add(uc_engine *uc, uint64_t address)
 {
-    uc_err res;
+    uint64_t *key;
 
-    if (uc->mem_redirect) {
-        address = uc->mem_redirect(address);
+    address = stop_addr(uc, address);
+
+    if (uc->breakpoints == NULL) {
+        uc->breakpoints = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+        if (uc->breakpoints == NULL)
+            return UC_ERR_NOMEM;
     }
 
-    res = mem_map_check(uc, address, size, perms);
-    if (res)
-        return res;
+    if (uc_breakpoint_exists(uc, address))
+        // nothing to do
+        return UC_ERR_OK;
 
-    return mem_map(uc, address, size, perms, uc->memory_map(uc, address, size, perms));
+    key = g_malloc(sizeof(*key));
+    if (key == NULL)
+        return UC_ERR_NOMEM;
+
+    *key = address;
+    g_hash_table_insert(uc->breakpoints, key, key);
+    tb_flush_now(uc);
+
+    return UC_ERR_OK;
 }
 
 UNICORN_EXPORT
-uc_err uc_mem_map_ptr(uc_engine *uc, uint64_t address, size_t size, uint32_t perms, void *ptr)
+uc_err uc_breakpoint_del(uc_engine *uc, uint64_t address)
 {
-    uc_err res;
+    address = stop_addr(uc, address);
+    if (!uc_breakpoint_exists(uc, address))
+        return UC_ERR_ARG;
 
-    if (ptr == NULL)
+    g_hash_table_remove(uc->breakpoints, &address);
+    tb_flush_now(uc);
+
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_cache_translate(uc_engine *uc, uint64_t begin, uint64_t end, uint64_t until, uc_cache_info *info)
+{
+    uc_cache_info stats = { 0, 0 };
+    uc_err err;
+
+    if (begin >= end)
         return UC_ERR_ARG;
 
-    if (uc->mem_redirect) {
-        address = uc->mem_redirect(address);
+    // translated code cannot be generated in the middle of emulation
+    if (uc->current_cpu)
+        return UC_ERR_ARG;
+
+    if (uc->addr_end != until) {
+        uc->addr_end = until;
+        uc->tb_flush_request = true;
     }
 
-    res = mem_map_check(uc, address, size, perms);
-    if (res)
-        return res;
+    err = uc->tb_translate_range(uc, begin, end, &stats);
+    if (info)
+        *info = stats;
 
-    return mem_map(uc, address, size, UC_PROT_ALL, uc->memory_map_ptr(uc, address, size, perms, ptr));
+    return err;
 }
 
-// Create a backup copy of the indicated MemoryRegion.
-// Generally used in prepartion for splitting a MemoryRegion.
-static uint8_t *copy_region(struct uc_struct *uc, MemoryRegion *mr)
+UNICORN_EXPORT
+uc_err uc_cache_flush(uc_engine *uc)
 {
-    uint8_t *block = (uint8_t *)g_malloc0((size_t)int128_get64(mr->size));
-    if (block != NULL) {
-        uc_err err = uc_mem_read(uc, mr->addr, block, (size_t)int128_get64(mr->size));
-        if (err != UC_ERR_OK) {
-            free(block);
-            block = NULL;
-        }
-    }
+    tb_flush_now(uc);
 
-    return block;
+    return UC_ERR_OK;
 }
 
-/*
-   Split the given MemoryRegion at the indicated address for the indicated size
+// file format of uc_cache_save_list(): a header, then one entry per block.
+// All fields are little endian, whatever the host.
+#define CACHE_FILE_MAGIC    0x43544355  // "UCTC"
+#define CACHE_FILE_VERSION  1
+
+#define CACHE_HEADER_SIZE   24  // magic, version, arch, mode: 32-bit, count: 64-bit
+#define CACHE_ENTRY_SIZE    28  // pc, cs_base: 64-bit, flags, size, crc: 32-bit
+
+struct cache_file_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t arch;
+    uint32_t mode;
+    uint64_t count;     // number of entries
+};
+
+struct cache_file_entry {
+    uint64_t pc;
+    uint64_t cs_base;
+    uint32_t flags;     // CPU state this block was translated for
+    uint32_t size;      // size of the guest code of this block
+    uint32_t crc;       // crc32c of this guest code
+};
+
+struct cache_save {
+    uc_engine *uc;
+    FILE *f;
+    uint64_t count;
+    bool failed;
+};
+
+static uint8_t *cache_put(uint8_t *p, uint64_t value, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++) {
+        *p++ = (uint8_t)(value >> (8 * i));
+    }
+
+    return p;
+}
+
+static const uint8_t *cache_get(const uint8_t *p, uint64_t *value, int size)
+{
+    int i;
+
+    *value = 0;
+    for (i = 0; i < size; i++) {
+        *value |= (uint64_t)*p++ << (8 * i);
+    }
+
+    return p;
+}
+
+static bool cache_write_header(FILE *f, const struct cache_file_header *header)
+{
+    uint8_t buf[CACHE_HEADER_SIZE], *p = buf;
+
+    p = cache_put(p, header->magic, 4);
+    p = cache_put(p, header->version, 4);
+    p = cache_put(p, header->arch, 4);
+    p = cache_put(p, header->mode, 4);
+    cache_put(p, header->count, 8);
+
+    return fwrite(buf, sizeof(buf), 1, f) == 1;
+}
+
+static bool cache_read_header(FILE *f, struct cache_file_header *header)
+{
+    uint8_t buf[CACHE_HEADER_SIZE];
+    const uint8_t *p = buf;
+    uint64_t v;
+
+    if (fread(buf, sizeof(buf), 1, f) != 1)
+        return false;
+
+    p = cache_get(p, &v, 4);
+    header->magic = (uint32_t)v;
+    p = cache_get(p, &v, 4);
+    header->version = (uint32_t)v;
+    p = cache_get(p, &v, 4);
+    header->arch = (uint32_t)v;
+    p = cache_get(p, &v, 4);
+    header->mode = (uint32_t)v;
+    cache_get(p, &header->count, 8);
+
+    return true;
+}
+
+static bool cache_write_entry(FILE *f, const struct cache_file_entry *entry)
+{
+    uint8_t buf[CACHE_ENTRY_SIZE], *p = buf;
+
+    p = cache_put(p, entry->pc, 8);
+    p = cache_put(p, entry->cs_base, 8);
+    p = cache_put(p, entry->flags, 4);
+    p = cache_put(p, entry->size, 4);
+    cache_put(p, entry->crc, 4);
+
+    return fwrite(buf, sizeof(buf), 1, f) == 1;
+}
+
+static bool cache_read_entry(FILE *f, struct cache_file_entry *entry)
+{
+    uint8_t buf[CACHE_ENTRY_SIZE];
+    const uint8_t *p = buf;
+    uint64_t v;
+
+    if (fread(buf, sizeof(buf), 1, f) != 1)
+        return false;
+
+    p = cache_get(p, &entry->pc, 8);
+    p = cache_get(p, &entry->cs_base, 8);
+    p = cache_get(p, &v, 4);
+    entry->flags = (uint32_t)v;
+    p = cache_get(p, &v, 4);
+    entry->size = (uint32_t)v;
+    cache_get(p, &v, 4);
+    entry->crc = (uint32_t)v;
+
+    return true;
+}
+
+// checksum the guest code of a block, if it is still mapped. The block is
+// read at the physical addresses its virtual pc maps to for the CPU, as
+// the code is fetched with paging on.
+static bool cache_block_crc(uc_engine *uc, uint64_t pc, uint32_t size, uint32_t *crc)
+{
+    uint64_t page_mask = ~(uint64_t)(uc->target_page_size - 1);
+    uint8_t *code = g_malloc(size);
+    uint64_t addr = pc, len;
+    hwaddr paddr;
+    uint32_t done = 0;
+    bool ok = true;
+
+    if (code == NULL)
+        return false;
+
+    // a block spans at most two pages
+    while (ok && done < size) {
+        len = MIN(size - done, (addr & page_mask) + uc->target_page_size - addr);
+        paddr = cpu_get_phys_page_debug(uc->cpu, addr & page_mask);
+        ok = paddr != -1 &&
+            uc_mem_read(uc, paddr + (addr & ~page_mask), code + done, (size_t)len) == UC_ERR_OK;
+        done += (uint32_t)len;
+        addr += len;
+    }
+
+    if (ok)
+        *crc = crc32c(0xffffffff, code, size);
+
+    g_free(code);
+    return ok;
+}
+
+static void cache_save_block(void *opaque, uint64_t pc, uint64_t cs_base, uint32_t flags, uint32_t size)
+{
+    struct cache_save *save = opaque;
+    struct cache_file_entry entry;
+
+    if (save->failed)
+        return;
+
+    memset(&entry, 0, sizeof(entry));
+    entry.pc = pc;
+    entry.cs_base = cs_base;
+    entry.flags = flags;
+    entry.size = size;
+    if (!cache_block_crc(save->uc, pc, size, &entry.crc))
+        // this code is not mapped anymore
+        return;
+
+    if (!cache_write_entry(save->f, &entry)) {
+        save->failed = true;
+        return;
+    }
+
+    save->count++;
+}
+
+UNICORN_EXPORT
+uc_err uc_cache_save_list(uc_engine *uc, const char *path)
+{
+    struct cache_file_header header;
+    struct cache_save save;
+
+    if (uc->current_cpu)
+        return UC_ERR_ARG;
+
+    save.uc = uc;
+    save.count = 0;
+    save.failed = false;
+    save.f = fopen(path, "wb");
+    if (save.f == NULL)
+        return UC_ERR_ARG;
+
+    memset(&header, 0, sizeof(header));
+    header.magic = CACHE_FILE_MAGIC;
+    header.version = CACHE_FILE_VERSION;
+    header.arch = uc->arch;
+    header.mode = uc->mode;
+
+    // the header is written again once the number of entries is known
+    if (!cache_write_header(save.f, &header))
+        save.failed = true;
+
+    uc->tb_foreach(uc, cache_save_block, &save);
+
+    header.count = save.count;
+    if (!save.failed && (fseek(save.f, 0, SEEK_SET) != 0 ||
+                !cache_write_header(save.f, &header)))
+        save.failed = true;
+
+    if (fclose(save.f) != 0)
+        save.failed = true;
+
+    return save.failed ? UC_ERR_RESOURCE : UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_cache_translate_list(uc_engine *uc, const char *path, uint64_t until, uc_cache_info *info)
+{
+    struct cache_file_header header;
+    struct cache_file_entry entry;
+    uc_cache_info stats = { 0, 0 };
+    uc_err err = UC_ERR_OK;
+    uint64_t i;
+    uint32_t crc;
+    FILE *f;
+
+    if (uc->current_cpu)
+        return UC_ERR_ARG;
+
+    f = fopen(path, "rb");
+    if (f == NULL)
+        return UC_ERR_ARG;
+
+    if (!cache_read_header(f, &header) ||
+            header.magic != CACHE_FILE_MAGIC || header.version != CACHE_FILE_VERSION) {
+        fclose(f);
+        return UC_ERR_ARG;
+    }
+
+    if (header.arch != uc->arch || header.mode != uc->mode) {
+        fclose(f);
+        return UC_ERR_MODE;
+    }
+
+    if (uc->addr_end != until) {
+        uc->addr_end = until;
+        uc->tb_flush_request = true;
+    }
+
+    for (i = 0; i < header.count; i++) {
+        if (!cache_read_entry(f, &entry) ||
+                entry.size == 0 || entry.size > 2 * uc->target_page_size) {
+            err = UC_ERR_ARG;
+            break;
+        }
+
+        // skip blocks whose code changed since it was saved
+        if (!cache_block_crc(uc, entry.pc, entry.size, &crc) || crc != entry.crc)
+            continue;
+
+        // translated with the hooks, exits & breakpoints installed now
+        uc->tb_translate_block(uc, entry.pc, entry.cs_base, entry.flags, &stats);
+    }
+
+    fclose(f);
+
+    if (info)
+        *info = stats;
+
+    return err;
+}
+
+UNICORN_EXPORT
+uc_err uc_emu_set_exits(uc_engine *uc, const uint64_t *exits, size_t count)
+{
+    GHashTable *table = NULL;
+    uint64_t *list = NULL;
+    size_t i;
+
+    if (count > 0) {
+        if (exits == NULL)
+            return UC_ERR_ARG;
+
+        list = g_malloc(count * sizeof(*list));
+        if (list == NULL)
+            return UC_ERR_NOMEM;
+        for (i = 0; i < count; i++)
+            list[i] = stop_addr(uc, exits[i]);
+
+        // keys & values point into the list, which gives us the exit index
+        table = g_hash_table_new(g_int64_hash, g_int64_equal);
+        if (table == NULL) {
+            g_free(list);
+            return UC_ERR_NOMEM;
+        }
+        for (i = 0; i < count; i++) {
+            // on duplicated addresses, report the first one
+            if (g_hash_table_lookup(table, &list[i]) == NULL)
+                g_hash_table_insert(table, &list[i], &list[i]);
+        }
+    }
+
+    if (uc->exits)
+        g_hash_table_destroy(uc->exits);
+    g_free(uc->exit_list);
+
+    uc->exits = table;
+    uc->exit_list = list;
+    tb_flush_now(uc);
+
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_vcpu_add(uc_engine *uc, int *index)
+{
+    CPUState *selected = uc->cpu;
+
+    // vCPUs cannot be added in the middle of emulation
+    if (uc->current_cpu)
+        return UC_ERR_ARG;
+
+    // this makes the new vCPU uc->cpu
+    if (machine_add_cpu(uc)) {
+        uc->cpu = selected;
+        return UC_ERR_RESOURCE;
+    }
+
+    if (uc->reg_reset)
+        uc->reg_reset(uc);
+
+    if (index)
+        *index = uc->cpu->cpu_index;
+    uc->cpu = selected;
+
+    // translated code only checks the quantum with several vCPUs
+    uc->tb_flush_request = true;
+
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_vcpu_select(uc_engine *uc, int index)
+{
+    CPUState *cpu;
+
+    if (uc->current_cpu)
+        return UC_ERR_ARG;
+
+    CPU_FOREACH(uc, cpu) {
+        if (cpu->cpu_index == index) {
+            uc->cpu = cpu;
+            return UC_ERR_OK;
+        }
+    }
+
+    return UC_ERR_ARG;
+}
+
+UNICORN_EXPORT
+uc_err uc_vcpu_set_quantum(uc_engine *uc, uint32_t quantum)
+{
+    if (quantum == 0 || quantum > INT32_MAX)
+        return UC_ERR_ARG;
+
+    uc->quantum = quantum;
+
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_mem_flat_enable(uc_engine *uc)
+{
+#ifdef UC_FLAT_MEMORY
+    uint8_t *base, *ram;
+    int fd;
+
+    if (uc->flat_base != NULL)
+        // nothing to do
+        return UC_ERR_OK;
+
+    if (!flat_supported(uc))
+        return UC_ERR_MODE;
+
+    // memory mapped already would have to move
+    if (uc->mapped_block_count > 0)
+        return UC_ERR_ARG;
+
+    // one memory file, mapped once for translated code with the guest
+    // protections, and once always writable for everything else
+    fd = (int)syscall(SYS_memfd_create, "unicorn-flat", MFD_CLOEXEC);
+    if (fd < 0)
+        return UC_ERR_NOMEM;
+
+    if (ftruncate(fd, UC_FLAT_SIZE) != 0) {
+        close(fd);
+        return UC_ERR_NOMEM;
+    }
+
+    ram = mmap(NULL, UC_FLAT_SIZE, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_NORESERVE, fd, 0);
+    if (ram == MAP_FAILED) {
+        close(fd);
+        return UC_ERR_NOMEM;
+    }
+
+    // one more page stops accesses crossing the end of the address space
+    base = mmap((void *)FLAT_HINT, UC_FLAT_SIZE + UC_FLAT_PAGE_SIZE, PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED ||
+            mmap(base, UC_FLAT_SIZE, PROT_NONE, MAP_SHARED | MAP_FIXED | MAP_NORESERVE, fd, 0) == MAP_FAILED ||
+            (uc->arch == UC_ARCH_MIPS &&
+             (mmap(base + FLAT_MIPS_KSEG0, FLAT_MIPS_KSEG_SIZE, PROT_NONE,
+                   MAP_SHARED | MAP_FIXED | MAP_NORESERVE, fd, 0) == MAP_FAILED ||
+              mmap(base + FLAT_MIPS_KSEG1, FLAT_MIPS_KSEG_SIZE, PROT_NONE,
+                   MAP_SHARED | MAP_FIXED | MAP_NORESERVE, fd, 0) == MAP_FAILED))) {
+        if (base != MAP_FAILED)
+            munmap(base, UC_FLAT_SIZE + UC_FLAT_PAGE_SIZE);
+        munmap(ram, UC_FLAT_SIZE);
+        close(fd);
+        return UC_ERR_NOMEM;
+    }
+
+    pthread_once(&flat_once, flat_install);
+
+    uc->flat_fd = fd;
+    uc->flat_ram = ram;
+    uc->flat_code = g_new0(unsigned long, BITS_TO_LONGS(UC_FLAT_SIZE >> UC_FLAT_PAGE_BITS));
+    uc->flat_slow = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+    uc->flat_base = base;
+
+    return UC_ERR_OK;
+#else
+    return UC_ERR_MODE;
+#endif
+}
+
+// find if a memory range overlaps with existing mapped regions
+static bool memory_overlap(struct uc_struct *uc, uint64_t begin, size_t size)
+{
+    unsigned int i;
+    uint64_t end = begin + size - 1;
+
+    for(i = 0; i < uc->mapped_block_count; i++) {
+        // begin address falls inside this region?
+        if (begin >= uc->mapped_blocks[i]->addr && begin <= uc->mapped_blocks[i]->end - 1)
+            return true;
+
+        // end address falls inside this region?
+        if (end >= uc->mapped_blocks[i]->addr && end <= uc->mapped_blocks[i]->end - 1)
+            return true;
+
+        // this region falls totally inside this range?
+        if (begin < uc->mapped_blocks[i]->addr && end > uc->mapped_blocks[i]->end - 1)
+            return true;
+    }
+
+    // not found
+    return false;
+}
+
+// common setup/error checking shared between uc_mem_map and uc_mem_map_ptr
+static uc_err mem_map(uc_engine *uc, uint64_t address, size_t size, uint32_t perms, MemoryRegion *block)
+{
+    MemoryRegion **regions;
+
+    if (block == NULL)
+        return UC_ERR_NOMEM;
+
+    if ((uc->mapped_block_count & (MEM_BLOCK_INCR - 1)) == 0) {  //time to grow
+        regions = (MemoryRegion**)g_realloc(uc->mapped_blocks,
+                sizeof(MemoryRegion*) * (uc->mapped_block_count + MEM_BLOCK_INCR));
+        if (regions == NULL) {
+            return UC_ERR_NOMEM;
+        }
+        uc->mapped_blocks = regions;
+    }
+
+    uc->mapped_blocks[uc->mapped_block_count] = block;
+    uc->mapped_block_count++;
+
+    return UC_ERR_OK;
+}
+
+// map RAM backed by flat memory, which keeps its content when regions are split
+static uc_err flat_map(uc_engine *uc, uint64_t address, size_t size, uint32_t perms)
+{
+    uc_err res;
+
+    res = mem_map(uc, address, size, perms,
+            uc->memory_map_ptr(uc, address, size, perms, uc->flat_ram + address));
+    if (res == UC_ERR_OK)
+        flat_update(uc, address, address + size);
+
+    return res;
+}
+
+static uc_err mem_map_check(uc_engine *uc, uint64_t address, size_t size, uint32_t perms)
+{
+    if (size == 0)
+        // invalid memory mapping
+        return UC_ERR_ARG;
+
+    // address cannot wrapp around
+    if (address + size - 1 < address)
+        return UC_ERR_ARG;
+
+    // address must be aligned to uc->target_page_size
+    if ((address & uc->target_page_align) != 0)
+        return UC_ERR_ARG;
+
+    // size must be multiple of uc->target_page_size
+    if ((size & uc->target_page_align) != 0)
+        return UC_ERR_ARG;
+
+    // check for only valid permissions
+    if ((perms & ~UC_PROT_ALL) != 0)
+        return UC_ERR_ARG;
+
+    // flat memory is protected per host page, and ends with the 32-bit address space
+    if (uc->flat_base != NULL &&
+            (((address | size) & (UC_FLAT_PAGE_SIZE - 1)) != 0 || address + size > UC_FLAT_SIZE))
+        return UC_ERR_ARG;
+
+    // this area overlaps existing mapped regions?
+    if (memory_overlap(uc, address, size)) {
+        return UC_ERR_MAP;
+    }
+
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_mem_map(uc_engine *uc, uint64_t address, size_t size, uint32_t perms)
+{
+    uc_err res;
+
+    if (uc->mem_redirect) {
+        address = uc->mem_redirect(address);
+    }
+
+    res = mem_map_check(uc, address, size, perms);
+    if (res)
+        return res;
+
+    if (uc->flat_base != NULL)
+        return flat_map(uc, address, size, perms);
+
+    return mem_map(uc, address, size, perms, uc->memory_map(uc, address, size, perms));
+}
+
+UNICORN_EXPORT
+uc_err uc_mem_map_ptr(uc_engine *uc, uint64_t address, size_t size, uint32_t perms, void *ptr)
+{
+    uc_err res;
+
+    if (ptr == NULL)
+        return UC_ERR_ARG;
+
+    if (uc->mem_redirect) {
+        address = uc->mem_redirect(address);
+    }
+
+    res = mem_map_check(uc, address, size, perms);
+    if (res)
+        return res;
+
+    // flat memory only remaps itself, when regions are split
+    if (uc->flat_base != NULL) {
+        if (ptr != uc->flat_ram + address)
+            return UC_ERR_ARG;
+        return flat_map(uc, address, size, perms);
+    }
+
+    return mem_map(uc, address, size, UC_PROT_ALL, uc->memory_map_ptr(uc, address, size, perms, ptr));
+}
+
+UNICORN_EXPORT
+uc_err uc_mem_map_file(uc_engine *uc, uint64_t address, size_t size, uint32_t perms,
+        int fd, uint64_t offset, uint32_t flags)
+{
+#ifdef UC_FILE_MAP
+    struct file_map *fm;
+    struct stat st;
+    uint8_t *host;
+    uc_err res;
+
+    if (flags != UC_MAP_PRIVATE && flags != UC_MAP_SHARED)
+        return UC_ERR_ARG;
+
+    // flat memory cannot be backed by anything else
+    if (uc->flat_base != NULL)
+        return UC_ERR_ARG;
+
+    if (size == 0 || (offset & (sysconf(_SC_PAGESIZE) - 1)) != 0)
+        return UC_ERR_ARG;
+
+    if (fstat(fd, &st) != 0)
+        return UC_ERR_ARG;
+
+    // the guest would fault on pages past the end of the file
+    if (S_ISREG(st.st_mode) && (offset > (uint64_t)st.st_size || size > st.st_size - offset))
+        return UC_ERR_ARG;
+
+    // always writable by the host, like RAM: guest permissions are checked by the softmmu
+    host = mmap(NULL, size, PROT_READ | PROT_WRITE,
+            flags == UC_MAP_SHARED ? MAP_SHARED : MAP_PRIVATE, fd, (off_t)offset);
+    if (host == MAP_FAILED)
+        return errno == ENOMEM ? UC_ERR_NOMEM : UC_ERR_ARG;
+
+    res = uc_mem_map_ptr(uc, address, size, perms, host);
+    if (res != UC_ERR_OK) {
+        munmap(host, size);
+        return res;
+    }
+
+    fm = malloc(sizeof(*fm));
+    if (fm == NULL) {
+        uc_mem_unmap(uc, address, size);
+        munmap(host, size);
+        return UC_ERR_NOMEM;
+    }
+    fm->host = host;
+    fm->size = size;
+    fm->mapped = size;
+    list_append(&uc->file_maps, fm);
+
+    return UC_ERR_OK;
+#else
+    return UC_ERR_MODE;
+#endif
+}
+
+// find the RAM block backing this memory region
+static RAMBlock *ram_block(struct uc_struct *uc, MemoryRegion *mr)
+{
+    RAMBlock *block;
+
+    QTAILQ_FOREACH(block, &uc->ram_list.blocks, next) {
+        if (block->mr == mr)
+            return block;
+    }
+
+    return NULL;
+}
+
+// Create a backup copy of the indicated MemoryRegion.
+// Generally used in prepartion for splitting a MemoryRegion.
+static uint8_t *copy_region(struct uc_struct *uc, MemoryRegion *mr)
+{
+    uint8_t *block = (uint8_t *)g_malloc0((size_t)int128_get64(mr->size));
+    if (block != NULL) {
+        uc_err err = uc_mem_read(uc, mr->addr, block, (size_t)int128_get64(mr->size));
+        if (err != UC_ERR_OK) {
+            free(block);
+            block = NULL;
+        }
+    }
+
+    return block;
+}
+
+/*
+   Split the given MemoryRegion at the indicated address for the indicated size
    this may result in the create of up to 3 spanning sections. If the delete
    parameter is true, the no new section will be created to replace the indicate
    range. This functions exists to support uc_mem_protect and uc_mem_unmap.
@@ -829,12 +2029,7 @@ static bool split_region(struct uc_struct *uc, MemoryRegion *mr, uint64_t addres
         // impossible case
         return false;
 
-    QTAILQ_FOREACH(block, &uc->ram_list.blocks, next) {
-        if (block->offset <= mr->addr && block->length >= (mr->end - mr->addr)) {
-            break;
-        }
-    }
-
+    block = ram_block(uc, mr);
     if (block == NULL)
         return false;
 
@@ -842,7 +2037,12 @@ static bool split_region(struct uc_struct *uc, MemoryRegion *mr, uint64_t addres
     // moving it
 	prealloc = !!(block->flags & 1);
 
-    if (block->flags & 1) {
+    if (uc->flat_base != NULL) {
+        // flat memory stays in place, and is only mapped again
+        prealloc = true;
+        backup = uc->flat_ram + mr->addr;
+    } else if (block->flags & 1) {
+        // so does memory given by uc_mem_map_ptr() & uc_mem_map_file()
         backup = block->host;
     } else {
         backup = copy_region(uc, mr);
@@ -856,7 +2056,11 @@ static bool split_region(struct uc_struct *uc, MemoryRegion *mr, uint64_t addres
     end = mr->end;
 
     // unmap this region first, then do split it later
-    if (uc_mem_unmap(uc, mr->addr, (size_t)int128_get64(mr->size)) != UC_ERR_OK)
+    if (prealloc) {
+        // without releasing the memory, which the pieces are mapped to again
+        uc->memory_unmap(uc, mr);
+        uc->tb_flush_request = true;
+    } else if (uc_mem_unmap(uc, mr->addr, (size_t)int128_get64(mr->size)) != UC_ERR_OK)
         goto error;
 
     /* overlapping cases
@@ -903,6 +2107,8 @@ static bool split_region(struct uc_struct *uc, MemoryRegion *mr, uint64_t addres
             if (uc_mem_map_ptr(uc, address, m_size, perms, backup + l_size) != UC_ERR_OK)
                 goto error;
         }
+    } else if (m_size > 0 && prealloc) {
+        file_unmapped(uc, backup + l_size, m_size);
     }
 
     if (r_size > 0) {
@@ -951,6 +2157,10 @@ uc_err uc_mem_protect(struct uc_struct *uc, uint64_t address, size_t size, uint3
     if ((perms & ~UC_PROT_ALL) != 0)
         return UC_ERR_ARG;
 
+    // flat memory is protected per host page
+    if (uc->flat_base != NULL && ((address | size) & (UC_FLAT_PAGE_SIZE - 1)) != 0)
+        return UC_ERR_ARG;
+
     if (uc->mem_redirect) {
         address = uc->mem_redirect(address);
     }
@@ -980,10 +2190,12 @@ uc_err uc_mem_protect(struct uc_struct *uc, uint64_t address, size_t size, uint3
         addr += len;
     }
 
+    if (uc->flat_base != NULL)
+        flat_update(uc, address, address + size);
+
     // if EXEC permission is removed, then quit TB and continue at the same place
     if (remove_exec) {
-        uc->quit_request = true;
-        uc_emu_stop(uc);
+        tb_flush_now(uc);
     }
 
     return UC_ERR_OK;
@@ -993,6 +2205,7 @@ UNICORN_EXPORT
 uc_err uc_mem_unmap(struct uc_struct *uc, uint64_t address, size_t size)
 {
     MemoryRegion *mr;
+    uint8_t *host;
     uint64_t addr;
     size_t count, len;
 
@@ -1008,6 +2221,10 @@ uc_err uc_mem_unmap(struct uc_struct *uc, uint64_t address, size_t size)
     if ((size & uc->target_page_align) != 0)
         return UC_ERR_ARG;
 
+    // flat memory is released per host page
+    if (uc->flat_base != NULL && ((address | size) & (UC_FLAT_PAGE_SIZE - 1)) != 0)
+        return UC_ERR_ARG;
+
     if (uc->mem_redirect) {
         address = uc->mem_redirect(address);
     }
@@ -1029,12 +2246,22 @@ uc_err uc_mem_unmap(struct uc_struct *uc, uint64_t address, size_t size)
         // if we can retrieve the mapping, then no splitting took place
         // so unmap here
         mr = memory_mapping(uc, addr);
-        if (mr != NULL)
-           uc->memory_unmap(uc, mr);
+        if (mr != NULL) {
+            host = uc->file_maps.head != NULL ? ram_block(uc, mr)->host : NULL;
+            uc->memory_unmap(uc, mr);
+            if (host != NULL)
+                file_unmapped(uc, host, len);
+        }
         count += len;
         addr += len;
     }
 
+    if (uc->flat_base != NULL)
+        flat_release(uc, address, size);
+
+    // code translated from this area is gone
+    uc->tb_flush_request = true;
+
     return UC_ERR_OK;
 }
 
@@ -1068,6 +2295,51 @@ MemoryRegion *memory_mapping(struct uc_struct* uc, uint64_t address)
     return NULL;
 }
 
+MemoryRegion *memory_page_in(struct uc_struct *uc, uc_mem_type type, uint64_t address, int size)
+{
+    uc_mem_page page;
+    uint32_t align = uc->target_page_align;
+    uc_err err;
+
+    // flat memory is mapped per host page
+    if (uc->flat_base != NULL)
+        align |= UC_FLAT_PAGE_SIZE - 1;
+
+    page.begin = address & ~(uint64_t)align;
+    page.size = align + 1;
+    page.perms = UC_PROT_ALL;
+    page.ptr = NULL;
+    page.data = NULL;
+
+    if (!uc->pager(uc, type, address, size, &page, uc->pager_data))
+        return NULL;
+
+    // the region must cover the faulting address
+    if (address < page.begin || address - page.begin >= page.size)
+        return NULL;
+
+    if (page.ptr != NULL) {
+        err = uc_mem_map_ptr(uc, page.begin, page.size, page.perms, page.ptr);
+    } else {
+        err = uc_mem_map(uc, page.begin, page.size, page.perms);
+        if (err == UC_ERR_OK && page.data != NULL)
+            err = uc_mem_write(uc, page.begin, page.data, page.size);
+    }
+    if (err != UC_ERR_OK)
+        return NULL;
+
+    return memory_mapping(uc, address);
+}
+
+UNICORN_EXPORT
+uc_err uc_mem_set_pager(uc_engine *uc, uc_cb_mem_pager_t callback, void *user_data)
+{
+    uc->pager = callback;
+    uc->pager_data = user_data;
+
+    return UC_ERR_OK;
+}
+
 UNICORN_EXPORT
 uc_err uc_hook_add(uc_engine *uc, uc_hook *hh, int type, void *callback,
         void *user_data, uint64_t begin, uint64_t end, ...)
@@ -1116,6 +2388,7 @@ uc_err uc_hook_add(uc_engine *uc, uc_hook *hh, int type, void *callback,
         }
 
         hook->refs++;
+        uc->tb_flush_request = true;
         return UC_ERR_OK;
     }
 
@@ -1148,8 +2421,12 @@ uc_err uc_hook_add(uc_engine *uc, uc_hook *hh, int type, void *callback,
     // TODO: return an error?
     if (hook->refs == 0) {
         free(hook);
+        return ret;
     }
 
+    // translated code only calls the hooks that existed when it was generated
+    uc->tb_flush_request = true;
+
     return ret;
 }
 
@@ -1165,6 +2442,7 @@ uc_err uc_hook_del(uc_engine *uc, uc_hook hh)
     // and store the type mask in the hook pointer.
     for (i = 0; i < UC_HOOK_MAX; i++) {
         if (list_remove(&uc->hook[i], (void *)hook)) {
+            uc->tb_flush_request = true;
             if (--hook->refs == 0) {
                 free(hook);
                 break;
@@ -1174,6 +2452,145 @@ uc_err uc_hook_del(uc_engine *uc, uc_hook hh)
     return UC_ERR_OK;
 }
 
+static inline void *trace_record(struct trace *trace)
+{
+    if (trace->count == trace->max) {
+        trace->max = trace->max ? trace->max * 2 : 4096;
+        trace->records = g_realloc(trace->records, trace->max * trace->record_size);
+    }
+
+    return trace->records + trace->record_size * trace->count++;
+}
+
+static void trace_code(uc_engine *uc, uint64_t address, uint32_t size, void *user_data)
+{
+    *(uint64_t *)trace_record(user_data) = address;
+}
+
+static void trace_coverage(uc_engine *uc, uint64_t address, uint32_t size, void *user_data)
+{
+    struct trace *trace = user_data;
+    uint64_t *key;
+
+    if (g_hash_table_lookup(trace->seen, &address) != NULL)
+        return;
+
+    key = g_new(uint64_t, 1);
+    *key = address;
+    g_hash_table_insert(trace->seen, key, key);
+    *(uint64_t *)trace_record(trace) = address;
+}
+
+static void trace_mem(uc_engine *uc, uc_mem_type type, uint64_t address,
+        int size, int64_t value, void *user_data)
+{
+    uc_trace_mem_access *access = trace_record(user_data);
+
+    access->address = address;
+    access->value = type == UC_MEM_WRITE ? value : 0;
+    access->type = type;
+    access->size = size;
+}
+
+static struct trace *trace_find(uc_engine *uc, uc_hook hh)
+{
+    struct list_item *cur;
+
+    for (cur = uc->traces.head; cur != NULL; cur = cur->next) {
+        if (((struct trace *)cur->data)->hh == hh)
+            return cur->data;
+    }
+
+    return NULL;
+}
+
+UNICORN_EXPORT
+uc_err uc_trace_add(uc_engine *uc, uc_hook *hh, uc_trace_type type, uint64_t begin, uint64_t end)
+{
+    struct trace *trace;
+    uc_err err;
+
+    trace = calloc(1, sizeof(*trace));
+    if (trace == NULL)
+        return UC_ERR_NOMEM;
+
+    switch (type) {
+        default:
+            free(trace);
+            return UC_ERR_ARG;
+        case UC_TRACE_CODE:
+            trace->record_size = sizeof(uint64_t);
+            err = uc_hook_add(uc, &trace->hh, UC_HOOK_CODE, trace_code, trace, begin, end);
+            break;
+        case UC_TRACE_BLOCK:
+            trace->record_size = sizeof(uint64_t);
+            err = uc_hook_add(uc, &trace->hh, UC_HOOK_BLOCK, trace_code, trace, begin, end);
+            break;
+        case UC_TRACE_MEM:
+            trace->record_size = sizeof(uc_trace_mem_access);
+            err = uc_hook_add(uc, &trace->hh, UC_HOOK_MEM_READ | UC_HOOK_MEM_WRITE, trace_mem, trace, begin, end);
+            break;
+        case UC_TRACE_COVERAGE:
+            trace->record_size = sizeof(uint64_t);
+            trace->seen = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, NULL);
+            err = uc_hook_add(uc, &trace->hh, UC_HOOK_BLOCK, trace_coverage, trace, begin, end);
+            break;
+    }
+
+    if (err == UC_ERR_OK && list_append(&uc->traces, trace) == NULL) {
+        uc_hook_del(uc, trace->hh);
+        err = UC_ERR_NOMEM;
+    }
+    if (err != UC_ERR_OK) {
+        trace_free(trace);
+        return err;
+    }
+
+    *hh = trace->hh;
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_trace_get(uc_engine *uc, uc_hook hh, const void **records, size_t *count)
+{
+    struct trace *trace = trace_find(uc, hh);
+
+    if (trace == NULL)
+        return UC_ERR_ARG;
+
+    *records = trace->records;
+    *count = trace->count;
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_trace_reset(uc_engine *uc, uc_hook hh)
+{
+    struct trace *trace = trace_find(uc, hh);
+
+    if (trace == NULL)
+        return UC_ERR_ARG;
+
+    trace->count = 0;
+    if (trace->seen)
+        g_hash_table_remove_all(trace->seen);
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_trace_del(uc_engine *uc, uc_hook hh)
+{
+    struct trace *trace = trace_find(uc, hh);
+
+    if (trace == NULL)
+        return UC_ERR_ARG;
+
+    uc_hook_del(uc, hh);
+    list_remove(&uc->traces, trace);
+    trace_free(trace);
+    return UC_ERR_OK;
+}
+
 // TCG helper
 void helper_uc_tracecode(int32_t size, uc_hook_type type, void *handle, int64_t address);
 void helper_uc_tracecode(int32_t size, uc_hook_type type, void *handle, int64_t address)
@@ -1182,6 +2599,14 @@ void helper_uc_tracecode(int32_t size, uc_hook_type type, void *handle, int64_t
     struct list_item *cur = uc->hook[type].head;
     struct hook *hook;
 
+    // the instruction at @address faulted on flat memory and runs again:
+    // its hooks were called already
+    if (uc->flat_replay && (uint64_t)address == uc->flat_replay_pc) {
+        if ((int)type == UC_HOOK_CODE_IDX || uc->hook[UC_HOOK_CODE_IDX].head == NULL)
+            uc->flat_replay = false;
+        return;
+    }
+
     // sync PC in CPUArchState with address
     if (uc->set_pc) {
         uc->set_pc(uc, address);
@@ -1196,6 +2621,42 @@ void helper_uc_tracecode(int32_t size, uc_hook_type type, void *handle, int64_t
     }
 }
 
+// TCG helper, called at the start of a block beginning at a breakpoint or exit
+void helper_uc_stop_addr(void *handle, int64_t address);
+void helper_uc_stop_addr(void *handle, int64_t address)
+{
+    struct uc_struct *uc = handle;
+    CPUState *cpu = uc->current_cpu;
+    uint64_t *exit = NULL;
+
+    // the instruction at @address faulted on flat memory and runs again
+    if (uc->flat_replay && (uint64_t)address == uc->flat_replay_pc)
+        return;
+
+    if (uc->exits)
+        exit = g_hash_table_lookup(uc->exits, &address);
+
+    if (exit) {
+        uc->exit_index = exit - uc->exit_list;
+    } else {
+        // the first breakpoint we run into is skipped if emulation resumes from it
+        if (uc->breakpoint_skip) {
+            uc->breakpoint_skip = false;
+            if ((uint64_t)address == uc->breakpoint_skip_addr)
+                return;
+        }
+
+        uc->breakpoint_hit = true;
+    }
+
+    uc->stop_request = true;
+
+    // PC was already synced by the translated code, so quit the TB now
+    // before the instruction at @address is executed, like cpu_loop_exit()
+    cpu->current_tb = NULL;
+    siglongjmp(cpu->jmp_env, 1);
+}
+
 UNICORN_EXPORT
 uint32_t uc_mem_regions(uc_engine *uc, uc_mem_region **regions, uint32_t *count)
 {
@@ -1223,6 +2684,30 @@ uint32_t uc_mem_regions(uc_engine *uc, uc_mem_region **regions, uint32_t *count)
     return UC_ERR_OK;
 }
 
+UNICORN_EXPORT
+uc_err uc_mem_host_ptr(uc_engine *uc, uint64_t address, void **ptr, size_t *size)
+{
+    MemoryRegion *mr;
+    RAMBlock *block;
+
+    if (uc->mem_redirect) {
+        address = uc->mem_redirect(address);
+    }
+
+    mr = memory_mapping(uc, address);
+    if (mr == NULL)
+        return UC_ERR_NOMEM;
+
+    block = ram_block(uc, mr);
+    if (block == NULL)
+        return UC_ERR_NOMEM;
+
+    *ptr = block->host + (address - mr->addr);
+    *size = (size_t)(mr->end - address);
+
+    return UC_ERR_OK;
+}
+
 UNICORN_EXPORT
 uc_err uc_query(uc_engine *uc, uc_query_type type, size_t *result)
 {
@@ -1236,6 +2721,16 @@ uc_err uc_query(uc_engine *uc, uc_query_type type, size_t *result)
         return UC_ERR_OK;
     }
 
+    if (type == UC_QUERY_EXIT) {
+        *result = uc->exit_index;
+        return UC_ERR_OK;
+    }
+
+    if (type == UC_QUERY_VCPU) {
+        *result = uc->current_cpu ? uc->current_cpu->cpu_index : uc->cpu_last;
+        return UC_ERR_OK;
+    }
+
     switch(uc->arch) {
 #ifdef UNICORN_HAS_ARM
         case UC_ARCH_ARM:
@@ -1292,16 +2787,68 @@ static size_t cpu_context_size(uc_arch arch, uc_mode mode)
 UNICORN_EXPORT
 uc_err uc_context_alloc(uc_engine *uc, uc_context **context)
 {
-    struct uc_context **_context = context;
+    return uc_context_alloc_groups(uc, UC_CTX_ALL, context);
+}
+
+// last version given to the content of a register group, shared by all engines
+// so that contexts of any engine tell apart what they hold
+static uint64_t context_versions;
+
+static uint64_t context_version_new(void)
+{
+#ifdef _MSC_VER
+    return InterlockedIncrement64((volatile LONG64 *)&context_versions);
+#else
+    return atomic_fetch_inc(&context_versions) + 1;
+#endif
+}
+
+static size_t context_data_size(struct uc_context *context)
+{
+    return context->size & ~UC_CONTEXT_TRACKED;
+}
+
+static struct uc_context_info *context_info(struct uc_context *context)
+{
+    // keep the info aligned after the data
+    size_t offset = (context_data_size(context) + 7) & ~(size_t)7;
+
+    return (struct uc_context_info *)(context->data + offset);
+}
+
+UNICORN_EXPORT
+uc_err uc_context_alloc_groups(uc_engine *uc, int groups, uc_context **context)
+{
+    struct uc_context *_context;
+    struct uc_context_info *info;
     size_t size = cpu_context_size(uc->arch, uc->mode);
 
-    *_context = malloc(size + sizeof(uc_context));
-    if (*_context) {
-        (*_context)->size = size;
+    if (groups == 0 || (groups & ~UC_CTX_ALL)) {
+        return UC_ERR_ARG;
+    }
+
+    // without register groups, contexts are copied in full
+    if (!uc->context_ranges || size == 0) {
+        _context = malloc(size + sizeof(uc_context));
+        if (!_context) {
+            return UC_ERR_NOMEM;
+        }
+        _context->size = size;
+        *context = _context;
         return UC_ERR_OK;
-    } else {
+    }
+
+    _context = malloc(sizeof(uc_context) + ((size + 7) & ~(size_t)7) + sizeof(*info));
+    if (!_context) {
         return UC_ERR_NOMEM;
     }
+    _context->size = size | UC_CONTEXT_TRACKED;
+    info = context_info(_context);
+    info->groups = groups;
+    memset(info->version, 0, sizeof(info->version));
+    *context = _context;
+
+    return UC_ERR_OK;
 }
 
 UNICORN_EXPORT
@@ -1317,11 +2864,87 @@ size_t uc_context_size(uc_engine *uc)
     return cpu_context_size(uc->arch, uc->mode);
 }
 
+// fold the changes of the CPU which the engine learns about lazily into the versions
+static void context_sync(uc_engine *uc)
+{
+    // translated code sets fpu_dirty when it changes FPU registers
+    if (uc->cpu->fpu_dirty) {
+        uc->cpu->fpu_dirty = 0;
+        context_dirty(uc->cpu, UC_CTX_FPU);
+    }
+
+    // called from a hook: emulation is changing the registers
+    if (uc->current_cpu) {
+        context_dirty(uc->cpu, UC_CTX_GPR | UC_CTX_SYS);
+    }
+}
+
+// groups of the context which differ from the CPU
+static int context_stale(uc_engine *uc, struct uc_context_info *info)
+{
+    int i, stale = 0;
+
+    for (i = 0; i < UC_CTX_GROUPS; i++) {
+        if (info->version[i] == 0 || info->version[i] != uc->cpu->context_version[i]) {
+            stale |= 1 << i;
+        }
+    }
+
+    return stale & info->groups;
+}
+
+// check if restoring this data changes the translation of addresses
+static bool context_mmu_changed(uc_engine *uc, const char *data, size_t size)
+{
+    const char *env = uc->cpu->env_ptr;
+    const uc_context_range *r;
+
+    for (r = uc->context_mmu; r && r->group; r++) {
+        if (r->end <= size && memcmp(env + r->begin, data + r->begin, r->end - r->begin)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 UNICORN_EXPORT
 uc_err uc_context_save(uc_engine *uc, uc_context *context)
 {
     struct uc_context *_context = context;
-    memcpy(_context->data, uc->cpu->env_ptr, _context->size);
+    struct uc_context_info *info;
+    const uc_context_range *r;
+    char *env = uc->cpu->env_ptr;
+    int i, stale;
+
+    if (!(_context->size & UC_CONTEXT_TRACKED)) {
+        memcpy(_context->data, env, _context->size);
+        return UC_ERR_OK;
+    }
+
+    context_sync(uc);
+    info = context_info(_context);
+
+    // name what the CPU holds, to recognize it when it comes back
+    for (i = 0; i < UC_CTX_GROUPS; i++) {
+        if ((info->groups & (1 << i)) && uc->cpu->context_version[i] == 0) {
+            uc->cpu->context_version[i] = context_version_new();
+        }
+    }
+
+    stale = context_stale(uc, info);
+    for (r = uc->context_ranges; stale && r->group; r++) {
+        if (r->group & stale) {
+            memcpy(_context->data + r->begin, env + r->begin, r->end - r->begin);
+        }
+    }
+
+    for (i = 0; i < UC_CTX_GROUPS; i++) {
+        if (info->groups & (1 << i)) {
+            info->version[i] = uc->cpu->context_version[i];
+        }
+    }
+
     return UC_ERR_OK;
 }
 
@@ -1329,6 +2952,40 @@ UNICORN_EXPORT
 uc_err uc_context_restore(uc_engine *uc, uc_context *context)
 {
     struct uc_context *_context = context;
-    memcpy(uc->cpu->env_ptr, _context->data, _context->size);
+    struct uc_context_info *info;
+    const uc_context_range *r;
+    char *env = uc->cpu->env_ptr;
+    bool flush;
+    int i, stale;
+
+    if (!(_context->size & UC_CONTEXT_TRACKED)) {
+        flush = context_mmu_changed(uc, _context->data, _context->size);
+        memcpy(env, _context->data, _context->size);
+        context_dirty(uc->cpu, UC_CTX_ALL);
+    } else {
+        context_sync(uc);
+        info = context_info(_context);
+        stale = context_stale(uc, info);
+        flush = (stale & UC_CTX_SYS) &&
+            context_mmu_changed(uc, _context->data, context_data_size(_context));
+
+        for (r = uc->context_ranges; stale && r->group; r++) {
+            if (r->group & stale) {
+                memcpy(env + r->begin, _context->data + r->begin, r->end - r->begin);
+            }
+        }
+
+        for (i = 0; i < UC_CTX_GROUPS; i++) {
+            if (info->groups & (1 << i)) {
+                uc->cpu->context_version[i] = info->version[i];
+            }
+        }
+    }
+
+    // translated code does not depend on the context, but the TLB does on its address space
+    if (flush) {
+        uc->tlb_flush(uc);
+    }
+
     return UC_ERR_OK;
 }